@@ -59,7 +59,7 @@ Because we need literal functor and class names for registration in python, we p
 #define _WOO_DIM_DISPATCHER_FUNCTOR_DOC_ATTRS_CTOR_PY(Dim,DispatcherT,FunctorT,_doc,attrs,ctor,ppy) \
 	WOO_DIM_DISPATCHER_FUNCTOR__DECLS(Dim,DispatcherT,FunctorT) \
 	WOO_CLASS_BASE_DOC_ATTRS_CTOR_PY(DispatcherT,Dispatcher,ClassTrait().doc("Dispatcher calling :obj:`functors<" BOOST_PP_STRINGIZE(FunctorT) ">` based on received argument type(s).\n\n") _doc, \
-		WOO_DISPATCHER_FUNCTOR__ATTRS(DispatcherT,FunctorT) \
+		WOO_DISPATCHER_FUNCTOR__ATTRS(DispatcherT,FunctorT) attrs \
 		,/*ctor*/ ctor, /*py*/ ppy WOO_DISPATCHER_FUNCTOR__PY(DispatcherT,FunctorT) \
 	)
 
@@ -1,5 +1,6 @@
 #include<woo/core/EnergyTracker.hpp>
 #include<woo/core/Master.hpp>
+#include<woo/lib/base/CompUtils.hpp>
 #include<boost/algorithm/string.hpp>
 
 
@@ -128,15 +129,11 @@ void EnergyTrackerGrid::add(const Real& val, int& id, const Vector3r& xyz){\
 	if(id>=(int)data.shape()[0]) LOG_WARN("EnergyTrackerGrid: index "+to_string(id)+" beyond max energy index "+(to_string(data.shape()[0]))+" (set at initialization time).");
 	if(isnan(val)) return;
 	if(val==0) return;
-	/*** THIS FOLLOWING WAS COPIED FROM pkg/dem/FLowAnalysis.cpp ***/
 	Vector3i ijk=xyz2ijk(xyz);
 	Vector3r n=(xyz-ijk2xyz(ijk))/cellSize; // normalized coordinate in the cube (0..1)x(0..1)x(0..1)
-	// trilinear interpolation
-	const Real& x(n[0]); const Real& y(n[1]); const Real& z(n[2]);	Real X(1-x), Y(1-y), Z(1-z);
-	const int& i(ijk[0]); const int& j(ijk[1]); const int& k(ijk[2]);	int I(i+1), J(j+1), K(k+1);
-	// traverse all affected points
-	Real weights[]={X*Y*Z,x*Y*Z,x*y*Z,X*y*Z, X*Y*z,x*Y*z,x*y*z,X*y*z };
-	Vector3i pts[]={ Vector3i(i,j,k),Vector3i(I,j,k),Vector3i(I,J,k),Vector3i(i,J,k), Vector3i(i,j,K),Vector3i(I,j,K),Vector3i(I,J,K),Vector3i(i,J,K) };
+	// trilinear interpolation, shared with FlowAnalysis
+	Real weights[8]; Vector3i pts[8];
+	CompUtils::trilinearWeights(ijk,n,pts,weights);
 	Eigen::AlignedBox<int,3> validIjkRange(Vector3i::Zero(),Vector3i(data.shape()[1]-1,data.shape()[2]-1,data.shape()[3]-1));
 	for(int ii=0; ii<8; ii++){
 		if(!validIjkRange.contains(pts[ii])) continue;
@@ -70,29 +70,209 @@ void Engine::field_set(const shared_ptr<Field>& f){
 	else{ field=f; userAssignedField=true; }
 }
 
+py::object Engine::compiledPy(const string& callerId, const string& command){
+	// never destroyed, so that no python objects are released after the interpreter is finalized
+	static std::map<std::pair<string,string>,py::object>* cache=new std::map<std::pair<string,string>,py::object>();
+	// commands assembled at runtime (with changing values) would make the cache grow forever; start over when it is full
+	const size_t maxSize=256;
+	const auto key=std::make_pair(callerId,command);
+	auto I=cache->find(key);
+	if(I!=cache->end()) return I->second;
+	if(cache->size()>=maxSize) cache->clear();
+	py::object code=py::import("builtins").attr("compile")(command,"<"+callerId+">","exec");
+	(*cache)[key]=code;
+	return code;
+}
+
+namespace{
+	void runPy_compiled(const string& callerId, const string& command, Scene* scene_, Engine* engine_, const shared_ptr<Field>& field_, const py::object& snapshot=py::object()){
+		try{
+			// scripts are run in this namespace (wooMain)
+			py::object global(py::import("wooMain").attr("__dict__"));
+			py::dict local;
+			local["scene"]=py::cast(py::ptr(scene_));
+			local["S"]=py::cast(py::ptr(scene_));
+			local["engine"]=py::cast(py::ptr(engine_));
+			local["field"]=py::cast(field_);
+			local["woo"]=py::import("woo");
+			if(snapshot) local["snapshot"]=snapshot;
+			// local["wooExtra"]=py::import("wooExtra"); // FIXME: not always importable
+			py::object code=Engine::compiledPy(callerId,command);
+			PyObject* ret=PyEval_EvalCode(code.ptr(),global.ptr(),local.ptr());
+			if(!ret) throw py::error_already_set();
+			Py_DECREF(ret);
+		} catch (py::error_already_set& e){
+			throw std::runtime_error(callerId+": exception in '"+command+"':\n"+parsePythonException_gilLocked(e));
+		};
+	}
+};
+
 void Engine::runPy_generic(const string& callerId, const string& command, Scene* scene_, Engine* engine_, const shared_ptr<Field>& field_){
 	if(command.empty()) return;
 	GilLock lock;
-	try{
-		// scripts are run in this namespace (wooMain)
-		py::object global(py::import("wooMain").attr("__dict__"));
-		py::dict local;
-		local["scene"]=py::cast(py::ptr(scene_));
-		local["S"]=py::cast(py::ptr(scene_));
-		local["engine"]=py::cast(py::ptr(engine_));
-		local["field"]=py::cast(field_);
-		local["woo"]=py::import("woo");
-		// local["wooExtra"]=py::import("wooExtra"); // FIXME: not always importable
-		py::exec(command.c_str(),global,local);
-	} catch (py::error_already_set& e){
-		throw std::runtime_error(callerId+": exception in '"+command+"':\n"+parsePythonException_gilLocked(e));
-	};
+	runPy_compiled(callerId,command,scene_,engine_,field_);
 }
 
 void Engine::runPy(const string& callerId, const string& command){
 	runPy_generic(callerId,command,scene,this,field);
 };
 
+void Engine::runPyQueued(const string& callerId, const string& command, bool live){
+	if(command.empty()) return;
+	PyHookQueue::instance().push(callerId,command,scene,this,field,live);
+}
+
+void Engine::waitQueuedPy(){
+	if(PyGILState_Check()){
+		py::gil_scoped_release nogil;
+		PyHookQueue::instance().wait();
+	}
+	else PyHookQueue::instance().wait();
+	PyHookQueue::instance().rethrow();
+}
+
+WOO_IMPL_LOGGER(PyHookQueue);
+
+PyHookQueue& PyHookQueue::instance(){
+	static PyHookQueue* q=new PyHookQueue;
+	return *q;
+}
+
+void PyHookQueue::rethrow(){
+	std::unique_lock<std::mutex> l(mutex);
+	if(error.empty()) return;
+	string err; err.swap(error);
+	l.unlock();
+	throw std::runtime_error("Queued python command failed: "+err);
+}
+
+void PyHookQueue::push(const string& callerId, const string& command, Scene* scene, Engine* engine, const shared_ptr<Field>& field, bool live){
+	rethrow();
+	Item it{callerId,command,
+		scene?static_pointer_cast<Scene>(scene->shared_from_this()):shared_ptr<Scene>(),
+		engine?static_pointer_cast<Engine>(engine->shared_from_this()):shared_ptr<Engine>(),
+		field,live,-1,NaN,NaN,{}};
+	if(scene){
+		it.step=scene->step; it.time=scene->time; it.dt=scene->dt;
+		if(scene->trackEnergy) for(const auto& ni: scene->energy->names) it.energy.push_back({ni.first,scene->energy->energies.get(ni.second)});
+	}
+	std::unique_lock<std::mutex> l(mutex);
+	if(!started){
+		std::thread(&PyHookQueue::loop,this).detach();
+		started=true;
+	}
+	pending[scene]++;
+	if(live){
+		pendingLive[scene]++;
+		// without a scene, there is no step to wait for
+		if(scene){ held.push_back(std::move(it)); return; }
+	}
+	items.push_back(std::move(it));
+	l.unlock();
+	cvItems.notify_one();
+}
+
+void PyHookQueue::stepDone(const Scene* scene){
+	std::unique_lock<std::mutex> l(mutex);
+	if(held.empty()) return;
+	bool any=false;
+	for(auto I=held.begin(); I!=held.end(); ){
+		if(I->scene.get()!=scene){ ++I; continue; }
+		items.push_back(std::move(*I)); I=held.erase(I); any=true;
+	}
+	l.unlock();
+	if(any) cvItems.notify_one();
+}
+
+void PyHookQueue::wait(){
+	// called from a queued command: the worker would wait for itself
+	if(std::this_thread::get_id()==workerId) return;
+	std::unique_lock<std::mutex> l(mutex);
+	// live commands still held are released, as their steps will not be waited for
+	if(!held.empty()){
+		for(Item& it: held) items.push_back(std::move(it));
+		held.clear();
+		cvItems.notify_one();
+	}
+	cvIdle.wait(l,[this]{ return items.empty() && !busy; });
+}
+
+void PyHookQueue::waitPending(const Scene* scene, std::map<const Scene*,long>& counts){
+	if(std::this_thread::get_id()==workerId) return;
+	{
+		std::scoped_lock<std::mutex> l(mutex);
+		auto I=counts.find(scene);
+		if(I==counts.end() || I->second==0) return;
+	}
+	// the worker needs the GIL to run the commands
+	auto doWait=[&]{
+		std::unique_lock<std::mutex> l(mutex);
+		cvIdle.wait(l,[&]{ auto I=counts.find(scene); return I==counts.end() || I->second==0; });
+	};
+	if(PyGILState_Check()){ py::gil_scoped_release nogil; doWait(); }
+	else doWait();
+}
+
+void PyHookQueue::waitScene(const Scene* scene){
+	// live commands from an unfinished step (e.g. interrupted by an exception) would never be released otherwise
+	stepDone(scene);
+	waitPending(scene,pending);
+}
+void PyHookQueue::waitLive(const Scene* scene){
+	// commands held from an earlier step which did not finish (exception) are released now
+	stepDone(scene);
+	waitPending(scene,pendingLive);
+}
+
+void PyHookQueue::loop(){
+	{
+		std::scoped_lock<std::mutex> l(mutex);
+		workerId=std::this_thread::get_id();
+	}
+	while(true){
+		std::deque<Item> batch;
+		{
+			std::unique_lock<std::mutex> l(mutex);
+			cvItems.wait(l,[this]{ return !items.empty(); });
+			batch.swap(items);
+			busy=true;
+		}
+		{
+			// whole batch under one GIL acquisition; the scene loop mutex is not locked, the step loop runs meanwhile
+			// (except for live commands, which the next step waits for)
+			GilLock lock;
+			for(Item& it: batch){
+				try{
+					py::dict snap;
+					snap["step"]=it.step; snap["time"]=it.time; snap["dt"]=it.dt;
+					py::dict energy;
+					for(const auto& e: it.energy) energy[e.first.c_str()]=e.second;
+					snap["energy"]=energy;
+					runPy_compiled(it.callerId,it.command,it.scene.get(),it.engine.get(),it.field,snap);
+				} catch(std::exception& e){
+					LOG_ERROR("{}",e.what());
+					std::scoped_lock<std::mutex> l(mutex);
+					if(error.empty()) error=e.what();
+				}
+				{
+					std::scoped_lock<std::mutex> l(mutex);
+					const Scene* scene=it.scene.get();
+					if(--pending[scene]<=0) pending.erase(scene);
+					if(it.live && --pendingLive[scene]<=0) pendingLive.erase(scene);
+				}
+				cvIdle.notify_all();
+				// release references while still holding the GIL
+				it.scene.reset(); it.engine.reset(); it.field.reset();
+			}
+		}
+		{
+			std::scoped_lock<std::mutex> l(mutex);
+			busy=false;
+		}
+		cvIdle.notify_all();
+	}
+}
+
 
 void ParallelEngine::setField(){
 	for(vector<shared_ptr<Engine>>& grp: slaves){
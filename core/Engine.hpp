@@ -7,6 +7,10 @@
 #include<woo/lib/base/Logging.hpp>
 
 #include<stdexcept>
+#include<deque>
+#include<map>
+#include<condition_variable>
+#include<thread>
 
 #include<woo/lib/pyutil/except.hpp>
 #include<woo/lib/pyutil/converters.hpp>
@@ -55,9 +59,16 @@ class Engine: public Object {
 		// run given command, with some variables are set automatically
 		// TODO: move outside of Engine, it does not depend on it really
 		static void runPy_generic(const string& callerId, const string& command, Scene* scene_=nullptr, Engine* engine_=nullptr, const shared_ptr<Field>& field_=shared_ptr<Field>());
+		// return compiled code object for given command; compiled only the first time it is seen (GIL must be held)
+		static py::object compiledPy(const string& callerId, const string& command);
 
 		// convenience function to call runPy_generic using Engine's internal data
 		void runPy(const string& callerId, const string&);
+		// queue the command to be run by the python worker thread (PyHookQueue), without waiting for the GIL
+		// with live, the command runs after the current step and the next step waits for it
+		void runPyQueued(const string& callerId, const string&, bool live=false);
+		// block until all queued commands have finished (releases the GIL if held)
+		static void waitQueuedPy();
 
 		// get the scene object from the raw pointer
 		py::object py_getScene();
@@ -97,6 +108,7 @@ class Engine: public Object {
 		.add_property("field",&Engine::field_get,&Engine::field_set,"Field to run this engine on; if unassigned, or set to *None*, automatic field selection is triggered.") \
 		.add_property_readonly("scene",&Engine::py_getScene,"Get associated scene object, if any (this function is dangerous in some corner cases, as it has to use raw pointer).") \
 		.def("critDt",&Engine::critDt,"Return critical (maximum numerically stable) timestep for this engine. By default returns infinity (no critical timestep) but derived engines may override this function.") \
+		.def_static("waitQueuedPy",&Engine::waitQueuedPy,"Block until all python commands queued for the python worker thread (such as :obj:`PyRunner` with :obj:`~PyRunner.queued`) have finished.") \
 		; \
 		woo::converters_cxxVector_pyList_2way<shared_ptr<Engine>>(mod);
 
@@ -104,6 +116,58 @@ class Engine: public Object {
 };
 WOO_REGISTER_OBJECT(Engine);
 
+/*
+Python commands run by a dedicated worker thread, so that the engine loop does not block on the GIL
+(contended by the UI and IPython) when hooks fire. Commands queued within one step are run in one batch,
+under a single GIL acquisition, concurrently with the following steps; they get the snapshot of scene values
+(step, time, dt, energies) from when they were queued. The worker never locks Scene::engineLoopMutex,
+so commands may use Scene.paused().
+
+Live commands (which need the scene itself) are held back until the step in which they were queued
+has finished (Scene::doOneStep calls stepDone), and the next step waits for them (waitLive).
+
+Exceptions are stored and re-thrown in the engine thread by the next push, or by Scene.wait / Engine.waitQueuedPy.
+*/
+class PyHookQueue{
+	struct Item{
+		string callerId, command;
+		shared_ptr<Scene> scene; shared_ptr<Engine> engine; shared_ptr<Field> field;
+		bool live;
+		// snapshot of scene values at the moment the command was queued
+		long step; Real time, dt;
+		vector<std::pair<string,Real>> energy;
+	};
+	std::mutex mutex;
+	std::condition_variable cvItems, cvIdle;
+	std::deque<Item> items;
+	// live commands waiting for the end of the step
+	std::deque<Item> held;
+	// number of queued or running commands for each scene (all, and live only)
+	std::map<const Scene*,long> pending, pendingLive;
+	bool busy=false;
+	string error;
+	bool started=false;
+	std::thread::id workerId;
+	void loop();
+	void waitPending(const Scene* scene, std::map<const Scene*,long>& counts);
+	PyHookQueue(){}
+	public:
+	// the instance is never destroyed, its thread is detached and sleeps when there is nothing to do
+	static PyHookQueue& instance();
+	void push(const string& callerId, const string& command, Scene* scene, Engine* engine, const shared_ptr<Field>& field, bool live);
+	// release live commands held for scene until the end of its step
+	void stepDone(const Scene* scene);
+	// wait until all commands have finished
+	void wait();
+	// wait until commands queued for scene have finished (releases the GIL if held)
+	void waitScene(const Scene* scene);
+	// wait until live commands queued for scene have finished (releases the GIL if held)
+	void waitLive(const Scene* scene);
+	// throw exception from a failed command, if there was any
+	void rethrow();
+	WOO_DECL_LOGGER;
+};
+
 class ParallelEngine: public Engine {
 	public:
 		typedef vector<vector<shared_ptr<Engine> > > slaveContainer;
@@ -165,14 +229,16 @@ WOO_REGISTER_OBJECT(PeriodicEngine);
 
 
 struct PyRunner: public PeriodicEngine{
-	virtual void run() override{ Engine::runPy("PyRunner",command); }
+	virtual void run() override{ if(queued) Engine::runPyQueued("PyRunner",command,live); else Engine::runPy("PyRunner",command); }
 	// to give command without saying 'command=...'
 	virtual bool needsField() override { return false; }
 	virtual void pyHandleCustomCtorArgs(py::args_& t, py::kwargs& d) override;
 	#define woo_core_PyRunner__CLASS_BASE_DOC_ATTRS \
 		PyRunner,PeriodicEngine, \
 		"Execute a python command periodically, with defined (and adjustable) periodicity. See :obj:`PeriodicEngine` documentation for details.\n\n.. admonition:: Special constructor\n\n   *command* can be given as first unnamed string argument (``PyRunner('foo()')``), stepPeriod as unnamed integer argument (``PyRunner('foo()',100)`` or ``PyRunner(100,'foo()')``).", \
-		((string,command,"",,"Command to be run by python interpreter. Not run if empty."))
+		((string,command,"",,"Command to be run by python interpreter. Not run if empty.")) \
+		((bool,queued,false,,"Do not run the command inside the engine loop, but queue it for the python worker thread, so that the engine thread never acquires the GIL for it. The command runs concurrently with the following steps and should only read the ``snapshot`` dict (``step``, ``time``, ``dt`` and ``energy`` from when the command was queued) or things which do not change while the simulation runs; it may use :obj:`Scene.paused` to access the scene consistently. Several commands queued in one step share one GIL acquisition. Exceptions are reported by the next queued command, by :obj:`Scene.wait` or by :obj:`Engine.waitQueuedPy`, which waits for queued commands to finish.")) \
+		((bool,live,false,,"With :obj:`queued`, the command needs the scene itself rather than the snapshot: it runs when the step in which it was queued has finished, and the next step waits for it. This serializes the command with the simulation (the engine thread still does not acquire the GIL)."))
 	WOO_DECL__CLASS_BASE_DOC_ATTRS(woo_core_PyRunner__CLASS_BASE_DOC_ATTRS);
 };
 WOO_REGISTER_OBJECT(PyRunner);
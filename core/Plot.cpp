@@ -4,18 +4,260 @@
 #include<woo/lib/pyutil/gil.hpp>
 
 
-WOO_PLUGIN(core,(SceneAttachedObject)(SceneCtrl)(Plot));
+WOO_PLUGIN(core,(SceneAttachedObject)(SceneCtrl)(PlotData)(Plot));
 WOO_IMPL__CLASS_BASE_DOC_ATTRS_PY(woo_core_SceneAttachedObject__CLASS_BASE_DOC_ATRRS_PY);
 shared_ptr<Scene> SceneAttachedObject::getScene_py(){ return scene.lock(); }
 WOO_IMPL__CLASS_BASE_DOC(woo_core_SceneCtrl__CLASS_BASE_DOC);
+WOO_IMPL__CLASS_BASE_DOC_ATTRS_PY(woo_core_PlotData__CLASS_BASE_DOC_ATTRS_PY);
 WOO_IMPL__CLASS_BASE_DOC_ATTRS_PY(woo_core_Plot__CLASS_BASE_DOC_ATTRS_PY);
 
 void Plot::_resetPyObjects(){
 	unique_ptr<GilLock> gil;
 	if(Py_IsInitialized()){ gil=unique_ptr<GilLock>(new GilLock); }
-	data=imgData=plots=labels=xylabels=py::dict();
+	imgData=plots=labels=xylabels=py::dict();
 	legendLoc=py::tuple();
 	currLineRefs=py::none();
 }
 
 
+
+void PlotData::reserve(size_t n){
+	if(n<=capacity) return;
+	const size_t ch=max(chunk,1);
+	// grow geometrically, so that the amortized cost of copying is constant per row
+	size_t cap=max(n,capacity+capacity/2);
+	cap=ch*((cap+ch-1)/ch);
+	for(auto& c: cols){
+		// new buffer, old one might be still referenced from python
+		auto c2=make_shared<Buffer>(cap,NaN);
+		std::copy(c->begin(),c->begin()+nRows,c2->begin());
+		c=c2;
+	}
+	capacity=cap;
+}
+
+int PlotData::addColumn(const string& name){
+	int ix=colIx(name);
+	if(ix>=0) return ix;
+	cols.push_back(make_shared<Buffer>(capacity,NaN));
+	names.push_back(name);
+	ix=names.size()-1;
+	name2ix[name]=ix;
+	return ix;
+}
+
+void PlotData::addRow(const vector<string>& nn, const vector<Real>& vals){
+	assert(nn.size()==vals.size());
+	reserve(nRows+1);
+	// columns not given are nan; the buffer might hold old values after truncation
+	for(auto& c: cols) (*c)[nRows]=NaN;
+	for(size_t i=0; i<nn.size(); i++) (*cols[addColumn(nn[i])])[nRows]=vals[i];
+	nRows++;
+}
+
+void PlotData::clear(){
+	names.clear(); cols.clear(); name2ix.clear();
+	nRows=capacity=0;
+}
+
+void PlotData::reverse(){
+	for(auto& c: cols){
+		auto c2=make_shared<Buffer>(capacity,NaN);
+		std::reverse_copy(c->begin(),c->begin()+nRows,c2->begin());
+		c=c2;
+	}
+}
+
+void PlotData::resize(size_t n, bool fillLast){
+	if(n<=nRows){ nRows=n; return; }
+	reserve(n);
+	for(auto& c: cols) std::fill(c->begin()+nRows,c->begin()+n,(fillLast && nRows>0)?(*c)[nRows-1]:NaN);
+	nRows=n;
+}
+
+py::array_t<Real> PlotData::column_py(const string& name) const {
+	int ix=colIx(name);
+	if(ix<0) woo::KeyError(name);
+	// the capsule keeps the buffer alive as long as the array exists
+	auto* keep=new shared_ptr<Buffer>(cols[ix]);
+	py::capsule base(keep,[](void* p){ delete (shared_ptr<Buffer>*)p; });
+	py::array_t<Real> ret(nRows,(*keep)->data(),base);
+	ret.attr("setflags")(py::arg("write")=false);
+	return ret;
+}
+
+void PlotData::setColumn_py(const string& name, py::array_t<Real,py::array::c_style|py::array::forcecast> arr){
+	if(arr.ndim()!=1) woo::ValueError("PlotData: column must be 1d sequence (not "+to_string(arr.ndim())+"d).");
+	const size_t n=arr.shape(0);
+	// when there are no data yet, the number of rows is set from the new column
+	if(nRows==0) resize(n,/*fillLast*/false);
+	if(n!=nRows) woo::ValueError("PlotData: column '"+name+"' has "+to_string(n)+" items, "+to_string(nRows)+" expected.");
+	Buffer& c=*cols[addColumn(name)];
+	std::copy(arr.data(),arr.data()+n,c.begin());
+}
+
+void PlotData::delColumn_py(const string& name){
+	int ix=colIx(name);
+	if(ix<0) woo::KeyError(name);
+	names.erase(names.begin()+ix); cols.erase(cols.begin()+ix);
+	name2ix.clear();
+	for(size_t i=0; i<names.size(); i++) name2ix[names[i]]=i;
+}
+
+py::list PlotData::keys_py() const { py::list ret; for(const auto& n: names) ret.append(n); return ret; }
+py::list PlotData::values_py() const { py::list ret; for(const auto& n: names) ret.append(column_py(n)); return ret; }
+py::list PlotData::items_py() const { py::list ret; for(const auto& n: names) ret.append(py::make_tuple(n,column_py(n))); return ret; }
+py::object PlotData::iter_py() const { return py::iter(keys_py()); }
+
+py::dict PlotData::asDict() const {
+	py::dict ret;
+	for(size_t i=0; i<names.size(); i++){
+		py::list l;
+		for(size_t r=0; r<nRows; r++) l.append((*cols[i])[r]);
+		ret[py::str(names[i])]=l;
+	}
+	return ret;
+}
+
+// numbers (including numpy scalars and bool) and None (nan)
+static Real plotValue(const string& name, const py::handle& v){
+	if(v.is_none()) return NaN;
+	try{ return py::cast<Real>(v); }
+	catch(py::cast_error&){ woo::ValueError("PlotData: '"+name+"' is a "+py::cast<string>(v.get_type().attr("__name__"))+"; only numbers (or None for nan) can be stored."); }
+	return NaN; // not reached
+}
+
+void PlotData::fromDict(const py::dict& d){
+	clear();
+	for(const auto& item: d){
+		const string name=py::cast<string>(item.first);
+		vector<Real> vv;
+		for(const auto& v: item.second) vv.push_back(plotValue(name,v));
+		// the first column sets the number of rows
+		if(names.empty()) resize(vv.size(),/*fillLast*/false);
+		if(vv.size()!=nRows) woo::ValueError("PlotData: column '"+name+"' has "+to_string(vv.size())+" items, "+to_string(nRows)+" expected.");
+		std::copy(vv.begin(),vv.end(),cols[addColumn(name)]->begin());
+	}
+}
+
+void PlotData::pyHandleCustomCtorArgs(py::args_& t, py::kwargs& d){
+	if(py::len(t)==0) return;
+	if(py::len(t)>1 || !py::isinstance<py::dict>(t[0])) woo::TypeError("PlotData: the only non-keyword argument must be dict of columns.");
+	fromDict(py::cast<py::dict>(t[0]));
+	t=py::tuple();
+}
+
+void PlotData::addRow_py(const py::dict& d){
+	vector<string> nn; vector<Real> vv;
+	nn.reserve(d.size()); vv.reserve(d.size());
+	auto add=[&nn,&vv](const string& n, Real v){ nn.push_back(n); vv.push_back(v); };
+	// component suffixes, with the separator
+	const char* v6[]={"_xx","_yy","_zz","_yz","_zx","_xy"};
+	const char* xyz[]={"_x","_y","_z"};
+	for(const auto& item: d){
+		const string name=py::cast<string>(item.first);
+		const py::handle& v=item.second;
+		// check exact types first, since minieigen types are implicitly convertible from sequences
+		if(PyFloat_Check(v.ptr()) || PyLong_Check(v.ptr())){ add(name,py::cast<Real>(v)); continue; }
+		if(v.is_none()){ add(name,NaN); continue; }
+		if(py::isinstance<Vector3r>(v)){ const auto& x=py::cast<Vector3r>(v); for(int i:{0,1,2}) add(name+xyz[i],x[i]); add(name+"_norm",x.norm()); continue; }
+		if(py::isinstance<Vector2r>(v)){ const auto& x=py::cast<Vector2r>(v); for(int i:{0,1}) add(name+xyz[i],x[i]); add(name+"_norm",x.norm()); continue; }
+		if(py::isinstance<Vector6r>(v)){ const auto& x=py::cast<Vector6r>(v); for(int i=0; i<6; i++) add(name+v6[i],x[i]); add(name+"_norm",x.norm()); continue; }
+		if(py::isinstance<Matrix3r>(v)){ const auto& x=py::cast<Matrix3r>(v); for(int i:{0,1,2}) for(int j:{0,1,2}) add(name+"_"+xyz[i][1]+xyz[j][1],x(i,j)); continue; }
+		if(py::isinstance<Vector3i>(v)){ const auto& x=py::cast<Vector3i>(v); for(int i:{0,1,2}) add(name+xyz[i],x[i]); continue; }
+		if(py::isinstance<Vector2i>(v)){ const auto& x=py::cast<Vector2i>(v); for(int i:{0,1}) add(name+xyz[i],x[i]); continue; }
+		if(py::hasattr(v,"__len__")) woo::ValueError("plot.addData given unhandled sequence type for '"+name+"' (is a "+py::cast<string>(v.get_type().attr("__name__"))+", must be number or Vector2/Vector3/Vector6/Matrix3/Vector2i/Vector3i).");
+		// other scalar types (numpy scalars, bool, ...)
+		add(name,plotValue(name,v));
+	}
+	addRow(nn,vv);
+}
+
+vector<Real> PlotData::flat() const {
+	vector<Real> ret(names.size()*nRows);
+	for(size_t i=0; i<cols.size(); i++) std::copy(cols[i]->begin(),cols[i]->begin()+nRows,ret.begin()+i*nRows);
+	return ret;
+}
+
+void PlotData::preSave(PlotData&){
+	_names=names;
+	_flat=flat();
+}
+
+void PlotData::postLoad(PlotData&, void* addr){
+	if(addr) return;
+	// nothing was loaded (construction, or updateAttrs without _names and _flat): keep current data
+	if(_names.empty() && _flat.empty()){
+		// nRows might have been set along with other attributes; make sure the buffers hold all rows
+		if(nRows>capacity){ const size_t n=nRows; nRows=capacity; resize(n,/*fillLast*/false); }
+		return;
+	}
+	if(_flat.size()!=_names.size()*nRows) throw std::runtime_error("PlotData: inconsistent data sizes ("+to_string(_flat.size())+" values, "+to_string(_names.size())+" columns, "+to_string(nRows)+" rows).");
+	const size_t n=nRows;
+	clear();
+	reserve(n);
+	for(size_t i=0; i<_names.size(); i++){
+		int ix=addColumn(_names[i]);
+		std::copy(_flat.begin()+i*n,_flat.begin()+(i+1)*n,cols[ix]->begin());
+	}
+	nRows=n;
+	_names.clear(); _flat.clear();
+}
+
+#ifdef WOO_HDF5
+
+#include<H5Cpp.h>
+
+// H5::Exception does not derive from std::exception; convert to std::runtime_error
+static void rethrowH5(H5::Exception& e){
+	std::ostringstream oss;
+	e.walkErrorStack(H5E_WALK_DOWNWARD,[](unsigned int n, const H5E_error_t* err, void* oss_)->herr_t{ *((std::ostringstream*)oss_)<<"  #"<<n<<" "<<err->func_name<<": "<<err->desc<<endl; return  (herr_t)0; },/*client_data*/(void*)&oss);
+	throw std::runtime_error("HDF5 exception in "+e.getFuncName()+": "+e.getDetailMsg()+":\n"+oss.str());
+}
+
+void PlotData::saveHdf5(const string& out, const string& group, int deflate) const {
+	H5::Exception::dontPrint();
+	try{
+		H5::H5File h5file;
+		if(filesystem::exists(out)) h5file=H5::H5File(out,H5F_ACC_RDWR);
+		else h5file=H5::H5File(out,H5F_ACC_TRUNC);
+		H5::Group grp=h5file.createGroup(group);
+		hsize_t dim[]={nRows};
+		H5::DataSpace space(1,dim);
+		H5::DSetCreatPropList plist;
+		if(nRows>0){
+			// chunk may not be larger than the dataset
+			hsize_t chunkdim[]={min((hsize_t)max(chunk,1),(hsize_t)nRows)};
+			plist.setChunk(1,chunkdim);
+			plist.setDeflate(min(max(deflate,0),9));
+		}
+		for(size_t i=0; i<names.size(); i++){
+			H5::DataSet ds=grp.createDataSet(names[i],H5::PredType::NATIVE_DOUBLE,space,plist);
+			ds.write(cols[i]->data(),H5::PredType::NATIVE_DOUBLE);
+		}
+		grp.close();
+		h5file.close();
+	} catch(H5::Exception& e){ rethrowH5(e); }
+}
+
+void PlotData::loadHdf5(const string& in, const string& group){
+	H5::Exception::dontPrint();
+	try{
+		H5::H5File h5file(in,H5F_ACC_RDONLY);
+		H5::Group grp=h5file.openGroup(group);
+		clear();
+		for(hsize_t i=0; i<grp.getNumObjs(); i++){
+			const string name=grp.getObjnameByIdx(i);
+			H5::DataSet ds=grp.openDataSet(name);
+			H5::DataSpace space=ds.getSpace();
+			if(space.getSimpleExtentNdims()!=1) throw std::runtime_error("PlotData.loadHdf5: dataset "+group+"/"+name+" is not 1-dimensional.");
+			hsize_t dim[1];
+			space.getSimpleExtentDims(dim);
+			if(i==0) resize(dim[0],/*fillLast*/false);
+			else if(dim[0]!=nRows) throw std::runtime_error("PlotData.loadHdf5: dataset "+group+"/"+name+" has "+to_string(dim[0])+" rows, "+to_string(nRows)+" expected.");
+			ds.read(cols[addColumn(name)]->data(),H5::PredType::NATIVE_DOUBLE);
+		}
+	} catch(H5::Exception& e){ rethrowH5(e); }
+}
+
+#endif /* WOO_HDF5 */
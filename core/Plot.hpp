@@ -1,5 +1,6 @@
 #pragma once
 #include<woo/lib/object/Object.hpp>
+#include<pybind11/numpy.h>
 
 struct Scene;
 
@@ -23,6 +24,89 @@ struct SceneCtrl: public SceneAttachedObject{
 WOO_REGISTER_OBJECT(SceneCtrl);
 
 namespace woo{
+	/* Columnar storage for plot data: each column is contiguous array of doubles, all columns have nRows items.
+	Buffers are allocated with spare capacity (multiple of chunk); when it runs out, a new buffer is allocated and
+	data are copied over, the old buffer being released once the last numpy view referencing it is gone.
+	*/
+	struct PlotData: public Object{
+		typedef vector<Real> Buffer;
+		// grow all columns so that they can hold at least n rows
+		void reserve(size_t n);
+		// append row; nan for columns not given; new columns are created as necessary (padded with nan)
+		void addRow(const vector<string>& names, const vector<Real>& vals);
+		// find column index, or -1
+		int colIx(const string& name) const { auto I=name2ix.find(name); return I==name2ix.end()?-1:I->second; }
+		// create new column (nan-filled) if it does not exist yet; return its index
+		int addColumn(const string& name);
+		void clear();
+		void reverse();
+		void resize(size_t n, bool fillLast);
+		py::array_t<Real> column_py(const string& name) const;
+		void setColumn_py(const string& name, py::array_t<Real,py::array::c_style|py::array::forcecast> arr);
+		void delColumn_py(const string& name);
+		bool contains_py(const string& name) const { return colIx(name)>=0; }
+		size_t len_py() const { return names.size(); }
+		py::list keys_py() const;
+		py::list values_py() const;
+		py::list items_py() const;
+		py::object iter_py() const;
+		py::dict asDict() const;
+		void addColumns_py(const vector<string>& nn){ for(const auto& n: nn) addColumn(n); }
+		void addRow_py(const py::dict& d);
+		// replace data with columns from dict of sequences (as Plot.data used to be)
+		void fromDict(const py::dict& d);
+		void pyHandleCustomCtorArgs(py::args_& t, py::kwargs& d) override;
+		// concatenated columns, as stored in _flat
+		vector<Real> flat() const;
+		#ifdef WOO_HDF5
+			void saveHdf5(const string& out, const string& group, int deflate) const;
+			void loadHdf5(const string& in, const string& group);
+		#endif
+		void preSave(PlotData&);
+		void postSave(PlotData&){ _names.clear(); _flat.clear(); }
+		void postLoad(PlotData&, void* addr);
+		vector<string> names;
+		vector<shared_ptr<Buffer>> cols;
+		std::map<string,int> name2ix;
+		size_t capacity=0;
+		#define woo_core_PlotData__CLASS_BASE_DOC_ATTRS_PY \
+			PlotData,Object,"Columnar storage of plot data (see :obj:`Plot.data`); behaves like a dictionary mapping column names to 1d arrays, all of them having :obj:`nRows` items. Values are stored as double-precision floats. It can be constructed from dictionary of sequences (``PlotData({'a':[1,2],'b':[3,None]})``, where ``None`` is nan), which is also converted automatically when assigned to :obj:`Plot.data`.\n\nArrays returned by indexing (``data['name']``) are read-only numpy views of the internal buffer (no copy is made), which remain valid when new rows are added, but do not grow with them; they should be re-fetched to see new data.\n\nData can be saved as part of the scene, in compressed binary format with :obj:`woo.core.Object.dump` (e.g. ``S.plot.data.dump('data.bin.gz')``), as text (``format='expr'`` or ``'json'``) or, when compiled with HDF5 support, in HDF5 files with :obj:`saveHdf5`.", \
+			((size_t,nRows,0,AttrTrait<Attr::readonly>(),"Number of rows.")) \
+			((int,chunk,1024,,"Allocation granularity (in rows) for column buffers; buffers grow by at least half of their current capacity, rounded up to a multiple of *chunk*.")) \
+			((vector<string>,_names,,AttrTrait<Attr::readonly>().noGui(),"Column names, for serialization and dumps; reading it from python returns current column names.")) \
+			((vector<Real>,_flat,,AttrTrait<Attr::readonly>().noGui(),"Column data (concatenated columns), for serialization and dumps; reading it from python returns current data.")) \
+			,/*py*/ \
+			/* replace getters of _names and _flat, which are only filled when saving */ \
+			.add_property_readonly("_names",[](const PlotData& d){ return d.names; }) \
+			.add_property_readonly("_flat",&PlotData::flat) \
+			.def("__len__",&PlotData::len_py,"Number of columns.") \
+			.def("__getitem__",&PlotData::column_py,"Return read-only numpy view of the column with given name.") \
+			.def("__setitem__",&PlotData::setColumn_py,"Replace (or create) column; the sequence must have :obj:`nRows` items, unless the storage is empty, in which case it sets :obj:`nRows`.") \
+			.def("__delitem__",&PlotData::delColumn_py,"Delete column.") \
+			.def("__contains__",&PlotData::contains_py,"Query whether a column exists.") \
+			.def("__iter__",&PlotData::iter_py,"Iterate over column names.") \
+			.def("keys",&PlotData::keys_py,"Return column names.") \
+			.def("values",&PlotData::values_py,"Return list of column views.") \
+			.def("items",&PlotData::items_py,"Return list of (name,column view) tuples.") \
+			.def("asDict",&PlotData::asDict,"Return copy of all data as dictionary of lists.") \
+			.def("addRow",&PlotData::addRow_py,WOO_PY_ARGS(py::arg("d")),"Append row from dictionary of numbers (``None`` is nan), or of Vector2, Vector3, Vector6, Matrix3, Vector2i, Vector3i, which are expanded to columns for components (see :obj:`woo.plot.addData`); columns not given are nan, new columns are padded with nan. Other values (such as strings) cannot be stored and raise ValueError.") \
+			.def("addColumns",&PlotData::addColumns_py,WOO_PY_ARGS(py::arg("names")),"Add nan-filled columns which don't exist yet.") \
+			.def("clear",&PlotData::clear,"Remove all data.") \
+			.def("reverse",&PlotData::reverse,"Reverse order of rows.") \
+			.def("resize",&PlotData::resize,WOO_PY_ARGS(py::arg("n"),py::arg("fillLast")=false),"Truncate or extend all columns to *n* rows; new rows are nan, or repeat the last value with *fillLast*.") \
+			.def("__reduce__",[](py::object self){ return py::make_tuple(self.get_type(),py::make_tuple(self.attr("asDict")())); },"Pickle as dictionary of columns (see :obj:`asDict`).") \
+			WOO_PLOTDATA_HDF5_PY \
+			; py::implicitly_convertible<py::dict,PlotData>()
+		#ifdef WOO_HDF5
+			#define WOO_PLOTDATA_HDF5_PY \
+				.def("saveHdf5",&PlotData::saveHdf5,WOO_PY_ARGS(py::arg("out"),py::arg("group")="plotData",py::arg("deflate")=4),"Save data to HDF5 file *out* (opened for writing if it exists), as 1d datasets under *group*; the group must not exist yet.") \
+				.def("loadHdf5",&PlotData::loadHdf5,WOO_PY_ARGS(py::arg("in"),py::arg("group")="plotData"),"Replace current data with those from HDF5 file *in* (as written by :obj:`saveHdf5`).")
+		#else
+			#define WOO_PLOTDATA_HDF5_PY
+		#endif
+		WOO_DECL__CLASS_BASE_DOC_ATTRS_PY(woo_core_PlotData__CLASS_BASE_DOC_ATTRS_PY);
+	};
+
 	struct Plot: public SceneAttachedObject{
 		void _resetPyObjects(); // called at regular shutdown (see py/system.py:setExitHandlers)
 		#define woo_core_Plot__CLASS_BASE_DOC_ATTRS_PY \
@@ -30,7 +114,7 @@ namespace woo{
 			Plot,SceneAttachedObject,"Storage for plots updated during simulation.", \
 			/* attrs */ \
 			/* since Scene.plot is noGui, we don't have to specify noGui() here for attributes (there are no handlers for dicts etc in the gui code) */ \
-			((py::dict,data,,,"Global dictionary containing all data values, common for all plots, in the form {'name':[value,...],...}. Data should be added using plot.addData function. All [value,...] columns have the same length, they are padded with NaN if unspecified.")) \
+			((shared_ptr<PlotData>,data,make_shared<PlotData>(),,"Data values, common for all plots, stored in columns (see :obj:`PlotData`). Data should be added using plot.addData function. All columns have the same length, they are padded with NaN if unspecified. Dictionary of sequences (as used by older versions) can be assigned and is converted to :obj:`PlotData`.")) \
 			((py::dict,imgData,,,"Dictionary containing lists of strings, which have the meaning of images corresponding to respective :obj:`woo.plot.data` rows. See :obj:`woo.plot.plots` on how to plot images.")) \
 			((py::dict,plots,,,"dictionary x-name -> (yspec,...), where yspec is either y-name or (y-name,'line-specification'). If ``(yspec,...)`` is ``None``, then the plot has meaning of image, which will be taken from respective field of :obj:`woo.plot.imgData`.")) \
 			((py::dict,labels,,,"Dictionary converting names in data to human-readable names (TeX names, for instance); if a variable is not specified, it is left untranslated.")) \
@@ -45,4 +129,5 @@ namespace woo{
 	};
 };
 // must be without woo:: namespace
+WOO_REGISTER_OBJECT(PlotData);
 WOO_REGISTER_OBJECT(Plot);
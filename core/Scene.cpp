@@ -63,10 +63,17 @@ void Scene::pyOne(){
 }
 
 void Scene::pyWait(){
-	if(!running()) return;
+	// python commands queued by the simulation should be finished as well (the GIL is released while waiting)
+	if(!running()){
+		PyHookQueue::instance().waitScene(this);
+		PyHookQueue::instance().rethrow();
+		return;
+	}
 	Py_BEGIN_ALLOW_THREADS;
 		while(running() || ((!subStepping)&&(subStep!=SUBSTEP_INIT))) std::this_thread::sleep_for(std::chrono::milliseconds(40));
 	Py_END_ALLOW_THREADS;
+	PyHookQueue::instance().waitScene(this);
+	PyHookQueue::instance().rethrow();
 	// handle possible exception: reset it and rethrow
 	if(!except) return;
 	std::exception e(*except);
@@ -360,6 +367,8 @@ void Scene::doOneStep(){
 				std::this_thread::sleep_for(std::chrono::milliseconds(100));
 		}
 	#endif
+	// live python commands queued in the previous step (PyRunner.live) must finish before the scene changes again
+	PyHookQueue::instance().waitLive(this);
 	std::scoped_lock<std::timed_mutex> lock(engineLoopMutex);
 
 	if(runInternalConsistencyChecks){
@@ -454,4 +463,6 @@ void Scene::doOneStep(){
 		}
 		subStep++; // if not substepping, this will make subStep=-2+1=-1, which is what we want
 	}
+	// the step is finished, live python commands queued during the step may run now
+	if(subStep==SUBSTEP_INIT) PyHookQueue::instance().stepDone(this);
 }
@@ -1,4 +1,5 @@
 #include<woo/core/Test.hpp>
+#include<woo/lib/base/KdTree.hpp>
 
 WOO_IMPL__CLASS_BASE_DOC_ATTRS_CTOR_PY(woo_core_WooTestClass__CLASS_BASE_DOC_ATTRS_CTOR_PY);
 WOO_IMPL__CLASS_BASE_DOC_ATTRS(woo_core_WooTestPeriodicEngine__CLASS_BASE_DOC_ATTRS);
@@ -74,3 +75,14 @@ void WooTestClass::arr3d_set(const Vector3i& shape, const vector<Real>& data){
 	for(int i=0; i<shape[0]; i++) for(int j=0; j<shape[1]; j++) for(int k=0; k<shape[2]; k++) arr3d[i][j][k]=data[i*shape[0]*shape[1]+j*shape[1]+k];
 }
 
+vector<int> WooTestClass::kdRadiusSearch(const vector<Vector3r>& pts, const Vector3r& p, Real radius, int leafSize){
+	KdTree tree(leafSize); tree.build(pts);
+	vector<int> ret; tree.radiusSearch(p,radius,ret);
+	return ret;
+}
+
+vector<int> WooTestClass::kdKnnSearch(const vector<Vector3r>& pts, const Vector3r& p, int k, int leafSize){
+	KdTree tree(leafSize); tree.build(pts);
+	vector<int> ret; tree.knnSearch(p,k,ret);
+	return ret;
+}
@@ -18,6 +18,8 @@ namespace woo{
 		typedef boost::multi_array<Real,3> boost_multi_array_real_3;
 		py::object arr3d_py_get();
 		void arr3d_set(const Vector3i& shape, const vector<Real>& data);
+		static vector<int> kdRadiusSearch(const vector<Vector3r>& pts, const Vector3r& p, Real radius, int leafSize);
+		static vector<int> kdKnnSearch(const vector<Vector3r>& pts, const Vector3r& p, int k, int leafSize);
 		#define woo_core_WooTestClass__CLASS_BASE_DOC_ATTRS_CTOR_PY \
 			WooTestClass,Object,"This class serves to test various functionalities; it also includes all possible units, which thus get registered in woo", \
 			/* enumerate all units here: */ \
@@ -66,6 +68,8 @@ namespace woo{
 				.def("aaccuWriteThreads",&WooTestClass::aaccuWriteThreads,WOO_PY_ARGS(py::arg("index"),py::arg("cycleData")),"Assign a single line in the array accumulator, assigning number from *cycleData* in parallel in each thread.") \
 				.def("arr3d_set",&WooTestClass::arr3d_set,WOO_PY_ARGS(py::arg("shape"),py::arg("data")),"Set arr3d to have *shape* and fill it with *data* (must have the corresponding number of elements).") \
 				.add_property_readonly("arr3d",&WooTestClass::arr3d_py_get) \
+				.def_static("kdRadiusSearch",&WooTestClass::kdRadiusSearch,WOO_PY_ARGS(py::arg("pts"),py::arg("p"),py::arg("radius"),py::arg("leafSize")=10),"Build :obj:`KdTree` over *pts* and return indices of points within *radius* from *p*, in no particular order.") \
+				.def_static("kdKnnSearch",&WooTestClass::kdKnnSearch,WOO_PY_ARGS(py::arg("pts"),py::arg("p"),py::arg("k"),py::arg("leafSize")=10),"Build :obj:`KdTree` over *pts* and return indices of *k* points closest to *p*, sorted by increasing distance.") \
 				; \
 				_classObj.attr("postLoad_none")=(int)POSTLOAD_NONE; \
 				_classObj.attr("postLoad_ctor")=(int)POSTLOAD_CTOR; \
@@ -14,12 +14,13 @@ S.engines=woo.dem.DemField.minimalEngines(damping=.3)+[
 ]
 
 def recomputePorosity(S):
-    # this computes radical Delaunay tesselation and returns [(id,(x,y,z),porosity),...]
+    # this computes radical Delaunay tesselation and returns NumPy arrays (ids,positions,porosity)
     # this is what the tesselation looks like: http://math.lbl.gov/voro++/examples/
     # quite inefficient to be run periodically, this is just a showcase
-    poro=woo.triangulated.porosity(S.dem,box=box)
+    ids,pos,por=woo.triangulated.porosity(S.dem,box=box)
     # color particles by local porosity
-    for p in poro: S.dem.par[p[0]].shape.color=p[2]
+    for i,p in zip(ids,por): S.dem.par[int(i)].shape.color=p
+    return pos,por
 
 # generate particles
 S.one() 
@@ -32,7 +33,8 @@ woo.qt.View()
 
 # plot with matplotlib
 if 0:
-    xx,yy,zz,pp=[p[1][0] for p in poro],[p[1][1] for p in poro],[p[1][2] for p in poro],[p[2] for p in poro]
+    pos,pp=recomputePorosity(S)
+    xx,yy,zz=pos[:,0],pos[:,1],pos[:,2]
     import matplotlib.pyplot as plt
     import mpl_toolkits.mplot3d, matplotlib.lines
     fig=plt.figure()
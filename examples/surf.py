@@ -4,7 +4,9 @@ pre=woo.pre.depot.CylDepot(htDiam=(.1,.1),unbE=0.01)
 pre.model.mats[0].young=20000
 S=woo.master.scene=pre()
 S.run(wait=True)
-surf=woo.triangulated.surfParticleIdNormals(S.dem,box=((-.05,-.05,0),(.05,.05,.15)),r=.03)
+ids,normals=woo.triangulated.surfParticleIdNormals(S.dem,box=((-.05,-.05,0),(.05,.05,.15)),r=.03)
+surf={}
+for i,n in zip(ids,normals): surf.setdefault(int(i),[]).append(Vector3(n))
 S.gl.demField.shape='spheroids'
 S.gl.demField.shape2=False
 S.gl.demField.colorBy='Shape.color'
@@ -36,6 +36,17 @@ struct CompUtils{
 	// return barycentric coordinates of a point (must be in-plane) on a triangle in space
 	static Vector3r triangleBarycentrics(const Vector3r& x, const Vector3r& A, const Vector3r& B, const Vector3r& C);
 
+	// trilinear interpolation on a regular grid: for point with normalized coordinate n∈⟨0,1⟩³ inside the cell with lower corner ijk,
+	// fill 8 grid points at the cell corners and their weights (summing to 1); used by FlowAnalysis and EnergyTrackerGrid
+	static void trilinearWeights(const Vector3i& ijk, const Vector3r& n, Vector3i pts[8], Real weights[8]){
+		const Real& x(n[0]); const Real& y(n[1]); const Real& z(n[2]); Real X(1-x), Y(1-y), Z(1-z);
+		const int& i(ijk[0]); const int& j(ijk[1]); const int& k(ijk[2]); int I(i+1), J(j+1), K(k+1);
+		weights[0]=X*Y*Z; weights[1]=x*Y*Z; weights[2]=x*y*Z; weights[3]=X*y*Z;
+		weights[4]=X*Y*z; weights[5]=x*Y*z; weights[6]=x*y*z; weights[7]=X*y*z;
+		pts[0]=Vector3i(i,j,k); pts[1]=Vector3i(I,j,k); pts[2]=Vector3i(I,J,k); pts[3]=Vector3i(i,J,k);
+		pts[4]=Vector3i(i,j,K); pts[5]=Vector3i(I,j,K); pts[6]=Vector3i(I,J,K); pts[7]=Vector3i(i,J,K);
+	}
+
 	// convert cartesian coordinates to cylindrical
 	static Vector3r cart2cyl(const Vector3r& ca);
 	// convert cylindrical coordinates to cartesian
@@ -0,0 +1,104 @@
+#pragma once
+#include<woo/lib/base/Types.hpp>
+#include<woo/lib/base/Math.hpp>
+
+#include<algorithm>
+#include<numeric>
+#include<queue>
+
+/*
+Static kd-tree over a set of points, for radius and k-nearest-neighbor queries.
+
+The tree is built from all points at once (median split along the longest axis of each node's box);
+queries don't modify the tree, so they can be run from several threads simultaneously.
+Returned indices are positions of points in the vector passed to build().
+*/
+struct KdTree{
+	struct Node{
+		AlignedBox3r box;
+		int begin, end; // range in ix
+		int left=-1, right=-1; // children; negative for leaves
+	};
+	vector<Vector3r> pts;
+	vector<int> ix; // permutation of point indices, each node owning a contiguous range
+	vector<Node> nodes;
+	int leafSize;
+
+	KdTree(int _leafSize=10): leafSize(_leafSize){}
+	size_t size() const { return pts.size(); }
+	bool empty() const { return pts.empty(); }
+	void clear(){ pts.clear(); ix.clear(); nodes.clear(); }
+
+	void build(vector<Vector3r>&& _pts){ pts=std::move(_pts); rebuild(); }
+	void build(const vector<Vector3r>& _pts){ pts=_pts; rebuild(); }
+	void rebuild(){
+		ix.resize(pts.size());
+		std::iota(ix.begin(),ix.end(),0);
+		nodes.clear();
+		nodes.reserve(2*(pts.size()/max(1,leafSize)+1));
+		if(!pts.empty()) buildNode(0,pts.size());
+	}
+
+	// points with distance ≤ radius from p, in no particular order
+	void radiusSearch(const Vector3r& p, Real radius, vector<int>& ret) const {
+		ret.clear();
+		if(nodes.empty()) return;
+		const Real r2=pow2(radius);
+		// tree depth is ~log2(N/leafSize), and at most one pending node is kept per level
+		int stack[128]; int top=0;
+		stack[top++]=0;
+		while(top>0){
+			const Node& n=nodes[stack[--top]];
+			if(n.box.squaredExteriorDistance(p)>r2) continue;
+			if(n.left<0){
+				for(int i=n.begin; i<n.end; i++){ if((pts[ix[i]]-p).squaredNorm()<=r2) ret.push_back(ix[i]); }
+				continue;
+			}
+			stack[top++]=n.left; stack[top++]=n.right;
+		}
+	}
+
+	// k points closest to p, sorted by increasing distance
+	void knnSearch(const Vector3r& p, int k, vector<int>& ret) const {
+		ret.clear();
+		if(nodes.empty() || k<=0) return;
+		std::priority_queue<std::pair<Real,int>> best; // max-heap of (distSq,index)
+		knnNode(0,p,k,best);
+		ret.resize(best.size());
+		for(int i=(int)best.size()-1; i>=0; i--){ ret[i]=best.top().second; best.pop(); }
+	}
+
+	private:
+	int buildNode(int begin, int end){
+		int id=nodes.size();
+		nodes.push_back(Node());
+		AlignedBox3r box;
+		for(int i=begin; i<end; i++) box.extend(pts[ix[i]]);
+		nodes[id].box=box; nodes[id].begin=begin; nodes[id].end=end;
+		if(end-begin<=leafSize) return id;
+		int ax; box.sizes().maxCoeff(&ax);
+		int mid=begin+(end-begin)/2;
+		std::nth_element(ix.begin()+begin,ix.begin()+mid,ix.begin()+end,[&](int a, int b){ return pts[a][ax]<pts[b][ax]; });
+		// nodes may be reallocated by recursion, don't keep references
+		int l=buildNode(begin,mid);
+		int r=buildNode(mid,end);
+		nodes[id].left=l; nodes[id].right=r;
+		return id;
+	}
+	void knnNode(int id, const Vector3r& p, int k, std::priority_queue<std::pair<Real,int>>& best) const {
+		const Node& n=nodes[id];
+		if((int)best.size()==k && n.box.squaredExteriorDistance(p)>=best.top().first) return;
+		if(n.left<0){
+			for(int i=n.begin; i<n.end; i++){
+				Real d2=(pts[ix[i]]-p).squaredNorm();
+				if((int)best.size()<k) best.push(std::make_pair(d2,ix[i]));
+				else if(d2<best.top().first){ best.pop(); best.push(std::make_pair(d2,ix[i])); }
+			}
+			return;
+		}
+		// nearer child first, so that the other one is more likely to be pruned
+		Real dl=nodes[n.left].box.squaredExteriorDistance(p), dr=nodes[n.right].box.squaredExteriorDistance(p);
+		if(dl<=dr){ knnNode(n.left,p,k,best); knnNode(n.right,p,k,best); }
+		else { knnNode(n.right,p,k,best); knnNode(n.left,p,k,best); }
+	}
+};
@@ -226,6 +226,13 @@
 		ar & cereal::make_nvp("data",boost::serialization::make_array(m.data(),6*6));
 	}
 
+	// other fixed-size matrices (e.g. FEM element matrices); types listed above are more specialized and take precedence
+	template<class Archive, int Rows, int Cols>
+	void serialize(Archive & ar, Eigen::Matrix<Real,Rows,Cols> & m, const unsigned int version){
+		static_assert(Rows!=Eigen::Dynamic && Cols!=Eigen::Dynamic,"Dynamic-size matrices are handled separately.");
+		ar & cereal::make_nvp("data",boost::serialization::make_array(m.data(),Rows*Cols));
+	}
+
 	template<class Archive>
 	void serialize(Archive & ar, VectorXr & v, const unsigned int version){
 		int size=v.size();
@@ -6,6 +6,8 @@
 #include<boost/algorithm/string/classification.hpp>
 #include<woo/lib/base/CompUtils.hpp>
 
+bool GLUtils::glutReady=false;
+
 void GLUtils::Grid(const Vector3r& pos, const Vector3r& unitX, const Vector3r& unitY, const Vector2i& size, int edgeMask){
 	//glPushAttrib(GL_ALL_ATTRIB_BITS);
 		glDisable(GL_LIGHTING);
@@ -40,7 +42,7 @@ void GLUtils::AlignedBox(const AlignedBox3r& box, const Vector3r& color){
 		glTranslatev(box.center().eval());
 		glScalev(Vector3r(box.max()-box.min()));
 		glDisable(GL_LINE_SMOOTH);
-		glutWireCube(1);
+		WireCube(1);
 		glEnable(GL_LINE_SMOOTH);
 	glPopMatrix();
 }
@@ -132,6 +134,28 @@ void GLUtils::Cylinder(const Vector3r& a, const Vector3r& b, Real rad1, const Ve
 	glPopMatrix();
 }
 
+void GLUtils::Sphere(Real radius, int slices, int stacks, bool wire){
+	static GLUquadric* gluQuadric;
+	if(!gluQuadric) gluQuadric=gluNewQuadric(); assert(gluQuadric);
+	gluQuadricDrawStyle(gluQuadric,wire?GLU_LINE:GLU_FILL);
+	gluSphere(gluQuadric,radius,slices,stacks);
+}
+
+void GLUtils::WireCube(Real side){
+	const Real h=.5*side;
+	glBegin(GL_LINES);
+		// 4 edges parallel with each axis
+		for(int ax:{0,1,2}){
+			int ax1=(ax+1)%3, ax2=(ax+2)%3;
+			for(Real c1:{-h,h}) for(Real c2:{-h,h}){
+				Vector3r a; a[ax]=-h; a[ax1]=c1; a[ax2]=c2;
+				Vector3r b(a); b[ax]=h;
+				glVertex3v(a); glVertex3v(b);
+			}
+		}
+	glEnd();
+}
+
 /****
  code copied over from qglviewer
 ****/
@@ -180,7 +204,7 @@ void GLUtils::QGLViewer::drawArrow(const Vector3r& from, const Vector3r& to, flo
 }
 
 void GLUtils::GLDrawText(const std::string& txt, const Vector3r& pos, const Vector3r& color, bool center, void* font, const Vector3r& bgColor, bool shiftIfNeg){
-	if(isnan(color.maxCoeff())) return;
+	if(isnan(color.maxCoeff()) || !glutReady) return;
 	font=font?font:GLUT_BITMAP_8_BY_13;
 	Vector2i xyOff=center?Vector2i(-glutBitmapLength(font,(unsigned char*)txt.c_str())/2,glutBitmapHeight(font)/2):Vector2i::Zero();
 	glPushMatrix();
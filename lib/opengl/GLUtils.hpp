@@ -11,6 +11,8 @@
 #include<string>
 
 struct GLUtils{
+	// set by Renderer::init when GLUT was initialized (GLUT can only be initialized with a display connection, not with offscreen contexts); text is not rendered without GLUT
+	static bool glutReady;
 	// code copied from qglviewer
 	struct QGLViewer{
 		static void drawArrow(float length=1.0f, float radius=-1.0f, int nbSubdivisions=12, bool doubled=false);
@@ -31,6 +33,11 @@ struct GLUtils{
 	// if stacks<0, then it is approximate stack length (axial subdivision) relative to rad1, multiplied by 10 (i.e. -5 -> stacks approximately .5*rad1)
 	static void Cylinder(const Vector3r& a, const Vector3r& b, Real rad1, const Vector3r& color, bool wire=false, bool caps=false, Real rad2=-1 /* if negative, use rad1 */, int slices=6, int stacks=-10);
 
+	// sphere centered at origin, wire or solid (replacement for glut{Solid,Wire}Sphere which need initialized GLUT)
+	static void Sphere(Real radius, int slices, int stacks, bool wire=false);
+	// cube centered at origin (replacement for glutWireCube)
+	static void WireCube(Real side=1.);
+
 	// draw parallelepipedic grid with lines starting at pos
 	static void Grid(const Vector3r& pos, const Vector3r& unitX, const Vector3r& unitY, const Vector2i& size, int edgeMask=15);
 
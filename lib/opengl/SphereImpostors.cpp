@@ -0,0 +1,168 @@
+#ifdef WOO_OPENGL
+// glew must be included before any other GL header
+#include<GL/glew.h>
+#include<woo/lib/opengl/SphereImpostors.hpp>
+
+WOO_IMPL_LOGGER(SphereImpostors);
+
+namespace{
+	// corner selects vertex of the screen-space bounding rectangle of the sphere, computed from projections of its bounding box;
+	// vNear is the eye-space point on the near plane under the vertex, which interpolates linearly over the quad
+	const char* impostorVertSrc=R"GLSL(#version 120
+		attribute vec2 corner;
+		attribute vec3 center;
+		attribute float radius;
+		attribute vec3 color;
+		varying vec3 vNear;
+		varying vec3 vCenter;
+		varying float vRadius;
+		varying vec3 vColor;
+		void main(){
+			vCenter=(gl_ModelViewMatrix*vec4(center,1.)).xyz;
+			vRadius=radius*length(gl_ModelViewMatrix[0].xyz);
+			vColor=color;
+			vec2 lo=vec2(1e30), hi=vec2(-1e30);
+			for(float sx=-1.; sx<2.; sx+=2.) for(float sy=-1.; sy<2.; sy+=2.) for(float sz=-1.; sz<2.; sz+=2.){
+				vec4 p=gl_ProjectionMatrix*vec4(vCenter+vRadius*vec3(sx,sy,sz),1.);
+				// sphere reaching behind the camera is not rendered (degenerate quad)
+				if(p.w<=0.){ gl_Position=vec4(2.,2.,2.,1.); vNear=vec3(0.); return; }
+				lo=min(lo,p.xy/p.w); hi=max(hi,p.xy/p.w);
+			}
+			vec2 ndc=mix(lo,hi,.5*(corner+1.));
+			gl_Position=vec4(ndc,0.,1.);
+			vec4 n=gl_ProjectionMatrixInverse*vec4(ndc,-1.,1.);
+			vNear=n.xyz/n.w;
+		}
+	)GLSL";
+	// ray-sphere intersection in eye space, then depth and fixed-function-like lighting (color material, lights 0 and 1)
+	const char* impostorFragSrc=R"GLSL(#version 120
+		uniform vec3 lightOn; // lighting, light 0, light 1 enabled (0 or 1)
+		varying vec3 vNear;
+		varying vec3 vCenter;
+		varying float vRadius;
+		varying vec3 vColor;
+		void main(){
+			vec3 ro, rd;
+			if(gl_ProjectionMatrix[2][3]==0.){ ro=vNear; rd=vec3(0.,0.,-1.); } // orthographic projection
+			else { ro=vec3(0.); rd=normalize(vNear); }
+			vec3 oc=ro-vCenter;
+			float b=dot(rd,oc), h=b*b-dot(oc,oc)+vRadius*vRadius;
+			if(h<0.) discard;
+			float t=-b-sqrt(h);
+			if(t<0.) discard;
+			vec3 p=ro+t*rd, n=(p-vCenter)/vRadius;
+			vec4 clip=gl_ProjectionMatrix*vec4(p,1.);
+			gl_FragDepth=.5*(gl_DepthRange.diff*clip.z/clip.w+gl_DepthRange.near+gl_DepthRange.far);
+			if(lightOn[0]==0.){ gl_FragColor=vec4(vColor,1.); return; }
+			vec3 col=gl_FrontMaterial.emission.rgb+gl_LightModel.ambient.rgb*vColor;
+			for(int i=0; i<2; i++){
+				vec4 lp=gl_LightSource[i].position;
+				vec3 L=normalize(lp.w==0.?lp.xyz:lp.xyz-p);
+				float nl=max(dot(n,L),0.);
+				float nh=max(dot(n,normalize(L-rd)),0.);
+				col+=lightOn[i+1]*(vColor*(gl_LightSource[i].ambient.rgb+nl*gl_LightSource[i].diffuse.rgb)+(nl>0.?pow(nh,gl_FrontMaterial.shininess):0.)*gl_FrontMaterial.specular.rgb*gl_LightSource[i].specular.rgb);
+			}
+			gl_FragColor=vec4(col,1.);
+		}
+	)GLSL";
+}
+
+bool SphereImpostors::ensureGlObjects(){
+	glewExperimental=GL_TRUE;
+	GLenum err=glewInit();
+	if(err!=GLEW_OK
+		#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+			&& err!=GLEW_ERROR_NO_GLX_DISPLAY // non-GLX (e.g. EGL) context, GL entry points are still loaded
+		#endif
+	){
+		LOG_WARN("glewInit failed ({}), sphere impostors disabled.",(const char*)glewGetErrorString(err));
+		return false;
+	}
+	if(!GLEW_VERSION_2_0 || !GLEW_ARB_instanced_arrays || !GLEW_ARB_draw_instanced){
+		LOG_WARN("OpenGL 2.0 with ARB_instanced_arrays and ARB_draw_instanced is required for sphere impostors (have {} {}), falling back to per-sphere rendering.",(const char*)glGetString(GL_RENDERER),(const char*)glGetString(GL_VERSION));
+		return false;
+	}
+	auto compile=[](GLenum type, const char* src)->GLuint{
+		GLuint sh=glCreateShader(type);
+		glShaderSource(sh,1,&src,NULL);
+		glCompileShader(sh);
+		GLint ok; glGetShaderiv(sh,GL_COMPILE_STATUS,&ok);
+		if(!ok){
+			char log[4096]; glGetShaderInfoLog(sh,sizeof(log),NULL,log);
+			LOG_WARN("Impostor {} shader compilation failed: {}",(type==GL_VERTEX_SHADER?"vertex":"fragment"),log);
+			glDeleteShader(sh);
+			return 0;
+		}
+		return sh;
+	};
+	GLuint vs=compile(GL_VERTEX_SHADER,impostorVertSrc), fs=compile(GL_FRAGMENT_SHADER,impostorFragSrc);
+	if(!vs || !fs){ if(vs) glDeleteShader(vs); if(fs) glDeleteShader(fs); return false; }
+	program=glCreateProgram();
+	glAttachShader(program,vs); glAttachShader(program,fs);
+	// generic attribute 0 must be enabled for drawing in compatibility contexts, so give it to the per-vertex attribute
+	glBindAttribLocation(program,0,"corner");
+	glLinkProgram(program);
+	glDeleteShader(vs); glDeleteShader(fs); // flagged for deletion, freed with the program
+	GLint ok; glGetProgramiv(program,GL_LINK_STATUS,&ok);
+	if(!ok){
+		char log[4096]; glGetProgramInfoLog(program,sizeof(log),NULL,log);
+		LOG_WARN("Impostor shader program linking failed: {}",log);
+		glDeleteProgram(program); program=0;
+		return false;
+	}
+	locCenter=glGetAttribLocation(program,"center");
+	locRadius=glGetAttribLocation(program,"radius");
+	locColor=glGetAttribLocation(program,"color");
+	locLights=glGetUniformLocation(program,"lightOn");
+	const float quad[]={-1,-1, 1,-1, -1,1, 1,1}; // triangle strip
+	glGenBuffers(1,&quadBuf);
+	glBindBuffer(GL_ARRAY_BUFFER,quadBuf);
+	glBufferData(GL_ARRAY_BUFFER,sizeof(quad),quad,GL_STATIC_DRAW);
+	glGenBuffers(1,&instBuf);
+	instBufSize=0;
+	glBindBuffer(GL_ARRAY_BUFFER,0);
+	LOG_DEBUG("Sphere impostors initialized ({} {}).",(const char*)glGetString(GL_RENDERER),(const char*)glGetString(GL_VERSION));
+	return true;
+}
+
+bool SphereImpostors::isSupported(){
+	// objects are per-context; when the program is unknown to the current context, (re)create everything
+	if(supported==1 && !glIsProgram(program)) supported=-1;
+	if(supported<0) supported=(ensureGlObjects()?1:0);
+	return supported==1;
+}
+
+void SphereImpostors::draw(){
+	if(data.empty()) return;
+	if(!isSupported()){ data.clear(); return; }
+	glUseProgram(program);
+	glUniform3f(locLights,glIsEnabled(GL_LIGHTING)?1:0,glIsEnabled(GL_LIGHT0)?1:0,glIsEnabled(GL_LIGHT1)?1:0);
+	// upload instance data; buffer grows as needed, and is orphaned otherwise so that the driver does not stall on the previous frame
+	size_t bytes=data.size()*sizeof(float);
+	glBindBuffer(GL_ARRAY_BUFFER,instBuf);
+	if(bytes>instBufSize){ instBufSize=bytes; glBufferData(GL_ARRAY_BUFFER,bytes,data.data(),GL_STREAM_DRAW); }
+	else { glBufferData(GL_ARRAY_BUFFER,instBufSize,NULL,GL_STREAM_DRAW); glBufferSubData(GL_ARRAY_BUFFER,0,bytes,data.data()); }
+	const GLsizei stride=FLOATS_PER_SPHERE*sizeof(float);
+	struct{ int loc; int n; size_t off; } inst[]={{locCenter,3,0},{locRadius,1,3},{locColor,3,4}};
+	for(const auto& a: inst){
+		if(a.loc<0) continue;
+		glEnableVertexAttribArray(a.loc);
+		glVertexAttribPointer(a.loc,a.n,GL_FLOAT,GL_FALSE,stride,(const void*)(a.off*sizeof(float)));
+		glVertexAttribDivisorARB(a.loc,1);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER,quadBuf);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0,2,GL_FLOAT,GL_FALSE,0,NULL);
+	glDrawArraysInstancedARB(GL_TRIANGLE_STRIP,0,4,(GLsizei)size());
+	// restore state, attributes are not encapsulated in a VAO
+	glDisableVertexAttribArray(0);
+	for(const auto& a: inst){
+		if(a.loc<0) continue;
+		glVertexAttribDivisorARB(a.loc,0);
+		glDisableVertexAttribArray(a.loc);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER,0);
+	glUseProgram(0);
+	data.clear();
+}
+#endif /* WOO_OPENGL */
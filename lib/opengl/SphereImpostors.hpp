@@ -0,0 +1,44 @@
+#pragma once
+
+#ifndef WOO_OPENGL
+#error "This build doesn't support openGL. Therefore, this header must not be used."
+#endif
+
+#include<woo/lib/base/Types.hpp>
+#include<woo/lib/base/Logging.hpp>
+#include<woo/lib/base/Math.hpp>
+
+/*
+Batched rendering of spheres as ray-cast impostors.
+
+Spheres are collected with add(); draw() uploads them into one vertex buffer and renders all of them with a single
+instanced draw call of a screen-aligned quad covering the projected sphere; the fragment shader intersects the view ray
+with the sphere, discards pixels outside, and writes per-pixel normal (for lighting by the fixed-function lights 0 and 1)
+and depth, so impostors intersect correctly with each other and with other geometry.
+
+Only GLSL 1.20 and ARB_instanced_arrays are required, which are available with Mesa's llvmpipe software rasterizer.
+GL objects are created lazily in the current context (and re-created if the context changes, e.g. new view is opened);
+when the context lacks the required features, isSupported() returns false and the caller should fall back to per-sphere rendering.
+*/
+class SphereImpostors{
+	vector<float> data; // per sphere: center (3), radius (1), color (3)
+	unsigned program=0, quadBuf=0, instBuf=0;
+	size_t instBufSize=0;
+	int locCenter=-1, locRadius=-1, locColor=-1, locLights=-1;
+	int supported=-1; // -1 unknown, 0 not supported, 1 supported
+	bool ensureGlObjects();
+	public:
+	enum { FLOATS_PER_SPHERE=7 };
+	size_t size() const { return data.size()/FLOATS_PER_SPHERE; }
+	bool empty() const { return data.empty(); }
+	void clear(){ data.clear(); }
+	void reserve(size_t n){ data.reserve(n*FLOATS_PER_SPHERE); }
+	void add(const Vector3r& pos, Real radius, const Vector3r& color){
+		data.insert(data.end(),{(float)pos[0],(float)pos[1],(float)pos[2],(float)radius,(float)color[0],(float)color[1],(float)color[2]});
+	}
+	// check (and cache) whether the current context can render impostors; must be called with the context current
+	bool isSupported();
+	// render all spheres added so far, and clear the batch
+	void draw();
+	WOO_DECL_LOGGER;
+};
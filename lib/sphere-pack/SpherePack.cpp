@@ -12,6 +12,12 @@
 #include<boost/algorithm/string.hpp>
 
 #include<chrono>
+#include<array>
+#include<algorithm>
+
+#ifdef WOO_OPENMP
+	#include<omp.h>
+#endif
 
 
 #include<iostream>
@@ -133,11 +139,56 @@ void SpherePack::toFile(const string& fname) const {
 	f.close();
 };
 
-long SpherePack::makeCloud_simple(const Vector3r& mn, const Vector3r& mx, const Real& rMean, const Real& rRelFuzz, int num, bool periodic){
-	return makeCloud(mn,mx,rMean,rRelFuzz,num,periodic,/*porosity*/0.5);
+namespace {
+	/* uniform grid of sphere indices over normalized coordinates ⟨0,1⟩³ of a box (or periodic cell);
+	cells are at least minCell wide (in real space), so that spheres of radius ≤ minCell/2 can only overlap
+	if they are in the same or adjacent cells; periodic axes wrap around */
+	struct SphereGrid{
+		Vector3i dim;
+		std::array<bool,3> peri;
+		vector<long> head, next; // singly-linked lists of sphere indices, one per cell
+		SphereGrid(const Vector3r& extents, Real minCell, const std::array<bool,3>& _peri, long maxCells=1L<<22): peri(_peri){
+			for(int ax:{0,1,2}) dim[ax]=(minCell>0 && extents[ax]>0)?max(1,(int)min(1e6,floor(extents[ax]/minCell))):1;
+			while((long)dim[0]*dim[1]*dim[2]>maxCells){ for(int ax:{0,1,2}) dim[ax]=max(1,dim[ax]/2); }
+			head.assign((long)dim[0]*dim[1]*dim[2],-1);
+		}
+		int wrapClamp(int i, int ax) const {
+			if(peri[ax]) return ((i%dim[ax])+dim[ax])%dim[ax];
+			return max(0,min(dim[ax]-1,i));
+		}
+		long linIx(int i, int j, int k) const { return i+(long)dim[0]*(j+(long)dim[1]*k); }
+		Vector3i cellOf(const Vector3r& norm) const { Vector3i ret; for(int ax:{0,1,2}) ret[ax]=wrapClamp((int)floor(norm[ax]*dim[ax]),ax); return ret; }
+		void add(long id, const Vector3r& norm){
+			if((long)next.size()<=id) next.resize(id+1,-1);
+			Vector3i c=cellOf(norm); long l=linIx(c[0],c[1],c[2]);
+			next[id]=head[l]; head[l]=id;
+		}
+		// call f(id) for spheres in the same and adjacent cells; stop and return true as soon as f returns true
+		template<typename F> bool anyNear(const Vector3r& norm, const F& f) const {
+			Vector3i c=cellOf(norm);
+			int ix[3][3], n[3];
+			for(int ax:{0,1,2}){
+				n[ax]=0;
+				if(dim[ax]<=3){ for(int i=0; i<dim[ax]; i++) ix[ax][n[ax]++]=i; continue; }
+				for(int d:{-1,0,1}){
+					int i=c[ax]+d;
+					if(!peri[ax] && (i<0 || i>=dim[ax])) continue;
+					ix[ax][n[ax]++]=wrapClamp(i,ax);
+				}
+			}
+			for(int a=0; a<n[0]; a++) for(int b=0; b<n[1]; b++) for(int d=0; d<n[2]; d++){
+				for(long id=head[linIx(ix[0][a],ix[1][b],ix[2][d])]; id>=0; id=next[id]){ if(f(id)) return true; }
+			}
+			return false;
+		}
+	};
+}
+
+long SpherePack::makeCloud_simple(const Vector3r& mn, const Vector3r& mx, const Real& rMean, const Real& rRelFuzz, int num, bool periodic, bool parallel){
+	return makeCloud(mn,mx,rMean,rRelFuzz,num,periodic,/*porosity*/0.5,vector<Real>(),vector<Real>(),/*distributeMass*/false,/*seed*/0,Matrix3r::Zero(),parallel);
 }
 
-long SpherePack::makeCloud(Vector3r mn, Vector3r mx, Real rMean, Real rRelFuzz, int num, bool periodic, Real porosity, const vector<Real>& psdSizes, const vector<Real>& psdCumm, bool distributeMass, int seed, Matrix3r hSize){
+long SpherePack::makeCloud(Vector3r mn, Vector3r mx, Real rMean, Real rRelFuzz, int num, bool periodic, Real porosity, const vector<Real>& psdSizes, const vector<Real>& psdCumm, bool distributeMass, int seed, Matrix3r hSize, bool parallel){
 	static boost::minstd_rand randGen(seed!=0?seed:(int)getNow());
 	static boost::variate_generator<boost::minstd_rand&, boost::uniform_real<Real> > rnd(randGen, boost::uniform_real<Real>(0,1));
 	vector<Real> psdRadii; // holds plain radii (rather than diameters), scaled down in some situations to get the target number
@@ -191,63 +242,98 @@ long SpherePack::makeCloud(Vector3r mn, Vector3r mx, Real rMean, Real rRelFuzz,
 	// adjust uniform distribution parameters with distributeMass; rMean has the meaning (dimensionally) of _volume_
 	const int maxTry=1000;
 	if(periodic)(cellSize=size);
-	Real r=0;
-	for(int i=0; (i<num) || (num<0); i++) {
+	// radius of the i-th sphere
+	auto sphereRadius=[&](long i)->Real{
 		Real norm, rand;
 		//Determine radius of the next sphere we will attempt to place in space. If (num>0), generate radii the deterministic way, in decreasing order, else radii are stochastic since we don't know what the final number will be
 		if (num>0) rand = ((Real)num-(Real)i+0.5)/((Real)num+1.);
 		else rand = rnd();
-		int t;
 		switch(mode){
-			case RDIST_RMEAN:
-				//FIXME : r is never defined, it will be zero at first iteration, but it will have values in the next ones. Some magic?
+			case RDIST_RMEAN: // same as RDIST_NUM, only rMean was not computed
 			case RDIST_NUM:
-				if(distributeMass) r=pow3Interp(rand,rMean*(1-rRelFuzz),rMean*(1+rRelFuzz));
-				else r=rMean*(2*(rand-.5)*rRelFuzz+1); // uniform distribution in rMean*(1±rRelFuzz)
-				break;
+				if(distributeMass) return pow3Interp(rand,rMean*(1-rRelFuzz),rMean*(1+rRelFuzz));
+				return rMean*(2*(rand-.5)*rRelFuzz+1); // uniform distribution in rMean*(1±rRelFuzz)
 			case RDIST_PSD:
 				if(distributeMass){
 					int piece=psdGetPiece(rand,psdCumm2,norm);
-					r=pow3Interp(norm,psdRadii[piece],psdRadii[piece+1]);
+					return pow3Interp(norm,psdRadii[piece],psdRadii[piece+1]);
 				} else {
 					int piece=psdGetPiece(rand,psdCumm,norm);
-					r=psdRadii[piece]+norm*(psdRadii[piece+1]-psdRadii[piece]);}
-		}
-		// try to put the sphere into a free spot
-		for(t=0; t<maxTry; ++t){
-			Vector3r c;
-			if(!periodic) { for(int axis=0; axis<3; axis++) c[axis]=mn[axis]+r+(size[axis]-2*r)*rnd(); }
-			else { 	for(int axis=0; axis<3; axis++) c[axis]=rnd();//coordinates in [0,1]
-				c=mn+hSize*c;}//coordinates in reference frame (inside the base cell)
-			size_t packSize=pack.size(); bool overlap=false;
-			if(!periodic) for(size_t j=0;j<packSize;j++) {if(pow2(pack[j].r+r)>=(pack[j].c-c).squaredNorm()) {overlap=true; break;}}
-			else {
-				for(size_t j=0; j<packSize; j++){
-					Vector3r dr=Vector3r::Zero();
-					if (!hSizeFound) {//The box is axis-aligned, use the wrap methods
-						for(int axis=0; axis<3; axis++) dr[axis]=min(cellWrapRel(c[axis],pack[j].c[axis],pack[j].c[axis]+size[axis]),cellWrapRel(pack[j].c[axis],c[axis],c[axis]+size[axis]));
-					} else {//not aligned, find closest neighbor in a cube of size 1, then transform distance to cartesian coordinates
-						Vector3r c1c2=invHsize*(pack[j].c-c);
-						for(int axis=0; axis<3; axis++){
-							if (abs(c1c2[axis])<abs(c1c2[axis] - Mathr::Sign(c1c2[axis]))) dr[axis]=c1c2[axis];
-							else dr[axis] = c1c2[axis] - Mathr::Sign(c1c2[axis]);}
-						dr=hSize*dr;//now in cartesian coordinates
-					}
-					if(pow2(pack[j].r+r)>= dr.squaredNorm()){ overlap=true; break; }
+					return psdRadii[piece]+norm*(psdRadii[piece+1]-psdRadii[piece]);
 				}
-			}
-			if(!overlap) { pack.push_back(Sph(c,r)); break; }
 		}
-		if (t==maxTry) {
+		return NaN; // not reached
+	};
+	auto randomPos=[&](Real r)->Vector3r{
+		Vector3r c;
+		if(!periodic) { for(int axis=0; axis<3; axis++) c[axis]=mn[axis]+r+(size[axis]-2*r)*rnd(); }
+		else { 	for(int axis=0; axis<3; axis++) c[axis]=rnd();//coordinates in [0,1]
+			c=mn+hSize*c;}//coordinates in reference frame (inside the base cell)
+		return c;
+	};
+	auto overlaps=[&](const Sph& s, const Vector3r& c, Real r)->bool{
+		if(!periodic) return pow2(s.r+r)>=(s.c-c).squaredNorm();
+		Vector3r dr=Vector3r::Zero();
+		if (!hSizeFound) {//The box is axis-aligned, use the wrap methods
+			for(int axis=0; axis<3; axis++) dr[axis]=min(cellWrapRel(c[axis],s.c[axis],s.c[axis]+size[axis]),cellWrapRel(s.c[axis],c[axis],c[axis]+size[axis]));
+		} else {//not aligned, find closest neighbor in a cube of size 1, then transform distance to cartesian coordinates
+			Vector3r c1c2=invHsize*(s.c-c);
+			for(int axis=0; axis<3; axis++){
+				if (abs(c1c2[axis])<abs(c1c2[axis] - Mathr::Sign(c1c2[axis]))) dr[axis]=c1c2[axis];
+				else dr[axis] = c1c2[axis] - Mathr::Sign(c1c2[axis]);}
+			dr=hSize*dr;//now in cartesian coordinates
+		}
+		return pow2(s.r+r)>=dr.squaredNorm();
+	};
+
+	// grid for overlap checks: cells must be wider than the largest sphere (placed or to be placed)
+	Real rMax=(mode==RDIST_PSD?*std::max_element(psdRadii.begin(),psdRadii.end()):rMean*(1+abs(rRelFuzz)));
+	for(const Sph& s: pack) rMax=max(rMax,s.r);
+	Vector3r extents; // distances between opposite faces of the box
+	for(int ax:{0,1,2}) extents[ax]=abs(volume)/hSize.col((ax+1)%3).cross(hSize.col((ax+2)%3)).norm();
+	SphereGrid grid(extents,2*rMax,{periodic,periodic,periodic});
+	auto gridNorm=[&](const Vector3r& c)->Vector3r{ return invHsize*(c-mn); };
+	const size_t size0=pack.size();
+	for(size_t j=0; j<size0; j++) grid.add(j,gridNorm(pack[j].c));
+
+	// candidates are placed in batches: positions are drawn serially, checked against placed spheres in parallel,
+	// then accepted in order (checking only against spheres accepted from the same batch); those failing are retried
+	// batch size must not depend on the number of threads, so that the result with a given seed is reproducible
+	const long batchSize=(parallel?256:1);
+	struct Candidate{ long i; Real r; int tries; Vector3r c; bool free; };
+	vector<Candidate> cands; cands.reserve(batchSize);
+	long nextI=0;
+	while(true){
+		while((long)cands.size()<batchSize && (num<0 || nextI<num)){ cands.push_back(Candidate{nextI,sphereRadius(nextI),0,Vector3r::Zero(),false}); nextI++; }
+		if(cands.empty()) break;
+		for(Candidate& cand: cands) cand.c=randomPos(cand.r);
+		const long nCands=cands.size();
+		#ifdef WOO_OPENMP
+			#pragma omp parallel for schedule(guided) if(nCands>1)
+		#endif
+		for(long k=0; k<nCands; k++){
+			Candidate& cand(cands[k]);
+			cand.free=!grid.anyNear(gridNorm(cand.c),[&](long j){ return overlaps(pack[j],cand.c,cand.r); });
+		}
+		const long batchStart=pack.size();
+		size_t kept=0;
+		for(long k=0; k<nCands; k++){
+			Candidate& cand(cands[k]);
+			if(cand.free && (long)pack.size()>batchStart) cand.free=!grid.anyNear(gridNorm(cand.c),[&](long j){ return j>=batchStart && overlaps(pack[j],cand.c,cand.r); });
+			if(cand.free){ grid.add(pack.size(),gridNorm(cand.c)); pack.push_back(Sph(cand.c,cand.r)); continue; }
+			if(++cand.tries<maxTry){ cands[kept++]=cand; continue; }
+			long placed=pack.size()-size0;
 			if(num>0) {
 				if (mode!=RDIST_RMEAN) {
 					Real nextPoro = porosity+(1-porosity)/10.;
-					LOG_WARN("Exceeded {} tries to insert non-overlapping sphere to packing. Only {} spheres was added, although you requested {}. Trying again with porosity {}. The size distribution is being scaled down",maxTry,i,num,nextPoro);
+					LOG_WARN("Exceeded {} tries to insert non-overlapping sphere to packing. Only {} spheres was added, although you requested {}. Trying again with porosity {}. The size distribution is being scaled down",maxTry,placed,num,nextPoro);
 					pack.clear();
-					return makeCloud(mn, mx, -1., rRelFuzz, num, periodic, nextPoro, psdSizes, psdCumm, distributeMass,seed,hSizeFound?hSize:Matrix3r::Zero());}
-				else LOG_WARN("Exceeded {} tries to insert non-overlapping sphere to packing. Only {} spheres was added, although you requested {}.",maxTry,i,num);
+					return makeCloud(mn, mx, -1., rRelFuzz, num, periodic, nextPoro, psdSizes, psdCumm, distributeMass,seed,hSizeFound?hSize:Matrix3r::Zero(),parallel);}
+				else LOG_WARN("Exceeded {} tries to insert non-overlapping sphere to packing. Only {} spheres was added, although you requested {}.",maxTry,placed,num);
 			}
-			return i;}
+			return placed;
+		}
+		cands.resize(kept);
 	}
 	if (appliedPsdScaling<1) LOG_WARN("The size distribution has been scaled down by a factor pack.appliedPsdScaling={}",appliedPsdScaling);
 	return pack.size();
@@ -344,6 +430,7 @@ int SpherePack::addShadows(){
 	// check there are no shadows yet
 	for(size_t i=0; i<sz0; i++){ if (pack[i].shadowOf>=0) throw std::runtime_error(fmt::format("SpherePack.addShadows: {} is a shadow of {}; remove shadows (SpherePack.removeShadows) before calling addShadows.",i,pack[i].shadowOf)); }
 	int ret=0;
+	pack.reserve(sz0*5/4); // most spheres are usually not crossing the boundary
 	for(size_t i=0; i<sz0; i++){
 		Sph& s=pack[i];
 		// check that points are in canonical positions
@@ -355,10 +442,12 @@ int SpherePack::addShadows(){
 		}
 		Vector3i mn, mx;
 		for(int j:{0,1,2}){ mn[j]=(s.c[j]+s.r>cellSize[j]?-1:0); mx[j]=(s.c[j]-s.r<0?1:0); }
+		// copy, since push_back below may invalidate s
+		const Vector3r c(s.c); const Real r(s.r);
 		Vector3i n;
 		for(n[0]=mn[0]; n[0]<=mx[0]; n[0]++) for(n[1]=mn[1]; n[1]<=mx[1]; n[1]++) for(n[2]=mn[2]; n[2]<=mx[2]; n[2]++){
 			if(n==Vector3i::Zero()) continue; // in the middle
-			pack.push_back(Sph(s.c+Vector3r(n[0]*cellSize[0],n[1]*cellSize[1],n[2]*cellSize[2]),s.r,/*clumpId*/-1,/*shadowOf*/i));
+			pack.push_back(Sph(c+Vector3r(n[0]*cellSize[0],n[1]*cellSize[1],n[2]*cellSize[2]),r,/*clumpId*/-1,/*shadowOf*/i));
 			ret++;
 		}
 	};
@@ -445,11 +534,9 @@ shared_ptr<SpherePack> SpherePack::filtered(const shared_ptr<Predicate>& p, bool
 
 
 int SpherePack::removeShadows(){
-	int ret=0;
-	for(long i=(long)pack.size(); i>=0; i--){
-		if(pack[i].shadowOf>=0){ pack.erase(pack.begin()+i); ret++; }
-	}
-	return ret;
+	size_t sz0=pack.size();
+	pack.erase(std::remove_if(pack.begin(),pack.end(),[](const Sph& s){ return s.shadowOf>=0; }),pack.end());
+	return sz0-pack.size();
 };
 
 void SpherePack::scale(Real scale, bool keepRadius){
@@ -468,22 +555,42 @@ Real SpherePack::maxRelOverlap(){
 	With s=z/d₀,  we have d₀s=d₀(z/d₀+1)=z+d₀ which is r₁+r₂.
 	Therefore this function returns max(z/d₀)=max((r₁+r₂-d₀)/d₀).
 	*/
-	size_t sz=pack.size();
+	const long sz=pack.size();
+	if(sz==0) return 0.;
 	bool peri=(cellSize!=Vector3r::Zero());
+	// only spheres in the same or adjacent grid cells may overlap
+	Real rMax=0.; AlignedBox3r box;
+	for(const Sph& s: pack){ rMax=max(rMax,s.r); box.extend(s.c); }
+	std::array<bool,3> axPeri; Vector3r lo, extents;
+	for(int ax:{0,1,2}){
+		// periodicity is per-axis, as in periPtDistSq
+		axPeri[ax]=(cellSize[ax]>0);
+		lo[ax]=(axPeri[ax]?0.:box.min()[ax]);
+		extents[ax]=(axPeri[ax]?cellSize[ax]:box.sizes()[ax]);
+	}
+	auto gridNorm=[&](const Vector3r& c)->Vector3r{ Vector3r ret; for(int ax:{0,1,2}) ret[ax]=(extents[ax]>0?(c[ax]-lo[ax])/extents[ax]:0.); return ret; };
+	SphereGrid grid(extents,2*rMax,axPeri);
+	for(long i=0; i<sz; i++) grid.add(i,gridNorm(pack[i].c));
 	Real ret=0.;
-	for(size_t i=0; i<sz; i++){
-		for(size_t j=i+1; j<sz; j++){
-			const Sph &s1=pack[i]; const Sph& s2=pack[j];
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(guided) reduction(max:ret)
+	#endif
+	for(long i=0; i<sz; i++){
+		const Sph& s1=pack[i];
+		grid.anyNear(gridNorm(s1.c),[&](long j){
+			if(j<=i) return false; // each pair only once
+			const Sph& s2=pack[j];
+			// sphere in a clump, and within the same clump
+			if(s1.clumpId>=0 && s1.clumpId==s2.clumpId) return false;
 			// squared distance - normal or wrapped, if periodic
 			Real sqDist=peri?periPtDistSq(s1.c,s2.c):(s1.c-s2.c).squaredNorm();
-			// sphere in a clump, and within the same clump
-			if(s1.clumpId>=0 && s1.clumpId==s2.clumpId) continue;
 			// too far from each other
-			if(sqDist>pow2(s1.r+s2.r)) continue;
+			if(sqDist>pow2(s1.r+s2.r)) return false;
 			// compute relative overlap
 			Real dist=sqrt(sqDist);
 			ret=max(ret,(s1.r+s2.r-dist)/dist);
-		}
+			return false;
+		});
 	}
 	return ret;
 }
@@ -9,7 +9,14 @@ void HalfspaceBuoyancy::run(){
 	if(gravNorm==0.) throw std::runtime_error("HalfspaceBuoyancy: DemField.gravity must not be zero.");
 	// downwards unit vector, in the direction of gravity (≡ inner normal of the liquid surface)
 	Vector3r gravDir=dem.gravity/gravNorm;
-	for(const auto& p: *dem.particles){
+	const auto& particles=*dem.particles;
+	const long nPar=(long)particles.size();
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(guided)
+	#endif
+	for(long i=0; i<nPar; i++){
+		const shared_ptr<Particle>& p=particles[i];
+		if(!p) continue;
 		// check mask
 		if(mask!=0 && ((mask&p->mask)==0)) continue;
 		// check that the particle is uninodal
@@ -29,8 +36,8 @@ void HalfspaceBuoyancy::run(){
 		// DemData instance for the node
 		auto& dyn(p->shape->nodes[0]->getData<DemData>());
 		const auto& vel=dyn.vel; const auto& angVel=dyn.angVel;
-		// will be modified in-place
-		auto& F=dyn.force; auto& T=dyn.torque;
+		// accumulated locally and applied at the end; nodes might be shared between particles, hence the locking
+		Vector3r F(Vector3r::Zero()), T(Vector3r::Zero());
 
 		// * simple buoyancy = submerged volume * density of water * gravity
 		// * drag forces are referenced from http://www.tandfonline.com/doi/abs/10.1080/02726351.2010.544377
@@ -67,6 +74,7 @@ void HalfspaceBuoyancy::run(){
 				T+=-dragCoef*(liqRho/2)*angVel*angVel.norm()*pow5(rad);
 			}	
 		}
+		dyn.addForceTorque(F,T);
 	}
 }
 
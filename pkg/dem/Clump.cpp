@@ -169,6 +169,7 @@ std::tuple<vector<shared_ptr<Node>>,vector<shared_ptr<Particle>>> SphereClumpGeo
 		cd->relPos[i]=(centers[i]-pos)*scale;
 		cd->relOri[i]=ori.conjugate(); // nice to set, but not really important
 	}
+	cd->invalidateMemberDyn();
 	// sets particles in global space based on relPos, relOri
 	ClumpData::applyToMembers(n);
 	// set clump properties
@@ -257,6 +258,7 @@ shared_ptr<Node> ClumpData::makeClump(const vector<shared_ptr<Node>>& nn, shared
 		LOG_TRACE("relPos={}, relOri={}:{}",clump->relPos.rbegin()->transpose(),aa.axis(),aa.angle());
 		dem.setClumped(cNode);
 	}
+	clump->invalidateMemberDyn();
 	return cNode;
 }
 
@@ -274,14 +276,24 @@ py::tuple ClumpData::pyForceTorqueFromMembers(const shared_ptr<Node>& node){
 }
 
 
+void ClumpData::updateMemberDyn(){
+	memberDyn.resize(nodes.size());
+	for(size_t i=0; i<nodes.size(); i++) memberDyn[i]=&(nodes[i]->getData<DemData>());
+}
+
 void ClumpData::forceTorqueFromMembers(const shared_ptr<Node>& node, Vector3r& F, Vector3r& T){
 	ClumpData& clump=node->getData<DemData>().cast<ClumpData>();
-	for(const auto& n: clump.nodes){
-		const DemData& dyn=n->getData<DemData>();
-		F+=dyn.force;
-		T+=dyn.torque+(n->pos-node->pos).cross(dyn.force);
-		// cerr<<"f="<<F.transpose()<<", t="<<T.transpose()<<endl;
+	clump.ensureMemberDyn();
+	const Vector3r& clumpPos(node->pos);
+	const size_t N=clump.nodes.size();
+	// sum locally, add to F, T only once
+	Vector3r f(Vector3r::Zero()), t(Vector3r::Zero());
+	for(size_t i=0; i<N; i++){
+		const DemData& dyn(*clump.memberDyn[i]);
+		f+=dyn.force;
+		t+=dyn.torque+(clump.nodes[i]->pos-clumpPos).cross(dyn.force);
 	}
+	F+=f; T+=t;
 }
 
 void ClumpData::pyApplyToMembers(const shared_ptr<Node>& node){
@@ -292,15 +304,20 @@ void ClumpData::pyApplyToMembers(const shared_ptr<Node>& node){
 
 void ClumpData::applyToMembers(const shared_ptr<Node>& node, bool reset){
 	ClumpData& clump=node->getData<DemData>().cast<ClumpData>();
+	clump.ensureMemberDyn();
 	const Vector3r& clumpPos(node->pos); const Quaternionr& clumpOri(node->ori);
 	assert(clump.nodes.size()==clump.relPos.size()); assert(clump.nodes.size()==clump.relOri.size());
-	for(size_t i=0; i<clump.nodes.size(); i++){
-		const shared_ptr<Node>& n(clump.nodes[i]);
-		DemData& nDyn(n->getData<DemData>());
+	// rotation matrix is cheaper than quaternion when applied to several vectors
+	const Matrix3r R(clumpOri.toRotationMatrix());
+	const size_t N=clump.nodes.size();
+	for(size_t i=0; i<N; i++){
+		Node& n(*clump.nodes[i]);
+		DemData& nDyn(*clump.memberDyn[i]);
 		assert(nDyn.isClumped());
-		n->pos=clumpPos+clumpOri*clump.relPos[i];
-		n->ori=clumpOri*clump.relOri[i];
-		nDyn.vel=clump.vel+clump.angVel.cross(n->pos-clumpPos);
+		const Vector3r arm(R*clump.relPos[i]);
+		n.pos=clumpPos+arm;
+		n.ori=clumpOri*clump.relOri[i];
+		nDyn.vel=clump.vel+clump.angVel.cross(arm);
 		nDyn.angVel=clump.angVel;
 		if(reset) nDyn.force=nDyn.torque=Vector3r::Zero();
 	}
@@ -308,9 +325,6 @@ void ClumpData::applyToMembers(const shared_ptr<Node>& node, bool reset){
 
 void ClumpData::resetForceTorque(const shared_ptr<Node>& node){
 	ClumpData& clump=node->getData<DemData>().cast<ClumpData>();
-	for(size_t i=0; i<clump.nodes.size(); i++){
-		DemData& nDyn(clump.nodes[i]->getData<DemData>());
-		nDyn.force=nDyn.torque=Vector3r::Zero();
-	}
+	clump.ensureMemberDyn();
+	for(DemData* nDyn: clump.memberDyn) nDyn->force=nDyn->torque=Vector3r::Zero();
 }
-
@@ -49,6 +49,15 @@ struct ClumpData: public DemData{
 
 	static void resetForceTorque(const shared_ptr<Node>&);
 
+	// raw pointers to DemData of members, parallel to nodes, relPos, relOri; built on first use, cleared
+	// (invalidateMemberDyn) whenever nodes are assigned: in makeClump and after loading (postLoad)
+	// each clump is only touched by one thread at a time (in Leapfrog), so gather/scatter need no locking
+	vector<DemData*> memberDyn;
+	void ensureMemberDyn(){ if(WOO_UNLIKELY(memberDyn.size()!=nodes.size())) updateMemberDyn(); }
+	void invalidateMemberDyn(){ memberDyn.clear(); }
+	void postLoad(ClumpData&,void*){ invalidateMemberDyn(); }
+	void updateMemberDyn();
+
 	WOO_DECL_LOGGER;
 	#define woo_dem_ClumpData__CLASS_BASE_DOC_ATTRS_PY \
 		ClumpData,DemData,"Data of a DEM particle which binds multiple particles together.", \
@@ -9,6 +9,8 @@
 #include<boost/graph/one_bit_color_map.hpp>
 #include <boost/graph/stoer_wagner_min_cut.hpp>
 
+#include<atomic>
+
 #ifdef WOO_OPENGL
 	#include<woo/lib/opengl/GLUtils.hpp>
 	#include<woo/lib/base/CompUtils.hpp>
@@ -32,15 +34,16 @@ WOO_IMPL_LOGGER(ClusterAnalysis);
 
 
 void ClusterAnalysis::analyzeParticles(const vector<Particle::id_t>& ids, int level){
+	assert(level>0);
 	if(ids.size()<2){
 		LOG_TRACE("single particle, nothing to do @ conn {}",level);
 		return;
 	}
-	LOG_WARN("== conn {}, {} particles ==",level,ids.size());
+	LOG_DEBUG("== conn {}, {} particles ==",level,ids.size());
 	// two-way mapping:
-	// find particle id from vertex number i: ids[i]; complexity O(1)
-	// find vertex number i from particle id: id2i[id]; complexity O(log n)
-	std::map<Particle::id_t,size_t> id2i;
+	// find particle id from vertex number i: ids[i]
+	// find vertex number i from particle id: id2v[id] (dense table, reset to -1 before returning)
+	for(size_t i=0; i<ids.size(); i++) id2v[ids[i]]=i;
 
 	typedef boost::property<boost::edge_weight_t, int> EdgeWeightProp;
 
@@ -58,133 +61,119 @@ void ClusterAnalysis::analyzeParticles(const vector<Particle::id_t>& ids, int le
 	LOG_TRACE("Conn {}, {} vertices.",level,ids.size());
 
 	for(size_t i=0; i<ids.size(); i++){
-		assert((*dem->particles)[i]);
 		const auto& p((*dem->particles)[ids[i]]);
-		// LOG_WARN("#{}: {} {} || {} --- {} {}",p->id,p->shape->nodes[0]->pos,box.contains(p->shape->nodes[0]->pos),box.min(),box.max(),box.isEmpty());
-		id2i[ids[i]]=i;
+		assert(p);
 		for(const auto& idCon: p->contacts){
 			if(!idCon.second->isReal()) continue;
-			// This will find nothing if the other particles is not in ids at all
-			// or has not been traversed yet; in the latter case, the contact will
-			// be added when the loop gets to the other particle (symmetry).
-			// This way, we can save one extra loop just to fill id2i first.
-			const auto& iOther=id2i.find(idCon.first);
-			if(iOther==id2i.end()) continue;
-			boost::add_edge(i,iOther->second,EdgeWeightProp(1),conn);
-			LOG_TRACE("   + {} ⇔ {}",i,iOther->second);
+			// other particle not in ids at all, or the contact will be added from the other particle (each contact only once)
+			const long iOther=id2v[idCon.first];
+			if(iOther<0 || iOther>=(long)i) continue;
+			boost::add_edge(i,iOther,EdgeWeightProp(1),conn);
+			LOG_TRACE("   + {} ⇔ {}",i,iOther);
 		}
 	}
-	if(level>0){
-		/*
-
-		For level>0, do min-cut and remove all edges in cuts with cost==level (unit edge weight).
-
-		1. if cheaptest min-cut has lower cost, it is an error (should have been separated at previous levels already) -- not sure?!
-		2. as optimization: if the cheapest min-cut has higher cost, short-circuit and mark all as part of one cluster, return
-
-		// http://www.boost.org/doc/libs/1_64_0/libs/graph/example/stoer_wagner.cpp
-		stoer_wagner does not support finding multiple same-valued cuts, therefore:
-		(a) initially define unit edge weights (that is done above, when edges are added to the graph)
-		(b) run min-cut
-		(c) if cost is higher than level, go to (e)
-		(c) save the edges cut
-		(c) increase cut edges weight to 2 (or more, that does not matter)
-		(d) back to (b)
-		(e) remove all saved edges (or simply edges with more than unit weight)
-		(f) feed that to connected_components below
-		*/
-		std::list<std::pair<size_t,size_t>> cuts;
-		int mincut=-1;
-		do{
-			auto parities=boost::make_one_bit_color_map(num_vertices(conn),boost::get(boost::vertex_index,conn));
-			LOG_TRACE("  --- mincut, conn {}",level);
-			mincut=boost::stoer_wagner_min_cut(conn,boost::get(boost::edge_weight,conn),boost::parity_map(parities));
-			if(mincut<level){
-				//throw std::runtime_error
-				LOG_ERROR("ClusterAnalysis: Stoer-Wagner min-cut on contact graph reported minimum cut with weight {}, but it should not be smaller than current connectivity level {}",mincut,level);
-				return;
-			}
-			if(mincut==level){
-				// https://stackoverflow.com/questions/4810589/output-bgl-edge-weights
-				/*
-					how to get edge indices directly?
-					asked at https://stackoverflow.com/questions/46753785/bgl-geting-edge-indices-from-stoer-wagner-min-cut
-					for now, use parity map, find edges which connect non-equal partities iterating over edges
-				*/
-				auto eds=boost::edges(conn);
-				int ie=0;
-				for(auto E=eds.first; E!=eds.second; ++E){
-					auto a(boost::source(*E,conn)),b(boost::target(*E,conn));
-					if(boost::get(parities,a)!=boost::get(parities,b)){
-						LOG_DEBUG("   | {} ⇔ {}, weight {}{}",a,b,mincut,(ie==0?" (edge weight bumped)":""));
-						// only change weight for the first edge in the cut
-						if (ie==0) { boost::get(boost::edge_weight,conn)[*E]=2; ie++; };
-						// but remember all of them for later removal
-						cuts.push_back(std::make_pair(a,b));
-					}
+	for(const auto& id: ids) id2v[id]=-1;
+	/*
+
+	For level>0, do min-cut and remove all edges in cuts with cost==level (unit edge weight).
+
+	1. if cheaptest min-cut has lower cost, it is an error (should have been separated at previous levels already) -- not sure?!
+	2. as optimization: if the cheapest min-cut has higher cost, short-circuit and mark all as part of one cluster, return
+
+	// http://www.boost.org/doc/libs/1_64_0/libs/graph/example/stoer_wagner.cpp
+	stoer_wagner does not support finding multiple same-valued cuts, therefore:
+	(a) initially define unit edge weights (that is done above, when edges are added to the graph)
+	(b) run min-cut
+	(c) if cost is higher than level, go to (e)
+	(c) save the edges cut
+	(c) increase cut edges weight to 2 (or more, that does not matter)
+	(d) back to (b)
+	(e) remove all saved edges (or simply edges with more than unit weight)
+	(f) feed that to connected_components below
+	*/
+	std::list<std::pair<size_t,size_t>> cuts;
+	int mincut=-1;
+	do{
+		auto parities=boost::make_one_bit_color_map(num_vertices(conn),boost::get(boost::vertex_index,conn));
+		LOG_TRACE("  --- mincut, conn {}",level);
+		mincut=boost::stoer_wagner_min_cut(conn,boost::get(boost::edge_weight,conn),boost::parity_map(parities));
+		if(mincut<level){
+			//throw std::runtime_error
+			LOG_ERROR("ClusterAnalysis: Stoer-Wagner min-cut on contact graph reported minimum cut with weight {}, but it should not be smaller than current connectivity level {}",mincut,level);
+			return;
+		}
+		if(mincut==level){
+			// https://stackoverflow.com/questions/4810589/output-bgl-edge-weights
+			/*
+				how to get edge indices directly?
+				asked at https://stackoverflow.com/questions/46753785/bgl-geting-edge-indices-from-stoer-wagner-min-cut
+				for now, use parity map, find edges which connect non-equal partities iterating over edges
+			*/
+			auto eds=boost::edges(conn);
+			int ie=0;
+			for(auto E=eds.first; E!=eds.second; ++E){
+				auto a(boost::source(*E,conn)),b(boost::target(*E,conn));
+				if(boost::get(parities,a)!=boost::get(parities,b)){
+					LOG_DEBUG("   | {} ⇔ {}, weight {}{}",a,b,mincut,(ie==0?" (edge weight bumped)":""));
+					// only change weight for the first edge in the cut
+					if (ie==0) { boost::get(boost::edge_weight,conn)[*E]=2; ie++; };
+					// but remember all of them for later removal
+					cuts.push_back(std::make_pair(a,b));
 				}
 			}
-		} while(mincut==level);
-		LOG_TRACE("  --- no more cuts (weight {} for conn {})",mincut,level);
-		for(const auto& ab: cuts){
-			LOG_TRACE("  - {} ⇔ {}",ab.first,ab.second);
-			boost::remove_edge(ab.first,ab.second,conn);
 		}
+	} while(mincut==level);
+	LOG_TRACE("  --- no more cuts (weight {} for conn {})",mincut,level);
+	for(const auto& ab: cuts){
+		LOG_TRACE("  - {} ⇔ {}",ab.first,ab.second);
+		boost::remove_edge(ab.first,ab.second,conn);
 	}
 
 	// connected components analysis on assembled graph
-	vector<size_t> id2small(boost::num_vertices(conn));
-	size_t smallNum=boost::connected_components(conn,id2small.data());
-	LOG_TRACE("conn {}: {} connected components.",level,smallNum);
-	assert(id2small.size()==ids.size());
-	// count particles in each cluster
-	vector<int> smallSizes(smallNum,0);
-	for(const auto& c: id2small) smallSizes[c]++;
-	// assign contiguous labels only to clusters with at least clustMin particles
-	vector<int> small2big(smallNum); // maps small cluster number (0..smallNum) to contiguous big number
-	vector<int> big2small; // reverse mapping, dynamically resized
-	for(size_t small=0; small<smallNum; small++){
-		if(smallSizes[small]<clustMin){
-			small2big[small]=-1; // invalid, does not count as cluster at all
-			continue;
-		}
-		small2big[small]=big2small.size();
-		big2small.push_back(small);
-	}
-	LOG_TRACE("conn {}: {} conn components >= clustMin (={}).",level,big2small.size(),clustMin);
+	vector<size_t> comp(boost::num_vertices(conn));
+	size_t nComp=boost::connected_components(conn,comp.data());
+	LOG_TRACE("conn {}: {} connected components.",level,nComp);
+	assert(comp.size()==ids.size());
+	labelComponents(ids,comp,nComp,level);
+}
 
-	// find existing labels
-	vector<int> exBig(small2big.size(),-1);
+void ClusterAnalysis::labelComponents(const vector<Particle::id_t>& ids, const vector<size_t>& comp, size_t nComp, int level, const vector<char>* skip){
+	// count particles in each component; only components with at least clustMin particles count as clusters
+	vector<size_t> sizes(nComp,0);
+	for(const auto& c: comp) sizes[c]++;
+	auto isCluster=[&](size_t c){ return (int)sizes[c]>=clustMin && !(skip && (*skip)[c]); };
+
+	// find existing labels; one label is only reused by one cluster (e.g. when a cluster broke up), also across different parent clusters
+	vector<int> label(nComp,-1);
 	for(size_t i=0; i<ids.size(); i++){
+		const size_t& c=comp[i];
+		if(!isCluster(c)) continue;
 		const auto& p((*dem->particles)[ids[i]]);
-		const int& label=small2big[id2small[i]];
-		if(label<0) continue;
-		if(p->matState && p->matState->isA<ClusterMatState>()){
-			const auto& ll(p->matState->cast<ClusterMatState>().labels);
-			// no label for this connectivity, do nothing
-			if((int)ll.size()<=level || exBig[label]<0) continue;
-			// existing label mismatch, overwrite older value
-			if(ll[level]!=exBig[label]){
-				LOG_WARN("#{}: cluster level {}, label {} → {}",p->id,level,exBig[label],ll[level]);
-				exBig[label]=ll[level];
-			}
-		}
+		if(!p->matState || !p->matState->isA<ClusterMatState>()) continue;
+		const auto& ll(p->matState->cast<ClusterMatState>().labels);
+		// no label for this connectivity, do nothing
+		if((int)ll.size()<=level || ll[level]<0) continue;
+		if(label[c]==ll[level]) continue;
+		if(label[c]>=0){ LOG_DEBUG("#{}: cluster level {}, label {} (keeping {})",p->id,level,ll[level],label[c]); continue; }
+		if(claimed[level].count(ll[level])) continue;
+		label[c]=ll[level];
+		claimed[level].insert(ll[level]);
 	}
 	// assign new labels to those clusters which have no label yet
-	for(size_t i=0; i<small2big.size(); i++){
-		if(exBig[i]<0) exBig[i]=++lastLabels[level];
+	for(size_t c=0; c<nComp; c++){
+		if(isCluster(c) && label[c]<0) label[c]=++lastLabels[level];
 	}
-	
+
 	// write results
 	for(size_t i=0; i<ids.size(); i++){
+		const size_t& c=comp[i];
+		if(!isCluster(c)) continue;
 		const auto& p((*dem->particles)[ids[i]]);
-		const int& label=small2big[id2small[i]];
-		if(label<0) continue;
 		// foreign MatState
 		if(p->matState && !p->matState->isA<ClusterMatState>()){
 			switch(replMatState){
 				case REPL_MATSTATE_NEVER: continue;
-				case REPL_MATSTATE_ALWAYS: p->matState=make_shared<ClusterMatState>();
+				case REPL_MATSTATE_ALWAYS: p->matState=make_shared<ClusterMatState>(); break;
 				case REPL_MATSTATE_ERROR: throw std::runtime_error("ClusterAnalysis: #"+to_string(p->id)+" already has p.matState "+p->matState->pyStr()+" (it could be discarded, but ClusterAnalysis.replMatState=='error').");
 			}
 		}
@@ -193,38 +182,137 @@ void ClusterAnalysis::analyzeParticles(const vector<Particle::id_t>& ids, int le
 		auto& st(p->matState->cast<ClusterMatState>());
 		if((int)st.labels.size()<=level){
 			if((int)st.labels.size()<level) LOG_WARN("ClusterAnalysis: S.dem.par["+to_string(p->id)+"].matState.labels: current size "+to_string(st.labels.size())+", adding "+to_string(level)+"-level label would skip some values, possibly leading to garbage.");
-			st.labels.resize(level+1);
+			st.labels.resize(level+1,-1);
 		}
-		st.labels[level]=exBig[label];
+		st.labels[level]=label[c];
 	}
 
-	// TODO: recurse by passing ids of each cluster separately, with level+1
-	if(level<maxConn){
-		for(int big=0; big<(int)big2small.size(); big++){
-			int smallId=big2small[big];
-			// assemble only particles in this cluster
-			vector<Particle::id_t> subIds; subIds.reserve(smallSizes[smallId]);
-			for(size_t i=0; i<ids.size(); i++){
-				if((int)id2small[i]==smallId) subIds.push_back(ids[i]);
-			}
-			analyzeParticles(subIds,level+1);
-		}
+	// recurse by passing ids of each cluster separately, with level+1
+	if(level>=maxConn) return;
+	// bucket particle ids by component
+	vector<size_t> start(nComp+1,0);
+	for(const auto& c: comp) start[c+1]++;
+	for(size_t c=0; c<nComp; c++) start[c+1]+=start[c];
+	vector<Particle::id_t> byComp(ids.size());
+	vector<size_t> fill(start.begin(),start.end()-1);
+	for(size_t i=0; i<ids.size(); i++) byComp[fill[comp[i]]++]=ids[i];
+	for(size_t c=0; c<nComp; c++){
+		if(!isCluster(c)) continue;
+		analyzeParticles(vector<Particle::id_t>(byComp.begin()+start[c],byComp.begin()+start[c+1]),level+1);
 	}
 }
 
+namespace{
+	// lock-free union-find: roots are only ever linked under a root with smaller index (using CAS), so no cycles can form
+	long ufFind(vector<std::atomic<long>>& parent, long i){
+		while(true){
+			long p=parent[i].load(std::memory_order_relaxed);
+			if(p==i) return i;
+			long gp=parent[p].load(std::memory_order_relaxed);
+			// path halving; failure only means someone else changed it already
+			if(gp!=p) parent[i].compare_exchange_weak(p,gp,std::memory_order_relaxed);
+			i=gp;
+		}
+	}
+	void ufUnite(vector<std::atomic<long>>& parent, long a, long b){
+		while(true){
+			a=ufFind(parent,a); b=ufFind(parent,b);
+			if(a==b) return;
+			if(a<b) std::swap(a,b);
+			long expected=a;
+			if(parent[a].compare_exchange_strong(expected,b,std::memory_order_relaxed)) return;
+		}
+	}
+	// splitmix64 finalizer, for order-independent hashes of sets (sum of mixed values)
+	uint64_t mix64(uint64_t x){
+		x+=0x9e3779b97f4a7c15ULL;
+		x=(x^(x>>30))*0xbf58476d1ce4e5b9ULL;
+		x=(x^(x>>27))*0x94d049bb133111ebULL;
+		return x^(x>>31);
+	}
+}
 
 void ClusterAnalysis::run(){
 	dem=static_cast<DemField*>(field.get());
 	if((int)lastLabels.size()<=maxConn) lastLabels.resize(maxConn+1,-1);
+	const size_t nPar=dem->particles->size();
 
-	vector<Particle::id_t> pSeq;
-	// pSeq.reserve(dem->particles->size()); // will be most likely (much) smaller
+	// graph vertices: dense particle id → vertex table
+	id2v.assign(nPar,-1);
+	vector<Particle::id_t> ids;
 	for(const auto& p: *dem->particles){
 		assert(p);
 		if(p->shape
 			&& (mask==0 || p->mask&mask)
 			&& (box.isEmpty() || box.contains(p->shape->nodes[0]->pos))
-		) pSeq.push_back(p->id);
+		){ id2v[p->id]=ids.size(); ids.push_back(p->id); }
+	}
+	const long N=ids.size();
+
+	// connectivity 0: connected components, by union-find over the contact container
+	vector<std::atomic<long>> parent(N);
+	for(long i=0; i<N; i++) parent[i].store(i,std::memory_order_relaxed);
+	const auto& contacts(*dem->contacts);
+	const long nCon=contacts.size();
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static)
+	#endif
+	for(long i=0; i<nCon; i++){
+		const shared_ptr<Contact>& C(contacts[i]);
+		if(!C->isReal()) continue;
+		long a=id2v[C->leakPA()->id], b=id2v[C->leakPB()->id];
+		if(a<0 || b<0) continue;
+		ufUnite(parent,a,b);
+	}
+	// number components contiguously
+	vector<size_t> comp(N);
+	vector<long> root2comp(N,-1);
+	size_t nComp=0;
+	for(long i=0; i<N; i++){
+		long r=ufFind(parent,i);
+		if(root2comp[r]<0) root2comp[r]=nComp++;
+		comp[i]=root2comp[r];
+	}
+	LOG_TRACE("conn 0: {} connected components.",nComp);
+
+	// find components which did not change since the last run, by their members and contacts
+	vector<char> skip(nComp,0);
+	if(incremental){
+		vector<CompSig> sig(nComp);
+		vector<Particle::id_t> minId(nComp,std::numeric_limits<Particle::id_t>::max());
+		for(long i=0; i<N; i++){
+			auto& s(sig[comp[i]]);
+			s.num++; s.members+=mix64(ids[i]);
+			minId[comp[i]]=min(minId[comp[i]],ids[i]);
+		}
+		for(long i=0; i<nCon; i++){
+			const shared_ptr<Contact>& C(contacts[i]);
+			if(!C->isReal()) continue;
+			Particle::id_t idA=C->leakPA()->id, idB=C->leakPB()->id;
+			long a=id2v[idA];
+			if(a<0 || id2v[idB]<0) continue;
+			sig[comp[a]].edges+=mix64((uint64_t)min(idA,idB)<<32|(uint32_t)max(idA,idB));
+		}
+		if(prevSig.size()==nPar && prevClustMin==clustMin && prevMaxConn==maxConn){
+			for(size_t c=0; c<nComp; c++) skip[c]=(prevSig[minId[c]]==sig[c]);
+		}
+		prevSig.assign(nPar,CompSig());
+		for(size_t c=0; c<nComp; c++) prevSig[minId[c]]=sig[c];
+		prevClustMin=clustMin; prevMaxConn=maxConn;
+	} else prevSig.clear();
+	for(long i=0; i<N; i++) id2v[ids[i]]=-1;
+	nChanged=std::count(skip.begin(),skip.end(),0);
+	// labels of unchanged clusters (at all levels) stay as they are, and may not be claimed by other clusters
+	claimed.assign(maxConn+1,std::unordered_set<int>());
+	vector<size_t> sizes(nComp,0);
+	for(const auto& c: comp) sizes[c]++;
+	for(long i=0; i<N; i++){
+		if(!skip[comp[i]] || (int)sizes[comp[i]]<clustMin) continue;
+		const auto& p((*dem->particles)[ids[i]]);
+		if(!p->matState || !p->matState->isA<ClusterMatState>()) continue;
+		const auto& ll(p->matState->cast<ClusterMatState>().labels);
+		for(int l=0; l<=maxConn && l<(int)ll.size(); l++) if(ll[l]>=0) claimed[l].insert(ll[l]);
 	}
-	analyzeParticles(pSeq,/*level*/0);
+	LOG_DEBUG("conn 0: {} components, {} changed.",nComp,nChanged);
+	labelComponents(ids,comp,nComp,/*level*/0,&skip);
 }
@@ -2,6 +2,8 @@
 
 #include<woo/pkg/dem/Particle.hpp>
 
+#include<unordered_set>
+
 
 struct ClusterMatState: public MatState {
 	size_t getNumScalars() const override { return labels.size()*2; }
@@ -27,8 +29,23 @@ struct ClusterAnalysis: public PeriodicEngine {
 	WOO_DECL_LOGGER;
 	bool acceptsField(Field* f) override { return dynamic_cast<DemField*>(f); }
 	DemField* dem; // temp only
+	// connectivity level>0: split particles by min-cut of their contact graph, then label the resulting components
 	void analyzeParticles(const vector<Particle::id_t>& ids, int level);
+	// label particles ids[i] by their component comp[i] (0…nComp-1) and recurse into clusters for higher levels; components with skip[c] set are left alone
+	void labelComponents(const vector<Particle::id_t>& ids, const vector<size_t>& comp, size_t nComp, int level, const vector<char>* skip=nullptr);
 	void run() override;
+	// dense particle id → graph vertex table (-1 for particles not in the graph), reused between calls
+	vector<long> id2v;
+	// labels already used in this run, for each level; an old label is only reused by one cluster
+	vector<std::unordered_set<int>> claimed;
+	// signature of a level-0 component: number of members, hashes of member ids and of contacts between them
+	struct CompSig{
+		size_t num=0; uint64_t members=0, edges=0;
+		bool operator==(const CompSig& o) const { return num==o.num && members==o.members && edges==o.edges; }
+	};
+	// signatures from the previous run, indexed by the smallest particle id in the component
+	vector<CompSig> prevSig;
+	int prevClustMin=-1, prevMaxConn=-1;
 
 	#ifdef WOO_OPENGL
 		void render(const GLViewInfo&) override;
@@ -43,7 +60,9 @@ struct ClusterAnalysis: public PeriodicEngine {
 		((int,mask,0,,"Particles to consider in cluster analysis. If 0, consider all particles.")) \
 		((int,clustMin,5,,"Minimum number of particles to mark them as clustered.")) \
 		((vector<int>,lastLabels,,AttrTrait<Attr::readonly>(),"Next free labels to be used for respective connectivity level.")) \
-		((int,maxConn,0,,"Maximum connectivity (recursion) for cluster analysis. Only 0 is implemented so far.")) \
+		((int,maxConn,0,,"Maximum connectivity (recursion) for cluster analysis. Connectivity 0 are connected components of the contact graph (found by union-find over all contacts); for higher levels, clusters are split further by min-cut.")) \
+		((bool,incremental,true,,"Only (re)label components which changed since the last run (in their members or contacts), and only recurse into those for higher connectivity levels. Labels changed from outside will not be noticed in unchanged components.")) \
+		((long,nChanged,0,AttrTrait<Attr::readonly>(),"Number of connectivity-0 components which were (re)labeled in the last run.")) \
 		((int,replMatState,REPL_MATSTATE_ALWAYS,AttrTrait<Attr::namedEnum>().namedEnum({{REPL_MATSTATE_ALWAYS,{"always","yes","ok"}},{REPL_MATSTATE_NEVER,{"never","no"}},{REPL_MATSTATE_ERROR,{"error"}}}),"What to do when an existing :obj:`MatState` is attached to a particle but it is not a :obj:`ClusterMatState`.")) \
 		((Real,glColor,.4,,"Color for rendering the box (NaN to disable rendering)")) 
 
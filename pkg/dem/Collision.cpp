@@ -3,6 +3,7 @@
 #include<woo/pkg/dem/Contact.hpp>
 #ifdef WOO_OPENGL
 	#include<woo/lib/opengl/OpenGLWrapper.hpp>
+	#include<woo/lib/opengl/GLUtils.hpp>
 #endif
 
 WOO_PLUGIN(dem,(Aabb)(BoundFunctor)(BoundDispatcher)(Collider));
@@ -73,7 +74,7 @@ void Gl1_Aabb::go(const shared_ptr<Bound>& bv){
 		glScalev(Vector3r(mx-mn));
 	}
 	glDisable(GL_LINE_SMOOTH);
-	glutWireCube(1);
+	GLUtils::WireCube(1);
 	glEnable(GL_LINE_SMOOTH);
 }
 #endif
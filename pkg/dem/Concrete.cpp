@@ -72,8 +72,9 @@ void Cp2_ConcreteMat_ConcretePhys::go(const shared_ptr<Material>& m1, const shar
 	// geometry-dependent
 	assert(C->geom->isA<L6Geom>());
 	const auto& g(C->geom->cast<L6Geom>());
-	p->kn=p->E*g.contA/g.lens.sum();
-	p->kt=p->G*g.contA/g.lens.sum();
+	const Real contADivLen=g.contA/g.lens.sum();
+	p->kn=p->E*contADivLen;
+	p->kt=p->G*contADivLen;
 }
 
 
@@ -264,9 +265,10 @@ bool Law2_L6Geom_ConcretePhys::go(const shared_ptr<CGeom>& _geom, const shared_p
 	
 	if(C->isFresh(scene)) phys.uN0=geom.uN;
 
-	phys.epsN=(geom.uN-phys.uN0)/geom.lens.sum();
+	const Real lenSum=geom.lens.sum();
+	phys.epsN=(geom.uN-phys.uN0)/lenSum;
 
-	phys.epsT+=scene->dt*geom.vel.tail<2>()/geom.lens.sum();
+	phys.epsT+=(scene->dt/lenSum)*geom.vel.tail<2>();
 
 	Real& epsN(phys.epsN);
 	Vector2r& epsT(phys.epsT);
@@ -299,8 +301,12 @@ bool Law2_L6Geom_ConcretePhys::go(const shared_ptr<CGeom>& _geom, const shared_p
 
 	/* constitutive law */
 	Real epsNorm=max(epsN-epsNPl,0.); /* sqrt(epsN**2); */
-	kappaD=max(epsNorm,kappaD); /* kappaD is non-decreasing */
-	omega=isCohesive?ConcretePhys::funcG(kappaD,epsCrackOnset,epsFracture,neverDamage,damLaw):1.; /* damage parameter; simulate non-cohesive contact via full damage */
+	/* kappaD is non-decreasing; damage parameter only changes with kappaD, so funcG (with exp) is not evaluated otherwise */
+	if(epsNorm>kappaD){
+		kappaD=epsNorm;
+		if(isCohesive) omega=ConcretePhys::funcG(kappaD,epsCrackOnset,epsFracture,neverDamage,damLaw);
+	}
+	if(!isCohesive) omega=1.; /* simulate non-cohesive contact via full damage */
 	sigmaN=(1-(epsN-epsNPl>0?omega:0))*E*(epsN-epsNPl); /* normal stress */
 	if((epsSoft<0) && (epsN-epsNPl<epsSoft)){ /* plastic slip in compression */
 		Real sigmaNSoft=E*(epsSoft+relKnSoft*(epsN-epsSoft));
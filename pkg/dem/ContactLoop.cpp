@@ -3,6 +3,11 @@
 
 // temporary
 #include<woo/pkg/dem/G3Geom.hpp>
+// for trackStiffness
+#include<woo/pkg/dem/FrictMat.hpp>
+#include<woo/pkg/dem/L6Geom.hpp>
+// for evalStiffness
+#include<woo/pkg/dem/Funcs.hpp>
 
 WOO_PLUGIN(dem,(CGeomFunctor)(CGeomDispatcher)(CPhysFunctor)(CPhysDispatcher)(LawFunctor)(LawDispatcher)(ContactLoop));
 WOO_IMPL_LOGGER(ContactLoop);
@@ -12,6 +17,19 @@ WOO_IMPL__CLASS_BASE_DOC_PY(woo_dem_CPhysFunctor__CLASS_BASE_DOC_PY);
 WOO_IMPL__CLASS_BASE_DOC_PY(woo_dem_LawFunctor__CLASS_BASE_DOC_PY);
 WOO_IMPL__CLASS_BASE_DOC_ATTRS_CTOR(woo_dem_ContactLoop__CLASS_BASE_DOC_ATTRS_CTOR);
 
+// multirate level of contact between pA and pB: the finest level of their non-blocked nodes (see Multirate)
+static int contactLevel(const Particle* pA, const Particle* pB){
+	int ret=std::numeric_limits<int>::max();
+	for(const Particle* p: {pA,pB}){
+		if(!p->shape) continue;
+		for(const auto& n: p->shape->nodes){
+			const DemData& dyn=n->getData<DemData>();
+			if(!dyn.isBlockedAll()) ret=min(ret,dyn.level);
+		}
+	}
+	return ret==std::numeric_limits<int>::max()?0:ret;
+}
+
 
 shared_ptr<Contact> CGeomDispatcher::explicitAction(Scene* _scene, const shared_ptr<Particle>& p1, const shared_ptr<Particle>& p2, bool force){
 	scene=_scene;
@@ -121,6 +139,17 @@ void ContactLoop::run(){
 	bool removeUnseen=(dem.contacts->stepColliderLastRun>=0 && dem.contacts->stepColliderLastRun==scene->step);
 
 	const bool doStress=(evalStress && scene->isPeriodic);
+	const bool doStressStiffness=(doStress && evalStiffness);
+	// per-thread sums, added together after the loop
+	if(doStress){
+		#ifdef WOO_OPENMP
+			const size_t nThreads=omp_get_max_threads();
+		#else
+			const size_t nThreads=1;
+		#endif
+		stressTh.assign(nThreads,Matrix3r::Zero());
+		if(doStressStiffness) stiffTh.assign(nThreads,Matrix6r::Zero());
+	}
 	const bool deterministic(scene->deterministic);
 
 	if(reorderEvery>0 && (scene->step%reorderEvery==0)) reorderContacts();
@@ -130,105 +159,161 @@ void ContactLoop::run(){
 	CONTACTLOOP_CHECKPOINT("prologue");
 
 	const bool hasHook=!!hook;
+	const bool hasSleeping=(dem.nSleeping>0);
+	const bool doStiffness=(trackStiffness || stiffRequestStep==scene->step);
+	if(doStiffness){
+		const auto& nodes(dem.nodes);
+		const long nNodes=nodes.size();
+		#ifdef WOO_OPENMP
+			#pragma omp parallel for schedule(static)
+		#endif
+		for(long i=0; i<nNodes; i++){ DemData& dyn(nodes[i]->getData<DemData>()); dyn.stiffTrans=dyn.stiffRot=Vector3r::Zero(); }
+	}
 
-	#ifdef WOO_OPENMP
-		#pragma omp parallel for schedule(guided)
-	#endif
-	for(size_t i=0; i<size; i++){
-		CONTACTLOOP_CHECKPOINT("loop-begin");
-		const shared_ptr<Contact>& C=(*dem.contacts)[i];
-
-		if(WOO_UNLIKELY(removeUnseen && !C->isReal() && C->stepLastSeen<scene->step)) { removeAfterLoop(C); continue; }
-		if(WOO_UNLIKELY(!C->isReal() && !C->isColliding())){ removeAfterLoop(C); continue; }
-
-		/* this block is called exactly once for every potential contact created; it should check whether shapes
-			should be swapped, and also set minDist00Sq if used (Sphere-Sphere only)
-		*/
-		if(WOO_UNLIKELY(!C->isReal() && C->isFresh(scene))){
-			bool swap=false;
-			const shared_ptr<CGeomFunctor>& cgf=geoDisp->getFunctor2D(C->leakPA()->shape,C->leakPB()->shape,swap);
-			if(!cgf) continue;
-			if(swap){ C->swapOrder(); }
-			cgf->setMinDist00Sq(C->pA.lock()->shape,C->pB.lock()->shape,C);
-			CONTACTLOOP_CHECKPOINT("swap-check");
-		}
-		Particle *pA=C->leakPA(), *pB=C->leakPB();
-		Vector3r shift2=(scene->isPeriodic?scene->cell->intrShiftPos(C->cellDist):Vector3r::Zero());
-		// the order is as the geometry functor expects it
-		shared_ptr<Shape>& sA(pA->shape); shared_ptr<Shape>& sB(pB->shape);
-
-		// if minDist00Sq is defined, we might see that there is no contact without ever calling the functor
-		// saving quite a few calls for sphere-sphere contacts
-		if(WOO_LIKELY(dist00 && !C->isReal() && !C->isFresh(scene) && C->minDist00Sq>0 && (sA->nodes[0]->pos-(sB->nodes[0]->pos+shift2)).squaredNorm()>C->minDist00Sq)){
-			CONTACTLOOP_CHECKPOINT("dist00Sq-too-far");
-			continue;
-		}
-
-		CONTACTLOOP_CHECKPOINT("pre-geom");
-
-		bool geomCreated=geoDisp->operator()(sA,sB,shift2,/*force*/false,C);
-
-		CONTACTLOOP_CHECKPOINT("geom");
-		if(!geomCreated){
-			if(/* has both geo and phy */C->isReal()) LOG_ERROR("CGeomFunctor {} did not update existing contact ##{}+{}",geoDisp->getClassName(),pA->id,pB->id);
-			continue;
-		}
-
-
-		// CPhys
-		if(!C->phys) C->stepCreated=scene->step;
-		if(!C->phys || updatePhys>UPDATE_PHYS_NEVER) phyDisp->operator()(pA->material,pB->material,C);
-		if(!C->phys) throw std::runtime_error("ContactLoop: ##"+to_string(pA->id)+"+"+to_string(pB->id)+": con Contact.phys created from materials "+pA->material->getClassName()+" and "+pB->material->getClassName()+" (a CPhysFunctor must be available for every contacting material combination).");
-
-		if(hasHook && C->isFresh(scene) && hook->isMatch(pA->mask,pB->mask)) hook->hookNew(dem,C);
+	// with multirate integration (see Multirate), contacts are processed in passes by their level m, each with scene->dt=2^m*dt;
+	// contacts of level m are only due every 2^m steps, right before Leapfrog updates velocities of level-m nodes (step+1 is a multiple of 2^m),
+	// and apply the impulse of the whole period (2^m times their force) then; nothing is applied in steps in between (r-RESPA),
+	// which also means that new contacts of level m are only detected in those steps
+	const int mrLevel=dem.maxLevel;
+	const Real dt0=scene->dt;
+	int nPasses=1;
+	if(WOO_UNLIKELY(mrLevel>0)){ while(nPasses<=mrLevel && ((scene->step+1)&((1L<<nPasses)-1))==0) nPasses++; }
+	for(int pass=0; pass<nPasses; pass++){
+		if(pass>0) scene->dt=dt0*(1<<pass);
+		#ifdef WOO_OPENMP
+			#pragma omp parallel for schedule(guided)
+		#endif
+		for(size_t i=0; i<size; i++){
+			CONTACTLOOP_CHECKPOINT("loop-begin");
+			const shared_ptr<Contact>& C=(*dem.contacts)[i];
+
+			// all contacts are visited in the first pass already, don't check them again
+			if(WOO_UNLIKELY(removeUnseen && !C->isReal() && C->stepLastSeen<scene->step)) { if(pass==0) removeAfterLoop(C); continue; }
+			if(WOO_UNLIKELY(!C->isReal() && !C->isColliding())){ if(pass==0) removeAfterLoop(C); continue; }
+
+			/* this block is called exactly once for every potential contact created; it should check whether shapes
+				should be swapped, and also set minDist00Sq if used (Sphere-Sphere only)
+			*/
+			if(WOO_UNLIKELY(pass==0 && !C->isReal() && C->isFresh(scene))){
+				bool swap=false;
+				const shared_ptr<CGeomFunctor>& cgf=geoDisp->getFunctor2D(C->leakPA()->shape,C->leakPB()->shape,swap);
+				if(!cgf) continue;
+				if(swap){ C->swapOrder(); }
+				cgf->setMinDist00Sq(C->pA.lock()->shape,C->pB.lock()->shape,C);
+				CONTACTLOOP_CHECKPOINT("swap-check");
+			}
+			if(WOO_UNLIKELY(mrLevel>0)){
+				const int m=contactLevel(C->leakPA(),C->leakPB());
+				if(m!=pass){
+					// not due in this step (or in another pass); stiffness is still needed every step
+					if(pass==0 && m>=nPasses && doStiffness && C->isReal() && WOO_LIKELY(!deterministic)) addNodalStiffness(C);
+					continue;
+				}
+			}
+			Particle *pA=C->leakPA(), *pB=C->leakPB();
+			Vector3r shift2=(scene->isPeriodic?scene->cell->intrShiftPos(C->cellDist):Vector3r::Zero());
+			// the order is as the geometry functor expects it
+			shared_ptr<Shape>& sA(pA->shape); shared_ptr<Shape>& sB(pB->shape);
+
+			// if minDist00Sq is defined, we might see that there is no contact without ever calling the functor
+			// saving quite a few calls for sphere-sphere contacts
+			if(WOO_LIKELY(dist00 && !C->isReal() && !C->isFresh(scene) && C->minDist00Sq>0 && (sA->nodes[0]->pos-(sB->nodes[0]->pos+shift2)).squaredNorm()>C->minDist00Sq)){
+				CONTACTLOOP_CHECKPOINT("dist00Sq-too-far");
+				continue;
+			}
 
-		CONTACTLOOP_CHECKPOINT("phys");
+			// contacts between sleeping particles (see Deactivator) are frozen: geometry is not updated and the stored force is applied;
+			// the law is only called (with zero relative velocities) when energy is tracked, so that elastic energy remains accounted for;
+			// that is only possible with L6Geom, contacts with other geometries are then processed normally
+			const bool frozen=(WOO_UNLIKELY(hasSleeping) && Particle::isContactFrozen(pA,pB) && (!scene->trackEnergy || !C->geom || dynamic_cast<L6Geom*>(C->geom.get())));
+			if(frozen && !C->isReal()) continue;
+
+			if(!frozen){
+				CONTACTLOOP_CHECKPOINT("pre-geom");
+
+				bool geomCreated=geoDisp->operator()(sA,sB,shift2,/*force*/false,C);
+
+				CONTACTLOOP_CHECKPOINT("geom");
+				if(!geomCreated){
+					if(/* has both geo and phy */C->isReal()) LOG_ERROR("CGeomFunctor {} did not update existing contact ##{}+{}",geoDisp->getClassName(),pA->id,pB->id);
+					continue;
+				}
+
+
+				// CPhys
+				if(!C->phys) C->stepCreated=scene->step;
+				if(!C->phys || updatePhys>UPDATE_PHYS_NEVER) phyDisp->operator()(pA->material,pB->material,C);
+				if(!C->phys) throw std::runtime_error("ContactLoop: ##"+to_string(pA->id)+"+"+to_string(pB->id)+": con Contact.phys created from materials "+pA->material->getClassName()+" and "+pB->material->getClassName()+" (a CPhysFunctor must be available for every contacting material combination).");
+
+				if(hasHook && C->isFresh(scene) && hook->isMatch(pA->mask,pB->mask)) hook->hookNew(dem,C);
+
+				CONTACTLOOP_CHECKPOINT("phys");
+
+				// CLaw
+				bool keepContact=lawDisp->operator()(C->geom,C->phys,C);
+				if(!keepContact){
+					if(hasHook && hook->isMatch(pA->mask,pB->mask)) hook->hookDel(dem,C); // call before requestRemove resets contact internals
+					dem.contacts->requestRemoval(C);
+				}
+				CONTACTLOOP_CHECKPOINT("law");
+			} else if(WOO_UNLIKELY(scene->trackEnergy)){
+				L6Geom& g=C->geom->cast<L6Geom>();
+				g.vel=g.angVel=Vector3r::Zero();
+				if(!lawDisp->operator()(C->geom,C->phys,C)){
+					if(hasHook && hook->isMatch(pA->mask,pB->mask)) hook->hookDel(dem,C);
+					dem.contacts->requestRemoval(C);
+				}
+			}
 
-		// CLaw
-		bool keepContact=lawDisp->operator()(C->geom,C->phys,C);
-		if(!keepContact){
-			if(hasHook && hook->isMatch(pA->mask,pB->mask)) hook->hookDel(dem,C); // call before requestRemove resets contact internals
-			dem.contacts->requestRemoval(C);
-		}
-		CONTACTLOOP_CHECKPOINT("law");
-
-		if(applyForces && C->isReal() && WOO_LIKELY(!deterministic)){
-			applyForceUninodal(C,pA);
-			applyForceUninodal(C,pB);
-			#if  0
-			for(const Particle* particle:{pA,pB}){
-				// remove once tested thoroughly
-					const shared_ptr<Shape>& sh(particle->shape);
-					if(!sh || sh->nodes.size()!=1) continue;
-					// if(sh->nodes.size()!=1) continue;
-					#if 0
-						for(size_t i=0; i<sh->nodes.size(); i++){
-							if((sh->nodes[i]->getData<DemData>().flags&DemData::DOF_ALL)!=DemData::DOF_ALL) LOG_WARN("Multinodal #{} has free DOFs, but force will not be applied; set ContactLoop.applyForces=False and use IntraForce(...) dispatcher instead.",particle->id);
-						}
-					#endif
-					Vector3r F,T,xc;
-					std::tie(F,T,xc)=C->getForceTorqueBranch(particle,/*nodeI*/0,scene);
-					sh->nodes[0]->getData<DemData>().addForceTorque(F,xc.cross(F)+T);
+			if(doStiffness && C->isReal() && WOO_LIKELY(!deterministic)) addNodalStiffness(C);
+
+			if(applyForces && C->isReal() && WOO_LIKELY(!deterministic)){
+				// impulse of the whole period for multirate contacts
+				const Real mult=(1<<pass);
+				applyForceUninodal(C,pA,mult);
+				applyForceUninodal(C,pB,mult);
+				#if  0
+				for(const Particle* particle:{pA,pB}){
+					// remove once tested thoroughly
+						const shared_ptr<Shape>& sh(particle->shape);
+						if(!sh || sh->nodes.size()!=1) continue;
+						// if(sh->nodes.size()!=1) continue;
+						#if 0
+							for(size_t i=0; i<sh->nodes.size(); i++){
+								if((sh->nodes[i]->getData<DemData>().flags&DemData::DOF_ALL)!=DemData::DOF_ALL) LOG_WARN("Multinodal #{} has free DOFs, but force will not be applied; set ContactLoop.applyForces=False and use IntraForce(...) dispatcher instead.",particle->id);
+							}
+						#endif
+						Vector3r F,T,xc;
+						std::tie(F,T,xc)=C->getForceTorqueBranch(particle,/*nodeI*/0,scene);
+						sh->nodes[0]->getData<DemData>().addForceTorque(F,xc.cross(F)+T);
+				}
+				#endif
 			}
-			#endif
-		}
 
-		// track gradV work
-		/* this is meant to avoid calling extra loop at every step, since the work must be evaluated incrementally */
-		if(doStress && /*contact law deleted the contact?*/ C->isReal()){
-			const auto& nnA(pA->shape->nodes); const auto& nnB(pB->shape->nodes);
-			if(nnA.size()!=1 || nnB.size()!=1) throw std::runtime_error("ContactLoop.trackWork not allowed with multi-nodal particles in contact (##"+to_string(pA->id)+"+"+to_string(pB->id)+")");
-			Vector3r branch=C->dPos(scene); // (nnB[0]->pos-nnA[0]->pos+scene->cell->intrShiftPos(C->cellDist));
-			Vector3r F=C->geom->node->ori*C->phys->force; // force in global coords
-			#ifdef WOO_OPENMP
-				#pragma omp critical
-			#endif
-			{
-				stress.noalias()+=F*branch.transpose();
+			// track gradV work
+			/* this is meant to avoid calling extra loop at every step, since the work must be evaluated incrementally */
+			if(doStress && /*contact law deleted the contact?*/ C->isReal()){
+				const auto& nnA(pA->shape->nodes); const auto& nnB(pB->shape->nodes);
+				if(nnA.size()!=1 || nnB.size()!=1) throw std::runtime_error("ContactLoop.trackWork not allowed with multi-nodal particles in contact (##"+to_string(pA->id)+"+"+to_string(pB->id)+")");
+				Vector3r branch=C->dPos(scene); // (nnB[0]->pos-nnA[0]->pos+scene->cell->intrShiftPos(C->cellDist));
+				Vector3r F=C->geom->node->ori*C->phys->force; // force in global coords
+				#ifdef WOO_OPENMP
+					const int th=omp_get_thread_num();
+				#else
+					const int th=0;
+				#endif
+				stressTh[th].noalias()+=F*branch.transpose();
+				if(doStressStiffness && dynamic_cast<FrictPhys*>(C->phys.get())){
+					Vector3r n=C->geom->node->ori*Vector3r::UnitX();
+					if(G3Geom* g3g=dynamic_cast<G3Geom*>(C->geom.get())) n=g3g->normal;
+					const auto& ph=C->phys->cast<FrictPhys>();
+					DemFuncs::addContactStiffness(stiffTh[th],n,branch.norm(),ph.kn,ph.kt);
+				}
 			}
+			CONTACTLOOP_CHECKPOINT("force+stress");
 		}
-		CONTACTLOOP_CHECKPOINT("force+stress");
 	}
+	scene->dt=dt0;
 	// process removeAfterLoop
 	#ifdef WOO_OPENMP
 		for(list<shared_ptr<Contact>>& l: removeAfterLoopRefs){
@@ -241,7 +326,15 @@ void ContactLoop::run(){
 	#endif
 	// compute gradVWork eventually
 	if(doStress){
+		for(const auto& s: stressTh) stress+=s;
 		stress/=scene->cell->getVolume();
+		if(doStressStiffness){
+			stiffness=Matrix6r::Zero();
+			for(const auto& K: stiffTh) stiffness+=K;
+			for(int p=0;p<6;p++)for(int q=p+1;q<6;q++) stiffness(q,p)=stiffness(p,q); // symmetrize
+			stiffness/=scene->cell->getVolume();
+		}
+		stressStep=scene->step;
 		if(scene->trackEnergy){
 			Matrix3r midStress=.5*(stress+prevStress);
 			Real midVol=(!isnan(prevVol)?.5*(prevVol+scene->cell->getVolume()):scene->cell->getVolume());
@@ -258,19 +351,54 @@ void ContactLoop::run(){
 		// non-paralell loop here
 		for(const auto& C: *dem.contacts){
 			if(!C->isReal()) continue;
-			applyForceUninodal(C,C->leakPA());
-			applyForceUninodal(C,C->leakPB());
+			Real mult=1.;
+			if(WOO_UNLIKELY(mrLevel>0)){
+				const int m=contactLevel(C->leakPA(),C->leakPB());
+				if(m>=nPasses) continue; // not due
+				mult=(1<<m);
+			}
+			applyForceUninodal(C,C->leakPA(),mult);
+			applyForceUninodal(C,C->leakPB(),mult);
 		}
 	}
+	if(WOO_UNLIKELY(deterministic) && doStiffness){
+		for(const auto& C: *dem.contacts){ if(C->isReal()) addNodalStiffness(C); }
+	}
+	if(doStiffness) stiffStep=scene->step;
 	// reset updatePhys if it was to be used only once
 	if(updatePhys==UPDATE_PHYS_ONCE) updatePhys=UPDATE_PHYS_NEVER;
 	CONTACTLOOP_CHECKPOINT("epilogue");
 }
 
-void ContactLoop::applyForceUninodal(const shared_ptr<Contact>& C, const Particle* particle){
+void ContactLoop::applyForceUninodal(const shared_ptr<Contact>& C, const Particle* particle, Real mult){
 	const auto& sh(particle->shape);
 	if(!sh || sh->nodes.size()!=1) return;
 	Vector3r F,T,xc;
 	std::tie(F,T,xc)=C->getForceTorqueBranch(particle,/*nodeI*/0,scene);
+	if(WOO_UNLIKELY(mult!=1.)){ F*=mult; T*=mult; }
 	sh->nodes[0]->getData<DemData>().addForceTorque(F,xc.cross(F)+T);
 }
+
+void ContactLoop::addNodalStiffness(const shared_ptr<Contact>& C){
+	// same as what DynDt::nodalStiffAdd computes when traversing contacts of particles
+	const FrictPhys* ph=dynamic_cast<const FrictPhys*>(C->phys.get());
+	const L6Geom* g=dynamic_cast<const L6Geom*>(C->geom.get());
+	if(!ph || !g) return;
+	Vector3r n=C->geom->node->ori*Vector3r::UnitX(); // contact normal in global coords
+	Vector3r n2=n.array().pow(2).matrix();
+	Vector3r kt=n2*(ph->kn-ph->kt)+Vector3r::Constant(ph->kt);
+	Vector3r krDir(n2[1]+n2[2],n2[2]+n2[0],n2[0]+n2[1]);
+	for(short ix: {0,1}){
+		const Particle* p=(ix==0?C->leakPA():C->leakPB());
+		if(!p->shape) continue;
+		// rotational stiffness only due to translation
+		Vector3r kr=pow2(g->lens[ix])*ph->kt*krDir;
+		for(const auto& nn: p->shape->nodes){
+			DemData& dyn(nn->getData<DemData>());
+			if(!dyn.isClumped()){ dyn.addStiffness(kt,kr); continue; }
+			// clump members contribute to the clump node
+			shared_ptr<Node> master(dyn.master.lock());
+			if(master) master->getData<DemData>().addStiffness(kt,kr);
+		}
+	}
+}
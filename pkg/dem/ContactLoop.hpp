@@ -7,6 +7,11 @@
 #include<woo/pkg/dem/Contact.hpp>
 #include<woo/pkg/dem/ContactHook.hpp>
 
+#include<array>
+#include<map>
+#include<cstring>
+#include<shared_mutex>
+
 /* ***************************************** */
 
 struct CGeomFunctor: public Functor2D<
@@ -31,6 +36,52 @@ class CPhysFunctor: public Functor2D<
 };
 WOO_REGISTER_OBJECT(CPhysFunctor);
 
+/*
+Per-material-pair table of constants for CPhysFunctor's, which otherwise re-derive the same values (effective moduli,
+damping coefficients, averages) for every new contact. Entries are keyed by material addresses, hold weak references
+to the materials and remember N input values they were computed from (material and functor parameters); when the inputs
+change (material was modified), or the address belongs to another material (the old one was deleted), the entry is
+re-computed, so the table never needs explicit invalidation. Entries of deleted materials are purged whenever an entry
+is (re)computed. Inputs are compared bitwise, so that NaN inputs hit the cache as well.
+
+Lookups only take a shared lock, since functors run from the parallel ContactLoop. The table is not copied with the functor.
+*/
+template<size_t N, typename Consts>
+class MatPairTable{
+	public:
+	typedef std::array<Real,N> Inputs;
+	private:
+	struct Entry{ weak_ptr<Material> m1; weak_ptr<Material> m2; Inputs in; Consts c; };
+	std::map<std::pair<const Material*,const Material*>,Entry> entries;
+	mutable std::shared_mutex mutex;
+	// same object (not only the same address); m is alive, so its control block cannot be re-used
+	static bool same(const weak_ptr<Material>& w, const shared_ptr<Material>& m){ return !w.owner_before(m) && !m.owner_before(w); }
+	public:
+	MatPairTable(){}
+	MatPairTable(const MatPairTable&){}
+	MatPairTable& operator=(const MatPairTable&){ return *this; }
+	// return constants for m1+m2, calling compute() if not found or stale
+	template<typename ComputeT>
+	Consts get(const shared_ptr<Material>& m1, const shared_ptr<Material>& m2, const Inputs& in, ComputeT compute){
+		const auto key=std::make_pair(m1.get(),m2.get());
+		{
+			std::shared_lock<std::shared_mutex> l(mutex);
+			auto I=entries.find(key);
+			if(I!=entries.end() && same(I->second.m1,m1) && same(I->second.m2,m2) && memcmp(I->second.in.data(),in.data(),sizeof(Inputs))==0) return I->second.c;
+		}
+		Consts c=compute();
+		std::unique_lock<std::shared_mutex> l(mutex);
+		for(auto I=entries.begin(); I!=entries.end(); ){
+			if(I->second.m1.expired() || I->second.m2.expired()) I=entries.erase(I);
+			else ++I;
+		}
+		entries[key]=Entry{m1,m2,in,c};
+		return c;
+	}
+	size_t size() const { std::shared_lock<std::shared_mutex> l(mutex); return entries.size(); }
+	void clear(){ std::unique_lock<std::shared_mutex> l(mutex); entries.clear(); }
+};
+
 
 class LawFunctor: public Functor2D<
 	/*dispatch types*/ CGeom,CPhys,
@@ -85,10 +136,16 @@ class ContactLoop: public Engine {
 		list<shared_ptr<Contact>> removeAfterLoopRefs;
 		void removeAfterLoop(const shared_ptr<Contact>& c){ removeAfterLoopRefs.push_back(c); }
 	#endif
+	// per-thread sums of stress and stiffness, with evalStress
+	vector<Matrix3r> stressTh;
+	vector<Matrix6r> stiffTh;
 	void reorderContacts();
 
 	// internal use only
-	void applyForceUninodal(const shared_ptr<Contact>& C, const Particle* p);
+	// mult>1 for multirate contacts, which apply impulse of several steps at once (see Multirate)
+	void applyForceUninodal(const shared_ptr<Contact>& C, const Particle* p, Real mult=1.);
+	// add contact stiffness to DemData::stiffTrans, DemData::stiffRot of all nodes of both particles (clump members to their clump node)
+	void addNodalStiffness(const shared_ptr<Contact>& C);
 
 	public:
 		virtual void pyHandleCustomCtorArgs(py::args_& t, py::kwargs& d) override;
@@ -120,11 +177,17 @@ class ContactLoop: public Engine {
 			/*((bool,alreadyWarnedForceNotApplied,false,AttrTrait<>().noGui(),"We already warned if forces are not applied here and no IntraForce engine exists in O.scene.engines")) */ \
 			((bool,dist00,true,,"Whether to apply the Contact.minDist00Sq optimization (for mesuring the speedup only)")) \
 			((Matrix3r,stress,Matrix3r::Zero(),AttrTrait<Attr::readonly>(),"Stress value, used to compute *gradV*  energy if *trackWork* is True.")) \
+			((bool,evalStiffness,false,,"With :obj:`evalStress`, also evaluate :obj:`stiffness`, so that stress controllers (:obj:`PeriIsoCompressor`, :obj:`WeirdTriaxControl`) don't have to traverse contacts again (see :obj:`woo.utils.stressStiffnessWork`).")) \
+			((Matrix6r,stiffness,Matrix6r::Zero(),AttrTrait<Attr::readonly>(),"Stiffness tensor in Voigt notation, evaluated with :obj:`evalStiffness` from contacts with :obj:`FrictPhys`.")) \
+			((long,stressStep,-1,AttrTrait<Attr::readonly|Attr::noSave>(),"Step in which :obj:`stress` (and :obj:`stiffness`) was evaluated last time.")) \
 			((int,reorderEvery,1000,,"Reorder contacts so that real ones are at the beginning in the linear sequence, making the OpenMP loop traversal (hopefully) less unbalanced.")) \
 			((Real,prevVol,NaN,AttrTrait<Attr::hidden>(),"Previous value of cell volume")) \
 			/*((Real,prevTrGradVStress,NaN,AttrTrait<Attr::hidden>(),"Previous value of tr(gradV*stress)"))*/ \
 			((Matrix3r,prevStress,Matrix3r::Zero(),,"Previous value of stress, used to compute mid-step stress")) \
 			((int,gradVIx,-1,AttrTrait<Attr::hidden|Attr::noSave>(),"Cache energy index for gradV work")) \
+			((bool,trackStiffness,false,,"Accumulate translational and rotational stiffness of real contacts with :obj:`FrictPhys` on nodes (in the same lock as forces are applied) at every step. :obj:`DynDt` with :obj:`~DynDt.viaContactLoop` does not need this flag, it requests accumulation only in steps when it runs (see :obj:`stiffRequestStep`).")) \
+			((long,stiffRequestStep,-1,AttrTrait<Attr::readonly|Attr::noSave>(),"Step in which nodal stiffnesses are accumulated even without :obj:`trackStiffness`; set by :obj:`DynDt` with :obj:`~DynDt.viaContactLoop` to the step when it runs next.")) \
+			((long,stiffStep,-1,AttrTrait<Attr::readonly|Attr::noSave>(),"Step in which nodal stiffnesses were accumulated (with :obj:`trackStiffness`) last time.")) \
 			, /*ctor*/ \
 				woo_dem_ContactLoop__CTOR_timingDeltas \
 				woo_dem_ContactLoop__CTOR_removeAfterLoopRefs
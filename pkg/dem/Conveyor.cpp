@@ -51,6 +51,10 @@ Real ConveyorInlet::packVol() const {
 }
 
 void ConveyorInlet::postLoad(ConveyorInlet&,void* attr){
+	if(attr==NULL || attr==&spill){
+		if(spill) spill->setCols({"diam","mass","time"});
+		if(attr==&spill) return;
+	}
 	if(attr==NULL || attr==&spherePack || attr==&clumps || attr==&centers || attr==&radii || attr==&shapePack){
 		if(spherePack){
 			// spherePack given
@@ -147,22 +151,26 @@ void ConveyorInlet::sortPacking(const Real& zTrimVol){
 	if(hasClumps() && radii.size()!=clumps.size()) throw std::logic_error("ConveyorInlet.sortPacking: clumps not empty and clumps.size()!=centers.size()");
 	if(!(cellLen>0) /*catches NaN as well*/) ValueError("ConveyorInlet.cellLen must be positive (not "+to_string(cellLen)+")");
 	size_t N=radii.size();
-	// sort spheres according to their x-coordinate
-	// copy arrays to structs first
-	struct CRC{ Vector3r c; Real r; shared_ptr<SphereClumpGeom> clump; };
-	vector<CRC> ccrrcc(radii.size());
 	bool doClumps=hasClumps();
+	// sort according to the z-coordinate of the top, if z-trimming, otherwise according to the x-coord of the center
+	// only sort keys with indices, then permute the arrays (clumps are not copied around during sorting)
+	vector<std::pair<Real,size_t>> keyIx(N);
 	for(size_t i=0;i<N;i++){
 		if(centers[i][0]<0 || centers[i][0]>=cellLen) centers[i][0]=CompUtils::wrapNum(centers[i][0],cellLen);
-		ccrrcc[i]=CRC{centers[i],radii[i],doClumps?clumps[i]:shared_ptr<SphereClumpGeom>()};
+		keyIx[i]=std::make_pair(zTrimVol>0?centers[i][2]+radii[i]:centers[i][0],i);
+	}
+	std::sort(keyIx.begin(),keyIx.end(),[](const std::pair<Real,size_t>& a, const std::pair<Real,size_t>& b)->bool{ return a.first<b.first; });
+	{
+		vector<Vector3r> cc(N); vector<Real> rr(N); vector<shared_ptr<SphereClumpGeom>> ccll(doClumps?N:0);
+		for(size_t i=0;i<N;i++){
+			const size_t j=keyIx[i].second;
+			cc[i]=centers[j]; rr[i]=radii[j];
+			if(doClumps) ccll[i]=std::move(clumps[j]);
+		}
+		centers.swap(cc); radii.swap(rr); if(doClumps) clumps.swap(ccll);
 	}
-	// sort according to the z-coordinate of the top, if z-trimming, otherwise according to the x-coord of the center
-	if(zTrimVol>0) std::sort(ccrrcc.begin(),ccrrcc.end(),[](const CRC& a, const CRC& b)->bool{ return (a.c[2]+a.r<b.c[2]+b.r); });
-	else std::sort(ccrrcc.begin(),ccrrcc.end(),[](const CRC& a, const CRC& b)->bool{ return a.c[0]<b.c[0]; });
 	Real currVol=0.;
 	for(size_t i=0;i<N;i++){
-		centers[i]=ccrrcc[i].c; radii[i]=ccrrcc[i].r;
-		if(doClumps) clumps[i]=ccrrcc[i].clump;
 		// z-trimming
 		if(zTrimVol>0){
 			currVol+=(doClumps?clumps[i]->volume:(4/3.)*M_PI*pow3(radii[i]));
@@ -286,9 +294,13 @@ void ConveyorInlet::run(){
 	int stepNum=0;
 	// LOG_DEBUG("lenToDo={}, time={}, virtPrev={}, packVel={} (packVelCorrected={}",lenToDo,scene->time,virtPrev,packVel,packVelCorrected);
 	Real lenDone=0;
+	// new particles and nodes are collected and inserted at once after the loop
+	vector<shared_ptr<Particle>> newPar;
+	vector<shared_ptr<Node>> newNodes;
+	bool allDone=false;
 	while(true){
 		// done forever
-		if(Inlet::everythingDone()) return;
+		if(Inlet::everythingDone()){ allDone=true; break; }
 
 		LOG_TRACE("Doing next particle: mass/maxMass={}/{}, num/maxNum{}/{}",mass,maxMass,num,maxNum);
 		if(nextIx<0) nextIx=centers.size()-1;
@@ -332,8 +344,8 @@ void ConveyorInlet::run(){
 			// use conveyor's identity orientation which is added to the particle's orientation
 			std::tie(nn,pp)=r->makeParticles(material,/*pos*/newPos,/*ori*/node->ori,/*mask*/mask,/*scale*/1.);
 			for(auto& p: pp){
-				dem->particles->insert(p);
-				LOG_TRACE("[shapePack] new particle #{} at {}({}): {}",p->id,newPos,p->shape->nodes[0]->pos,p->shape->pyStr());
+				newPar.push_back(p);
+				LOG_TRACE("[shapePack] new particle at {}({}): {}",newPos,p->shape->nodes[0]->pos,p->shape->pyStr());
 			}
 		} else {
 			if(!hasClumps()){
@@ -341,16 +353,16 @@ void ConveyorInlet::run(){
 				sphere->mask=mask;
 				nn.push_back(sphere->shape->nodes[0]);
 				//LOG_TRACE("x={}, {}-({})*{}+{}",x,lenToDo,1+currWraps,cellLen,currX);
-				dem->particles->insert(sphere);
+				newPar.push_back(sphere);
 				nn[0]->pos=newPos;
-				LOG_TRACE("New sphere #{}, r={} at {}",sphere->id,radii[nextIx],nn[0]->pos.transpose());
+				LOG_TRACE("New sphere r={} at {}",radii[nextIx],nn[0]->pos.transpose());
 			} else {
 				const auto& clump=clumps[nextIx];
 				vector<shared_ptr<Particle>> spheres;
 				std::tie(nn,spheres)=clump->makeParticles(material,/*pos*/newPos,/*ori*/Quaternionr::Identity(),/*mask*/mask,/*scale*/1.);
 				for(auto& sphere: spheres){
-					dem->particles->insert(sphere);
-					LOG_TRACE("[clump] new sphere #{}, r={} at {}",sphere->id,radii[nextIx],nn[0]->pos.transpose());
+					newPar.push_back(sphere);
+					LOG_TRACE("[clump] new sphere r={} at {}",radii[nextIx],nn[0]->pos.transpose());
 				}
 			}
 		}
@@ -387,11 +399,7 @@ void ConveyorInlet::run(){
 				}
 			}
 
-			#ifdef WOO_OPENGL
-				std::scoped_lock lock(dem->nodesMutex);
-			#endif
-			dyn.linIx=dem->nodes.size();
-			dem->nodes.push_back(n);
+			newNodes.push_back(n);
 
 			stepMass+=dyn.mass;
 			mass+=dyn.mass;
@@ -399,7 +407,10 @@ void ConveyorInlet::run(){
 		}
 
 		// add mass of all nodes
-		if(save) genDiamMassTime.push_back(Vector3r(2*radii[nextIx],nnMass,scene->time));
+		if(save){
+			if(spill) spill->append({2*radii[nextIx],nnMass,scene->time});
+			else genDiamMassTime.push_back(Vector3r(2*radii[nextIx],nnMass,scene->time));
+		}
 
 		num+=1;
 		stepNum+=1;
@@ -409,6 +420,20 @@ void ConveyorInlet::run(){
 		nextIx-=1; 
 	};
 
+	dem->particles->insertMany(newPar);
+	if(!newNodes.empty()){
+		#ifdef WOO_OPENGL
+			std::scoped_lock lock(dem->nodesMutex);
+		#endif
+		for(auto& n: newNodes){
+			n->getData<DemData>().linIx=dem->nodes.size();
+			dem->nodes.push_back(n);
+		}
+	}
+	LOG_DEBUG("Inserted {} particles with {} nodes.",newPar.size(),newNodes.size());
+	// done forever
+	if(allDone) return;
+
 	setCurrRate(stepMass/(/*time*/lenToDo/packVel));
 
 	dem->contacts->dirty=true; // re-initialize the collider
@@ -420,25 +445,19 @@ void ConveyorInlet::run(){
 }
 
 py::object ConveyorInlet::pyDiamMass(bool zipped) const {
-	return DemFuncs::seqVectorToPy(genDiamMassTime,/*itemGetter*/[](const Vector3r& i)->Vector2r{ return i.head<2>(); },/*zip*/zipped);
+	return SpillLog::dmtToPy(spill,genDiamMassTime,/*head2*/true,zipped);
 }
 
 Real ConveyorInlet::pyMassOfDiam(Real min, Real max) const {
 	Real ret=0.;
-	for(const auto& vv: genDiamMassTime){
-		if(vv[0]>=min && vv[0]<=max) ret+=vv[1];
-	}
+	SpillLog::forEachDmt(spill,genDiamMassTime,[&](const Vector3r& vv, size_t){ if(vv[0]>=min && vv[0]<=max) ret+=vv[1]; });
 	return ret;
 }
 
 
 py::object ConveyorInlet::pyPsd(bool mass, bool cumulative, bool normalize, const Vector2r& dRange, const Vector2r& tRange, int num) const {
 	if(!save) throw std::runtime_error("ConveyorInlet.save must be True for calling ConveyorInlet.psd()");
-	auto tOk=[&tRange](const Real& t){ return isnan(tRange.minCoeff()) || (tRange[0]<=t && t<tRange[1]); };
-	vector<Vector2r> psd=DemFuncs::psd(genDiamMassTime,/*cumulative*/cumulative,/*normalize*/normalize,num,dRange,
-		/*radius getter*/[&tOk](const Vector3r& dmt, const size_t& i) ->Real { return tOk(dmt[2])?dmt[0]:NaN; },
-		/*weight getter*/[&](const Vector3r& dmt, const size_t& i) -> Real{ return mass?dmt[1]:1.; }
-	);
+	vector<Vector2r> psd=SpillLog::dmtPsd(spill,genDiamMassTime,psdHist,mass,cumulative,normalize,num,dRange,tRange);
 	return DemFuncs::seqVectorToPy(psd,[](const Vector2r& i)->Vector2r{ return i; },/*zip*/false);
 }
 
@@ -47,7 +47,9 @@ struct ConveyorInlet: public Inlet{
 	#endif
 	void run() override;
 	vector<shared_ptr<Node>> pyBarrier() const { return vector<shared_ptr<Node>>(barrier.begin(),barrier.end()); }
-	void pyClear(){ mass=0; num=0; genDiamMassTime.clear(); }
+	void pyClear(){ mass=0; num=0; genDiamMassTime.clear(); psdHist.clear(); if(spill) spill->clear(); }
+	// histogram of genDiamMassTime, synchronized when PSD is queried
+	mutable PsdHistogram psdHist;
 	bool hasClumps(){ return !clumps.empty(); }
 	py::object pyDiamMass(bool zipped=false) const;
 	Real pyMassOfDiam(Real min, Real max) const ;
@@ -95,12 +97,13 @@ struct ConveyorInlet: public Inlet{
 		((Real,avgRate,NaN,AttrTrait<>().readonly().massRateUnit(),"Average feed rate (computed from :obj:`Material density <Material.density>`, packing and  and :obj:`vel`")) \
 		((int,kinEnergyIx,-1,AttrTrait<Attr::hidden|Attr::noSave>(),"Index for kinetic energy in scene.energy")) \
 		((vector<Vector3r>,genDiamMassTime,,AttrTrait<Attr::readonly>().noGui(),"List of generated diameters, masses and times (for making granulometry)")) \
+		((shared_ptr<SpillLog>,spill,,AttrTrait<Attr::triggerPostLoad>(),"When given, generated particles are saved in this log (columns ``diam``, ``mass`` and ``time``) rather than in :obj:`genDiamMassTime`; only a bounded number of rows is kept in memory, the rest is spilled to a file. :obj:`psd`, :obj:`diamMass` and :obj:`massOfDiam` read data from the log.")) \
 		,/*py*/ \
 			.def("barrier",&ConveyorInlet::pyBarrier) \
 			.def("clear",&ConveyorInlet::pyClear) \
 			.def("diamMass",&ConveyorInlet::pyDiamMass,WOO_PY_ARGS(py::arg("zipped")=false),"Return masses and diameters of generated particles. With *zipped*, return list of (diameter, mass); without *zipped*, return tuple of 2 arrays, diameters and masses.") \
 			.def("massOfDiam",&ConveyorInlet::pyMassOfDiam,WOO_PY_ARGS(py::arg("min")=0,py::arg("max")=Inf),"Return mass of particles of which diameters are between *min* and *max*.") \
-			.def("psd",&ConveyorInlet::pyPsd,WOO_PY_ARGS(py::arg("mass")=true,py::arg("cumulative")=true,py::arg("normalize")=false,py::arg("dRange")=Vector2r(NaN,NaN),py::arg("tRange")=Vector2r(NaN,NaN),py::arg("num")=80),"Return PSD for particles generated.")
+			.def("psd",&ConveyorInlet::pyPsd,WOO_PY_ARGS(py::arg("mass")=true,py::arg("cumulative")=true,py::arg("normalize")=false,py::arg("dRange")=Vector2r(NaN,NaN),py::arg("tRange")=Vector2r(NaN,NaN),py::arg("num")=80),"Return PSD for particles generated. Without *tRange*, the result is computed from a histogram updated incrementally (diameters resolved to 0.1%), without traversing all generated particles.")
 	WOO_DECL__CLASS_BASE_DOC_ATTRS_PY(woo_dem_ConveyorInlet__CLASS_BASE_DOC_ATTRS_PY);
 };
 WOO_REGISTER_OBJECT(ConveyorInlet);
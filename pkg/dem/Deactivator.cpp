@@ -0,0 +1,171 @@
+#include<woo/pkg/dem/Deactivator.hpp>
+#include<woo/pkg/dem/ContactLoop.hpp>
+#include<woo/pkg/dem/Leapfrog.hpp>
+
+WOO_PLUGIN(dem,(Deactivator));
+WOO_IMPL__CLASS_BASE_DOC_ATTRS_PY(woo_dem_Deactivator__CLASS_BASE_DOC_ATTRS_PY);
+WOO_IMPL_LOGGER(Deactivator);
+
+void Deactivator::wakeAll(){
+	if(!field) throw std::runtime_error("Deactivator.wakeAll: field not set (the engine has not run yet?).");
+	dem=&field->cast<DemField>();
+	for(const auto& n: dem->nodes){
+		DemData& dyn=n->getData<DemData>();
+		if(dyn.isSleeping()) nWoken++;
+		dyn.setSleeping(false);
+		dyn.restSteps=0;
+		dyn.restForce=Vector3r(NaN,NaN,NaN);
+	}
+	dem->nSleeping=0;
+}
+
+size_t Deactivator::wakeIsland(Node* n0){
+	size_t ret=0;
+	vector<Node*> todo{n0};
+	auto pushSleeping=[&todo](const Particle* p){
+		if(!p->shape) return;
+		for(const auto& n: p->shape->nodes){ if(n->getData<DemData>().isSleeping()) todo.push_back(n.get()); }
+	};
+	while(!todo.empty()){
+		Node* n=todo.back(); todo.pop_back();
+		DemData& dyn=n->getData<DemData>();
+		if(!dyn.isSleeping()) continue; // already woken
+		dyn.setSleeping(false);
+		dyn.restSteps=0;
+		dyn.restForce=dyn.force;
+		ret++;
+		for(const Particle* p: dyn.parRef){
+			pushSleeping(p); // other nodes of multinodal particles
+			for(const auto& idC: p->contacts){
+				const shared_ptr<Contact>& C(idC.second);
+				if(!C->isReal()) continue;
+				pushSleeping(C->leakPA()==p?C->leakPB():C->leakPA());
+			}
+		}
+	}
+	return ret;
+}
+
+size_t Deactivator::sleepIslands(){
+	const auto& nodes=dem->nodes;
+	const size_t N=nodes.size();
+	// union-find over nodes, indexed by DemData.linIx; sleeping and static nodes don't join islands
+	vector<size_t> parent(N);
+	for(size_t i=0; i<N; i++) parent[i]=i;
+	auto find=[&parent](size_t i){ while(parent[i]!=i){ parent[i]=parent[parent[i]]; i=parent[i]; } return i; };
+	auto unite=[&](long a, long b){ size_t ra=find(a), rb=find(b); if(ra!=rb) parent[max(ra,rb)]=min(ra,rb); };
+	auto joins=[&N](const DemData& dyn){ return dyn.linIx>=0 && (size_t)dyn.linIx<N && !dyn.isSleeping() && !dyn.isStatic(); };
+	// return linIx of the first node of p which joins islands, or -1; unite all such nodes of p
+	auto uniteParticle=[&](const Particle* p)->long{
+		if(!p->shape) return -1;
+		long first=-1;
+		for(const auto& n: p->shape->nodes){
+			const DemData& dyn=n->getData<DemData>();
+			if(!joins(dyn)) continue;
+			if(first<0) first=dyn.linIx;
+			else unite(first,dyn.linIx);
+		}
+		return first;
+	};
+	for(const shared_ptr<Particle>& p: *dem->particles) uniteParticle(p.get());
+	for(const shared_ptr<Contact>& C: *dem->contacts){
+		if(!C->isReal()) continue;
+		long a=uniteParticle(C->leakPA()), b=uniteParticle(C->leakPB());
+		if(a>=0 && b>=0) unite(a,b);
+	}
+	// island is at rest if all its nodes are
+	vector<char> rest(N,1);
+	for(size_t i=0; i<N; i++){
+		const DemData& dyn=nodes[i]->getData<DemData>();
+		if(joins(dyn) && dyn.restSteps<restSteps) rest[find(i)]=0;
+	}
+	size_t ret=0;
+	Real Ek=0.;
+	const bool trackEnergy=scene->trackEnergy;
+	for(size_t i=0; i<N; i++){
+		const shared_ptr<Node>& n=nodes[i];
+		DemData& dyn=n->getData<DemData>();
+		if(!joins(dyn) || !rest[find(i)]) continue;
+		if(trackEnergy && !dyn.isEnergySkip()) Ek+=DemData::getEk_any(n,true,true,scene);
+		dyn.vel=dyn.angVel=Vector3r::Zero();
+		if(!isnan(dyn.angMom.maxCoeff())) dyn.angMom=Vector3r::Zero();
+		dyn.restForce=dyn.force;
+		// start from level 0 when woken up (see Multirate)
+		dyn.level=0; dyn.mrForce=dyn.mrTorque=Vector3r::Zero();
+		dyn.setSleeping(true);
+		ret++;
+	}
+	if(trackEnergy && ret>0) scene->energy->add(Ek,"sleep",sleepIx,EnergyTracker::IsIncrement|EnergyTracker::ZeroDontCreate);
+	return ret;
+}
+
+void Deactivator::run(){
+	dem=&field->cast<DemField>();
+	if(isnan(maxVel) || maxVel<0) throw std::runtime_error("Deactivator.maxVel must be given (and non-negative).");
+	if(!_orderChecked){
+		long ixCl=-1, ixLf=-1, ixMe=-1;
+		for(size_t i=0; i<scene->engines.size(); i++){
+			const auto& e=scene->engines[i];
+			if(e.get()==this) ixMe=i;
+			else if(e->isA<ContactLoop>() && ixCl<0) ixCl=i;
+			else if(e->isA<Leapfrog>() && ixLf<0) ixLf=i;
+		}
+		// engines run in a loop, so "between" is cyclic: going forward from ContactLoop, this engine comes before Leapfrog
+		const long nEng=scene->engines.size();
+		auto after=[&nEng](long a, long b){ return (b-a+nEng)%nEng; };
+		if(ixCl<0 || ixLf<0 || !(after(ixCl,ixMe)<after(ixCl,ixLf))) LOG_WARN("Deactivator should be placed between ContactLoop and Leapfrog in Scene.engines (found at {}, ContactLoop at {}, Leapfrog at {}); sleeping nodes might not be woken up correctly.",ixMe,ixCl,ixLf);
+		_orderChecked=true;
+	}
+
+	const auto& nodes=dem->nodes;
+	const long size=nodes.size();
+	const Real gNorm=dem->gravity.norm();
+	const Real maxVelSq=pow2(maxVel), maxAngVelSq=(isnan(maxAngVel)?Inf:pow2(maxAngVel));
+	long nSleeping=0, nCand=0;
+	// sleeping nodes to be woken up, with their islands
+	vector<Node*> wake;
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(guided) reduction(+:nSleeping,nCand)
+	#endif
+	for(long i=0; i<size; i++){
+		const shared_ptr<Node>& n=nodes[i];
+		DemData& dyn=n->getData<DemData>();
+		const Real refForce=max(dyn.force.norm(),dyn.mass*gNorm);
+		if(dyn.isSleeping()){
+			nSleeping++;
+			// not saved, set again after loading
+			if(isnan(dyn.restForce[0])){ dyn.restForce=dyn.force; continue; }
+			if(dyn.impose || (dyn.force-dyn.restForce).norm()>relWakeForce*refForce){
+				#ifdef WOO_OPENMP
+					#pragma omp critical
+				#endif
+				wake.push_back(n.get());
+			}
+			continue;
+		}
+		bool atRest=(!dyn.impose && dyn.isNoClump() && !dyn.isBlockedAll()
+			&& dyn.vel.squaredNorm()<=maxVelSq && dyn.angVel.squaredNorm()<=maxAngVelSq
+			&& !isnan(dyn.restForce[0]) && (dyn.force-dyn.restForce).norm()<=relForceChange*refForce);
+		dyn.restSteps=(atRest?dyn.restSteps+1:0);
+		dyn.restForce=dyn.force;
+		if(dyn.restSteps>=restSteps) nCand++;
+	}
+	nCandidates=nCand;
+	size_t woken=0;
+	for(Node* n: wake) woken+=wakeIsland(n);
+	nWoken+=woken; nSleeping-=woken;
+	if(woken>0) LOG_DEBUG("Woken up {} nodes ({} sleeping).",woken,nSleeping);
+	// in deforming periodic cell, nodes must follow the mean field
+	const bool canSleep=(!scene->isPeriodic || scene->cell->gradV==Matrix3r::Zero());
+	if(!canSleep && nSleeping>0){
+		LOG_DEBUG("Cell.gradV is non-zero, waking all {} sleeping nodes.",nSleeping);
+		wakeAll();
+		return;
+	}
+	if(canSleep && nCand>0 && islandPeriod>0 && scene->step%islandPeriod==0){
+		size_t s=sleepIslands();
+		nSlept+=s; nSleeping+=s;
+		if(s>0) LOG_DEBUG("Put {} nodes to sleep ({} sleeping).",s,nSleeping);
+	}
+	dem->nSleeping=nSleeping;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include<woo/pkg/dem/Particle.hpp>
+
+struct Deactivator: public Engine{
+	bool acceptsField(Field* f) override { return dynamic_cast<DemField*>(f); }
+	void run() override;
+	// wake all sleeping nodes
+	void wakeAll();
+	// wake the node and all sleeping nodes connected to it by contacts; return number of nodes woken
+	size_t wakeIsland(Node* n);
+	// find islands of nodes at rest and put them to sleep; return number of nodes put to sleep
+	size_t sleepIslands();
+	DemField* dem;
+	WOO_DECL_LOGGER;
+	#define woo_dem_Deactivator__CLASS_BASE_DOC_ATTRS_PY \
+		Deactivator,Engine,"Put quasi-static regions of the simulation to sleep: nodes which were at rest (velocity under :obj:`maxVel`, force changing less than :obj:`relForceChange`) during :obj:`restSteps` consecutive steps are candidates; an *island* (group of nodes connected by contacts, not counting :obj:`static <DemData.isStatic>` nodes such as fixed walls) is put to sleep when all its nodes are candidates. Sleeping nodes are not integrated by :obj:`Leapfrog`, their bounds are not updated by :obj:`InsertionSortCollider` and contacts between them (or with static nodes) are frozen by :obj:`ContactLoop` (the last force is applied without updating geometry and calling the law; with energy tracking, the law is called with zero relative velocity so that elastic energy is accounted for; contacts with geometry other than :obj:`L6Geom` are then not frozen at all). \n\nThe whole island is woken up when force on any of its nodes changes by more than :obj:`relWakeForce` (typically due to contact with a non-sleeping particle) or when something is imposed on the node. Kinetic energy left in the island when it is put to sleep is tracked as ``sleep`` in :obj:`S.energy <woo.core.EnergyTracker>`.\n\nThe engine must be placed between :obj:`ContactLoop` and :obj:`Leapfrog` (cyclically, e.g. at the end of :obj:`DemField.minimalEngines`). Clumps, clump members and nodes with :obj:`~DemData.impose` never sleep (and keep their islands awake); sleeping is disabled (and all nodes are woken up) in periodic simulations with non-zero :obj:`woo.core.Cell.gradV`. Call :obj:`wakeAll` before removing the engine, otherwise sleeping nodes stay frozen.", \
+		((Real,maxVel,NaN,AttrTrait<>().velUnit(),"Maximum velocity of a node at rest; must be given.")) \
+		((Real,maxAngVel,NaN,AttrTrait<>().angVelUnit(),"Maximum angular velocity of a node at rest; not checked if NaN.")) \
+		((Real,relForceChange,.01,,"Maximum change of force on a node at rest between two consecutive steps, relative to the larger of the current force and the node's weight.")) \
+		((Real,relWakeForce,.1,,"Change of force on a sleeping node (relative to the larger of the current force and the node's weight) since it was put to sleep, which wakes its island up.")) \
+		((int,restSteps,100,,"Number of consecutive steps a node must be at rest to become a candidate for sleeping.")) \
+		((int,islandPeriod,10,,"Search for islands at rest every *islandPeriod* steps (only when there are some candidates); the search traverses all nodes and contacts, and is not parallelized.")) \
+		((long,nSlept,0,AttrTrait<Attr::readonly>(),"Cumulative number of nodes put to sleep.")) \
+		((long,nWoken,0,AttrTrait<Attr::readonly>(),"Cumulative number of nodes woken up.")) \
+		((long,nCandidates,0,AttrTrait<Attr::readonly>(),"Number of awake nodes which were at rest for at least :obj:`restSteps` in the last step.")) \
+		((bool,_orderChecked,false,AttrTrait<Attr::noSave|Attr::hidden>(),"Whether position in :obj:`Scene.engines` was already checked.")) \
+		((int,sleepIx,-1,AttrTrait<Attr::hidden|Attr::noSave>(),"Index for kinetic energy removed when nodes are put to sleep.")) \
+		,/*py*/ .def("wakeAll",&Deactivator::wakeAll,"Wake all sleeping nodes in the field.")
+	WOO_DECL__CLASS_BASE_DOC_ATTRS_PY(woo_dem_Deactivator__CLASS_BASE_DOC_ATTRS_PY);
+};
+WOO_REGISTER_OBJECT(Deactivator);
@@ -3,6 +3,7 @@
 #include<woo/pkg/dem/FrictMat.hpp>
 #include<woo/pkg/dem/L6Geom.hpp>
 #include<woo/pkg/dem/Clump.hpp>
+#include<woo/pkg/dem/ContactLoop.hpp>
 
 WOO_PLUGIN(dem,(DynDt));
 WOO_IMPL__CLASS_BASE_DOC_ATTRS(woo_dem_DynDt__CLASS_BASE_DOC_ATTRS);
@@ -50,28 +51,56 @@ Real DynDt::nodalCritDtSq(const shared_ptr<Node>& n) const {
 		const auto& clump=dyn.cast<ClumpData>();
 		for(const auto& cn: clump.nodes) nodalStiffAdd(cn,ktrans,krot);
 	};
-	Real ret=Inf;
 	LOG_TRACE("ktrans={}, krot={}, mass={}, inertia={}",ktrans.transpose(),krot.transpose(),dyn.mass,dyn.inertia.transpose());
+	return critDtSq_fromStiffness(dyn,ktrans,krot);
+}
+
+Real DynDt::nodalCritDtSq_tracked(const shared_ptr<Node>& n) const {
+	const DemData& dyn=n->getData<DemData>();
+	if(dyn.isBlockedAll()) return Inf;
+	// contacts were already summed by ContactLoop (including contacts of clump members on the clump node)
+	Vector3r ktrans(dyn.stiffTrans), krot(dyn.stiffRot);
+	// internal stiffness of multinodal particles is not known to ContactLoop
+	if(intraForce){
+		for(auto& p: dyn.parRef){
+			if(p->shape->nodes.size()>1) intraForce->addIntraStiffness(shared_ptr<Particle>(p,woo::Object::null_deleter()),n,ktrans,krot);
+		}
+	}
+	return critDtSq_fromStiffness(dyn,ktrans,krot);
+}
+
+Real DynDt::critDtSq_fromStiffness(const DemData& dyn, const Vector3r& ktrans, const Vector3r& krot){
+	Real ret=Inf;
 	for(int i:{0,1,2}){ if(ktrans[i]!=0 && dyn.mass>0. && !dyn.isBlockedAxisDOF(i,/*rot*/false)) ret=min(ret,dyn.mass/abs(ktrans[i])); }
 	for(int i:{0,1,2}){ if(krot[i]!=0 && dyn.inertia[i]>0. && !dyn.isBlockedAxisDOF(i,/*rot*/true)) ret=min(ret,dyn.inertia[i]/abs(krot[i])); }
 	return 2*ret; // (sqrt(2)*sqrt(ret))^2
 }
 
 
-Real DynDt::critDt_stiffness() const {
+Real DynDt::critDt_stiffness(bool tracked, vector<Real>* nodalDtSq) const {
 	// traverse nodes, find critical timestep for each of them
+	const auto& nodes(field->cast<DemField>().nodes);
+	const long nNodes=nodes.size();
 	Real ret=Inf;
-	for(const auto& n: field->cast<DemField>().nodes){
-		ret=min(ret,nodalCritDtSq(n));
-		if(ret==0){ LOG_ERROR("DynDt::nodalCriDtSq returning 0 for node at {}??",n->pos); }
-		if(isnan(ret)){ LOG_ERROR("DynDt::nodalCritDtSq returning nan for node at {}??",n->pos); }
-		assert(!isnan(ret));
+	if(nodalDtSq) nodalDtSq->resize(nNodes);
+	// IntraForce functors may initialize stiffness matrices of particles lazily, shared by several nodes; stay serial then
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(guided) reduction(min:ret) if(!intraForce)
+	#endif
+	for(long i=0; i<nNodes; i++){
+		const auto& n(nodes[i]);
+		Real r=(tracked?nodalCritDtSq_tracked(n):nodalCritDtSq(n));
+		if(r==0){ LOG_ERROR("DynDt::nodalCriDtSq returning 0 for node at {}??",n->pos); }
+		if(isnan(r)){ LOG_ERROR("DynDt::nodalCritDtSq returning nan for node at {}??",n->pos); }
+		assert(!isnan(r));
+		if(nodalDtSq) (*nodalDtSq)[i]=r;
+		ret=min(ret,r);
 	}
 	return sqrt(ret);
 }
 
 
-Real DynDt::critDt_compute() {
+Real DynDt::critDt_compute(vector<Real>* nodalDtSq) {
 	// just for the case of unitialized finite elements, find the functor if present and store the pointer to it
 	// this way it can be called to compute their stiffness matrices on-demand
 	intraForce.reset();
@@ -80,21 +109,37 @@ Real DynDt::critDt_compute() {
 		intraForce=static_pointer_cast<IntraForce>(e); break;
 	}
 
+	// use stiffnesses accumulated by ContactLoop, if they are current
+	bool tracked=false;
+	if(viaContactLoop){
+		for(const auto& e: scene->engines){
+			if(!e->isA<ContactLoop>() || (e->field && e->field.get()!=field.get())) continue;
+			auto& cl(e->cast<ContactLoop>());
+			tracked=(cl.stiffStep==scene->step);
+			// only request stiffnesses for the step when we run next; that is not known with virtPeriod/realPeriod, so the next step is
+			// requested then (and the full traversal is used whenever we run later than that)
+			cl.stiffRequestStep=scene->step+(stepPeriod>0?stepPeriod:1);
+			break;
+		}
+	}
+
 	// compute timestep from contact stiffnesses
 	// and from internal stiffnesses of membranes
-	Real cdt=critDt_stiffness();
+	Real cdt=critDt_stiffness(tracked,nodalDtSq);
 	intraForce.reset();
 	return cdt;	
 }
 
 void DynDt::run(){
+	applyCritDt(critDt_compute());
+}
+
+Real DynDt::applyCritDt(Real crDt){
 	// apply critical timestep times safety factor
 	// prevent too fast changes, so cap the value with maxRelInc
-	Real crDt=critDt_compute();
-
 	if(isinf(crDt)){
 		if(!dryRun) LOG_INFO("No timestep computed, keeping the current value {}",scene->dt);
-		return;
+		return scene->dt;
 	}
 	int nSteps=scene->step-stepPrev;
 	Real maxNewDt=scene->dt*pown(1.+maxRelInc,nSteps);
@@ -110,4 +155,5 @@ void DynDt::run(){
 	} else {
 		this->dt=nextDt;
 	}
+	return nextDt;
 }
@@ -6,13 +6,20 @@ struct DynDt: public PeriodicEngine{
 	bool acceptsField(Field* f) override { return dynamic_cast<DemField*>(f); }
 	void nodalStiffAdd(const shared_ptr<Node>&, Vector3r& kt, Vector3r& kr) const;
 	Real nodalCritDtSq(const shared_ptr<Node>&) const;
+	// same as nodalCritDtSq, but uses stiffnesses accumulated by ContactLoop (DemData::stiffTrans, DemData::stiffRot)
+	Real nodalCritDtSq_tracked(const shared_ptr<Node>&) const;
+	// critical timestep squared from accumulated stiffnesses, mass and inertia
+	static Real critDtSq_fromStiffness(const DemData& dyn, const Vector3r& ktrans, const Vector3r& krot);
 	virtual void run() override;
 	// virtual func common to all engines
 	Real critDt() override { return critDt_compute(); }
 	// non-virtual func called from run() and from critDt(), the actual implementation
-	Real critDt_stiffness() const;
+	// if nodalDtSq is given, it is filled with squared critical timestep of each node (in the order of DemField.nodes)
+	Real critDt_stiffness(bool tracked=false, vector<Real>* nodalDtSq=nullptr) const;
 	Real critDt_compute(const shared_ptr<Scene>& s, const shared_ptr<DemField>& f){ scene=s.get(); field=f; return critDt_compute(); }
-	Real critDt_compute();
+	Real critDt_compute(vector<Real>* nodalDtSq=nullptr);
+	// set Scene.nextDt (or dt with dryRun) from critical timestep crDt, respecting maxRelInc; return the timestep for the next step
+	Real applyCritDt(Real crDt);
 	void postLoad(DynDt&,void*);
 	WOO_DECL_LOGGER;
 	shared_ptr<IntraForce> intraForce; // cache the dispatcher, if available
@@ -20,6 +27,7 @@ struct DynDt: public PeriodicEngine{
 		DynDt,PeriodicEngine,"Adjusts :obj:`Scene.dt` based on current stiffness of particle contacts.", \
 		((Real,maxRelInc,1e-4,AttrTrait<Attr::triggerPostLoad>(),"Maximum relative increment of timestep within one step, to void abrupt changes in timestep leading to numerical artefacts.")) \
 		((bool,dryRun,false,,"Only set :obj:`dt` to the value of timestep, don't apply it really.")) \
+		((bool,viaContactLoop,false,,"Let :obj:`ContactLoop` accumulate contact stiffnesses on nodes while it traverses contacts (only in steps when this engine runs, see :obj:`ContactLoop.stiffRequestStep`); the timestep is then computed from nodal values without traversing contacts of each particle again. Falls back to the full traversal if the stiffnesses were not accumulated in the current step (e.g. if :obj:`ContactLoop` runs after this engine).")) \
 		((Real,dt,NaN,,"New timestep value which would be used if :obj:`dryRun` were not set. Unused when :obj:`dryRun` is false."))
 	WOO_DECL__CLASS_BASE_DOC_ATTRS(woo_dem_DynDt__CLASS_BASE_DOC_ATTRS);
 };
@@ -4,10 +4,11 @@
 #include <boost/math/tools/minima.hpp>
 #include <boost/math/tools/tuple.hpp>
 
-WOO_PLUGIN(dem,(Ellipsoid)(Bo1_Ellipsoid_Aabb)(Cg2_Wall_Ellipsoid_L6Geom)(Cg2_Facet_Ellipsoid_L6Geom)(Cg2_Ellipsoid_Ellipsoid_L6Geom)(Cg2_Sphere_Ellipsoid_L6Geom));
+WOO_PLUGIN(dem,(Ellipsoid)(Bo1_Ellipsoid_Aabb)(Cg2_Wall_Ellipsoid_L6Geom)(Cg2_Facet_Ellipsoid_L6Geom)(EllL6Geom)(Cg2_Ellipsoid_Ellipsoid_L6Geom)(Cg2_Sphere_Ellipsoid_L6Geom));
 
 WOO_IMPL__CLASS_BASE_DOC_ATTRS_CTOR(woo_dem_Ellipsoid__CLASS_BASE_DOC_ATTRS_CTOR);
 WOO_IMPL__CLASS_BASE_DOC(woo_dem_Bo1_Ellipsoid_Aabb__CLASS_BASE_DOC);
+WOO_IMPL__CLASS_BASE_DOC_ATTRS_CTOR(woo_dem_EllL6Geom__CLASS_BASE_DOC_ATTRS_CTOR);
 WOO_IMPL__CLASS_BASE_DOC_ATTRS(woo_dem_Cg2_Ellipsoid_Ellipsoid_L6Geom__CLASS_BASE_DOC_ATTRS);
 WOO_IMPL__CLASS_BASE_DOC(woo_dem_Cg2_Wall_Ellipsoid_L6Geom__CLASS_BASE_DOC);
 WOO_IMPL__CLASS_BASE_DOC(woo_dem_Cg2_Sphere_Ellipsoid_L6Geom__CLASS_BASE_DOC);
@@ -277,53 +278,61 @@ bool Cg2_Ellipsoid_Ellipsoid_L6Geom::go_Ellipsoid_or_Sphere(const shared_ptr<Sha
 	const DemData& dyn1(s1->nodes[0]->getData<DemData>());const DemData& dyn2(s2->nodes[0]->getData<DemData>());
 
 	Vector3r R(rb-ra); // (2.1)
-	Matrix3r A(Matrix3r::Zero()), B(Matrix3r::Zero());
+
+	// cheap rejection of potential contacts: bounding spheres, then separating axes along principal axes of both ellipsoids (OBB test)
+	if(!C->isReal() && !force){
+		if(R.squaredNorm()>pow2(a.maxCoeff()+b.maxCoeff())) return false;
+		for(int k:{0,1,2}){
+			if(abs(R.dot(u[k]))>a[k]+b[0]*abs(v[0].dot(u[k]))+b[1]*abs(v[1].dot(u[k]))+b[2]*abs(v[2].dot(u[k]))) return false;
+			if(abs(R.dot(v[k]))>b[k]+a[0]*abs(u[0].dot(v[k]))+a[1]*abs(u[1].dot(v[k]))+a[2]*abs(u[2].dot(v[k]))) return false;
+		}
+	}
+
+	// (2.3a), (2.3b): inverses of (2.2a), (2.2b) computed directly, since u, v are orthonormal
+	Matrix3r Ainv(Matrix3r::Zero()), Binv(Matrix3r::Zero());
 	for(int k:{0,1,2}){
-		A+=u[k]*u[k].transpose()/pow2(a[k]); // (2.2a)
-		B+=v[k]*v[k].transpose()/pow2(b[k]); // (2.2b)
+		Ainv+=pow2(a[k])*u[k]*u[k].transpose();
+		Binv+=pow2(b[k])*v[k]*v[k].transpose();
 	}
-	Matrix3r Ainv=A.inverse(), Binv=B.inverse(); // (2.3a), (2.3b)
 
 	// (2.4), for Brent's maximization: return only the function value
 	// the result is negated so that we can use boost::math::brent_find_minima which finds the minimum
 	auto neg_S_lambda_0=[&](const Real& l) -> Real { return -l*(1-l)*R.transpose()*((1-l)*Ainv+l*Binv).inverse()*R; };
 
-	// cerr<<"S(l):"; for(Real l=0; l<1; l+=.05){ cerr<<" "<<-neg_S_lambda_0(l); }; cerr<<endl;
-
-	// TODO: define funcs returning 1st derivative (zero at the extreme) and 2nd derivative (used by Newton-Raphson)
-	#if 0
-		// (2.4) + (2.8) for Newton-Raphson, return both value and derivative
-		auto S_lambda_01=[&](const Real& l) -> boost::math::tuple {
-			Matrix3r G=(1-l)*Ainv+l*Binv; // (2.6)
-			Matrix3r GinvR=G.inverse()*R; // (2.9): GinvR≡X (GX=R)
-			return boost::math::make_tuple(
-				l*(a-l)*R.transpose()*GinvR,
-				GinvR.transpose()*(pow2(1-l)*Ainv-pow2(l)*Binv)*GinvR
-			);
-		}
-	#endif
 	// set once the iteration has result
-	Real L,Fab;
-	if(brent){
+	Real L=NaN,Fab=NaN;
+	if(!brent){
+		// Newton-Raphson for S'(λ)=0; S is concave on (0,1), S'(0)>0 and S'(1)<0, so the root is bracketed
+		// and steps leaving the bracket are replaced by bisection
+		EllL6Geom* eg=(C->geom?dynamic_cast<EllL6Geom*>(C->geom.get()):nullptr);
+		Real l=((eg && eg->lam>0 && eg->lam<1)?eg->lam:a.maxCoeff()/(a.maxCoeff()+b.maxCoeff())); // previous value, or as for spheres (Donev, pg 773)
+		Real lo=0, hi=1;
+		const Matrix3r D=Binv-Ainv;
+		for(int i=0; i<newtonMaxIter; i++){
+			Matrix3r Ginv=((1-l)*Ainv+l*Binv).inverse(); // (2.6)
+			Vector3r X=Ginv*R; // (2.9): GX=R
+			Vector3r HX=(pow2(1-l)*Ainv-pow2(l)*Binv)*X;
+			Real S1=X.dot(HX); // (2.8)
+			// derivative of (2.8): dX/dλ=-G⁻¹DX, d[(1-λ)²A⁻¹-λ²B⁻¹]/dλ=-2G
+			Real S2=-2*(Ginv*(D*X)).dot(HX)-2*X.dot(R);
+			Real dl=(S2<0?-S1/S2:NaN);
+			if(abs(dl)<newtonTol){ L=l+dl; Fab=-neg_S_lambda_0(L); break; }
+			if(S1>0) lo=l; else hi=l;
+			l=((l+dl>lo && l+dl<hi)?l+dl:.5*(lo+hi));
+		}
+	}
+	if(isnan(L)){
 		// boost docs claims that accuracy higher than half bits is ignored, so set just that -- half of 8*sizeof(Real)
 		auto lambda_negSmin=boost::math::tools::brent_find_minima(neg_S_lambda_0,0.,1.,brentBits);
 		L=boost::math::get<0>(lambda_negSmin);
 		Fab=-boost::math::get<1>(lambda_negSmin); // invert the sign
-	} else {
-		#if 0
-			// use Newton-Raphson
-			// FIXME: we should use the previous value of lambda as the initial guess!
-			Real l0=a.maxCoeff()/(a.maxCoeff()+b/maxCoeff()); // initial guess as for spheres; Donev, pg 773
-			// this is what boost docs do in the example on newton_raphson_iterate
-			int digits=(2*std::numeric_limits<T>::digits)/3;
-			boost::math::newton_raphson_iterate(S_lambda_01,...)
-		#else
-			throw std::runtime_error("Cg2_Ellipsoid_Ellipsoid_L6Geom::go: Newton-Raphson iteration is not yet implemented; use Brent's method by saying brent=True.");
-		#endif
 	}
 	// cerr<<"l="<<L<<", Fab="<<Fab<<endl;
 	// Perram, Rasmussen, pg 6567
 	if(Fab>1 && !C->isReal() && !force){ return false;	}
+	// new contact: allocate geometry which keeps λ for the next step (initialized by handleSpheresLikeContact)
+	if(!C->geom) C->geom=make_shared<EllL6Geom>();
+	if(auto eg=dynamic_cast<EllL6Geom*>(C->geom.get())) eg->lam=L;
 
 	Matrix3r G=(1-L)*Ainv+L*Binv; // (2.6)
 	Vector3r nUnnorm=G.inverse()*R; // Donev, (19)
@@ -48,6 +48,16 @@ struct Bo1_Ellipsoid_Aabb: public Bo1_Sphere_Aabb{
 };
 WOO_REGISTER_OBJECT(Bo1_Ellipsoid_Aabb);
 
+struct EllL6Geom: public L6Geom{
+	#define woo_dem_EllL6Geom__CLASS_BASE_DOC_ATTRS_CTOR \
+		EllL6Geom,L6Geom,":obj:`L6Geom` created by :obj:`Cg2_Ellipsoid_Ellipsoid_L6Geom`, keeping the parameter of the contact point so that it can be used as initial guess in the next step.", \
+		((Real,lam,NaN,AttrTrait<>().readonly(),"Parameter :math:`\\lambda\\in(0,1)` maximizing the Perram-Wertheim potential function in the last step.")) \
+		, /*ctor*/ createIndex();
+	WOO_DECL__CLASS_BASE_DOC_ATTRS_CTOR(woo_dem_EllL6Geom__CLASS_BASE_DOC_ATTRS_CTOR);
+	REGISTER_CLASS_INDEX(EllL6Geom,L6Geom);
+};
+WOO_REGISTER_OBJECT(EllL6Geom);
+
 struct Cg2_Ellipsoid_Ellipsoid_L6Geom: public Cg2_Any_Any_L6Geom__Base{
 	bool go(const shared_ptr<Shape>& s1, const shared_ptr<Shape>& s2, const Vector3r& shift2, const bool& force, const shared_ptr<Contact>& C) override;
 	// this can be called for sphere+ellipsoid and ellipsoid+ellipsoid collisions
@@ -55,8 +65,10 @@ struct Cg2_Ellipsoid_Ellipsoid_L6Geom: public Cg2_Any_Any_L6Geom__Base{
 	void setMinDist00Sq(const shared_ptr<Shape>& s1, const shared_ptr<Shape>& s2, const shared_ptr<Contact>& C) override;
 	#define woo_dem_Cg2_Ellipsoid_Ellipsoid_L6Geom__CLASS_BASE_DOC_ATTRS \
 		Cg2_Ellipsoid_Ellipsoid_L6Geom,Cg2_Any_Any_L6Geom__Base,"Incrementally compute :obj:`L6Geom` for contact of 2 :obj:`ellipsoids <woo.dem.Ellipsoid>`. Uses the Perram-Wertheim potential function (:cite:`Perram1985`, :cite:`Perram1996`, :cite:`Donev2005`). See example scripts :woosrc:`examples/ell0.py` and :woosrc:`examples/ell1.py`.\n\n.. youtube:: cBnz4el4qX8\n\n", \
-		((bool,brent,true,,"Use Brent iteration for finding maximum of the Perram-Wertheim potential. If false, use Newton-Raphson (not yet implemented).")) \
-		((int,brentBits,4*sizeof(Real),,"Precision for the Brent method, as number of bits."))
+		((bool,brent,false,,"Use Brent iteration for finding maximum of the Perram-Wertheim potential. If false, use safeguarded Newton-Raphson iteration with analytic derivatives, starting from :obj:`EllL6Geom.lam` of existing contacts; Brent's method is used as fallback when Newton does not converge.")) \
+		((int,brentBits,4*sizeof(Real),,"Precision for the Brent method, as number of bits.")) \
+		((Real,newtonTol,1e-10,,"Tolerance on :math:`\\lambda` for Newton-Raphson iteration.")) \
+		((int,newtonMaxIter,20,,"Maximum number of Newton-Raphson iterations before falling back to Brent's method."))
 	WOO_DECL__CLASS_BASE_DOC_ATTRS(woo_dem_Cg2_Ellipsoid_Ellipsoid_L6Geom__CLASS_BASE_DOC_ATTRS);
 	FUNCTOR2D(Ellipsoid,Ellipsoid);
 	DEFINE_FUNCTOR_ORDER_2D(Ellipsoid,Ellipsoid);
@@ -322,7 +322,7 @@ void In2_Facet::distributeForces(const shared_ptr<Particle>& particle, const Fac
 		for(int i:{0,1,2}){
 			std::tie(F,T,xc)=C->getForceTorqueBranch(particle,/*nodeI*/i,scene);
 			F*=weights[i]; T*=weights[i];
-			f.nodes[i]->getData<DemData>().addForceTorque(F,xc.cross(F)+T);
+			addNodalForceTorque(f.nodes[i]->getData<DemData>(),F,xc.cross(F)+T);
 		}
 	}
 }
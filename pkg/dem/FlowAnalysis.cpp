@@ -3,6 +3,7 @@
 #include<woo/pkg/dem/FlowAnalysis.hpp>
 #include<woo/pkg/dem/Sphere.hpp>
 #include<woo/pkg/dem/Funcs.hpp>
+#include<woo/lib/base/CompUtils.hpp>
 
 #include<vtkUniformGrid.h>
 #include<vtkPoints.h>
@@ -28,6 +29,7 @@ WOO_IMPL__CLASS_BASE_DOC_ATTRS_PY(woo_dem_FlowAnalysis__CLASS_BASE_DOC_ATTRS_PY)
 
 void FlowAnalysis::reset(){
 	data.resize(boost::extents[0][0][0][0][0]);
+	threadData.clear();
 	timeSpan=0.;
 	nDone=0; // this is used in the check below
 }
@@ -51,11 +53,53 @@ void FlowAnalysis::setupGrid(){
 	LOG_WARN("There are {} grid(s) {}x{}x{}={} storing {} numbers per point (total {} items)",nFractions,boxCells[0],boxCells[1],boxCells[2],boxCells.prod(),NUM_PT_DATA,boxCells.prod()*nFractions*NUM_PT_DATA);
 	data.resize(boost::extents[nFractions][boxCells[0]][boxCells[1]][boxCells[2]][NUM_PT_DATA]);
 	// zero all array items
-	std::fill(data.origin(),data.origin()+data.size(),0);
+	std::fill(data.origin(),data.origin()+data.num_elements(),0);
+	setupThreadData();
 }
 
+void FlowAnalysis::setupThreadData(){
+	threadData.clear();
+	if(!parallel && !viaLeapfrog) return;
+	#ifdef WOO_OPENMP
+		const int nThreads=omp_get_max_threads();
+	#else
+		const int nThreads=1;
+	#endif
+	threadData.resize(nThreads);
+	for(auto& td: threadData){
+		td.resize(boost::extents[data.shape()[0]][data.shape()[1]][data.shape()[2]][data.shape()[3]][data.shape()[4]]);
+		std::fill(td.origin(),td.origin()+td.num_elements(),0);
+	}
+}
 
-void FlowAnalysis::addOneParticle(const shared_ptr<Particle>& par, const Vector3r& parPosLocal, const Real& diameter, const Real& solidRatio){
+void FlowAnalysis::mergeThreadData(Real scale){
+	if(threadData.empty()) return;
+	const size_t N=data.num_elements();
+	Real* dst=data.origin();
+	// each thread sums a contiguous range of cells over all thread grids, resetting them on the way
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static)
+	#endif
+	for(size_t i=0; i<N; i++){
+		for(auto& td: threadData){ Real& v(td.origin()[i]); dst[i]+=scale*v; v=0.; }
+	}
+}
+
+
+void FlowAnalysis::initMatStateName(){
+	if(matStateScalar<0 || !matStateName.empty()) return;
+	for(const auto& p: *dem->particles){
+		if(!p || !p->matState) continue;
+		matStateName=p->matState->getScalarName(matStateScalar);
+		if(matStateName.empty()){
+			matStateName=p->matState->getClassName()+"::scalar_"+to_string(matStateScalar);
+			LOG_WARN("#{}: using {} instead of empty result from MatState::getScalarName({}).",p->id,matStateName,matStateScalar);
+		}
+		return;
+	}
+}
+
+void FlowAnalysis::addOneParticle(boost_multi_array_real_5& grid, const Particle* par, const Vector3r& parPosLocal, const Real& diameter, const Real& solidRatio, const Real& depoWeight){
 	const auto& mask(par->mask);
 	const auto& parNode0(par->shape->nodes[0]);
 	const auto& dyn(parNode0->getData<DemData>());
@@ -99,39 +143,22 @@ void FlowAnalysis::addOneParticle(const shared_ptr<Particle>& par, const Vector3
 	// matState
 	Real msScalar=NaN;
 	if(matStateScalar>=0 && par->matState){
+		// matStateName is filled by initMatStateName, serially from run()
 		msScalar=par->matState->getScalar(matStateScalar,scene->time,scene->step);
-		if(matStateName.empty()){
-			matStateName=par->matState->getScalarName(matStateScalar);
-			if(matStateName.empty()){
-				matStateName=par->matState->getClassName()+"::scalar_"+to_string(matStateScalar);
-				LOG_WARN("#{}: using {} instead of empty result from MatState::getScalarName({}).",par->id,matStateScalar);
-			}
-		}
 	}
 
 	// trilinear interpolation
-	const Real& x(n[0]); const Real& y(n[1]); const Real& z(n[2]);
-	Real X(1-x), Y(1-y), Z(1-z);
-	const int& i(ijk[0]); const int& j(ijk[1]); const int& k(ijk[2]);
-	int I(i+1), J(j+1), K(k+1);
-	// traverse all affected points
-	Real weights[]={
-		X*Y*Z,x*Y*Z,x*y*Z,X*y*Z,
-		X*Y*z,x*Y*z,x*y*z,X*y*z
-	};
+	Real weights[8]; Vector3i pts[8];
+	CompUtils::trilinearWeights(ijk,n,pts,weights);
 	// the sum should be equal to one
 	assert(abs(weights[0]+weights[1]+weights[2]+weights[3]+weights[4]+weights[5]+weights[6]+weights[7]-1) < 1e-5);
-	Vector3i pts[]={
-		Vector3i(i,j,k),Vector3i(I,j,k),Vector3i(I,J,k),Vector3i(i,J,k),
-		Vector3i(i,j,K),Vector3i(I,j,K),Vector3i(I,J,K),Vector3i(i,J,K)
-	};
-	Eigen::AlignedBox<int,3> validIjkRange(Vector3i::Zero(),Vector3i(data.shape()[1]-1,data.shape()[2]-1,data.shape()[3]-1));
+	Eigen::AlignedBox<int,3> validIjkRange(Vector3i::Zero(),Vector3i(grid.shape()[1]-1,grid.shape()[2]-1,grid.shape()[3]-1));
 	for(int ii=0; ii<8; ii++){
 		// make sure we are within bounds here
 		if(!validIjkRange.contains(pts[ii])) continue;
 		// subarray where we write the actual data for this point
-		auto pt(data[fraction][pts[ii][0]][pts[ii][1]][pts[ii][2]]); 
-		const Real& w(weights[ii]); /* ensured by validIjkRange */ assert(w>0);
+		auto pt(grid[fraction][pts[ii][0]][pts[ii][1]][pts[ii][2]]); 
+		const Real w(depoWeight*weights[ii]); /* ensured by validIjkRange */ assert(w>0);
 		pt[PT_FLOW_X]+=w*momentum_V[0];
 		pt[PT_FLOW_Y]+=w*momentum_V[1];
 		pt[PT_FLOW_Z]+=w*momentum_V[2];
@@ -153,7 +180,15 @@ void FlowAnalysis::addCurrentData(){
 	AlignedBox3r enlargedBox(box.min()-Vector3r::Ones()*cellSize,box.max()+Vector3r::Ones()*cellSize);
 	vector<Real> poroData;
 	if(porosity) poroData=DemFuncs::boxPorosity(static_pointer_cast<DemField>(field),enlargedBox);
-	for(const auto& p: *(dem->particles)){
+	const bool useThreadData=!threadData.empty();
+	const auto& particles(*dem->particles);
+	const long size=particles.size();
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(guided) if(useThreadData)
+	#endif
+	for(long i=0; i<size; i++){
+		const shared_ptr<Particle>& p(particles[i]);
+		if(!p || !p->shape) continue;
 		if(mask!=0 && (p->mask&mask)==0) continue;
 		//if(!p->shape->isA<Sphere>()) continue;
 		Real radius=p->shape->equivRadius();
@@ -161,14 +196,40 @@ void FlowAnalysis::addCurrentData(){
 		Vector3r parPosLocal=node?node->glob2loc(p->shape->nodes[0]->pos):p->shape->nodes[0]->pos;
 		if(!enlargedBox.contains(parPosLocal)) continue;
 		assert(!(porosity && (int)poroData.size()<=p->id));
-		addOneParticle(p,parPosLocal,radius*2.,(porosity?1-poroData[p->id]:NaN));
+		addOneParticle((useThreadData?threadGrid():data),p.get(),parPosLocal,radius*2.,(porosity?1-poroData[p->id]:NaN));
 	}
+	if(useThreadData) mergeThreadData();
 };
 
+void FlowAnalysis::addNodeData(const shared_ptr<Node>& n){
+	const DemData& dyn(n->getData<DemData>());
+	if(dyn.parRef.size()!=1) return;
+	const Particle* p=dyn.parRef.front();
+	if(!p->shape || p->shape->nodes.size()!=1) return;
+	if(mask!=0 && (p->mask&mask)==0) return;
+	Real radius=p->shape->equivRadius();
+	if(isnan(radius)) return;
+	Vector3r parPosLocal=node?node->glob2loc(n->pos):n->pos;
+	if(!AlignedBox3r(box.min()-Vector3r::Ones()*cellSize,box.max()+Vector3r::Ones()*cellSize).contains(parPosLocal)) return;
+	// weighted by dt; run() divides by the time elapsed since the previous run, so that
+	// the result is the time-average over that interval, as if deposited once by addCurrentData
+	addOneParticle(threadGrid(),p,parPosLocal,radius*2.,NaN,scene->dt);
+}
+
 void FlowAnalysis::run(){
 	dem=static_cast<DemField*>(field.get());
+	initMatStateName();
+	// between runs, thread grids only hold data deposited by Leapfrog, weighted by dt
+	const Real leapfrogScale=(nDone>0 && scene->time>virtPrev)?1./(scene->time-virtPrev):1.;
 	if(data.size()==0) setupGrid();
-	addCurrentData();
+	// changed parallel or viaLeapfrog meanwhile
+	else if(threadData.empty()==(parallel || viaLeapfrog)){ mergeThreadData(leapfrogScale); setupThreadData(); }
+	if(viaLeapfrog){
+		if(porosity) throw std::runtime_error("FlowAnalysis: porosity is not supported with viaLeapfrog.");
+		// data were deposited by Leapfrog since the last run already
+		mergeThreadData(leapfrogScale);
+	}
+	else addCurrentData();
 	if(nDone>0) timeSpan+=scene->time-virtPrev;
 }
 
@@ -5,7 +5,9 @@
 #include<vtkUniformGrid.h>
 #include<vtkDoubleArray.h>
 #include<vtkSmartPointer.h>
-
+#ifdef WOO_OPENMP
+	#include<omp.h>
+#endif
 
 
 struct FlowAnalysis: public PeriodicEngine{
@@ -26,8 +28,26 @@ struct FlowAnalysis: public PeriodicEngine{
 	inline Vector3r ijk2xyz(const Vector3i& ijk) const { return box.min()+ijk.cast<Real>()*cellSize; }
 
 	void setupGrid();
-	void addOneParticle(const shared_ptr<Particle>& par, const Vector3r& parPosLocal, const Real& radius, const Real& solidRatio);
+	// deposit one particle into *grid*, which is either data or one of threadData
+	// *depoWeight* scales everything deposited (1 for addCurrentData, dt for addNodeData)
+	void addOneParticle(boost_multi_array_real_5& grid, const Particle* par, const Vector3r& parPosLocal, const Real& diameter, const Real& solidRatio, const Real& depoWeight=1.);
+	// set matStateName from the first particle with matState, if not set yet; not thread-safe
+	void initMatStateName();
 	void addCurrentData();
+	// per-thread grids, same shape as data; summed into data by mergeThreadData
+	vector<boost_multi_array_real_5> threadData;
+	void setupThreadData();
+	void mergeThreadData(Real scale=1.);
+	boost_multi_array_real_5& threadGrid(){
+		#ifdef WOO_OPENMP
+			return threadData[omp_get_thread_num()];
+		#else
+			return threadData[0];
+		#endif
+	}
+	// called from Leapfrog (possibly in parallel) for every integrated node, when viaLeapfrog is set
+	bool leapfrogReady() const { return viaLeapfrog && !threadData.empty(); }
+	void addNodeData(const shared_ptr<Node>& n);
 	Real avgFlowNorm(const vector<size_t> &fractions);
 
 
@@ -72,6 +92,8 @@ struct FlowAnalysis: public PeriodicEngine{
 		((string,matStateName,"",,"If given, used for VTK-export of the scalar; if not given, is filled form the first instance encountered automatically.")) \
 		((Real,timeSpan,0.,,"Total time that the analysis has been running.")) \
 		((Vector3r,color,Vector3r(1,1,0),AttrTrait<>().rgbColor(),"Color for rendering the domain")) \
+		((bool,parallel,true,,"Deposit particles in parallel, each thread into its private grid; grids are summed into :obj:`data` afterwards. This needs one extra grid per thread; set to ``False`` if memory is scarce.")) \
+		((bool,viaLeapfrog,false,,"Deposit data at every step from within :obj:`Leapfrog`, right after each node is integrated and while its data are still in cache; :obj:`run` then only merges per-thread grids and advances :obj:`timeSpan`. Each deposit is weighted by :obj:`woo.core.Scene.dt` and the merged sum is divided by time elapsed since the previous run, so that :obj:`data` holds the time-average over that interval, the same as one deposition per run without viaLeapfrog. Only uninodal particles integrated by their own node are considered (not clump members), and :obj:`porosity` is not supported.")) \
 		, /*py*/ \
 			.def("vtkExport",&FlowAnalysis::vtkExport,WOO_PY_ARGS(py::arg("out")),"Export all fractions separately, and also an overall flow (sum). *out* specifies prefix for all export filenames, the rest is created to describe the fraction or ``all`` for the sum. Exported file names are returned, the sum being at the very end. Internally calls :obj:`vtkExportFractions` for all fractions.") \
 			.def("vtkExportFractions",&FlowAnalysis::vtkExportFractions,WOO_PY_ARGS(py::arg("out"),py::arg("fractions")),"Export one single fraction to file named *out*. The extension ``.vti`` is added automatically. *fractions* specifies existing fraction numbers to export. If *fractions* are an empty list (``[]``), all fractions are exported at once.") \
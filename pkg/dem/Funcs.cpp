@@ -180,50 +180,79 @@ Real DemFuncs::critDt(const shared_ptr<Scene>& scene, const shared_ptr<DemField>
 }
 
 
-std::tuple</*stress*/Matrix3r,/*stiffness*/Matrix6r> DemFuncs::stressStiffness(const Scene* scene, const DemField* dem, bool skipMultinodal, Real volume){
-	const int kron[3][3]={{1,0,0},{0,1,0},{0,0,1}}; // Kronecker delta
-
-	Matrix3r stress=Matrix3r::Zero();
-	Matrix6r K=Matrix6r::Zero();
+void DemFuncs::addContactStiffness(Matrix6r& K, const Vector3r& n, Real d0, Real kN, Real kT){
+	const Real d0sq=d0*d0;
+	const Matrix3r nn=n*n.transpose();
+	// only upper triangle used here
+	for(int p=0; p<6; p++) for(int q=p;q<6;q++){
+		const int i=voigtMap[p][q][0], j=voigtMap[p][q][1], k=voigtMap[p][q][2], l=voigtMap[p][q][3];
+		const Real nnnn=nn(i,j)*nn(k,l);
+		// kronecker delta as (i==l) etc
+		K(p,q)+=d0sq*(kN*nnnn+kT*(.25*(nn(j,k)*(i==l)+nn(j,l)*(i==k)+nn(i,k)*(j==l)+nn(i,l)*(j==k))-nnnn));
+	}
+}
 
-	for(const shared_ptr<Contact>& C: *dem->contacts){
-		FrictPhys* phys=WOO_CAST<FrictPhys*>(C->phys.get());
-		const Particle *pA=C->leakPA(), *pB=C->leakPB();
-		Vector3r posB=pB->shape->nodes[0]->pos;
-		Vector3r posA=pA->shape->nodes[0]->pos-(scene->isPeriodic?scene->cell->intrShiftPos(C->cellDist):Vector3r::Zero());
-		if(pA->shape->nodes.size()!=1 || pB->shape->nodes.size()!=1){
-			if(skipMultinodal) continue;
-			//else woo::ValueError("Particle "+to_string(pA->shape->nodes.size()!=1? pA->id : pB->id)+" has more than one node; to skip contacts with such particles, say skipMultinodal=True");
-			if(pA->shape->nodes.size()!=1) posA=C->geom->node->pos;
-			if(pB->shape->nodes.size()!=1) posB=C->geom->node->pos;
-		}
-		// use current distance here
-		const Real d0=(posA-posB).norm();
-		Vector3r n=C->geom->node->ori*Vector3r::UnitX(); // normal in global coords
-		#if 1
-			// g3geom doesn't set local x axis properly
-			G3Geom* g3g=dynamic_cast<G3Geom*>(C->geom.get());
-			if(g3g) n=g3g->normal;
-		#endif
-		// contact force, in global coords
-		Vector3r F=C->geom->node->ori*C->phys->force;
-		Real fN=F.dot(n);
-		Vector3r fT=F-n*fN;
-		//cerr<<"n="<<n.transpose()<<", fN="<<fN<<", fT="<<fT.transpose()<<endl;
-		for(int i:{0,1,2}) for(int j:{0,1,2}) stress(i,j)+=d0*(fN*n[i]*n[j]+.5*(fT[i]*n[j]+fT[j]*n[i]));
-		//cerr<<"stress="<<stress<<endl;
-		const Real& kN=phys->kn; const Real& kT=phys->kt;
-		// only upper triangle used here
-		for(int p=0; p<6; p++) for(int q=p;q<6;q++){
-			int i=voigtMap[p][q][0], j=voigtMap[p][q][1], k=voigtMap[p][q][2], l=voigtMap[p][q][3];
-			K(p,q)+=d0*d0*(kN*n[i]*n[j]*n[k]*n[l]+kT*(.25*(n[j]*n[k]*kron[i][l]+n[j]*n[l]*kron[i][k]+n[i]*n[k]*kron[j][l]+n[i]*n[l]*kron[j][k])-n[i]*n[j]*n[k]*n[l]));
-		}
+bool DemFuncs::addContactStressStiffness(const Scene* scene, const Contact* C, bool skipMultinodal, Matrix3r& stress, Matrix6r& K){
+	const FrictPhys* phys=WOO_CAST<const FrictPhys*>(C->phys.get());
+	const Particle *pA=C->leakPA(), *pB=C->leakPB();
+	const auto& nnA(pA->shape->nodes); const auto& nnB(pB->shape->nodes);
+	Vector3r posB=nnB[0]->pos;
+	Vector3r posA=nnA[0]->pos-(scene->isPeriodic?scene->cell->intrShiftPos(C->cellDist):Vector3r::Zero());
+	if(nnA.size()!=1 || nnB.size()!=1){
+		if(skipMultinodal) return false;
+		if(nnA.size()!=1) posA=C->geom->node->pos;
+		if(nnB.size()!=1) posB=C->geom->node->pos;
 	}
-	for(int p=0;p<6;p++)for(int q=p+1;q<6;q++) K(q,p)=K(p,q); // symmetrize
+	// use current distance here
+	const Real d0=(posA-posB).norm();
+	const Quaternionr& ori=C->geom->node->ori;
+	Vector3r n=ori*Vector3r::UnitX(); // normal in global coords
+	#if 1
+		// g3geom doesn't set local x axis properly
+		if(const G3Geom* g3g=dynamic_cast<const G3Geom*>(C->geom.get())) n=g3g->normal;
+	#endif
+	// contact force, in global coords
+	const Vector3r F=ori*phys->force;
+	const Real fN=F.dot(n);
+	const Vector3r fT=F-n*fN;
+	stress.noalias()+=d0*(fN*n*n.transpose()+.5*(fT*n.transpose()+n*fT.transpose()));
+	addContactStiffness(K,n,d0,phys->kn,phys->kt);
+	return true;
+}
+
+std::tuple</*stress*/Matrix3r,/*stiffness*/Matrix6r> DemFuncs::stressStiffness(const Scene* scene, const DemField* dem, bool skipMultinodal, Real volume){
 	if(volume<=0){
 		if(scene->isPeriodic) volume=scene->cell->getVolume();
 		else woo::ValueError("Positive volume value must be given for aperiodic simulations.");
 	}
+	Matrix3r stress=Matrix3r::Zero();
+	Matrix6r K=Matrix6r::Zero();
+	const auto& contacts(*dem->contacts);
+	const long size=contacts.size();
+	// each thread sums into its own matrices, which are added together at the end in thread order;
+	// with static schedule, the result thus does not change between runs with the same number of threads
+	#ifdef WOO_OPENMP
+		const int nThreads=omp_get_max_threads();
+	#else
+		const int nThreads=1;
+	#endif
+	vector<Matrix3r> stressTh(nThreads,Matrix3r::Zero());
+	vector<Matrix6r> KTh(nThreads,Matrix6r::Zero());
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static) num_threads(nThreads)
+	#endif
+	for(long i=0; i<size; i++){
+		const Contact* C=contacts[i].get();
+		if(!C->isReal()) continue;
+		#ifdef WOO_OPENMP
+			const int th=omp_get_thread_num();
+		#else
+			const int th=0;
+		#endif
+		addContactStressStiffness(scene,C,skipMultinodal,stressTh[th],KTh[th]);
+	}
+	for(int th=0; th<nThreads; th++){ stress+=stressTh[th]; K+=KTh[th]; }
+	for(int p=0;p<6;p++)for(int q=p+1;q<6;q++) K(q,p)=K(p,q); // symmetrize
 	stress/=volume; K/=volume;
 	return std::make_tuple(stress,K);
 }
@@ -231,9 +260,15 @@ std::tuple</*stress*/Matrix3r,/*stiffness*/Matrix6r> DemFuncs::stressStiffness(c
 Real DemFuncs::unbalancedForce(const Scene* scene, const DemField* dem, bool useMaxForce){
 	// get maximum force on a body and sum of all forces (for averaging)
 	Real sumF=0,maxF=0;
-	int nb=0;
-	for(const shared_ptr<Node>& n: dem->nodes){
-		DemData& dyn=n->getData<DemData>();
+	long nb=0;
+	const auto& nodes(dem->nodes);
+	const long nNodes=nodes.size();
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static) reduction(+:sumF,nb) reduction(max:maxF)
+	#endif
+	for(long i=0; i<nNodes; i++){
+		const shared_ptr<Node>& n=nodes[i];
+		const DemData& dyn=n->getData<DemData>();
 		if(!dyn.isBlockedNone() || dyn.isClumped()) continue;
 		Real currF;
 		// we suppose here the clump has not yet received any forces from its members
@@ -249,12 +284,19 @@ Real DemFuncs::unbalancedForce(const Scene* scene, const DemField* dem, bool use
 	}
 	Real meanF=sumF/nb;
 	// get mean force on interactions
-	sumF=0; nb=0;
-	for(const shared_ptr<Contact>& C: *dem->contacts){
-		sumF+=C->phys->force.norm(); nb++;
+	Real sumFc=0; long nc=0;
+	const auto& contacts(*dem->contacts);
+	const long size=contacts.size();
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static) reduction(+:sumFc,nc)
+	#endif
+	for(long i=0; i<size; i++){
+		const Contact* C=contacts[i].get();
+		if(!C->isReal()) continue;
+		sumFc+=C->phys->force.norm(); nc++;
 	}
-	sumF/=nb;
-	return (useMaxForce?maxF:meanF)/(sumF);
+	sumFc/=nc;
+	return (useMaxForce?maxF:meanF)/(sumFc);
 }
 
 bool DemFuncs::particleStress(const shared_ptr<Particle>& p, Vector3r& normal, Vector3r& shear){
@@ -295,13 +337,15 @@ vector<Particle::id_t> DemFuncs::SpherePack_toSimulation_fast(const shared_ptr<S
 
 vector<Vector2r> DemFuncs::boxPsd(const Scene* scene, const DemField* dem, const AlignedBox3r& box, bool mass, int num, int mask, Vector2r rRange){
 	bool haveBox=!isnan(box.min()[0]) && !isnan(box.max()[0]);
-	return psd(
-		*dem->particles|boost::adaptors::filtered([&](const shared_ptr<Particle>&p){ return p && p->shape && p->shape->nodes.size()==1 && (mask?(p->mask&mask):true) && (bool)(dynamic_pointer_cast<woo::Sphere>(p->shape)) && (haveBox?box.contains(p->shape->nodes[0]->pos):true); }),
+	auto parOk=[&](const shared_ptr<Particle>&p){ return p && p->shape && p->shape->nodes.size()==1 && (mask?(p->mask&mask):true) && (bool)(dynamic_pointer_cast<woo::Sphere>(p->shape)) && (haveBox?box.contains(p->shape->nodes[0]->pos):true); };
+	// particles not matching are skipped by returning NaN diameter
+	return psdParallel(
+		*dem->particles,
 		/*cumulative*/true,/*normalize*/true,
 		num,
 		rRange,
-		/*diameter getter*/[](const shared_ptr<Particle>&p, const size_t& i) ->Real { return 2.*p->shape->cast<Sphere>().radius; },
-		/*weight getter*/[&](const shared_ptr<Particle>&p, const size_t& i) -> Real{ return mass?p->shape->nodes[0]->getData<DemData>().mass:1.; }
+		/*diameter getter*/[&](const shared_ptr<Particle>&p, const size_t& i) ->Real { return parOk(p)?2.*p->shape->cast<Sphere>().radius:NaN; },
+		/*weight getter*/[&](const shared_ptr<Particle>&p, const size_t& i) -> Real{ return !parOk(p)?NaN:(mass?p->shape->nodes[0]->getData<DemData>().mass:1.); }
 	);
 }
 
@@ -698,81 +742,200 @@ class _wall_initial_shape : public voro::wall {
 };
 
 
-voro::container_poly _makeVoroContainerPolyFromParticlesInBox(const shared_ptr<DemField>& dem, const AlignedBox3r& box, _wall_initial_shape& wis, int idOff=0){
-	voro::container_poly con(box.min()[0],box.max()[0],box.min()[1],box.max()[1],box.min()[2],box.max()[2],5,5,5,false,false,false,8);
-	// _wall_initial_shape wis(r);
-	con.add_wall(wis);
-	vector<Particle::id_t> ret;
-	for(const auto& p: *dem->particles){
-		if(!p->shape) continue;
-		const auto& sh(p->shape);
-		Real rad=p->shape->equivRadius();
-		if(isnan(rad)) continue; // discards also multinodal shapes
-		const auto& pos(sh->nodes[0]->pos);
-		if(!box.contains(pos)) continue;
-		con.put(p->id+idOff,pos[0],pos[1],pos[2],rad);
+namespace{
+	struct _VoroParticle{ Particle::id_t id; Vector3r pos; Real rad; };
+
+	// particles with valid equivalent radius (not multinodal) and centers inside box
+	vector<_VoroParticle> _voroParticlesInBox(const shared_ptr<DemField>& dem, const AlignedBox3r& box){
+		vector<_VoroParticle> ret;
+		for(const auto& p: *dem->particles){
+			if(!p->shape) continue;
+			Real rad=p->shape->equivRadius();
+			if(isnan(rad)) continue; // invalid radius (this includes multinodal shapes)
+			assert(rad>0); /* tested in Shape::selfTest */
+			const auto& pos(p->shape->nodes[0]->pos);
+			if(!box.contains(pos)) continue;
+			ret.push_back(_VoroParticle{p->id,pos,rad});
+		}
+		return ret;
+	}
+
+	/*
+	Compute radical Voronoi cells of particles pp inside box, calling cellFunc(i,cell) for every pp[i] with valid cell (from several threads concurrently).
+
+	The box is split along its longest dimension into slabs (maxSlabs at most, or one per thread if non-positive), each computed in its own voro++ container which also contains particles within margin around the slab. A cell computed this way is exact if no particle beyond the margin could cut it: in the radical tesselation, particle j at distance d cuts cell of radius R (maximum vertex distance) only if d<R+sqrt(R²+r_j²); cells failing this test are computed again in a container with all particles. Number of voro++ blocks in each container is set so that the block size is relBlockSize times average particle diameter (as with VoroField.relSubcellSize).
+	*/
+	template<class CellT, typename CellFunc>
+	void _voroComputeCells(const vector<_VoroParticle>& pp, const AlignedBox3r& box, voro::wall& wall, int idOff, const CellFunc& cellFunc, int maxSlabs=0, Real relBlockSize=2.5){
+		if(pp.empty()) return;
+		Real rAvg=0, rMax=0;
+		for(const auto& p: pp){ rAvg+=p.rad; rMax=max(rMax,p.rad); }
+		rAvg/=pp.size();
+		const Real blockSize=relBlockSize*2*rAvg;
+		auto makeContainer=[&](const AlignedBox3r& b){
+			Vector3i n;
+			for(int ax:{0,1,2}) n[ax]=max(1,(int)(.5+b.sizes()[ax]/blockSize));
+			// initial memory per block: expected number of particles in block, about 2× more in case of dense packings
+			int initMem=max(8,(int)(2*pp.size()*b.volume()/(box.volume()*n.prod())));
+			return std::unique_ptr<voro::container_poly>(new voro::container_poly(b.min()[0],b.max()[0],b.min()[1],b.max()[1],b.min()[2],b.max()[2],n[0],n[1],n[2],false,false,false,min(initMem,1024)));
+		};
+		// split along the longest axis; margin several diameters, slabs at least as thick as the margin
+		int ax; box.sizes().maxCoeff(&ax);
+		const Real margin=6*2*rAvg+rMax;
+		#ifdef WOO_OPENMP
+			const int nThreads=omp_get_max_threads();
+		#else
+			const int nThreads=1;
+		#endif
+		const int nSlabs=max(1,min(maxSlabs>0?maxSlabs:nThreads,(int)(box.sizes()[ax]/margin)));
+		const Real slabLen=box.sizes()[ax]/nSlabs;
+		vector<vector<size_t>> retry(nSlabs);
+		#ifdef WOO_OPENMP
+			#pragma omp parallel for schedule(dynamic,1) num_threads(nSlabs)
+		#endif
+		for(int s=0; s<nSlabs; s++){
+			const Real lo=box.min()[ax]+s*slabLen, hi=(s==nSlabs-1?box.max()[ax]:lo+slabLen);
+			AlignedBox3r ext(box);
+			if(s>0) ext.min()[ax]=lo-margin;
+			if(s<nSlabs-1) ext.max()[ax]=hi+margin;
+			ext=ext.intersection(box);
+			auto con=makeContainer(ext);
+			con->add_wall(wall);
+			for(size_t i=0; i<pp.size(); i++){
+				const auto& p(pp[i]);
+				if(p.pos[ax]<ext.min()[ax] || p.pos[ax]>ext.max()[ax]) continue;
+				con->put(i+idOff,p.pos[0],p.pos[1],p.pos[2],p.rad);
+			}
+			voro::c_loop_all cla(*con);
+			CellT c;
+			if(cla.start()) do {
+				int id; double x,y,z,r;
+				cla.pos(id,x,y,z,r);
+				// only particles of the core slab
+				const Real pAx=(ax==0?x:(ax==1?y:z));
+				if(pAx<lo || (s<nSlabs-1 && pAx>=hi)) continue;
+				if(!con->compute_cell(c,cla)) continue;
+				const size_t i=id-idOff;
+				if(nSlabs>1){
+					Real R=.5*sqrt(c.max_radius_squared());
+					Real dLo=(s>0?pAx-(lo-margin):Inf), dHi=(s<nSlabs-1?(hi+margin)-pAx:Inf);
+					if(min(dLo,dHi)<R+sqrt(R*R+rMax*rMax)){ retry[s].push_back(i); continue; }
+				}
+				cellFunc(i,c);
+			} while(cla.inc());
+		}
+		size_t nRetry=0;
+		for(const auto& r: retry) nRetry+=r.size();
+		if(nRetry==0) return;
+		// cells not determined within the margin: full container, computed serially
+		const auto& logger=DemFuncs::logger;
+		LOG_DEBUG("{} Voronoi cells extend beyond slab margins, computing them again.",nRetry);
+		vector<char> todo(pp.size(),0);
+		for(const auto& r: retry) for(size_t i: r) todo[i]=1;
+		auto con=makeContainer(box);
+		con->add_wall(wall);
+		for(size_t i=0; i<pp.size(); i++) con->put(i+idOff,pp[i].pos[0],pp[i].pos[1],pp[i].pos[2],pp[i].rad);
+		voro::c_loop_all cla(*con);
+		CellT c;
+		if(cla.start()) do {
+			const size_t i=cla.pid()-idOff;
+			if(todo[i] && con->compute_cell(c,cla)) cellFunc(i,c);
+		} while(cla.inc());
 	}
-	return con;
 }
 
-vector<Real> DemFuncs::boxPorosity(const shared_ptr<DemField>& dem, const AlignedBox3r& box){
-	voro::container_poly con(box.min()[0],box.max()[0],box.min()[1],box.max()[1],box.min()[2],box.max()[2],5,5,5,false,false,false,8);
+vector<Real> DemFuncs::boxPorosity(const shared_ptr<DemField>& dem, const AlignedBox3r& box, int slabs){
 	_wall_initial_shape wis; // XXX: radius of cell
-	con.add_wall(wis);
 	vector<Real> ret(dem->particles->size(),NaN); // return array, same ordering as particles; filled with NaN
-	for(const auto& p: *dem->particles){
-		if(!p->shape) continue;
-		const auto& sh(p->shape);
-		Real rad=p->shape->equivRadius();
-		if(isnan(rad)) continue; // invalid radius (this includes multinodal shapes)
-		assert(rad>0); /* tested in Shape::selfTest */
-		const auto& pos(sh->nodes[0]->pos);
-		if(!box.contains(pos)) continue;
-		con.put(p->id,pos[0],pos[1],pos[2],rad);
-	}
-	voro::c_loop_all cla(con);
-	voro::voronoicell c;
-	if(cla.start()) do if(con.compute_cell(c,cla)){
-		int id; double x,y,z,r;
-		cla.pos(id,x,y,z,r);
-		const auto& sh=(*dem->particles)[id]->shape;
-		ret[id]=1-CompUtils::clamped(sh->volume()/c.volume(),0,1);
-	} while(cla.inc());
+	vector<_VoroParticle> pp=_voroParticlesInBox(dem,box);
+	_voroComputeCells<voro::voronoicell>(pp,box,wis,/*idOff*/0,[&](size_t i, voro::voronoicell& c){
+		const auto& sh=(*dem->particles)[pp[i].id]->shape;
+		ret[pp[i].id]=1-CompUtils::clamped(sh->volume()/c.volume(),0,1);
+	},slabs);
 	return ret;
 }
 
-std::map<Particle::id_t,std::vector<Vector3r>> DemFuncs::surfParticleIdNormals(const shared_ptr<DemField>& dem, const AlignedBox3r& box, const Real& r){
+std::tuple<vector<Particle::id_t>,vector<Vector3r>> DemFuncs::surfParticleIdNormals(const shared_ptr<DemField>& dem, const AlignedBox3r& box, const Real& r, int slabs){
 	_wall_initial_shape wis(r);
-	voro::container_poly con=_makeVoroContainerPolyFromParticlesInBox(dem,box,wis,/*idOff*/1);
-	//con.draw_particles_pov("/tmp/surfParticleIds_p.pov");
-	//con.draw_cells_pov("/tmp/surfParticleIds_v.pov");
-	std::map<Particle::id_t,std::vector<Vector3r>> ret;
-	voro::c_loop_all cla(con);
-	voro::voronoicell_neighbor c;
-	if(cla.start()) do if(con.compute_cell(c,cla)){
-		int id; double x,y,z,r;
-		cla.pos(id,x,y,z,r);
+	vector<_VoroParticle> pp=_voroParticlesInBox(dem,box);
+	// normals of faces without neighbors (those come from the initial shape), for each particle; neighbor ids are offset so that 0 is not a particle
+	vector<vector<Vector3r>> surf(pp.size());
+	_voroComputeCells<voro::voronoicell_neighbor>(pp,box,wis,/*idOff*/1,[&](size_t i, voro::voronoicell_neighbor& c){
 		std::vector<int> neighbors;
 		c.neighbors(neighbors);
 		int zeros=0;
 		for(const auto& n: neighbors) if(n==0) zeros++;
-		if(zeros==0) continue;
+		if(zeros==0) return;
 		std::vector<double> normals;
 		c.normals(normals);
-		std::vector<Vector3r> nn;
-		nn.reserve(zeros);
 		assert(normals.size()/3==neighbors.size());
-		for(size_t i=0; i<neighbors.size(); i++){
-			if(neighbors[i]==0) nn.push_back(Vector3r(normals[3*i],normals[3*i+1],normals[3*i+2]));
+		surf[i].reserve(zeros);
+		for(size_t j=0; j<neighbors.size(); j++){
+			if(neighbors[j]==0) surf[i].push_back(Vector3r(normals[3*j],normals[3*j+1],normals[3*j+2]));
 		}
-		ret[id-1]=nn;
-		#if 0
-			cerr<<"#"<<id<<" neighbors ["<<neighbors.size()<<"]: ";
-			for(const auto& n: neighbors) cerr<<n<<",";
-			cerr<<"   normals["<<normals.size()/3<<"]: ";
-			for(size_t i=0; i<normals.size()/3; i+=1) cerr<<normals[3*i]<<","<<normals[3*i+1]<<","<<normals[3*i+2]<<"; ";
-			cerr<<"\n";
-		#endif
-	} while(cla.inc());
+	},slabs);
+	vector<Particle::id_t> ids; vector<Vector3r> nn;
+	for(size_t i=0; i<pp.size(); i++){
+		for(const Vector3r& n: surf[i]){ ids.push_back(pp[i].id); nn.push_back(n); }
+	}
+	return std::make_tuple(ids,nn);
+}
+
+void PsdHistogram::clear(){
+	n=0; last=Vector3r(NaN,NaN,NaN);
+	dMin=Inf; dMax=-Inf;
+	zero=Vector2r::Zero();
+	off=0; bins.clear();
+}
+
+void PsdHistogram::add(Real d, Real m){
+	if(isnan(d)) return;
+	dMin=min(dMin,d); dMax=max(dMax,d);
+	// NaN mass is not counted with mass-based PSD, which is the same as zero mass
+	const Vector2r cm(1.,isnan(m)?0.:m);
+	if(d<=0){ zero+=cm; return; }
+	long k=(long)floor(log(d)/log1p(relWidth));
+	if(bins.empty()){ off=k; bins.assign(1,Vector2r::Zero()); }
+	else if(k<off){ bins.insert(bins.begin(),off-k,Vector2r::Zero()); off=k; }
+	else if(k>=off+(long)bins.size()) bins.resize(k-off+1,Vector2r::Zero());
+	bins[k-off]+=cm;
+}
+
+void PsdHistogram::sync(const vector<Vector3r>& dmt){
+	// NaN-aware comparison
+	auto same=[](const Vector3r& a, const Vector3r& b){ for(int i:{0,1,2}){ if(!(a[i]==b[i] || (isnan(a[i]) && isnan(b[i])))) return false; } return true; };
+	if(dmt.size()<n || (n>0 && !same(dmt[n-1],last))) clear();
+	if(dmt.size()==n) return;
+	for(size_t i=n; i<dmt.size(); i++) add(dmt[i][0],dmt[i][1]);
+	n=dmt.size();
+	last=dmt.back();
+}
+
+vector<Vector2r> PsdHistogram::psd(bool mass, bool cumulative, bool normalize, int num, Vector2r dRange, bool emptyOk) const {
+	if(isnan(dRange[0]) || isnan(dRange[1]) || dRange[0]<0 || dRange[1]<=0 || dRange[0]>=dRange[1]){
+		if(isinf(dMin)){
+			if(!emptyOk) throw std::runtime_error("DemFuncs::psd: no spherical particles?");
+			else return vector<Vector2r>{Vector2r::Zero(),Vector2r::Zero()};
+		}
+		dRange=Vector2r(dMin,dMax);
+	}
+	vector<Vector2r> ret(num,Vector2r::Zero());
+	Real weight=0;
+	auto addBin=[&](const Vector2r& cm, Real d){
+		Real w=(mass?cm[1]:cm[0]);
+		if(w==0.) return;
+		weight+=w;
+		// representative diameter must not be outside of the real range, which would discard the largest particles
+		d=min(max(d,dMin),dMax);
+		if(d>dRange[1]) return;
+		int bin=max(0,min(num-1,1+(int)((num-1)*((d-dRange[0])/(dRange[1]-dRange[0])))));
+		ret[bin][1]+=w;
+	};
+	addBin(zero,0.);
+	const Real lnW=log1p(relWidth);
+	for(size_t i=0; i<bins.size(); i++) addBin(bins[i],exp((off+(long)i+.5)*lnW));
+	for(int i=0;i<num;i++) ret[i][0]=dRange[0]+i*(dRange[1]-dRange[0])/(num-1);
+	if(normalize) for(int i=0;i<num;i++) ret[i][1]=ret[i][1]/weight;
+	if(cumulative) for(int i=1;i<num;i++) ret[i][1]+=ret[i-1][1];
 	return ret;
 }
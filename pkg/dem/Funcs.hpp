@@ -7,6 +7,10 @@
 #include<woo/pkg/dem/Facet.hpp>
 #include<woo/lib/sphere-pack/SpherePack.hpp>
 
+#ifdef WOO_OPENMP
+	#include<omp.h>
+#endif
+
 #include <boost/iterator/zip_iterator.hpp>
 #include <boost/range.hpp>
 
@@ -14,6 +18,10 @@ struct DemFuncs{
 	WOO_DECL_LOGGER;
 	static shared_ptr<DemField> getDemField(const Scene* scene);
 	static std::tuple</*stress*/Matrix3r,/*stiffness*/Matrix6r> stressStiffness(const Scene* scene, const DemField* dem, bool skipMultinodal, Real volume);
+	// add stiffness of one contact with normal n and branch length d0 to the upper triangle of K (Voigt notation); not scaled by volume
+	static void addContactStiffness(Matrix6r& K, const Vector3r& n, Real d0, Real kN, Real kT);
+	// add stress and stiffness of one real contact (not scaled by volume); return false if skipped
+	static bool addContactStressStiffness(const Scene* scene, const Contact* C, bool skipMultinodal, Matrix3r& stress, Matrix6r& K);
 	static Real unbalancedForce(const Scene* scene, const DemField* dem, bool useMaxForce);
 	static shared_ptr<Particle> makeSphere(Real radius, const shared_ptr<Material>& m);
 	static vector<Particle::id_t> SpherePack_toSimulation_fast(const shared_ptr<SpherePack>& sp, const Scene* scene, const DemField* dem, const shared_ptr<Material>& mat, int mask=0, Real color=NaN);
@@ -101,6 +109,102 @@ struct DemFuncs{
 		return ret;
 	};
 
+	/* same as psd, but for random-access sequences (std::vector and such), which are traversed in parallel */
+	template<class Sequence, class DiameterGetter, class WeightGetter>
+	static vector<Vector2r> psdParallel(const Sequence& seq,
+		bool cumulative, bool normalize, int num, Vector2r dRange,
+		DiameterGetter diameterGetter,
+		WeightGetter weightGetter,
+		bool emptyOk=false
+	){
+		const long N=seq.size();
+		if(isnan(dRange[0]) || isnan(dRange[1]) || dRange[0]<0 || dRange[1]<=0 || dRange[0]>=dRange[1]){
+			Real dMin=Inf, dMax=-Inf;
+			#ifdef WOO_OPENMP
+				#pragma omp parallel for schedule(static) reduction(min:dMin) reduction(max:dMax)
+			#endif
+			for(long i=0; i<N; i++){
+				Real d=diameterGetter(seq[i],(size_t)i);
+				if(d<dMin) dMin=d;
+				if(d>dMax) dMax=d;
+			}
+			if(isinf(dMin)){
+				if(!emptyOk) throw std::runtime_error("DemFuncs::psd: no spherical particles?");
+				else return vector<Vector2r>{Vector2r::Zero(),Vector2r::Zero()};
+			}
+			dRange=Vector2r(dMin,dMax);
+		}
+		#ifdef WOO_OPENMP
+			const int nThreads=omp_get_max_threads();
+		#else
+			const int nThreads=1;
+		#endif
+		// per-thread bins, summed in thread order afterwards
+		vector<vector<Real>> binsTh(nThreads,vector<Real>(num,0.));
+		Real weight=0;
+		#ifdef WOO_OPENMP
+			#pragma omp parallel for schedule(static) reduction(+:weight)
+		#endif
+		for(long i=0; i<N; i++){
+			Real d=diameterGetter(seq[i],(size_t)i);
+			Real w=weightGetter(seq[i],(size_t)i);
+			if(isnan(d) || isnan(w) || w==0.) continue;
+			weight+=w;
+			if(d>dRange[1]) continue;
+			int bin=max(0,min(num-1,1+(int)((num-1)*((d-dRange[0])/(dRange[1]-dRange[0])))));
+			#ifdef WOO_OPENMP
+				binsTh[omp_get_thread_num()][bin]+=w;
+			#else
+				binsTh[0][bin]+=w;
+			#endif
+		}
+		vector<Vector2r> ret(num,Vector2r::Zero());
+		for(int i=0;i<num;i++){
+			ret[i][0]=dRange[0]+i*(dRange[1]-dRange[0])/(num-1);
+			for(int th=0; th<nThreads; th++) ret[i][1]+=binsTh[th][i];
+		}
+		if(normalize) for(int i=0;i<num;i++) ret[i][1]=ret[i][1]/weight;
+		if(cumulative) for(int i=1;i<num;i++) ret[i][1]+=ret[i-1][1];
+		return ret;
+	};
+
+	/* same as psd, for sequences which can only be traversed by calling forEach(f), which calls f(item,index) for each item (such as data read from a file) */
+	template<class ForEach, class DiameterGetter, class WeightGetter>
+	static vector<Vector2r> psdForEach(ForEach forEach,
+		bool cumulative, bool normalize, int num, Vector2r dRange,
+		DiameterGetter diameterGetter,
+		WeightGetter weightGetter,
+		bool emptyOk=false
+	){
+		if(isnan(dRange[0]) || isnan(dRange[1]) || dRange[0]<0 || dRange[1]<=0 || dRange[0]>=dRange[1]){
+			dRange=Vector2r(Inf,-Inf);
+			forEach([&](const auto& p, size_t i){
+				Real d=diameterGetter(p,i);
+				if(d<dRange[0]) dRange[0]=d;
+				if(d>dRange[1]) dRange[1]=d;
+			});
+			if(isinf(dRange[0])){
+				if(!emptyOk) throw std::runtime_error("DemFuncs::psd: no spherical particles?");
+				else return vector<Vector2r>{Vector2r::Zero(),Vector2r::Zero()};
+			}
+		}
+		vector<Vector2r> ret(num,Vector2r::Zero());
+		Real weight=0;
+		forEach([&](const auto& p, size_t i){
+			Real d=diameterGetter(p,i);
+			Real w=weightGetter(p,i);
+			if(isnan(d) || isnan(w) || w==0.) return;
+			weight+=w;
+			if(d>dRange[1]) return;
+			int bin=max(0,min(num-1,1+(int)((num-1)*((d-dRange[0])/(dRange[1]-dRange[0])))));
+			ret[bin][1]+=w;
+		});
+		for(int i=0;i<num;i++) ret[i][0]=dRange[0]+i*(dRange[1]-dRange[0])/(num-1);
+		if(normalize) for(int i=0;i<num;i++) ret[i][1]=ret[i][1]/weight;
+		if(cumulative) for(int i=1;i<num;i++) ret[i][1]+=ret[i-1][1];
+		return ret;
+	};
+
 	template<class IteratorRange, class ItemGetter>
 	static py::object seqVectorToPy(const IteratorRange& range, ItemGetter itemGetter, bool zipped){
 		if(!zipped){
@@ -138,12 +242,31 @@ struct DemFuncs{
 		static bool vtkExportTraces(const shared_ptr<Scene>& scene, const shared_ptr<DemField>& dem, const string& filename, const Vector2i& moduloOffset=Vector2i::Zero());
 	#endif
 
-	/* return porosity of particles, compued as void volume fraction after radical Voronoi tesselation */
-	static vector<Real> boxPorosity(const shared_ptr<DemField>&, const AlignedBox3r& box);
+	/* return porosity of particles, compued as void volume fraction after radical Voronoi tesselation; cells are computed in parallel, in at most slabs sub-boxes (one per thread if non-positive) */
+	static vector<Real> boxPorosity(const shared_ptr<DemField>&, const AlignedBox3r& box, int slabs=0);
 
-	static std::map<Particle::id_t,std::vector<Vector3r>> surfParticleIdNormals(const shared_ptr<DemField>& dem, const AlignedBox3r& box, const Real& r);
+	/* return normals of Voronoi cell faces without neighbors, and ids of particles they belong to (one id per normal) */
+	static std::tuple<vector<Particle::id_t>,vector<Vector3r>> surfParticleIdNormals(const shared_ptr<DemField>& dem, const AlignedBox3r& box, const Real& r, int slabs=0);
 
 
 };
 
-
+/* Fine histogram of diameters (with particle count and mass), with logarithmically spaced bins of relative width relWidth; it is updated incrementally from diamMassTime-like sequences (diameter, mass, time) and can be re-binned to what DemFuncs::psd returns in O(bins), without traversing the sequence. Diameters are only known up to relWidth, which is much finer than PSD bins normally are. */
+struct PsdHistogram{
+	static constexpr Real relWidth=1e-3;
+	// number of sequence items included, and the last of them (to detect when the sequence changed otherwise than by appending)
+	size_t n=0;
+	Vector3r last=Vector3r(NaN,NaN,NaN);
+	Real dMin=Inf, dMax=-Inf;
+	// count and mass of non-positive diameters
+	Vector2r zero=Vector2r::Zero();
+	// bin index of bins[0]; bins contain (count, mass)
+	long off=0;
+	vector<Vector2r> bins;
+	void clear();
+	void add(Real d, Real m);
+	// include new items of dmt; rebuild from scratch if items were removed or changed
+	void sync(const vector<Vector3r>& dmt);
+	// same arguments and result as DemFuncs::psd over all items
+	vector<Vector2r> psd(bool mass, bool cumulative, bool normalize, int num, Vector2r dRange, bool emptyOk=false) const;
+};
@@ -148,6 +148,17 @@ void Gl1_DemField::doShape(){
 	// experimental
 	glHint(GL_POINT_SMOOTH_HINT, GL_FASTEST);
 
+	// spheres are batched and rendered all at once after the loop; not when selecting, as the batch has no GL names
+	bool useImpostors=(sphereImpostors && !renderer->fastDraw && !renderer->withNames && impostors.isSupported());
+	// functor rendering spheres (looked up at the first sphere), to check its wire flag and get scale
+	shared_ptr<Gl1_Sphere> glSphere; bool glSphereChecked=false;
+	auto impostorFunctorOk=[&](const shared_ptr<Shape>& s)->bool{
+		if(!glSphereChecked){ glSphere=dynamic_pointer_cast<Gl1_Sphere>(shapeDispatcher->getFunctor1D(s)); glSphereChecked=true; }
+		return glSphere && !glSphere->wire;
+	};
+	impostors.clear();
+	if(useImpostors) impostors.reserve(dem->particles->size());
+
 	// instead of const shared_ptr&, get proper shared_ptr;
 	// Less efficient in terms of performance, since memory has to be written (not measured, though),
 	// but it is still better than crashes if the body gets deleted meanwile.
@@ -264,6 +275,10 @@ void Gl1_DemField::doShape(){
 			glBegin(GL_POINTS);
 				glVertex3v((n0->pos+n0->getData<GlData>().dGlPos).eval());
 			glEnd();
+		} else if(useImpostors && p->shape->isA<Sphere>() && !(wire||sh->getWire()) && !name.highlighted && impostorFunctorOk(p->shape)){
+			// own node, not n0, which is the clump for clumped spheres
+			const shared_ptr<Node>& n=sh->nodes[0];
+			impostors.add(n->pos+n->getData<GlData>().dGlPos,sh->cast<Sphere>().radius*glSphere->scale,parColor);
 		} else {
 			glPushMatrix();
 				glColor3v(parColor);
@@ -318,6 +333,10 @@ void Gl1_DemField::doShape(){
 			}
 		}
 	}
+	if(!impostors.empty()){
+		glEnable(GL_LIGHTING);
+		impostors.draw();
+	}
 }
 
 void Gl1_DemField::doNodes(const vector<shared_ptr<Node>>& nodeContainer){
@@ -326,7 +345,9 @@ void Gl1_DemField::doNodes(const vector<shared_ptr<Node>>& nodeContainer){
 	glDisable(GL_LIGHTING);
 
 	viewInfo->renderer->nodeDispatcher.scene=scene; viewInfo->renderer->nodeDispatcher.updateScenePtr();
-	for(shared_ptr<Node> n: nodeContainer){
+	const size_t stride=lodStride(nodeContainer.size(),maxNodes);
+	for(size_t i=0; i<nodeContainer.size(); i+=stride){
+		shared_ptr<Node> n=nodeContainer[i];
 		PROCESS_GUI_EVENTS_SOMETIMES;
 
 		viewInfo->renderer->setNodeGlData(n);
@@ -369,7 +390,8 @@ void Gl1_DemField::doContactNodes(){
 	// if(cNode==CNODE_NONE) return;
 	viewInfo->renderer->nodeDispatcher.scene=scene; viewInfo->renderer->nodeDispatcher.updateScenePtr();
 	std::scoped_lock lock(dem->contacts->manipMutex);
-	for(size_t i=0; i<dem->contacts->size(); i++){
+	const size_t stride=lodStride(dem->contacts->size(),maxContacts);
+	for(size_t i=0; i<dem->contacts->size(); i+=stride){
 		PROCESS_GUI_EVENTS_SOMETIMES;
 		const shared_ptr<Contact>& C((*dem->contacts)[i]);
 		const Particle *pA=C->leakPA(), *pB=C->leakPB();
@@ -424,7 +446,9 @@ void Gl1_DemField::doCPhys(){
 	glEnable(GL_LIGHTING);
 	cPhysDispatcher->scene=scene; cPhysDispatcher->updateScenePtr();
 	std::scoped_lock lock(dem->contacts->manipMutex);
-	for(const shared_ptr<Contact>& C: *dem->contacts){
+	const size_t stride=lodStride(dem->contacts->size(),maxContacts);
+	for(size_t i=0; i<dem->contacts->size(); i+=stride){
+		const shared_ptr<Contact>& C((*dem->contacts)[i]);
 		PROCESS_GUI_EVENTS_SOMETIMES;
 		#if 1
 			shared_ptr<CGeom> geom(C->geom);
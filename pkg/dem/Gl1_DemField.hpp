@@ -2,6 +2,7 @@
 #ifdef WOO_OPENGL
 //#include<woo/pkg/dem/Particle.hpp>
 #include<woo/pkg/gl/Functors.hpp>
+#include<woo/lib/opengl/SphereImpostors.hpp>
 
 
 GL_FUNCTOR(GlShapeFunctor,TYPELIST_4(const shared_ptr<Shape>&, /*shift*/ const Vector3r&, /*wire*/bool,const GLViewInfo&),Shape);
@@ -21,6 +22,9 @@ struct Gl1_DemField: public GlFieldFunctor{
 	virtual void go(const shared_ptr<Field>&, GLViewInfo*) override;
 	GLViewInfo* viewInfo; // set when called, so that it does not have to be passed around
 	shared_ptr<DemField> dem; // used by do* methods
+	SphereImpostors impostors; // batch of spheres collected in doShape
+	// stride for rendering at most maxNum out of num objects (level of detail)
+	static size_t lodStride(size_t num, int maxNum){ return (maxNum<=0 || num<=(size_t)maxNum)?1:(num+maxNum-1)/maxNum; }
 	void doShape();
 	void doBound();
 	void doNodes(const vector<shared_ptr<Node>>& nodeContainer);
@@ -58,6 +62,7 @@ struct Gl1_DemField: public GlFieldFunctor{
 		((bool,shape2,true,AttrTrait<Attr::triggerPostLoad>(),"Render also particles not matching :obj:`shape` (using :obj:`colorBy2`)")) \
 		((Vector2i,modulo,Vector2i(0,0),,"For particles matching :obj:`shape`, only show particles with :obj:`Particle.id` such that ``(id+modulo[1])%modulo[0]==0`` (similar to :obj:`woo.dem.Tracer.modulo`). Only nodes of which first particle matches (or don't have any particle attached) are shown (in case of nodes, regardless of its :obj:`shape`). Display of contacts is not affected by this value.")) \
 		((bool,wire,false,,"Render all shapes with wire only")) \
+		((bool,sphereImpostors,true,,"Render spheres as ray-cast impostors, all of them with a single instanced draw call, which is much faster than rendering them one-by-one. Only spheres rendered by :obj:`Gl1_Sphere` which are not in wire mode are concerned, and per-sphere rendering is still used for selecting objects and for the highlighted particle. Requires OpenGL 2.0 with instanced arrays (available also with software rendering via Mesa's llvmpipe); falls back to per-sphere rendering if not supported by the OpenGL context.")) \
 		\
 		((int,colorBy,COLOR_SHAPE,AttrTrait<Attr::triggerPostLoad|Attr::namedEnum>().namedEnum(GL1_DEMFIELD_COLORBY_NAMEDENUM).buttons({"Reference now","S.renderer.setRefNow=True","use current positions and orientations as reference for showing displacement/rotation"},/*showBefore*/false),"Color particles by")) \
 		((int,vecAxis,AXIS_NORM,AttrTrait<Attr::namedEnum>().namedEnum({{AXIS_X,{"x"}},{AXIS_Y,{"y"}},{AXIS_Z,{"z"}},{AXIS_YZ,{"yz","yz"}},{AXIS_ZX,{"zx","xz"}},{AXIS_XY,{"xy","yx"}},{AXIS_NORM,{"norm","magnitude","xyz"}}}).hideIf("self.colorBy in ('Shape.color', 'radius', 'diameter (mm)', 'material id', 'Particle.matState', 'number of contacts')"),"Axis for vector quantities.")) \
@@ -80,10 +85,12 @@ struct Gl1_DemField: public GlFieldFunctor{
 		((shared_ptr<ScalarRange>,glyphRange,,AttrTrait<>().readonly(),"Range for glyph colors")) \
 		((Real,glyphRelSz,.1,,"Maximum glyph size relative to scene radius")) \
 		((bool,deadNodes,true,,"Show :obj:`DemField.deadNodes <woo.dem.DemField.deadNodes>`.")) \
+		((int,maxNodes,50000,,"Level of detail for nodes: if there are more nodes than this number, only every n-th node is rendered so that at most *maxNodes* nodes are shown. Non-positive value renders all nodes.")) \
 		((vector<shared_ptr<ScalarRange>>,glyphRanges,,AttrTrait<>().readonly().noGui(),"List of glyph ranges")) \
 		\
 		((int,cNode,CNODE_NONE,AttrTrait<>().bits({"glRep","line","node","potLine"}).startGroup("Contact nodes"),"What should be shown for contact nodes")) \
 		((bool,cPhys,false,,"Render contact's nodes")) \
+		((int,maxContacts,50000,,"Level of detail for contacts: if there are more contacts than this number, only every n-th contact is rendered (both for :obj:`cNode` and :obj:`cPhys`) so that at most *maxContacts* contacts are shown. Non-positive value renders all contacts.")) \
  		\
 		((int,guiEvery,100,,"Process GUI events once every *guiEvery* objects are painted, to keep the ui responsive. Set to 0 to make rendering blocking.")) \
 		\
@@ -31,6 +31,15 @@ void Cp2_FrictMat_HertzPhys::go(const shared_ptr<Material>& m1, const shared_ptr
 }
 #endif
 
+void HertzPhys::updateDerived(){
+	kn0=K*sqrt(R);
+	// Schwarz model constants, only used when alpha and gamma are non-zero
+	Pc=-6*M_PI*R*gamma/(pow2(alpha)+3);
+	xi=sqrt(((2*M_PI*gamma)/(3*K))*(1-3/(pow2(alpha)+3)));
+	deltaMin=-3*cbrt(R*pow4(xi)); // -3R(-1/3)*ξ^(-4/3)
+	aMin=pow2(cbrt(xi*R)); // (ξR)^(2/3)
+}
+
 void Cp2_HertzMat_HertzPhys::go(const shared_ptr<Material>& m1, const shared_ptr<Material>& m2, const shared_ptr<Contact>& C){
 	if(!C->phys) C->phys=make_shared<HertzPhys>();
 	auto& mat1=m1->cast<HertzMat>(); auto& mat2=m2->cast<HertzMat>();
@@ -38,42 +47,52 @@ void Cp2_HertzMat_HertzPhys::go(const shared_ptr<Material>& m1, const shared_ptr
 	const auto& l6g=C->geom->cast<L6Geom>();
 	const Real& r1=l6g.lens[0]; const Real& r2=l6g.lens[1];
 	const Real& E1=mat1.young; const Real& E2=mat2.young;
-	const Real& nu1=poisson; const Real& nu2=poisson;
 
-	// normal behavior
-	// Johnson1987, pg 427 (Appendix 3)
-	ph.K=(4/3.)*1./( (1-nu1*nu1)/E1 + (1-nu2*nu2)/E2 ); // (4/3.)*E
+	// constants depending on materials only are computed once per material pair
+	const PairConsts pc=pairConsts.get(m1,m2,{E1,E2,poisson,en,mat1.surfEnergy,mat2.surfEnergy,mat1.alpha,mat2.alpha,mat1.tanPhi,mat2.tanPhi},[&](){
+		const Real& nu1=poisson; const Real& nu2=poisson;
+		PairConsts pc;
+		// normal behavior
+		// Johnson1987, pg 427 (Appendix 3)
+		pc.K=(4/3.)*1./( (1-nu1*nu1)/E1 + (1-nu2*nu2)/E2 ); // (4/3.)*E
+		// surface energy
+		pc.gamma=min(mat1.surfEnergy,mat2.surfEnergy);
+		// COS alpha
+		pc.alpha=.5*(mat1.alpha+mat2.alpha);
+		// shear behavior
+		Real G1=E1/(2*(1+nu1)); Real G2=E2/(2*(1+nu2));
+		Real G=.5*(G1+G2);
+		Real nu=.5*(nu1+nu2); 
+		pc.ktDivSqrtR=4*G/(2-nu); // kt0=2*sqrt(4R)*G/(2-ν)
+		pc.tanPhi=min(mat1.tanPhi,mat2.tanPhi);
+		// non-linear viscous damping parameters
+		// only for meaningful values of en; for eqs, see Antypov2012, (10) and (17)
+		if(en>0 && en<1.) pc.viscAlpha=-sqrt(5)*log(en)/(sqrt(pow2(log(en))+pow2(M_PI)));
+		else pc.viscAlpha=0.; // no damping at all
+		return pc;
+	});
+
+	ph.K=pc.K;
 	ph.R=1./(1./r1+1./r2);
-	Real kn0=ph.K*sqrt(ph.R);
-
-	// surface energy
-	ph.gamma=min(mat1.surfEnergy,mat2.surfEnergy);
-	// COS alpha
-	ph.alpha=.5*(mat1.alpha+mat2.alpha);
-
-	// shear behavior
-	Real G1=E1/(2*(1+nu1)); Real G2=E2/(2*(1+nu2));
-	Real G=.5*(G1+G2);
-	Real nu=.5*(nu1+nu2); 
-	ph.kt0=2*sqrt(4*ph.R)*G/(2-nu);
-	ph.tanPhi=min(mat1.tanPhi,mat2.tanPhi);
-
-	// non-linear viscous damping parameters
-	// only for meaningful values of en
-	if(en>0 && en<1.){
+	ph.gamma=pc.gamma;
+	ph.alpha=pc.alpha;
+	ph.tanPhi=pc.tanPhi;
+	Real sqrtR=sqrt(ph.R);
+	ph.kt0=pc.ktDivSqrtR*sqrtR;
+	ph.updateDerived();
+
+	if(pc.viscAlpha>0){
 		const Real& m1=C->leakPA()->shape->nodes[0]->getData<DemData>().mass;
 		const Real& m2=C->leakPB()->shape->nodes[0]->getData<DemData>().mass;
 		// equiv mass, but use only the other particle if one has no mass
 		// if both have no mass, then mbar is irrelevant as their motion won't be influenced by force
 		Real mbar=(m1<=0 && m2>0)?m2:((m1>0 && m2<=0)?m1:(m1*m2)/(m1+m2));
-		// For eqs, see Antypov2012, (10) and (17)
-		Real viscAlpha=-sqrt(5)*log(en)/(sqrt(pow2(log(en))+pow2(M_PI)));
-		ph.alpha_sqrtMK=max(0.,viscAlpha*sqrt(mbar*kn0)); // negative is nonsense, then no damping at all
+		ph.alpha_sqrtMK=max(0.,pc.viscAlpha*sqrt(mbar*ph.kn0)); // negative is nonsense, then no damping at all
 	} else {
 		// no damping at all
 		ph.alpha_sqrtMK=0.0;
 	}
-	LOG_DEBUG("K={}, G={}, nu={}, R={}, kn0={}, kt0={}, tanPhi={}, alpha_sqrtMK={}",ph.K,G,nu,ph.R,kn0,ph.kt0,ph.tanPhi,ph.alpha_sqrtMK);
+	LOG_DEBUG("K={}, R={}, kn0={}, kt0={}, tanPhi={}, alpha_sqrtMK={}",ph.K,ph.R,ph.kn0,ph.kt0,ph.tanPhi,ph.alpha_sqrtMK);
 }
 
 
@@ -90,10 +109,14 @@ bool Law2_L6Geom_HertzPhys_DMT::go(const shared_ptr<CGeom>& cg, const shared_ptr
 	const Real& velN(g.vel[0]);
 	const Vector2r velT(g.vel[1],g.vel[2]);
 
+	// cached constants are not saved, re-compute them after loading
+	if(WOO_UNLIKELY(isnan(ph.kn0))) ph.updateDerived();
+	const Real& kn0(ph.kn0);
+	// sqrt(δ) is used by all stiffnesses and by damping; zero in tension (adhesive models)
+	const Real sqrtDelta=sqrt(max(-g.uN,0.));
 	// current normal stiffness
-	Real kn0=ph.K*sqrt(ph.R);
 	// TODO: this not really valid for Schwarz?
-	ph.kn=(3/2.)*kn0*sqrt(-g.uN);
+	ph.kn=(3/2.)*kn0*sqrtDelta;
 	// normal elastic and adhesion forces
 	// those are only split in the DMT model, Fna is zero for Schwarz or Hertz
 	Real Fne, Fna=0.;
@@ -105,7 +128,7 @@ bool Law2_L6Geom_HertzPhys_DMT::go(const shared_ptr<CGeom>& cg, const shared_ptr
 			return false;
 		}
 		// pure Hertz/DMT
-		Fne=-kn0*pow_i_2(-g.uN,3); // elastic force
+		Fne=-kn0*(-g.uN)*sqrtDelta; // elastic force, -kn0*δ^(3/2)
 		// DMT adhesion ("sticking") force
 		// See Dejaguin1975 ("Effect of Contact Deformation on the Adhesion of Particles"), eq (44)
 		// Derjaguin has Fs=2πRφ(ε), which is derived for sticky sphere (with surface energy)
@@ -122,9 +145,7 @@ bool Law2_L6Geom_HertzPhys_DMT::go(const shared_ptr<CGeom>& cg, const shared_ptr
 
 		const Real& gamma(ph.gamma); const Real& R(ph.R); const Real& alpha(ph.alpha); const Real& K(ph.K);
 		Real delta=-g.uN; // inverse convention
-		Real Pc=-6*M_PI*R*gamma/(pow2(alpha)+3);
-		Real xi=sqrt(((2*M_PI*gamma)/(3*K))*(1-3/(pow2(alpha)+3)));
-		Real deltaMin=-3*cbrt(R*pow4(xi)); // -3R(-1/3)*ξ^(-4/3)
+		const Real& Pc(ph.Pc); const Real& xi(ph.xi); const Real& deltaMin(ph.deltaMin);
 		// broken contact
 		if(delta<deltaMin){
 			// TODO: track energy
@@ -134,16 +155,17 @@ bool Law2_L6Geom_HertzPhys_DMT::go(const shared_ptr<CGeom>& cg, const shared_ptr
 		// solution brackets
 		// XXX: a is for sure also greater than delta(a) for Hertz model, with delta>0
 		// this should be combined with aMin which gives the function apex
-		Real aMin=pow_i_3(xi*R,2); // (ξR)^(2/3)
-		Real a0=pow_i_3(4,2)*aMin; // (4ξR)^(2/3)=4^(2/3) (ξR)^(2/3)
+		const Real& aMin(ph.aMin); // (ξR)^(2/3)
+		const Real a0=2.5198420997897464*aMin; // (4ξR)^(2/3)=4^(2/3) (ξR)^(2/3)
 		Real aLo=(delta<0?aMin:a0);
 		Real aHi=aMin+sqrt(R*(delta-deltaMin));
+		const Real invR=1/R;
 		auto delta_diff_ddiff=[&](const Real& a){
-			Real aInvSqrt=1/sqrt(a);
+			Real aSqrt=sqrt(a), aInvSqrt=1/aSqrt;
 			return boost::math::make_tuple(
-				pow2(a)/R-4*xi*sqrt(a)-delta, // subtract delta as we need f(x)=0
-				2*a/R-2*xi*aInvSqrt,
-				2/R+xi*pow3(aInvSqrt)
+				pow2(a)*invR-4*xi*aSqrt-delta, // subtract delta as we need f(x)=0
+				2*a*invR-2*xi*aInvSqrt,
+				2*invR+xi*pow3(aInvSqrt)
 			);
 		};
 		// use a0 (defined as  δ(a0)=0) as intial guess for new contacts, since they are likely close to the equilibrium condition
@@ -158,7 +180,7 @@ bool Law2_L6Geom_HertzPhys_DMT::go(const shared_ptr<CGeom>& cg, const shared_ptr
 		#endif
 
 		ph.contRad=a;
-		Real Pne=pow2(sqrt(pow3(a)*(K/R))-alpha*sqrt(-Pc))+Pc;
+		Real Pne=pow2(a*sqrt(a*K*invR)-alpha*sqrt(-Pc))+Pc;
 		Fne=-Pne; // inverse convention
 		if(isnan(Pne)){
 			cerr<<"R="<<R<<", K="<<K<<", xi="<<xi<<", alpha="<<alpha<<", gamma="<<gamma<<endl;
@@ -170,7 +192,7 @@ bool Law2_L6Geom_HertzPhys_DMT::go(const shared_ptr<CGeom>& cg, const shared_ptr
 	// viscous coefficient, both for normal and tangential force
 	// Antypov2012 (10)
 	// XXX: max(-g.uN,0.) for adhesive models so that eta is not NaN
-	Real eta=(ph.alpha_sqrtMK>0?ph.alpha_sqrtMK*pow_1_4(max(-g.uN,0.)):0.);
+	Real eta=(ph.alpha_sqrtMK>0?ph.alpha_sqrtMK*sqrt(sqrtDelta):0.);
 	// cerr<<"eta="<<eta<<", -g.uN="<<-g.uN<<"; ";
 	Real Fnv=eta*velN; // viscous force
 	// DMT ONLY (for now at least):
@@ -181,7 +203,7 @@ bool Law2_L6Geom_HertzPhys_DMT::go(const shared_ptr<CGeom>& cg, const shared_ptr
 	if(WOO_UNLIKELY(scene->trackEnergy)) scene->energy->add(Fnv*velN*dt,"viscN",viscNIx,EnergyTracker::IsIncrement|EnergyTracker::ZeroDontCreate);
 
 	// shear sense; zero shear stiffness in tension (XXX: should be different with adhesion)
-	ph.kt=ph.kt0*sqrt(g.uN<0?-g.uN:0);
+	ph.kt=ph.kt0*sqrtDelta;
 	Ft+=dt*ph.kt*velT;
 	// sliding: take adhesion in account
 	Real maxFt=std::abs(min(0.,Fn)*ph.tanPhi);
@@ -203,7 +225,8 @@ bool Law2_L6Geom_HertzPhys_DMT::go(const shared_ptr<CGeom>& cg, const shared_ptr
 	if(WOO_UNLIKELY(scene->trackEnergy)){
 		// XXX: this is incorrect with adhesion
 		// skip if in tension, since we would get NaN from delta^(2/5)
-		if(g.uN<0) scene->energy->add(normalElasticEnergy(kn0,-g.uN)+0.5*Ft.squaredNorm()/ph.kt,"elast",elastPotIx,EnergyTracker::IsResettable);
+		// same as normalElasticEnergy(kn0,-g.uN), with sqrt(δ) already at hand
+		if(g.uN<0) scene->energy->add(kn0*(2/5.)*pow2(g.uN)*sqrtDelta+0.5*Ft.squaredNorm()/ph.kt,"elast",elastPotIx,EnergyTracker::IsResettable);
 	}
 	LOG_DEBUG("uN={}, Fn={}; duT/dt={},{}, Ft={},{}",g.uN,Fn,velT[0],velT[1],Ft[0],Ft[1]);
 	return true;
@@ -14,9 +14,10 @@ class HertzMat: public FrictMat{
 WOO_REGISTER_OBJECT(HertzMat);
 
 class HertzPhys: public FrictPhys{
+	// compute cached constants (kn0, xi, Pc, deltaMin, aMin) from K, R, gamma and alpha
+	void updateDerived();
 	#define woo_dem_HertzPhys__CLASS_BASE_DOC_ATTRS_CTOR \
 		HertzPhys,FrictPhys,"Physical properties of a contact of two :obj:`FrictMat` with viscous damping enabled (viscosity is currently not provided as material parameter).", \
-		/* ((Real,kn0,0,,"Constant for computing current normal stiffness.")) */ \
 		((Real,kt0,0,,"Constant for computing current normal stiffness.")) \
 		((Real,alpha_sqrtMK,0,,"Value for computing damping coefficient -- see :cite:`Antypov2011`, eq (10).")) \
 		((Real,R,0,,"Effective radius (for the Schwarz model)")) \
@@ -25,6 +26,11 @@ class HertzPhys: public FrictPhys{
 		((Real,alpha,0.,,"COS alpha coefficient")) \
 		((Real,contRad,0,,"Contact radius, used for storing previous value as the initial guess in the next step.")) \
 		/* ((Real,Lc,NaN,,"COS critical load")) ((Real,a0,NaN,,"COS zero load")) */ \
+		((Real,kn0,NaN,AttrTrait<Attr::noSave|Attr::readonly>().startGroup("Cached"),"Constant for computing current normal stiffness, :math:`K\\sqrt{R}`. This and the following values only depend on :obj:`K`, :obj:`R`, :obj:`gamma` and :obj:`alpha`; they are computed when the contact is created (or when NaN), so that the contact law does not re-compute them in every step.")) \
+		((Real,xi,NaN,AttrTrait<Attr::noSave|Attr::readonly>(),"Schwarz model: :math:`\\xi` parameter.")) \
+		((Real,Pc,NaN,AttrTrait<Attr::noSave|Attr::readonly>(),"Schwarz model: critical load.")) \
+		((Real,deltaMin,NaN,AttrTrait<Attr::noSave|Attr::readonly>(),"Schwarz model: minimum (negative) overlap before the contact breaks.")) \
+		((Real,aMin,NaN,AttrTrait<Attr::noSave|Attr::readonly>(),"Schwarz model: contact radius at the apex of the overlap-radius curve.")) \
 		, /*ctor*/ createIndex();
 	WOO_DECL__CLASS_BASE_DOC_ATTRS_CTOR(woo_dem_HertzPhys__CLASS_BASE_DOC_ATTRS_CTOR);
 	REGISTER_CLASS_INDEX(HertzPhys,CPhys);
@@ -51,6 +57,9 @@ WOO_REGISTER_OBJECT(Cp2_FrictMat_HertzPhys);
 
 struct Cp2_HertzMat_HertzPhys: public Cp2_FrictMat_FrictPhys{
 	void go(const shared_ptr<Material>&, const shared_ptr<Material>&, const shared_ptr<Contact>&) override;
+	// constants depending only on the materials (and poisson, en); viscAlpha is zero without damping
+	struct PairConsts{ Real K, ktDivSqrtR, gamma, alpha, tanPhi, viscAlpha; };
+	MatPairTable<10,PairConsts> pairConsts;
 	FUNCTOR2D(HertzMat,HertzMat);
 	WOO_DECL_LOGGER;
 	#define woo_dem_Cp2_HertzMat_HertzPhys__CLASS_BASE_DOC_ATTRS \
@@ -161,23 +161,17 @@ Vector3r LayeredAxialBias::unitPos(const Real& d){
 
 py::object ParticleGenerator::pyPsd(bool mass, bool cumulative, bool normalize, const Vector2r& dRange, const Vector2r& tRange, int num) const {
 	if(!save) throw std::runtime_error("ParticleGenerator.save must be True for calling ParticleGenerator.psd()");
-	auto tOk=[&tRange](const Real& t){ return isnan(tRange.minCoeff()) || (tRange[0]<=t && t<tRange[1]); };
-	vector<Vector2r> psd=DemFuncs::psd(genDiamMassTime,/*cumulative*/cumulative,/*normalize*/normalize,num,dRange,
-		/*diameter getter*/[&tOk](const Vector3r& dmt, const size_t& i) ->Real { return tOk(dmt[2])?dmt[0]:NaN; },
-		/*weight getter*/[&](const Vector3r& dmt, const size_t& i) -> Real{ return mass?dmt[1]:1.; }
-	);// 
+	vector<Vector2r> psd=SpillLog::dmtPsd(spill,genDiamMassTime,psdHist,mass,cumulative,normalize,num,dRange,tRange);
 	return DemFuncs::seqVectorToPy(psd,[](const Vector2r& i)->Vector2r{ return i; },/*zip*/false);
 }
 
 py::object ParticleGenerator::pyDiamMass(bool zipped) const {
-	return DemFuncs::seqVectorToPy(genDiamMassTime,/*itemGetter*/[](const Vector3r& i)->Vector2r{ return i.head<2>(); },/*zip*/zipped);
+	return SpillLog::dmtToPy(spill,genDiamMassTime,/*head2*/true,zipped);
 }
 
 Real ParticleGenerator::pyMassOfDiam(Real min, Real max) const{
 	Real ret=0.;
-	for(const Vector3r& vv: genDiamMassTime){
-		if(vv[0]>=min && vv[0]<=max) ret+=vv[1];
-	}
+	SpillLog::forEachDmt(spill,genDiamMassTime,[&](const Vector3r& vv, size_t){ if(vv[0]>=min && vv[0]<=max) ret+=vv[1]; });
 	return ret;
 };
 
@@ -189,7 +183,7 @@ MinMaxSphereGenerator::operator()(const shared_ptr<Material>&mat, const Real& ti
 	Real r=.5*(dRange[0]+Mathr::UnitRandom()*(dRange[1]-dRange[0]));
 	auto sphere=DemFuncs::makeSphere(r,mat);
 	Real m=sphere->shape->nodes[0]->getData<DemData>().mass;
-	if(save) genDiamMassTime.push_back(Vector3r(2*r,m,time));
+	saveDiamMassTime(2*r,m,time);
 	return std::make_tuple(2*r,vector<ParticleAndBox>({{sphere,AlignedBox3r(Vector3r(-r,-r,-r),Vector3r(r,r,r))}}));
 };
 
@@ -1,5 +1,6 @@
 #pragma once
 #include<woo/pkg/dem/Particle.hpp>
+#include<woo/pkg/dem/SpillLog.hpp>
 #include<boost/range/numeric.hpp>
 #include<boost/range/algorithm/fill.hpp>
 #include<woo/lib/pyutil/converters.hpp>
@@ -55,8 +56,18 @@ struct ParticleGenerator: public Object{
 	virtual std::tuple<Real,vector<ParticleAndBox>> operator()(const shared_ptr<Material>& m, const Real& time){ throw std::runtime_error("Calling ParticleGenerator.operator() (abstract method); use derived classes."); }
 	virtual Real critDt(Real density, Real young) { return Inf; }
 	// called when the particle placement failed; the generator must revoke it and update its bookkeeping information (e.g. PSD, generated radii and diameters etc)
-	virtual void revokeLast(){ if(save && !genDiamMassTime.empty()) genDiamMassTime.resize(genDiamMassTime.size()-1); }
-	virtual void clear(){ genDiamMassTime.clear(); }
+	virtual void revokeLast(){ if(!save) return; if(spill) spill->popLast(); else if(!genDiamMassTime.empty()) genDiamMassTime.resize(genDiamMassTime.size()-1); }
+	virtual void clear(){ genDiamMassTime.clear(); psdHist.clear(); if(spill) spill->clear(); }
+	// save diameter, mass and time of generated particle (if save is set) in genDiamMassTime or spill
+	void saveDiamMassTime(Real d, Real m, Real time){
+		if(!save) return;
+		if(spill) spill->append({d,m,time});
+		else genDiamMassTime.push_back(Vector3r(d,m,time));
+	}
+	// histogram of genDiamMassTime, synchronized when PSD is queried
+	mutable PsdHistogram psdHist;
+	// set columns of spill when it is assigned (or loaded), not with every particle
+	void postLoad(ParticleGenerator&, void* attr){ if(spill && (attr==NULL || attr==&spill)) spill->setCols({"diam","mass","time"}); }
 	// spheres-only generators override this to enable some optimizations
 	virtual bool isSpheresOnly() const { throw std::logic_error(pyStr()+" should override ParticleGenerator.isSpheresOnly."); }
 	virtual Real padDist() const {  throw std::logic_error(pyStr()+" should override ParticleGenerator.padDist."); }
@@ -69,11 +80,13 @@ struct ParticleGenerator: public Object{
 		ParticleGenerator,Object,"Abstract class for generating particles", \
 		((vector<Vector3r>,genDiamMassTime,,AttrTrait<Attr::readonly>().noGui().noDump(),"List of generated particle's (equivalent) radii and masses (for making granulometry)")) \
 		((bool,save,true,,"Save generated particles so that PSD can be generated afterwards")) \
+		((shared_ptr<SpillLog>,spill,,AttrTrait<Attr::triggerPostLoad>(),"When given, generated particles are saved in this log (columns ``diam``, ``mass`` and ``time``) rather than in :obj:`genDiamMassTime`; only a bounded number of rows is kept in memory, the rest is spilled to a file, and the data are preserved when the simulation is saved and loaded. :obj:`psd`, :obj:`diamMass` and :obj:`massOfDiam` read data from the log.")) \
 		,/*py*/ \
-			.def("psd",&ParticleGenerator::pyPsd,WOO_PY_ARGS(py::arg("mass")=true,py::arg("cumulative")=true,py::arg("normalize")=true,py::arg("dRange")=Vector2r(NaN,NaN),py::arg("tRange")=Vector2r(NaN,NaN),py::arg("num")=80),"Return PSD for particles generated.") \
+			.def("psd",&ParticleGenerator::pyPsd,WOO_PY_ARGS(py::arg("mass")=true,py::arg("cumulative")=true,py::arg("normalize")=true,py::arg("dRange")=Vector2r(NaN,NaN),py::arg("tRange")=Vector2r(NaN,NaN),py::arg("num")=80),"Return PSD for particles generated. Without *tRange*, the result is computed from a histogram updated incrementally (diameters resolved to 0.1%), without traversing all generated particles.") \
 			.def("diamMass",&ParticleGenerator::pyDiamMass,WOO_PY_ARGS(py::arg("zipped")=false),"With *zipped*, return list of (diameter, mass); without *zipped*, return tuple of 2 arrays, diameters and masses.") \
 			.def("massOfDiam",&ParticleGenerator::pyMassOfDiam,WOO_PY_ARGS(py::arg("min")=0,py::arg("max")=Inf),"Return mass of particles of which diameters are between *min* and *max*.") \
 			.def("clear",&ParticleGenerator::clear,"Clear stored data about generated particles; only subsequently generated particles will be considered in the PSD.") \
+			.def("revokeLast",&ParticleGenerator::revokeLast,"Forget the last generated particle (inlets call this when the particle could not be placed).") \
 			.def("critDt",&ParticleGenerator::critDt,WOO_PY_ARGS(py::arg("density"),py::arg("young")),"Return critical timestep for particles generated by us, given that their density and Young's modulus are as given in arguments.") \
 			.def("padDist",&ParticleGenerator::padDist,"Return padding distance by which the factory geometry should be shrunk before generating a random point.") \
 			.def("__call__",&ParticleGenerator::pyCall,WOO_PY_ARGS(py::arg("mat"),py::arg("time")=0),"Call the generation routine, returning one particle (at origin) and its bounding-box when at origin. Useful for debugging.") \
@@ -325,6 +325,9 @@ bool InsertionSortCollider::updateBboxes_doFullRun(){
 		} else verletDist=abs(verletDist)*minR;
 	}
 
+	// sleeping particles (see Deactivator) don't move, their bounds need neither checking nor updating
+	const bool hasSleeping=(dem->nSleeping>0);
+
 	bool recomputeBounds=false;
 	if(verletDist==0){
 		recomputeBounds=true;
@@ -340,6 +343,7 @@ bool InsertionSortCollider::updateBboxes_doFullRun(){
 				recomputeBounds=true;
 				break;
 			}
+			if(WOO_UNLIKELY(hasSleeping) && p->isSleeping()) continue;
 			// existing bound, do we need to update it?
 			const Aabb& aabb=p->shape->bound->cast<Aabb>();
 			assert(aabb.nodeLastPos.size()==p->shape->nodes.size());
@@ -404,6 +408,7 @@ bool InsertionSortCollider::updateBboxes_doFullRun(){
 	for(size_t i=0; i<size; i++){
 		const shared_ptr<Particle>& p((*particles)[i]);
 		if(!p || !p->shape) continue;
+		if(WOO_UNLIKELY(hasSleeping) && p->shape->bound && p->isSleeping()) continue;
 		// call dispatcher now
 		// cerr<<"["<<p->id<<"]";
 		boundDispatcher->operator()(p->shape);
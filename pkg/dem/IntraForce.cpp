@@ -3,6 +3,7 @@
 #include<woo/pkg/dem/Contact.hpp>
 #include<boost/range/algorithm/find_if.hpp>
 #include<cstdlib>
+#include<unordered_map>
 
 WOO_PLUGIN(dem,(IntraFunctor)(IntraForce));
 WOO_IMPL__CLASS_BASE_DOC_PY(woo_dem_IntraFunctor__CLASS_BASE_DOC_PY);
@@ -23,21 +24,79 @@ void IntraFunctor::addIntraStiffnesses(const shared_ptr<Particle>&, const shared
 }
 
 
+bool IntraForce::colorsValid(const DemField& dem) const {
+	const size_t size=dem.particles->size();
+	if(colorShapes.size()!=size) return false;
+	for(size_t i=0; i<size; i++){
+		const shared_ptr<Particle>& p((*dem.particles)[i]);
+		if(colorShapes[i]!=(p?p->shape.get():nullptr)) return false;
+	}
+	return true;
+}
+
+void IntraForce::updateColors(const DemField& dem){
+	const size_t size=dem.particles->size();
+	colorGroups.clear();
+	// record all shapes first, so that failed coloring (no groups) is valid as well and is not retried at every step
+	colorShapes.assign(size,nullptr);
+	for(size_t i=0; i<size; i++){
+		const shared_ptr<Particle>& p((*dem.particles)[i]);
+		if(p) colorShapes[i]=p->shape.get();
+	}
+	// bitmask of colors already used by particles touching each node; greedy coloring in particle order
+	std::unordered_map<const Node*,uint64_t> used;
+	for(size_t i=0; i<size; i++){
+		const shared_ptr<Particle>& p((*dem.particles)[i]);
+		if(!p) continue;
+		// no nodes to share; run in the first color, which reports the error
+		if(!p->shape){ if(colorGroups.empty()) colorGroups.resize(1); colorGroups[0].push_back(i); continue; }
+		uint64_t mask=0;
+		for(const auto& n: p->shape->nodes) mask|=used[n.get()];
+		if(~mask==0){
+			LOG_DEBUG("Particle #{}: node shared by more than 64 particles, not coloring.",i);
+			colorGroups.clear();
+			return;
+		}
+		int c=__builtin_ctzll(~mask);
+		for(const auto& n: p->shape->nodes) used[n.get()]|=(uint64_t(1)<<c);
+		if((int)colorGroups.size()<=c) colorGroups.resize(c+1);
+		colorGroups[c].push_back(i);
+	}
+	LOG_DEBUG("{} particles in {} colors.",size,colorGroups.size());
+}
+
 void IntraForce::run(){
 	DemField& dem=field->cast<DemField>();
 	updateScenePtr();
 	size_t size=dem.particles->size();
-	#ifdef WOO_OPENMP
-		#pragma omp parallel for schedule(guided)
-	#endif
-	for(size_t i=0; i<size; i++){
+	auto doParticle=[&](size_t i){
 		const shared_ptr<Particle>& p((*dem.particles)[i]);
-		if(!p) continue;
+		if(!p) return;
 		if(!p->shape || !p->material){
 			LOG_ERROR("#{} has no shape/material.",i);
-			continue;
+			return;
 		}
 		operator()(p->shape,p->material,p);
+	};
+	if(colored && !colorsValid(dem)) updateColors(dem);
+	nColors=(colored?colorGroups.size():0);
+	if(nColors>0){
+		for(const auto& f: functors) f->nodeLock=false;
+		#ifdef WOO_OPENMP
+			#pragma omp parallel
+		#endif
+		for(const auto& group: colorGroups){
+			// implicit barrier after each color
+			#ifdef WOO_OPENMP
+				#pragma omp for schedule(guided)
+			#endif
+			for(size_t j=0; j<group.size(); j++) doParticle(group[j]);
+		}
+		for(const auto& f: functors) f->nodeLock=true;
+		return;
 	}
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(guided)
+	#endif
+	for(size_t i=0; i<size; i++) doParticle(i);
 };
-
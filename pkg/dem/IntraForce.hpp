@@ -12,6 +12,12 @@ struct IntraFunctor: public Functor2D<
 	WOO_DECL_LOGGER;
 	// called from IntraForce::critDt
 	virtual void addIntraStiffnesses(const shared_ptr<Particle>&, const shared_ptr<Node>&, Vector3r& ktrans, Vector3r& krot) const;
+	// set by IntraForce: false when particles are processed in colors which share no nodes, so nodal forces need no locking
+	bool nodeLock=true;
+	void addNodalForceTorque(DemData& dyn, const Vector3r& F, const Vector3r& T=Vector3r::Zero()) const {
+		if(nodeLock) dyn.addForceTorque(F,T);
+		else { dyn.force+=F; dyn.torque+=T; }
+	}
 	
 	#define woo_dem_IntraFunctor__CLASS_BASE_DOC_PY IntraFunctor,Functor,"Functor appying internal forces", /*py*/ ; woo::converters_cxxVector_pyList_2way<shared_ptr<IntraFunctor>>(mod);
 	WOO_DECL__CLASS_BASE_DOC_PY(woo_dem_IntraFunctor__CLASS_BASE_DOC_PY);
@@ -22,7 +28,17 @@ struct IntraForce: public Dispatcher2D</* functor type*/ IntraFunctor, /* autosy
 	bool acceptsField(Field* f) override { return dynamic_cast<DemField*>(f); }
 	void addIntraStiffness(const shared_ptr<Particle>&, const shared_ptr<Node>&, Vector3r& ktrans, Vector3r& krot);
 	void run() override;
-	WOO_DISPATCHER2D_FUNCTOR_DOC_ATTRS_CTOR_PY(IntraForce,IntraFunctor,/*ClassObject instantiated by the macro*/.doc("Apply internal forces on integration nodes, by calling appropriate :obj:`IntraFunctor` objects.").section("Internal forces","TODO",{"IntraFunctor"}),/*attrs*/,/*ctor*/,/*py*/);
+	// particles (indices) grouped so that no two particles in a group share a node; empty when coloring failed
+	vector<vector<size_t>> colorGroups;
+	// shapes for which colorGroups were computed, to detect changes
+	vector<const Shape*> colorShapes;
+	bool colorsValid(const DemField&) const;
+	void updateColors(const DemField&);
+	WOO_DISPATCHER2D_FUNCTOR_DOC_ATTRS_CTOR_PY(IntraForce,IntraFunctor,/*ClassObject instantiated by the macro*/.doc("Apply internal forces on integration nodes, by calling appropriate :obj:`IntraFunctor` objects.").section("Internal forces","TODO",{"IntraFunctor"}),
+		/*attrs*/
+		((bool,colored,true,,"Process particles in groups (colors) such that particles in one group share no nodes; each group is run in parallel and nodal forces are added without locking. Groups are recomputed when particles are added, removed or replaced. If some node is shared by too many particles, the plain parallel loop (with locking) is used instead."))
+		((int,nColors,0,AttrTrait<>().readonly().noSave(),"Number of colors used in the last step (0 if particles were not colored)."))
+		,/*ctor*/,/*py*/);
 	WOO_DECL_LOGGER;
 };
 WOO_REGISTER_OBJECT(IntraForce);
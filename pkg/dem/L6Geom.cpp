@@ -47,9 +47,9 @@ pos2 however is with periodic correction already!!
 WOO_IMPL_LOGGER(Cg2_Any_Any_L6Geom__Base);
 
 void Cg2_Any_Any_L6Geom__Base::handleSpheresLikeContact(const shared_ptr<Contact>& C, const Vector3r& pos1, const Vector3r& vel1, const Vector3r& angVel1, const Vector3r& pos2, const Vector3r& vel2, const Vector3r& angVel2, const Vector3r& normal, const Vector3r& contPt, Real uN, Real r1, Real r2){
-	// create geometry
-	if(!C->geom){
-		C->geom=make_shared<L6Geom>();
+	// create geometry; the caller may have allocated it already (as a derived class), in which case uN is still NaN
+	if(!C->geom || isnan(C->geom->cast<L6Geom>().uN)){
+		if(!C->geom) C->geom=make_shared<L6Geom>();
 		L6Geom& g(C->geom->cast<L6Geom>());
 		g.setInitialLocalCoords(normal);
 		g.uN=uN;
@@ -3,6 +3,9 @@
 #include<woo/pkg/dem/Particle.hpp>
 #include<woo/pkg/dem/Clump.hpp>
 #include<woo/pkg/dem/Contact.hpp>
+#ifdef WOO_VTK
+	#include<woo/pkg/dem/FlowAnalysis.hpp>
+#endif
 #include<iomanip>
 
 WOO_PLUGIN(dem,(Leapfrog)(ForceResetter));
@@ -50,15 +53,15 @@ Vector3r Leapfrog::computeAngAccel(const Vector3r& torque, const Vector3r& inert
 
 
 
-void Leapfrog::doDampingDissipation(const shared_ptr<Node>& node){
+void Leapfrog::doDampingDissipation(const shared_ptr<Node>& node, int nSteps){
 	const DemData& dyn(node->getData<DemData>());
 	if(dyn.isEnergySkip()) return;
 	/* damping is evaluated incrementally, therefore computed with mid-step values */
 	// always positive dissipation, by-component: |F_i|*|v_i|*damping*dt (|T_i|*|ω_i|*damping*dt for rotations)
 	scene->energy->add(
-		dyn.vel.array().abs().matrix().dot(dyn.force.array().abs().matrix())*damping*scene->dt
+		dyn.vel.array().abs().matrix().dot(dyn.force.array().abs().matrix())*damping*scene->dt*nSteps
 		// with aspherical integrator, torque is damped instead of ang acceleration; this is only approximate
-		+ dyn.angVel.array().abs().matrix().dot(dyn.torque.array().abs().matrix())*damping*scene->dt
+		+ dyn.angVel.array().abs().matrix().dot(dyn.torque.array().abs().matrix())*damping*scene->dt*nSteps
 		,"nonviscDamp",nonviscDampIx,EnergyTracker::IsIncrement | EnergyTracker::ZeroDontCreate,node->pos
 	);
 }
@@ -139,8 +142,19 @@ void Leapfrog::run(){
 		Master::instance().checkApi(/*minApi*/10101,"DemField.nodes is empty; woo.dem.Leapfrog no longer calls DemField.collectNodes() automatically.",/*pyWarn*/false); // can happen in bg thread?
 	}
 
+	#ifdef WOO_VTK
+		flowHooks.clear();
+		for(const auto& e: scene->engines){
+			FlowAnalysis* fa=dynamic_cast<FlowAnalysis*>(e.get());
+			if(!fa || fa->dead || fa->field.get()!=field.get() || !fa->leapfrogReady()) continue;
+			fa->scene=scene;
+			flowHooks.push_back(fa);
+		}
+	#endif
+
 	size_t size=dem->nodes.size();
 	const auto& nodes=dem->nodes;
+	const bool hasSleeping=(dem->nSleeping>0);
 	#ifdef WOO_OPENMP
 		#pragma omp parallel for schedule(guided)
 	#endif
@@ -150,6 +164,17 @@ void Leapfrog::run(){
 		DemData& dyn(node->getData<DemData>());
 		// handle clumps
 		if(dyn.isClumped()) continue; // those particles are integrated via the clump's master node
+		// sleeping nodes (see Deactivator) are not moving, only their forces are reset
+		if(WOO_UNLIKELY(hasSleeping) && dyn.isSleeping()){
+			if(reset){
+				dyn.force=(hasGravity && !dyn.isGravitySkip())?(dyn.mass*dem->gravity).eval():Vector3r::Zero();
+				dyn.torque=Vector3r::Zero();
+			}
+			#ifdef WOO_VTK
+				for(FlowAnalysis* fa: flowHooks) fa->addNodeData(node);
+			#endif
+			continue;
+		}
 		bool isClump=dyn.isClump();
 		bool damp=(damping!=0. && !dyn.isDampingSkip());
 		// useless to compute node force if the value will not be used at all
@@ -160,8 +185,22 @@ void Leapfrog::run(){
 		Vector3r& f=dyn.force;
 		Vector3r& t=dyn.torque;
 
+		// multirate (see Multirate): force is accumulated over 2^level steps (it includes impulses of coarse contacts, applied
+		// by ContactLoop once per their period) and velocity is only updated in steps which are multiples of 2^level,
+		// with 2^level*dt and the mean force, i.e. with the total impulse; position is updated in every step
+		int mrK=1; bool mrSync=true;
+		if(WOO_UNLIKELY(dyn.level>0)){
+			mrK=1<<dyn.level;
+			dyn.mrForce+=f; dyn.mrTorque+=t;
+			mrSync=dyn.isMultirateSync(scene->step);
+			if(mrSync){
+				f=dyn.mrForce/mrK; t=dyn.mrTorque/mrK;
+				dyn.mrForce=dyn.mrTorque=Vector3r::Zero();
+			}
+		}
+
 		if(WOO_UNLIKELY(reallyTrackEnergy)){
-			if(damp) doDampingDissipation(node);
+			if(damp && mrSync) doDampingDissipation(node,mrK);
 			if(hasGravity) doGravityWork(dyn,*dem,node->pos);
 		}
 			
@@ -176,8 +215,13 @@ void Leapfrog::run(){
 
 		Vector3r linAccel(Vector3r::Zero()), angAccel(Vector3r::Zero());
 		// for particles not totally blocked, compute accelerations; otherwise, the computations would be useless
-		if (!dyn.isBlockedAll()) {
+		if(!dyn.isBlockedAll() && !mrSync){
+			// multirate node between velocity updates
+			pprevFluctVel=dyn.vel; pprevFluctAngVel=dyn.angVel;
+		}
+		else if (!dyn.isBlockedAll()) {
 			linAccel=computeAccel(f,dyn.mass,dyn);
+			if(mrK>1) linAccel*=mrK;
 			// fluctuation velocities
 			if(isPeriodic){
 				pprevFluctVel=scene->cell->pprevFluctVel(node->pos,dyn.vel,dt);
@@ -192,6 +236,7 @@ void Leapfrog::run(){
 			if(dyn.inertia!=Vector3r::Zero()){
 				if(!useAspherical){ // spherical integrator, uses angular velocity
 					angAccel=computeAngAccel(t,dyn.inertia,dyn);
+					if(mrK>1) angAccel*=mrK;
 					if(damp) nonviscDamp2nd(dt,t,pprevFluctAngVel,angAccel);
 					dyn.angVel+=dt*angAccel;
 					if(homoDeform==Cell::HOMO_GRADV2) dyn.angVel-=deltaSpinVec;
@@ -226,7 +271,10 @@ void Leapfrog::run(){
 		if(!useAspherical) leapfrogSphericalRotate(node);
 		else {
 			if(dyn.inertia==Vector3r::Zero()) throw std::runtime_error("Leapfrog::run: DemField.nodes["+to_string(i)+"].den.inertia==(0,0,0), but the node wants to use aspherical integrator. Aspherical integrator is selected for non-spherical particles which have at least one rotational DOF free.");
-			if(!isPeriodic) leapfrogAsphericalRotate(node,t);
+			if(!isPeriodic){
+				if(WOO_LIKELY(mrK==1)) leapfrogAsphericalRotate(node,t);
+				else leapfrogAsphericalRotate(node,mrSync?(mrK*t).eval():Vector3r::Zero().eval()); // angular momentum only changes in multirate steps
+			}
 			else{
 				// FIXME: add fake torque from rotating space or modify angMom or angVel
 				leapfrogAsphericalRotate(node,t); //-dyn.inertia.asDiagonal()*node->ori.conjugate()*deltaSpinVec/dt*2);
@@ -246,9 +294,20 @@ void Leapfrog::run(){
 		// if something is imposed, apply it here
 		if(dyn.impose && (dyn.impose->what & Impose::VELOCITY)) dyn.impose->velocity(scene,node);
 
+		// switch multirate level requested by Multirate, once the node's accumulation interval ends with both the old and new level
+		if(WOO_UNLIKELY(dyn.levelWanted!=dyn.level) && mrSync && (scene->step&((1L<<dyn.levelWanted)-1))==0){
+			dyn.level=dyn.levelWanted;
+			dyn.mrForce=dyn.mrTorque=Vector3r::Zero();
+		}
+
 		// for clumps, update positions/orientations of members as well
 		// (gravity already applied to the clump node itself, pass zero here! */
 		if(isClump) ClumpData::applyToMembers(node,/*resetForceTorque*/reset);
+
+		#ifdef WOO_VTK
+			// node data are still in cache, deposit them right away
+			for(FlowAnalysis* fa: flowHooks) fa->addNodeData(node);
+		#endif
 	}
 	// if(isPeriodic) prevVelGrad=scene->cell->velGrad;
 }
@@ -6,6 +6,10 @@
 	#include<omp.h>
 #endif
 
+#ifdef WOO_VTK
+	struct FlowAnalysis;
+#endif
+
 struct ForceResetter: public Engine{
 	bool acceptsField(Field* f) override { return dynamic_cast<DemField*>(f); }
 	void run() override;
@@ -28,10 +32,16 @@ struct Leapfrog: public Engine {
 	Vector3r computeAccel(const Vector3r& force, const Real& mass, /* for passing blocked DoFs */const DemData& dyn);
 	Vector3r computeAngAccel(const Vector3r& torque, const Vector3r& inertia, const DemData& dyn);
 	// energy tracking
-	void doDampingDissipation(const shared_ptr<Node>&);
+	// nSteps>1 for multirate nodes, which are damped once per nSteps steps
+	void doDampingDissipation(const shared_ptr<Node>&, int nSteps=1);
 	void doGravityWork(const DemData& dyn, const DemField& dem, const Vector3r& pos);
 	void doKineticEnergy(const shared_ptr<Node>&, const Vector3r& pprevFluctVel, const Vector3r& pprevFluctAngVel, const Vector3r& linAccel, const Vector3r& angAccel);
 
+	#ifdef WOO_VTK
+		// FlowAnalysis engines depositing data from within the integration loop; collected at every step
+		vector<FlowAnalysis*> flowHooks;
+	#endif
+
 	// whether the cell has changed from the previous step
 	int homoDeform; // updated from scene at every call; -1 for aperiodic simulations, otherwise equal to scene->cell->homoDeform
 	Real dt; // updated from scene at every call
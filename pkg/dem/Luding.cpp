@@ -19,29 +19,51 @@ void Cp2_LudingMat_LudingPhys::go(const shared_ptr<Material>& mat1, const shared
 	auto& g=C->geom->cast<L6Geom>();
 	Cp2_FrictMat_FrictPhys::updateFrictPhys(m1,m2,ph,C);
 	
+	const PairConsts pc=pairConsts.get(mat1,mat2,{
+			m1.k1DivKn,m2.k1DivKn,m1.kaDivKn,m2.kaDivKn,m1.deltaLimRel,m2.deltaLimRel,m1.krDivKn,m2.krDivKn,m1.kwDivKn,m2.kwDivKn,
+			m1.viscN,m2.viscN,m1.viscT,m2.viscT,m1.viscR,m2.viscR,m1.viscW,m2.viscW,m1.dynDivStat,m2.dynDivStat,m1.statR,m2.statR,m1.statW,m2.statW
+		},[&](){
+		PairConsts pc;
+		// averages
+		pc.k1DivKn=.5*(m1.k1DivKn+m2.k1DivKn);
+		pc.kaDivKn=.5*(m1.kaDivKn+m2.kaDivKn);
+		pc.deltaLimRel=.5*(m1.deltaLimRel+m2.deltaLimRel);
+		pc.krDivKn=.5*(m1.krDivKn+m2.krDivKn);
+		pc.kwDivKn=.5*(m1.kwDivKn+m2.kwDivKn);
+		// minima
+		pc.viscN=min(m1.viscN,m2.viscN);
+		pc.viscT=min(m1.viscT,m2.viscT);
+		pc.viscR=min(m1.viscR,m2.viscR);
+		pc.viscW=min(m1.viscW,m2.viscW);
+		pc.dynDivStat=min(m1.dynDivStat,m2.dynDivStat);
+		pc.statR=min(m1.statR,m2.statR);
+		pc.statW=min(m1.statW,m2.statW);
+		return pc;
+	});
+
 	const Real& a1(g.lens[0]); const Real& a2(g.lens[1]);
 	// XXX: meaning of a12=?
-	Real a12=(2*a1*a2)/(a1+a2);
+	ph.a12=(2*a1*a2)/(a1+a2);
+	const Real& a12(ph.a12);
 	ph.k2hat=ph.kn; 
 	const Real& k2hat(ph.k2hat);
 
-	ph.kn1=k2hat*.5*(m1.k1DivKn+m2.k1DivKn);
-	ph.kna=k2hat*.5*(m1.kaDivKn+m2.kaDivKn);
+	ph.kn1=k2hat*pc.k1DivKn;
+	ph.kna=k2hat*pc.kaDivKn;
 	// take the kn value computed in updateFrictPhys, but from now on ph.kn means current stiffness (k2)
 	ph.deltaMax=max(-g.uN,0.);
 	// eq (7)
-	ph.deltaLim=(k2hat/(k2hat-ph.kn1))*.5*(m1.deltaLimRel+m2.deltaLimRel)*a12;
+	ph.deltaLim=(k2hat/(k2hat-ph.kn1))*pc.deltaLimRel*a12;
 	// a12: dimensional scaling
-	ph.kr=k2hat*.5*(m1.krDivKn+m2.krDivKn)*a12;
-	ph.kw=k2hat*.5*(m1.kwDivKn+m2.kwDivKn)*a12;
-	// minima
-	ph.viscN=min(m1.viscN,m2.viscN);
-	ph.viscT=min(m1.viscT,m2.viscT);
-	ph.viscR=min(m1.viscR,m2.viscR);
-	ph.viscW=min(m1.viscW,m2.viscW);
-	ph.dynDivStat=min(m1.dynDivStat,m2.dynDivStat);
-	ph.statR=min(m1.statR,m2.statR);
-	ph.statW=min(m1.statW,m2.statW);
+	ph.kr=k2hat*pc.krDivKn*a12;
+	ph.kw=k2hat*pc.kwDivKn*a12;
+	ph.viscN=pc.viscN;
+	ph.viscT=pc.viscT;
+	ph.viscR=pc.viscR;
+	ph.viscW=pc.viscW;
+	ph.dynDivStat=pc.dynDivStat;
+	ph.statR=pc.statR;
+	ph.statW=pc.statW;
 }
 
 
@@ -172,8 +194,9 @@ bool Law2_L6Geom_LudingPhys::go(const shared_ptr<CGeom>& cg, const shared_ptr<CP
 	ph.deltaMax=max(delta,ph.deltaMax);
 	const Real& k2hat(ph.k2hat);
 	const Real& k1(ph.kn1);
-	// scaling for forces/torques
-	Real a12=(2*g.lens[0]*g.lens[1])/(g.lens[0]+g.lens[1]);
+	// scaling for forces/torques (not saved, re-computed after loading)
+	if(WOO_UNLIKELY(isnan(ph.a12))) ph.a12=(2*g.lens[0]*g.lens[1])/(g.lens[0]+g.lens[1]);
+	const Real& a12(ph.a12);
 	
 	// NORMAL
 	// eq (8)
@@ -204,21 +227,24 @@ bool Law2_L6Geom_LudingPhys::go(const shared_ptr<CGeom>& cg, const shared_ptr<CP
 	if(WOO_UNLIKELY(scene->trackEnergy)) addWork(ph,LudingPhys::WORK_VISCOUS,ph.viscN*velN*velN*scene->dt,g.node->pos);
 	// plastic work computed when contact dissolves
 
+	// normal force without the adhesive part, which scales yield limits in all senses
+	const Real fnNonAdh=fn+ph.kna*delta;
+
 	// TANGENT
 	Vector2r ft;
 	// coulomb sliding (yield) force
-	Real fts=ph.tanPhi*(fn+ph.kna*delta);
+	Real fts=ph.tanPhi*fnNonAdh;
 	Luding_genericSlidingRoutine(this,fts,ph.kt,ph.viscT,velT,ph.xiT,ph.dynDivStat,ft,ph,g.node->pos);
 
 	// ROLL
 	Vector2r mr;
-	Real mrs=ph.statR*(fn+ph.kna*delta)*a12;
+	Real mrs=ph.statR*fnNonAdh*a12;
 	Luding_genericSlidingRoutine(this,mrs,ph.kr,ph.viscR,angVelR,ph.xiR,ph.dynDivStat,mr,ph,g.node->pos);
 
 	// TWIST
 	Real mw;
 	Map1r mw_vec(&mw);
-	Real mws=ph.statW*(fn+ph.kna*delta)*a12;
+	Real mws=ph.statW*fnNonAdh*a12;
 	Map1r xiW_vec(&ph.xiW);
 	Luding_genericSlidingRoutine(this,mws,ph.kw,ph.viscW,Map1r_const(&g.angVel[0]),xiW_vec,ph.dynDivStat,mw_vec,ph,g.node->pos);
 
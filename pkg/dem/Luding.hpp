@@ -78,6 +78,7 @@ struct LudingPhys: public FrictPhys{
 			((Vector2r,xiR,Vector2r::Zero(),,"Tangent elastic rotation.")) \
 			((Real,xiW,0.,,"Twist elastic rotation.")) \
 			((vector<Real>,work,,,"Per-contact dissipation (unallocated when energy tracking is not enabled).")) \
+			((Real,a12,NaN,AttrTrait<Attr::noSave|Attr::readonly>(),"Dimensional scaling length for roll and twist, :math:`2a_1a_2/(a_1+a_2)`; cached so that it is not re-computed in every step (NaN when not yet computed).")) \
 			,/*py*/ .def_property_readonly("Wplast",&LudingPhys::Wplast).def_property_readonly("Wvisc",&LudingPhys::Wvisc)
 
 	WOO_DECL__CLASS_BASE_DOC_ATTRS_PY(woo_dem_LudingPhys__CLASS_BASE_DOC_ATTRS_PY);
@@ -87,6 +88,9 @@ WOO_REGISTER_OBJECT(LudingPhys);
 
 struct Cp2_LudingMat_LudingPhys: public Cp2_FrictMat_FrictPhys{
 	void go(const shared_ptr<Material>&, const shared_ptr<Material>&, const shared_ptr<Contact>&) override;
+	// averages and minima of LudingMat parameters, computed once per material pair
+	struct PairConsts{ Real k1DivKn, kaDivKn, deltaLimRel, krDivKn, kwDivKn, viscN, viscT, viscR, viscW, dynDivStat, statR, statW; };
+	MatPairTable<24,PairConsts> pairConsts;
 	FUNCTOR2D(LudingMat,LudingMat);
 	#define woo_dem_Cp2_LudingMat_LudingPhys__CLASS_BASE_DOC_ATTRS \
 		Cp2_LudingMat_LudingPhys,Cp2_FrictMat_FrictPhys,"Compute :obj:`LudingPhys` given two instances of :obj:`LudingMat`.",/*attrs*/
@@ -12,6 +12,7 @@ void MeshVolume::init(){
 	edges.clear();
 	vertices.clear();
 	nodes.clear();
+	tris.clear();
 	thickVol=0.;
 	// index of any node in the nodes array
 	std::map<Node*,size_t> nodeIx;
@@ -64,6 +65,16 @@ void MeshVolume::init(){
 		GtsFace* face=gts_face_new(gts_face_class(),edges[eIxs[0]].get(),edges[eIxs[1]].get(),edges[eIxs[2]].get());
 		// surface takes ownership of face
 		gts_surface_add_face(surface.get(),face);
+		// vertex order of the face as GTS sees it, which is what determines sign of the volume
+		GtsVertex *v[3];
+		gts_triangle_vertices(GTS_TRIANGLE(face),&v[0],&v[1],&v[2]);
+		Vector3i tri;
+		for(int i:{0,1,2}){
+			tri[i]=-1;
+			for(int j:{0,1,2}) if(vertices[nIxs[j]].get()==v[i]) tri[i]=nIxs[j];
+			assert(tri[i]>=0);
+		}
+		tris.push_back(tri);
 	}
 	LOG_INFO("Create surface with {} vertices, {} edges, {} faces. The surface is{} orientable, is{} closed.",gts_surface_vertex_number(surface.get()),gts_surface_edge_number(surface.get()),gts_surface_face_number(surface.get()),(gts_surface_is_orientable(surface.get())?"":" NOT"),(gts_surface_is_closed(surface.get())?"":" NOT"));
 	if(!gts_surface_is_orientable(surface.get()) || !gts_surface_is_closed(surface.get())){
@@ -72,20 +83,49 @@ void MeshVolume::init(){
 	}
 }
 
-void MeshVolume::updateVertices(){
+void MeshVolume::gatherPositions(){
 	assert(surface);
 	assert(nodes.size()==vertices.size());
+	const long N=nodes.size();
+	pos.resize(N);
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static)
+	#endif
+	for(long i=0; i<N; i++) pos[i]=nodes[i]->pos;
+}
+
+Real MeshVolume::computeVolume() const {
+	// sum of signed volumes of tetrahedra spanned by each face and the reference point, which is the same as gts_surface_volume computes;
+	// the reference point is one of the vertices (rather than the origin) to avoid cancellation when the mesh is far from the origin
+	if(tris.empty()) return 0.;
+	const Vector3r& ref=pos[0];
+	const long N=tris.size();
+	Real v6=0.;
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static) reduction(+:v6)
+	#endif
+	for(long i=0; i<N; i++){
+		const Vector3i& t=tris[i];
+		const Vector3r a=pos[t[0]]-ref, b=pos[t[1]]-ref, c=pos[t[2]]-ref;
+		v6+=a.dot(b.cross(c));
+	}
+	return v6/6.;
+}
+
+Real MeshVolume::gtsVolume(){
+	if(!surface) throw std::runtime_error("MeshVolume.gtsVolume: surface not initialized (run the engine first).");
 	for(size_t i=0; i<nodes.size(); i++){
-		const Vector3r& pos=(nodes[i]->pos);
-		gts_point_set(GTS_POINT(vertices[i].get()),pos[0],pos[1],pos[2]);
+		const Vector3r& p(nodes[i]->pos);
+		gts_point_set(GTS_POINT(vertices[i].get()),p[0],p[1],p[2]);
 	}
+	return gts_surface_volume(surface.get());
 }
 
 void MeshVolume::run(){
 	if(!surface || reinit) init();
 	reinit=false;
-	updateVertices();
-	vol=gts_surface_volume(surface.get());
+	gatherPositions();
+	vol=computeVolume();
 }
 
 #endif
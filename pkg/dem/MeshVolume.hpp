@@ -13,8 +13,15 @@ struct MeshVolume: public PeriodicEngine{
 	vector<std::unique_ptr<GtsEdge>> edges;
 	vector<std::unique_ptr<GtsFace>> faces;
 	std::unique_ptr<GtsSurface> surface;
+	// vertex indices of each face, in the orientation GTS uses for volume computation
+	vector<Vector3i> tris;
+	// node positions gathered before each volume computation
+	vector<Vector3r> pos;
 	void init();
-	void updateVertices();
+	void gatherPositions();
+	Real computeVolume() const;
+	// volume computed by GTS from current node positions, for checking
+	Real gtsVolume();
 	bool acceptsField(Field* f) override { return dynamic_cast<DemField*>(f); }
 	void run() override;
 	Real pyNetVol() const{ return vol-thickVol; }
@@ -26,7 +33,8 @@ struct MeshVolume: public PeriodicEngine{
 		((vector<shared_ptr<Node>>,nodes,,AttrTrait<Attr::noSave>().noGui(),"List of nodes, in the same order as the GTS surface structure.")) \
 		((Real,vol,NaN,,"Volume as computed when last run")) \
 		((Real,thickVol,NaN,,"Volume of the inner side of the mesh: the mesh is defined by :obj:`facets' <Facet>` midplanes, but some facets may have non-zero :obj:`Facet.halfThick`. This number is the sum of (initial!) facet area times :obj:`Facet.halfThick`. To get the volume with this part subtracted, use :obj:`netVol`.")) \
-		,/*py*/ .add_property_readonly("netVol",&MeshVolume::pyNetVol,"Net volume: :obj:`volume` minus :obj:`thickVol`.")
+		,/*py*/ .add_property_readonly("netVol",&MeshVolume::pyNetVol,"Net volume: :obj:`volume` minus :obj:`thickVol`.") \
+			.def("gtsVolume",&MeshVolume::gtsVolume,"Volume computed by ``gts_surface_volume`` from current node positions (for checking :obj:`vol`, which is computed without GTS); the engine must have run before.")
 	WOO_DECL__CLASS_BASE_DOC_ATTRS_PY(woo_dem_MeshVolume__CLASS_BASE_DOC_ATTRS_PY);
 };
 WOO_REGISTER_OBJECT(MeshVolume);
@@ -0,0 +1,55 @@
+#include<woo/pkg/dem/Multirate.hpp>
+
+WOO_PLUGIN(dem,(Multirate));
+WOO_IMPL__CLASS_BASE_DOC_ATTRS(woo_dem_Multirate__CLASS_BASE_DOC_ATTRS);
+WOO_IMPL_LOGGER(Multirate);
+
+int Multirate::nodeLevel(const shared_ptr<Node>& n, Real critDtSq, Real nextDt) const {
+	const DemData& dyn=n->getData<DemData>();
+	// no contacts (new contact could be too stiff for a coarse level), or nothing to integrate
+	if(isinf(critDtSq) || dyn.isBlockedAll() || dyn.impose || !dyn.isNoClump()) return 0;
+	for(const Particle* p: dyn.parRef){ if(p->shape && p->shape->nodes.size()>1) return 0; }
+	Real ratio=sqrt(critDtSq)*scene->dtSafety/nextDt;
+	if(!(ratio>=2.)) return 0;
+	return min(maxLevel,(int)floor(log2(ratio)));
+}
+
+void Multirate::run(){
+	if(maxLevel<0 || maxLevel>20) throw std::runtime_error("Multirate.maxLevel must be in 0..20 (not "+to_string(maxLevel)+").");
+	auto& dem=field->cast<DemField>();
+	vector<Real> nodalDtSq;
+	Real nextDt=applyCritDt(critDt_compute(&nodalDtSq));
+	if(dryRun) return;
+	const auto& nodes(dem.nodes);
+	const long nNodes=nodes.size();
+	// in periodic cell, position of all nodes depends on gradV every step
+	const bool enabled=(maxLevel>0 && !scene->isPeriodic && nodalDtSq.size()==(size_t)nNodes);
+	int maxLev=0;
+	vector<long> counts(maxLevel+1,0);
+	#ifdef WOO_OPENMP
+		#pragma omp parallel
+	#endif
+	{
+		vector<long> cnt(maxLevel+1,0);
+		int mx=0;
+		#ifdef WOO_OPENMP
+			#pragma omp for schedule(static)
+		#endif
+		for(long i=0; i<nNodes; i++){
+			DemData& dyn=nodes[i]->getData<DemData>();
+			dyn.levelWanted=(enabled?nodeLevel(nodes[i],nodalDtSq[i],nextDt):0);
+			cnt[dyn.levelWanted]++;
+			mx=max(mx,max(dyn.level,dyn.levelWanted));
+		}
+		#ifdef WOO_OPENMP
+			#pragma omp critical
+		#endif
+		{
+			for(int l=0; l<=maxLevel; l++) counts[l]+=cnt[l];
+			maxLev=max(maxLev,mx);
+		}
+	}
+	dem.maxLevel=maxLev;
+	levelCounts=counts;
+	LOG_DEBUG("Highest multirate level {}, {} nodes at level 0.",maxLev,levelCounts[0]);
+}
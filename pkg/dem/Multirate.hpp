@@ -0,0 +1,15 @@
+#pragma once
+#include<woo/pkg/dem/DynDt.hpp>
+
+struct Multirate: public DynDt{
+	void run() override;
+	// level the node may be integrated at, given its squared critical timestep and timestep of the next step
+	int nodeLevel(const shared_ptr<Node>& n, Real critDtSq, Real nextDt) const;
+	WOO_DECL_LOGGER;
+	#define woo_dem_Multirate__CLASS_BASE_DOC_ATTRS \
+		Multirate,DynDt,"Multirate (multiple timestep) integration: adjusts :obj:`Scene.dt` like :obj:`DynDt` (and replaces it, don't use both), and additionally assigns each node a *level* :math:`k` such that :math:`2^k \\Delta t` is still below the node's critical timestep (times :obj:`Scene.dtSafety`); stiff or light nodes stay at level 0, others are integrated by :obj:`Leapfrog` only every :math:`2^k` steps with the timestep :math:`2^k\\Delta t`, using force averaged over those steps (positions are still updated every step with the current velocity).\n\nContacts get the finest level of their nodes; :obj:`ContactLoop` evaluates contacts of level :math:`m` only every :math:`2^m` steps, right before velocities of level-:math:`m` nodes are updated (with :obj:`Scene.dt` set to :math:`2^m\\Delta t` for the contact law), and applies :math:`2^m` times their force then, i.e. the impulse over the whole period; nothing is applied in steps in between (impulse multiple timestepping, r-RESPA), and new contacts between coarse nodes are also only detected every :math:`2^m` steps. This assumes the usual engine order (:obj:`Leapfrog` before :obj:`ContactLoop`). Nodes without contacts, clumps and their members, nodes of multinodal particles, nodes with :obj:`~DemData.impose` and all nodes in periodic simulations stay at level 0. New levels only come into effect in steps which are multiples of both the old and the new period; since a node's level is updated every :obj:`stepPeriod` steps only, the period should be short when contacts change quickly.", \
+		((int,maxLevel,3,,"Maximum level; nodes are integrated at most every :math:`2^\\mathrm{maxLevel}` steps. 0 disables multirate integration (the engine then behaves as :obj:`DynDt`).")) \
+		((vector<long>,levelCounts,,AttrTrait<Attr::readonly|Attr::noSave>(),"Number of nodes wanting each level, from the last run."))
+	WOO_DECL__CLASS_BASE_DOC_ATTRS(woo_dem_Multirate__CLASS_BASE_DOC_ATTRS);
+};
+WOO_REGISTER_OBJECT(Multirate);
@@ -0,0 +1,174 @@
+#include<woo/pkg/dem/NodeStats.hpp>
+#include<woo/core/Scene.hpp>
+
+WOO_PLUGIN(dem,(NodeStat)(NodeStats));
+WOO_IMPL__CLASS_BASE_DOC_ATTRS_PY(woo_dem_NodeStat__CLASS_BASE_DOC_ATTRS_PY);
+WOO_IMPL__CLASS_BASE_DOC_ATTRS(woo_dem_NodeStats__CLASS_BASE_DOC_ATTRS);
+WOO_IMPL_LOGGER(NodeStats);
+
+void QuantileSketch::addBin(long k, long count){
+	if(bins.empty()){ off=k; bins.assign(1,count); return; }
+	if(k<off){ bins.insert(bins.begin(),off-k,0); off=k; }
+	else if(k>=off+(long)bins.size()) bins.resize(k-off+1,0);
+	bins[k-off]+=count;
+}
+
+void QuantileSketch::add(Real v){
+	n++;
+	if(!(v>0)){ nZero++; return; }
+	addBin((long)ceil(log(v)/lnGamma),1);
+}
+
+void QuantileSketch::merge(const QuantileSketch& o){
+	assert(relAcc==o.relAcc);
+	n+=o.n; nZero+=o.nZero;
+	for(size_t i=0; i<o.bins.size(); i++){ if(o.bins[i]>0) addBin(o.off+i,o.bins[i]); }
+}
+
+Real QuantileSketch::quantile(Real q) const {
+	if(n==0 || isnan(q)) return NaN;
+	// rank of the value we look for
+	const long rank=(long)(min(max(q,0.),1.)*(n-1));
+	if(rank<nZero) return 0.;
+	long cum=nZero;
+	for(size_t i=0; i<bins.size(); i++){
+		cum+=bins[i];
+		// midpoint (in the relative sense) of the bin: 2γ^k/(γ+1)
+		if(cum>rank) return 2*exp((off+(long)i)*lnGamma)/(exp(lnGamma)+1);
+	}
+	return NaN; // not reached
+}
+
+Real NodeStat::nodeValue(int qty, const shared_ptr<Node>& n, Scene* scene){
+	const DemData& dyn=n->getData<DemData>();
+	switch(qty){
+		case QTY_VEL: return dyn.vel.norm();
+		case QTY_ANGVEL: return dyn.angVel.norm();
+		case QTY_FORCE: return dyn.force.norm();
+		case QTY_TORQUE: return dyn.torque.norm();
+		case QTY_EK: return DemData::getEk_any(n,true,true,scene);
+		default: throw std::logic_error("NodeStat.qty: invalid value "+to_string(qty)+".");
+	}
+}
+
+Real NodeStat::trigValue() const {
+	switch(trigger){
+		case TRIG_NONE: return NaN;
+		case TRIG_MEAN: return mean;
+		case TRIG_STD: return stdev;
+		case TRIG_MAX: return vMax;
+		case TRIG_REL_MAX: return vMax/mean;
+		case TRIG_QUANTILE: return sketch.quantile(trigQuantile);
+		case TRIG_EMA: return ema;
+		case TRIG_EMA_CHANGE: return emaChange;
+		default: throw std::logic_error("NodeStat.trigger: invalid value "+to_string(trigger)+".");
+	}
+}
+
+namespace {
+	// running statistics of one quantity, accumulated by one thread
+	struct StatAccu{
+		long n=0;
+		Real mean=0., M2=0., min=Inf, max=-Inf;
+		QuantileSketch sketch;
+		// Welford's update
+		void add(Real v){
+			sketch.add(v);
+			n++;
+			Real d=v-mean;
+			mean+=d/n;
+			M2+=d*(v-mean);
+			min=std::min(min,v); max=std::max(max,v);
+		}
+		// pairwise combination (Chan et al.)
+		void merge(const StatAccu& o){
+			sketch.merge(o.sketch);
+			if(o.n==0) return;
+			if(n==0){ n=o.n; mean=o.mean; M2=o.M2; min=o.min; max=o.max; return; }
+			long nn=n+o.n;
+			Real d=o.mean-mean;
+			mean+=d*o.n/nn;
+			M2+=o.M2+d*d*((Real)n*o.n/nn);
+			n=nn;
+			min=std::min(min,o.min); max=std::max(max,o.max);
+		}
+	};
+}
+
+void NodeStats::run(){
+	const auto& dem=field->cast<DemField>();
+	const size_t nStats=stats.size();
+	for(const auto& s: stats){
+		if(!s) throw std::runtime_error("NodeStats.stats: must not contain None.");
+		if(s->qty<0 || s->qty>=NodeStat::QTY_NUM) throw std::runtime_error("NodeStats.stats: invalid qty value "+to_string(s->qty)+".");
+	}
+	if(nStats==0) return;
+	#ifdef WOO_OPENMP
+		const size_t nThreads=omp_get_max_threads();
+	#else
+		const size_t nThreads=1;
+	#endif
+	// per-thread accumulators, merged in thread order afterwards so that the result is deterministic
+	vector<vector<StatAccu>> accTh(nThreads,vector<StatAccu>(nStats));
+	for(auto& acc: accTh) for(auto& a: acc) a.sketch.reset(relAcc);
+	const auto& nodes=dem.nodes;
+	const long size=nodes.size();
+	long nn=0;
+	// single pass over nodes for all stats; each quantity is computed only once per node
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static) reduction(+:nn)
+	#endif
+	for(long i=0; i<size; i++){
+		const shared_ptr<Node>& n=nodes[i];
+		const DemData& dyn=n->getData<DemData>();
+		if(skipBlocked && (dyn.isBlockedAll() || dyn.isClumped())) continue;
+		nn++;
+		#ifdef WOO_OPENMP
+			vector<StatAccu>& acc=accTh[omp_get_thread_num()];
+		#else
+			vector<StatAccu>& acc=accTh[0];
+		#endif
+		Real val[NodeStat::QTY_NUM];
+		std::fill(val,val+NodeStat::QTY_NUM,NaN);
+		for(size_t j=0; j<nStats; j++){
+			const int qty=stats[j]->qty;
+			if(isnan(val[qty])) val[qty]=NodeStat::nodeValue(qty,n,scene);
+			if(!isnan(val[qty])) acc[j].add(val[qty]);
+		}
+	}
+	nNodes=nn;
+	for(size_t j=0; j<nStats; j++){
+		StatAccu a=std::move(accTh[0][j]);
+		for(size_t th=1; th<nThreads; th++) a.merge(accTh[th][j]);
+		NodeStat& s=*stats[j];
+		s.n=a.n;
+		s.mean=(a.n>0?a.mean:NaN);
+		s.stdev=(a.n>0?sqrt(a.M2/a.n):NaN);
+		s.vMin=(a.n>0?a.min:NaN);
+		s.vMax=(a.n>0?a.max:NaN);
+		s.sketch=std::move(a.sketch);
+		s.qVals.resize(s.quantiles.size());
+		for(size_t k=0; k<s.quantiles.size(); k++) s.qVals[k]=s.sketch.quantile(s.quantiles[k]);
+		if(!isnan(s.mean)){
+			const Real ema0=s.ema;
+			if(isnan(s.ema)) s.ema=s.mean;
+			else s.ema=(1-s.emaAlpha)*s.ema+s.emaAlpha*s.mean;
+			s.emaChange=(isnan(ema0)?NaN:abs(s.ema-ema0)/abs(s.ema));
+		}
+	}
+	// triggers are checked after all stats are updated, so that hooks see consistent values
+	for(const auto& sp: stats){
+		NodeStat& s=*sp;
+		if(s.trigger==NodeStat::TRIG_NONE || isnan(s.threshold)) continue;
+		const Real v=s.trigValue();
+		if(isnan(v)) continue;
+		const bool beyond=(s.above?v>s.threshold:v<s.threshold);
+		const int state0=s.trigState;
+		s.trigState=(beyond?1:0);
+		if(!beyond || state0==1) continue;
+		s.nFired++;
+		LOG_DEBUG("Trigger fired at step {}: value {} {} threshold {}.",scene->step,v,(s.above?">":"<"),s.threshold);
+		if(s.callback) s.callback(s);
+		if(!s.hook.empty()) runPy("NodeStat.hook",s.hook);
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include<woo/core/Engine.hpp>
+#include<woo/pkg/dem/Particle.hpp>
+
+// quantile sketch with bounded relative error: positive values are counted in logarithmically spaced bins (bin k holds values in (γ^(k-1),γ^k〉, with γ=(1+α)/(1-α) for relative accuracy α); mergeable, so that it can be filled by several threads independently
+struct QuantileSketch{
+	Real relAcc=.01;
+	long nZero=0, n=0;
+	long off=0; // bin index of bins[0]
+	vector<long> bins;
+	void reset(Real _relAcc){ relAcc=_relAcc; nZero=n=0; off=0; bins.clear(); lnGamma=log((1+relAcc)/(1-relAcc)); }
+	void add(Real v);
+	void merge(const QuantileSketch& o);
+	Real quantile(Real q) const;
+	private:
+		Real lnGamma=log(1.01/.99);
+		void addBin(long k, long count);
+};
+
+struct NodeStat: public Object{
+	enum{QTY_VEL=0,QTY_ANGVEL,QTY_FORCE,QTY_TORQUE,QTY_EK,QTY_NUM};
+	enum{TRIG_NONE=0,TRIG_MEAN,TRIG_STD,TRIG_MAX,TRIG_REL_MAX,TRIG_QUANTILE,TRIG_EMA,TRIG_EMA_CHANGE};
+	// value of the quantity for given node
+	static Real nodeValue(int qty, const shared_ptr<Node>& n, Scene* scene);
+	// value checked against threshold, according to trigger
+	Real trigValue() const;
+	// called from NodeStats when the trigger fires (before running hook); not saved
+	std::function<void(NodeStat&)> callback;
+	// merged sketch from the last pass, for querying arbitrary quantiles; not saved
+	QuantileSketch sketch;
+	Real pyQuantile(Real q) const { return sketch.quantile(q); }
+	#define woo_dem_NodeStat__CLASS_BASE_DOC_ATTRS_PY \
+		NodeStat,Object,"Streaming statistics of one scalar quantity over nodes, evaluated by :obj:`NodeStats`; in each pass, mean and standard deviation (Welford's algorithm), extrema and quantiles (from a sketch with bounded relative error) are computed; exponential moving average of the mean is kept over passes. Optional trigger runs :obj:`hook` (and C++ callback, if set) when the :obj:`trigger` value crosses :obj:`threshold`.", \
+		((int,qty,QTY_VEL,AttrTrait<Attr::namedEnum>().namedEnum({{QTY_VEL,{"vel","|v|"}},{QTY_ANGVEL,{"angVel","|ω|"}},{QTY_FORCE,{"force","|F|"}},{QTY_TORQUE,{"torque","|T|"}},{QTY_EK,{"Ek","kinetic energy"}}}),"Quantity evaluated for each node: norm of :obj:`~DemData.vel`, :obj:`~DemData.angVel`, :obj:`~DemData.force`, :obj:`~DemData.torque` or kinetic energy (fluctuation only in periodic simulations).")) \
+		((vector<Real>,quantiles,vector<Real>({.5,.9,.99}),,"Quantiles computed in each pass, stored in :obj:`qVals`; other quantiles from the last pass can be obtained with :obj:`quantile`.")) \
+		((Real,emaAlpha,.1,AttrTrait<>().range(Vector2r(0,1)),"Smoothing factor of :obj:`ema` ∈〈0,1〉 (1 means no smoothing).")) \
+		((int,trigger,TRIG_NONE,AttrTrait<Attr::namedEnum>().namedEnum({{TRIG_NONE,{"none",""}},{TRIG_MEAN,{"mean"}},{TRIG_STD,{"std"}},{TRIG_MAX,{"max"}},{TRIG_REL_MAX,{"relMax","max/mean"}},{TRIG_QUANTILE,{"quantile"}},{TRIG_EMA,{"ema"}},{TRIG_EMA_CHANGE,{"emaChange"}}}),"Value checked against :obj:`threshold`: :obj:`mean`, :obj:`stdev`, :obj:`vMax`, ratio of :obj:`vMax` and :obj:`mean` (outlier detection, as in :obj:`Suspicious`), quantile :obj:`trigQuantile`, :obj:`ema` or :obj:`emaChange` (steady state detection, with :obj:`above` set to ``False``).")) \
+		((Real,trigQuantile,.99,AttrTrait<>().range(Vector2r(0,1)),"Quantile checked with the ``quantile`` :obj:`trigger`.")) \
+		((Real,threshold,NaN,,"Threshold for :obj:`trigger`; the trigger is disabled if NaN.")) \
+		((bool,above,true,,"Fire when the trigger value gets above :obj:`threshold` (or below, if ``False``).")) \
+		((string,hook,"",,"Python code run when the trigger fires, i.e. when the trigger value crosses :obj:`threshold` (not in every pass where it stays beyond). The :obj:`NodeStats` engine is available as ``engine``.")) \
+		((long,nFired,0,AttrTrait<>().readonly(),"Number of times the trigger fired.")) \
+		((int,trigState,-1,AttrTrait<Attr::hidden>(),"Whether the trigger value was beyond threshold in the last pass (-1 if not known).")) \
+		((long,n,0,AttrTrait<>().readonly(),"Number of nodes in the last pass (NaN values are not counted).")) \
+		((Real,mean,NaN,AttrTrait<>().readonly(),"Mean value in the last pass.")) \
+		((Real,stdev,NaN,AttrTrait<>().readonly(),"Standard deviation in the last pass.")) \
+		((Real,vMin,NaN,AttrTrait<>().readonly(),"Minimum value in the last pass.")) \
+		((Real,vMax,NaN,AttrTrait<>().readonly(),"Maximum value in the last pass.")) \
+		((vector<Real>,qVals,,AttrTrait<>().readonly(),"Values of :obj:`quantiles` in the last pass.")) \
+		((Real,ema,NaN,AttrTrait<>().readonly(),"Exponential moving average of :obj:`mean` over passes.")) \
+		((Real,emaChange,NaN,AttrTrait<>().readonly(),"Change of :obj:`ema` in the last pass, relative to its value.")) \
+		,/*py*/ .def("quantile",&NodeStat::pyQuantile,WOO_PY_ARGS(py::arg("q")),"Return quantile *q* ∈〈0,1〉 from the last pass, with relative accuracy :obj:`NodeStats.relAcc`; NaN if no pass was done yet (the sketch is not saved).")
+	WOO_DECL__CLASS_BASE_DOC_ATTRS_PY(woo_dem_NodeStat__CLASS_BASE_DOC_ATTRS_PY);
+};
+WOO_REGISTER_OBJECT(NodeStat);
+
+struct NodeStats: public PeriodicEngine{
+	WOO_DECL_LOGGER;
+	bool acceptsField(Field* f) override { return dynamic_cast<DemField*>(f); }
+	void run() override;
+	#define woo_dem_NodeStats__CLASS_BASE_DOC_ATTRS \
+		NodeStats,PeriodicEngine,"Evaluate all :obj:`stats` in one (parallel) pass over :obj:`DemField.nodes`, and fire their triggers; this replaces several monitoring engines each traversing all nodes, and avoids computing statistics in Python.", \
+		((vector<shared_ptr<NodeStat>>,stats,,,"Statistics to be evaluated.")) \
+		((Real,relAcc,.01,AttrTrait<>().range(Vector2r(1e-4,.5)),"Relative accuracy of quantiles.")) \
+		((bool,skipBlocked,true,,"Skip nodes with all DoFs blocked (walls and other boundaries), and clump members (their clump node is used instead).")) \
+		((long,nNodes,0,AttrTrait<>().readonly(),"Number of nodes evaluated in the last pass."))
+	WOO_DECL__CLASS_BASE_DOC_ATTRS(woo_dem_NodeStats__CLASS_BASE_DOC_ATTRS);
+};
+WOO_REGISTER_OBJECT(NodeStats);
@@ -16,6 +16,7 @@ void Outlet::run(){
 	std::set<std::tuple<Particle::id_t,int>> delParIdLoc;
 	std::set<Particle::id_t> delClumpIxs;
 	bool deleting=(markMask==0);
+	if(spill) spill->setCols({"diam","mass","time","loc","rDivR0"});
 	auto canonPt=[this](const Vector3r& p)->Vector3r{ return scene->isPeriodic?scene->cell->canonicalizePt(p):p; };
 	for(size_t i=0; i<dem->nodes.size(); i++){
 		const auto& n=dem->nodes[i];
@@ -69,20 +70,26 @@ void Outlet::run(){
 		mass+=m;
 		stepMass+=m;
 		// handle radius recovery with spheres
+		Real d, rr=NaN;
 		if(recoverRadius && p->shape->isA<Sphere>()){
 			auto& s=p->shape->cast<Sphere>();
 			Real r=s.radius;
 			if(recoverRadius){
 				r=cbrt(3*m/(4*M_PI*p->material->density));
-				rDivR0.push_back(s.radius/r);
+				rr=s.radius/r;
+				if(!spill) rDivR0.push_back(rr);
 				s.radius=r; // assign to the original value, so that savePar saves with the original diameter
 			}
-			if(save) diamMassTime.push_back(Vector3r(2*r,m,scene->time));
+			d=2*r;
 		} else{
 			// all other cases
-			if(save) diamMassTime.push_back(Vector3r(2*p->shape->equivRadius(),m,scene->time));
+			d=2*p->shape->equivRadius();
 		}
-		locs.push_back(loc);
+		if(save){
+			if(spill) spill->append({d,m,scene->time,(Real)loc,rr});
+			else diamMassTime.push_back(Vector3r(d,m,scene->time));
+		}
+		if(!spill) locs.push_back(loc);
 		if(savePar) par.push_back(p);
 		LOG_TRACE("DemField.par[{}] will be {}",id,(deleting?"deleted.":"marked."));
 		if(deleting) dem->removeParticle(id);
@@ -96,7 +103,11 @@ void Outlet::run(){
 		num++;
 		mass+=m;
 		stepMass+=m;
-		if(save) diamMassTime.push_back(Vector3r(2*n->getData<DemData>().cast<ClumpData>().equivRad,m,scene->time));
+		if(save){
+			const Real d=2*n->getData<DemData>().cast<ClumpData>().equivRad;
+			if(spill) spill->append({d,m,scene->time,-1.,NaN});
+			else diamMassTime.push_back(Vector3r(d,m,scene->time));
+		}
 		LOG_TRACE("DemField.nodes[{}] (clump) will be {}, with all its particles.",ix,(deleting?"deleted":"marked"));
 		if(deleting) dem->removeClump(ix);
 		else {
@@ -114,15 +125,15 @@ void Outlet::run(){
 	else currRate=(1-currRateSmooth)*currRate+currRateSmooth*currRateNoSmooth;
 }
 py::object Outlet::pyDiamMass(bool zipped) const {
-	return DemFuncs::seqVectorToPy(diamMassTime,/*itemGetter*/[](const Vector3r& i)->Vector2r{ return i.head<2>(); },/*zip*/zipped);
+	return SpillLog::dmtToPy(spill,diamMassTime,/*head2*/true,zipped);
 }
 py::object Outlet::pyDiamMassTime(bool zipped) const {
-	return DemFuncs::seqVectorToPy(diamMassTime,/*itemGetter*/[](const Vector3r& i)->Vector3r{ return i; },/*zip*/zipped);
+	return SpillLog::dmtToPy(spill,diamMassTime,/*head2*/false,zipped);
 }
 
 Real Outlet::pyMassOfDiam(Real min, Real max) const {
 	Real ret=0.;
-	for(const auto& dm: diamMassTime){ if(dm[0]>=min && dm[0]<=max) ret+=dm[1]; }
+	SpillLog::forEachDmt(spill,diamMassTime,[&](const Vector3r& dm, size_t){ if(dm[0]>=min && dm[0]<=max) ret+=dm[1]; });
 	return ret;
 }
 
@@ -133,9 +144,27 @@ py::object Outlet::pyPsd(bool _mass, bool cumulative, bool normalize, int _num,
 	std::set<int> locs_set;
 	for(auto& i: locs_vec) locs_set.insert(i);
 	if(!save) throw std::runtime_error("Outlet.psd(): Outlet.save must be True.");
+	vector<Vector2r> psd;
+	if(isnan(tRange.minCoeff()) && locs_set.empty()){
+		// all particles: use the histogram, only adding particles since the last call
+		if(spill) spill->syncPsd(psdHist);
+		else psdHist.sync(diamMassTime);
+		psd=psdHist.psd(_mass,cumulative,normalize,_num,dRange,emptyOk);
+		return DemFuncs::seqVectorToPy(psd,[](const Vector2r& i)->Vector2r{ return i; },/*zip*/zip);
+	}
 	auto tOk=[&tRange](const Real& t){ return isnan(tRange.minCoeff()) || (tRange[0]<=t && t<tRange[1]); };
+	if(spill){
+		// stream rows from the spill file; location is stored in the row
+		auto lOk=[&locs_set](Real loc){ return locs_set.empty() || locs_set.count((int)loc)>0; };
+		psd=DemFuncs::psdForEach([this](auto f){ spill->forEach(f); },cumulative,normalize,_num,dRange,
+			/*diameter getter*/[&tOk,&lOk](const Real* r, size_t i)->Real{ return (tOk(r[2]) && lOk(r[3]))?r[0]:NaN; },
+			/*weight getter*/[&_mass](const Real* r, size_t i)->Real{ return _mass?r[1]:1.; },
+			/*emptyOk*/ emptyOk
+		);
+		return DemFuncs::seqVectorToPy(psd,[](const Vector2r& i)->Vector2r{ return i; },/*zip*/zip);
+	}
 	auto lOk=[&locs_set,this](const size_t& i){ return locs_set.empty() || (i<locs.size() && locs_set.count(locs[i])>0); };
-	vector<Vector2r> psd=DemFuncs::psd(diamMassTime,cumulative,normalize,_num,dRange,
+	psd=DemFuncs::psdParallel(diamMassTime,cumulative,normalize,_num,dRange,
 		/*diameter getter*/[&tOk,&lOk](const Vector3r& dmt, const size_t& i)->Real{ return (tOk(dmt[2]) && lOk(i))?dmt[0]:NaN; },
 		/*weight getter*/[&_mass](const Vector3r& dmt, const size_t& i)->Real{ return _mass?dmt[1]:1.; },
 		/*emptyOk*/ emptyOk
@@ -1,6 +1,7 @@
 #pragma once
 #include<woo/core/Engine.hpp>
 #include<woo/pkg/dem/Particle.hpp>
+#include<woo/pkg/dem/SpillLog.hpp>
 #include<woo/lib/pyutil/converters.hpp>
 
 
@@ -18,7 +19,9 @@ struct Outlet: public PeriodicEngine{
 	py::object pyDiamMass(bool zipped=false) const;
 	py::object pyDiamMassTime(bool zipped=false) const;
 	Real pyMassOfDiam(Real min, Real max) const ;
-	void pyClear(){ diamMassTime.clear(); rDivR0.clear(); locs.clear(); par.clear(); mass=0.; num=0; }
+	void pyClear(){ diamMassTime.clear(); rDivR0.clear(); locs.clear(); par.clear(); mass=0.; num=0; psdHist.clear(); if(spill) spill->clear(); }
+	// histogram of diamMassTime, synchronized when PSD is queried
+	PsdHistogram psdHist;
 	#ifdef WOO_OPENGL
 		void renderMassAndRate(const Vector3r& pos);
 	#endif
@@ -31,6 +34,7 @@ struct Outlet: public PeriodicEngine{
 		((bool,recoverRadius,false,,"Recover radius of Spheres by computing it back from particle's mass and its material density (used when radius is changed due to radius thinning (in Law2_L6Geom_PelletPhys_Pellet.thinningFactor). When radius is recovered, the :math:`r/r_0` ratio is added to :obj:`rDivR0` for further processing.")) \
 		((vector<Real>,rDivR0,,AttrTrait<>().noGui().readonly(),"List of the :math:`r/r_0` ratio of deleted particles, when :obj:`recoverRadius` is true.")) \
 		((vector<Vector3r>,diamMassTime,,/*must be hidden since pybind11 will not let us re-define it with function of the same name below */AttrTrait<Attr::hidden>(),"Radii and masses of deleted particles; not accessible from python (shadowed by the :obj:`diamMassTime` method).")) \
+		((shared_ptr<SpillLog>,spill,,,"When given, data of saved particles (with :obj:`save`) are written to this log (with columns ``diam``, ``mass``, ``time``, ``loc`` and ``rDivR0``, which is NaN if radius was not recovered) instead of :obj:`diamMassTime`, :obj:`locs` and :obj:`rDivR0`, which are not filled at all; only a bounded number of rows is kept in memory, the rest is spilled to a file. :obj:`psd`, :obj:`diamMass`, :obj:`diamMassTime` and :obj:`massOfDiam` read data from the log.")) \
 		((vector<int>,locs,,AttrTrait<>().noGui().readonly(),"Integer location specified for particles; -1 by default, derived classes can use this for any purposes (usually more precise location within the outlet volume).")) \
 		((int,num,0,AttrTrait<Attr::readonly>(),"Number of deleted particles")) \
 		((bool,savePar,false,,"Save particles as objects in :obj:`par`")) \
@@ -42,7 +46,7 @@ struct Outlet: public PeriodicEngine{
 		((Real,currRateSmooth,1,AttrTrait<>().range(Vector2r(0,1)),"Smoothing factor for currRate ∈〈0,1〉")) \
 		((int,kinEnergyIx,-1,AttrTrait<Attr::hidden|Attr::noSave>(),"Index for kinetic energy in scene.energy")) \
 		,/*py*/ \
-		.def("psd",&Outlet::pyPsd,WOO_PY_ARGS(py::arg("mass")=true,py::arg("cumulative")=true,py::arg("normalize")=true,py::arg("num")=80,py::arg("dRange")=Vector2r(NaN,NaN),py::arg("tRange")=Vector2r(NaN,NaN),py::arg("zip")=false,py::arg("emptyOk")=false,py::arg("locs")=py::list()),"Return particle size distribution of deleted particles (only useful with *save*), spaced between *dRange* (a 2-tuple of minimum and maximum radius); )") \
+		.def("psd",&Outlet::pyPsd,WOO_PY_ARGS(py::arg("mass")=true,py::arg("cumulative")=true,py::arg("normalize")=true,py::arg("num")=80,py::arg("dRange")=Vector2r(NaN,NaN),py::arg("tRange")=Vector2r(NaN,NaN),py::arg("zip")=false,py::arg("emptyOk")=false,py::arg("locs")=py::list()),"Return particle size distribution of deleted particles (only useful with *save*), spaced between *dRange* (a 2-tuple of minimum and maximum radius). Without *tRange* and *locs*, the result is computed from a histogram updated incrementally (diameters resolved to 0.1%), without traversing all saved particles.") \
 		.def("clear",&Outlet::pyClear,"Clear information about saved particles (particle list, if saved, mass and number, rDivR0)") \
 		.def("diamMass",&Outlet::pyDiamMass,WOO_PY_ARGS(py::arg("zipped")=false),"With *zipped*, return list of (diameter, mass); without *zipped*, return tuple of 2 arrays, diameters and masses.") \
 		.def("diamMassTime",&Outlet::pyDiamMassTime,WOO_PY_ARGS(py::arg("zipped")=false),"With *zipped*, return list of (diameter, mass, time); without *zipped*, return tuple of 3 arrays: diameters, masses, times.") \
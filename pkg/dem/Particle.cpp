@@ -118,6 +118,23 @@ int Particle::countRealContacts() const{
 	return boost::range::count_if(contacts,[&](const MapParticleContact::value_type& C)->bool{ return C.second->isReal(); });
 }
 
+bool Particle::isSleeping() const {
+	if(!shape || shape->nodes.empty()) return false;
+	for(const auto& n: shape->nodes){ if(!n->hasData<DemData>() || !n->getData<DemData>().isSleeping()) return false; }
+	return true;
+}
+
+bool Particle::isContactFrozen(const Particle* pA, const Particle* pB){
+	bool sA=pA->isSleeping(), sB=pB->isSleeping();
+	if(!sA && !sB) return false;
+	if(sA && sB) return true;
+	// one is sleeping, the other must be static
+	const Particle* o=(sA?pB:pA);
+	if(!o->shape) return false;
+	for(const auto& n: o->shape->nodes){ if(!n->hasData<DemData>() || !n->getData<DemData>().isStatic()) return false; }
+	return true;
+}
+
 void Shape::asRaw_helper_coordsFromNode(vector<shared_ptr<Node>>& nn, vector<Real>& raw, size_t pos, size_t nodeNum) const {
 	// find if the node is in nn
 	const auto& n=nodes[nodeNum];
@@ -69,6 +69,10 @@ struct Particle: public Object{
 	std::vector<shared_ptr<Node> > getNodes();
 	virtual string pyStr() const override;
 	int countRealContacts() const;
+	// all nodes are sleeping (see DemData::isSleeping)
+	bool isSleeping() const;
+	// contact between pA and pB can be frozen: both are sleeping, or one is sleeping and the other static
+	static bool isContactFrozen(const Particle* pA, const Particle* pB);
 	void postLoad(Particle&,void*);
 
 	// create new particle with given shape and material, set new nodes with DemData as needed, recompute intertia
@@ -197,6 +201,7 @@ public:
 	enum {
 		DOF_NONE=0,DOF_X=1,DOF_Y=2,DOF_Z=4,DOF_RX=8,DOF_RY=16,DOF_RZ=32,
 		CLUMP_CLUMPED=64,CLUMP_CLUMP=128,ENERGY_SKIP=256,GRAVITY_SKIP=512,TRACER_SKIP=1024,DAMPING_SKIP=2048,
+		SLEEPING=4096,
 	};
 	//! shorthands
 	static const unsigned DOF_ALL=DOF_X|DOF_Y|DOF_Z|DOF_RX|DOF_RY|DOF_RZ;
@@ -244,10 +249,26 @@ public:
 	void setTracerSkip(bool skip) { if(!skip) flags&=~TRACER_SKIP; else flags|=TRACER_SKIP; }
 	bool isDampingSkip() const { return flags&DAMPING_SKIP; }
 	void setDampingSkip(bool skip) { if(!skip) flags&=~DAMPING_SKIP; else flags|=DAMPING_SKIP; }
+	// sleeping nodes (see Deactivator) are not integrated and contacts between them are frozen
+	bool isSleeping() const { return flags&SLEEPING; }
+	void setSleeping(bool sleep) { if(!sleep) flags&=~SLEEPING; else flags|=SLEEPING; }
+	// fixed node which does not move at all; contacts of sleeping particles with such nodes are frozen as well
+	bool isStatic() const { return isBlockedAll() && !impose && vel==Vector3r::Zero() && angVel==Vector3r::Zero(); }
 
 	void pyHandleCustomCtorArgs(py::args_& args, py::kwargs& kw) override;
 	void addForceTorque(const Vector3r& f, const Vector3r& t=Vector3r::Zero()){ std::scoped_lock l(lock); force+=f; torque+=t; }
 	void addForce(const Vector3r& f){ std::scoped_lock l(lock); force+=f; }
+	// translational and rotational stiffness of contacts, accumulated by ContactLoop (with ContactLoop.trackStiffness) and read by DynDt; not saved
+	Vector3r stiffTrans=Vector3r::Zero(), stiffRot=Vector3r::Zero();
+	void addStiffness(const Vector3r& kt, const Vector3r& kr){ std::scoped_lock l(lock); stiffTrans+=kt; stiffRot+=kr; }
+	// number of consecutive steps the node was at rest, and force in the previous step (or when put to sleep); used by Deactivator, not saved
+	int restSteps=0;
+	Vector3r restForce=Vector3r(NaN,NaN,NaN);
+	// multirate integration (see Multirate): the node is integrated with 2^level*dt in steps which are multiples of 2^level;
+	// levelWanted is set by Multirate and applied by Leapfrog when allowed; mrForce, mrTorque accumulate force over those steps; not saved
+	int level=0, levelWanted=0;
+	Vector3r mrForce=Vector3r::Zero(), mrTorque=Vector3r::Zero();
+	bool isMultirateSync(long step) const { return (step&((1L<<level)-1))==0; }
 
 	// get kinetic energy of given node
 	static Real getEk_any(const shared_ptr<Node>& n, bool trans, bool rot, Scene* scene);
@@ -285,7 +306,7 @@ public:
 		((Vector3r,force,Vector3r::Zero(),AttrTrait<>().forceUnit(),"Applied force")) \
 		((Vector3r,torque,Vector3r::Zero(),AttrTrait<>().torqueUnit(),"Applied torque")) \
 		((Vector3r,angMom,Vector3r(NaN,NaN,NaN),AttrTrait<>().angMomUnit(),"Angular momentum; used with the aspherical integrator. If NaN and aspherical integrator (:obj:`Leapfrog`) is used, the value is initialized to :obj:`inertia` × :obj:`angVel`.")) \
-		((unsigned,flags,0,AttrTrait<Attr::readonly>().bits({"blockX","blockY","blockZ","blockRotX","blockRotY","blockRotZ","clumped","clump","energySkip","gravitySkip","tracerSkip","dampingSkip"},/*rw*/true),"Bit flags storing blocked DOFs, clump status, ...")) \
+		((unsigned,flags,0,AttrTrait<Attr::readonly>().bits({"blockX","blockY","blockZ","blockRotX","blockRotY","blockRotZ","clumped","clump","energySkip","gravitySkip","tracerSkip","dampingSkip","sleeping"},/*rw*/true),"Bit flags storing blocked DOFs, clump status, ...")) \
 		((long,linIx,-1,AttrTrait<>().readonly().noGui(),"Index within DemField.nodes (for efficient removal)")) \
 		((std::list<Particle*>,parRef,,AttrTrait<Attr::hidden|Attr::noSave>().noGui(),"Back-reference for particles using this node; this is important for knowing when a node may be deleted (no particles referenced) and such. Should be kept consistent.")) \
 		((shared_ptr<Impose>,impose,,,"Impose arbitrary velocity, angular velocity, ... on the node; the functor is called from Leapfrog, after new position and velocity have been computed.")) \
@@ -359,6 +380,8 @@ struct DemField: public Field{
 		((uint,loneMask,((void)":obj:`DemField.defaultLoneMask`",DemField::defaultLoneMask),,"Particle groups which have bits in loneMask in common (i.e. (A.mask & B.mask & loneMask)!=0) will not have contacts between themselves")) \
 		((Vector3r,gravity,Vector3r::Zero(),,"Constant gravity acceleration")) \
 		((Real,distFactor,((void)"deactivated",-1.0),,"Relative enlargement of bounding boxes, and of radii in contacts; only supported by a few functors (:obj:`Bo1_Sphere_Aabb`, :obj:`Cg2_Sphere_Sphere_L6Geom`), storing the value in :obj:`DemField` ensures the values are synchronized between all functors interested. Deactivated if negative; any negative value (``-1`` by default) is equivalent to ``1`` (no enlargement at all).")) \
+		((int,maxLevel,0,AttrTrait<Attr::readonly|Attr::noSave>(),"Highest multirate level of any node, set by :obj:`Multirate`; :obj:`ContactLoop` only evaluates contacts by levels when non-zero.")) \
+		((long,nSleeping,0,AttrTrait<Attr::readonly>(),"Number of :obj:`sleeping <DemData.flags>` nodes, updated by :obj:`Deactivator`; :obj:`ContactLoop`, :obj:`Leapfrog` and :obj:`InsertionSortCollider` only look for sleeping particles when this number is non-zero.")) \
 		((bool,saveDead,false,AttrTrait<>().buttons({"Clear dead nodes","self.clearDead()",""}),"Save unused nodes of deleted particles, which would be otherwise removed (useful for displaying traces of deleted particles).")) \
 		((vector<shared_ptr<Node>>,deadNodes,,AttrTrait<Attr::readonly>().noGui(),"List of nodes belonging to deleted particles; only used if :obj:`saveDead` is ``True``")) \
 		((vector<shared_ptr<Particle>>,deadParticles,,AttrTrait<Attr::readonly>().noGui(),"Deleted particles; only used if :obj:`saveDead` is ``True``")) \
@@ -72,6 +72,29 @@ Particle::id_t ParticleContainer::insert(shared_ptr<Particle>& p){
 	return id;
 }
 
+void ParticleContainer::insertMany(const vector<shared_ptr<Particle>>& pp){
+	if(pp.empty()) return;
+	std::scoped_lock lock(manipMutex);
+	auto put=[this](const shared_ptr<Particle>& p, id_t id){
+		p->id=id;
+		parts[id]=p;
+		#ifdef WOO_SUBDOMAINS
+			setParticleSubdomain(p,0);
+		#endif
+	};
+	size_t i=0;
+	// fill holes first
+	for(; i<pp.size(); i++){
+		id_t id=findFreeId();
+		if((size_t)id>=parts.size()) break; // no free ids below size, append the rest
+		put(pp[i],id);
+	}
+	if(i==pp.size()) return;
+	const size_t id0=parts.size();
+	parts.resize(id0+pp.size()-i);
+	for(size_t j=i; j<pp.size(); j++) put(pp[j],id0+(j-i));
+}
+
 #ifdef WOO_SUBDOMAINS
 	void ParticleContainer::clearSubdomains(){ subDomains.clear(); }
 	void ParticleContainer::setupSubdomains(){ subDomains.clear(); subDomains.resize(maxSubdomains); }
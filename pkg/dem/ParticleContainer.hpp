@@ -68,6 +68,8 @@ struct ParticleContainer: public Object{
 
 		id_t insert(shared_ptr<Particle>&);
 		void insertAt(shared_ptr<Particle>& p, id_t id);
+		// insert many particles at once, under one lock and with (at most) one resize; ids are set in the particles
+		void insertMany(const vector<shared_ptr<Particle>>& pp);
 
 	
 		// mimick some STL api
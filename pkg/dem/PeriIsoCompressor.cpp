@@ -7,6 +7,7 @@
 #include<woo/pkg/dem/Funcs.hpp>
 #include<woo/pkg/dem/FrictMat.hpp>
 #include<woo/pkg/dem/Leapfrog.hpp>
+#include<woo/pkg/dem/ContactLoop.hpp>
 #include<woo/lib/pyutil/gil.hpp>
 
 WOO_IMPL_LOGGER(PeriIsoCompressor);
@@ -15,6 +16,19 @@ WOO_PLUGIN(dem,(PeriIsoCompressor))
 WOO_IMPL__CLASS_BASE_DOC_ATTRS(woo_dem_PeriIsoCompressor__CLASS_BASE_DOC_ATTRS);
 WOO_IMPL__CLASS_BASE_DOC_ATTRS(woo_dem_WeirdTriaxControl__CLASS_BASE_DOC_ATTRS);
 
+// use stress and stiffness evaluated by ContactLoop in this step (with ContactLoop.evalStiffness), otherwise traverse contacts;
+// with multirate integration, ContactLoop only sums contacts due in the current step, so those values are partial
+static std::tuple</*stress*/Matrix3r,/*stiffness*/Matrix6r> currStressStiffness(const Scene* scene, const DemField* dem, Real volume){
+	if(dem->maxLevel==0) for(const auto& e: scene->engines){
+		const ContactLoop* cl=dynamic_cast<const ContactLoop*>(e.get());
+		if(!cl || !cl->evalStress || !cl->evalStiffness || cl->stressStep!=scene->step) continue;
+		// ContactLoop divides by the cell volume
+		const Real mult=(volume>0?scene->cell->getVolume()/volume:1.);
+		return std::make_tuple(Matrix3r(.5*mult*(cl->stress+cl->stress.transpose())),Matrix6r(mult*cl->stiffness));
+	}
+	return DemFuncs::stressStiffness(scene,dem,/*skipMultinodal*/false,volume);
+}
+
 
 
 void PeriIsoCompressor::run(){
@@ -38,7 +52,7 @@ void PeriIsoCompressor::run(){
 	const Real& maxSize=cellSize.maxCoeff();
 	if(((step%globalUpdateInt)==0) || isnan(avgStiffness) || isnan(sigma[0]) || isnan(sigma[1])|| isnan(sigma[2])){
 		Matrix3r TT=Matrix3r::Zero(); Matrix6r EE=Matrix6r::Zero();
-		std::tie(TT,EE)=DemFuncs::stressStiffness(scene,dem,/*skipMultinodal*/false,/*volume*/-1.);
+		std::tie(TT,EE)=currStressStiffness(scene,dem,/*volume*/-1.);
 		sigma=TT.diagonal();
 		avgStiffness=EE.topLeftCorner<3,3>().trace()/3.;
 	}
@@ -109,7 +123,7 @@ void WeirdTriaxControl::run(){
 		//"Natural" strain, still correct for large deformations, used for comparison with goals
 		for (int i=0;i<3;i++) strain[i]=log(scene->cell->trsf(i,i));
 		Matrix6r stiffness;
-		std::tie(stress,stiffness)=DemFuncs::stressStiffness(scene,dem,/*skipMultinodal*/false,scene->cell->getVolume()*relVol);
+		std::tie(stress,stiffness)=currStressStiffness(scene,dem,scene->cell->getVolume()*relVol);
 	}
 	if(isnan(mass) || mass<=0){ throw std::runtime_error("WeirdTriaxControl.mass must be positive, not "+to_string(mass)); }
 
@@ -17,6 +17,10 @@ WOO_IMPL_LOGGER(AnisoPorosityAnalyzer);
 Real AnisoPorosityAnalyzer::relSolid(Real theta, Real phi, Vector3r pt0, bool vis){
 	setField();
 	initialize();
+	return relSolid_noInit(theta,phi,pt0,vis);
+}
+
+Real AnisoPorosityAnalyzer::relSolid_noInit(Real theta, Real phi, const Vector3r& pt0, bool vis){
 	vector<Vector3r> endPts=splitRay(theta,phi,pt0,scene->cell->hSize);
 	assert(endPts.size()%2==0);
 	Real solid(0), total(0);
@@ -103,34 +107,105 @@ Real AnisoPorosityAnalyzer::computeOneRay_check(const Vector3r& A, const Vector3
 	return computeOneRay(A,B,vis);
 }
 
+Real AnisoPorosityAnalyzer::sphereSegment(int i, const Vector3r& A, const Vector3r& rayDir, Real lenAB, Real tA, Real tB, bool vis){
+	const SpherePack::Sph& s(pack.pack[i]);
+	Real t0,t1;
+	int nIntr=CompUtils::lineSphereIntersection(A,rayDir,s.c,s.r,t0,t1);
+	if(nIntr<2) return 0;
+	assert(t1>t0);
+	// segment endpoints have parameters 0 and lenAB, we constrain the intersection to that length only
+	t0=max(0.,t0); t1=min(lenAB,t1);
+	if(t1<=t0) return 0; // no intersection on the segment: t0>lenAB or t1<0
+	// the sphere may be seen from several grid cells: report it from the one where the intersection starts
+	if(vis && t0>=tA && t0<tB){ rayIds.push_back(s.shadowOf>=0?s.shadowOf:i); rayPts.push_back(A+t0*rayDir); rayPts.push_back(A+t1*rayDir); }
+	// count only the part inside the grid cell, so that the sum over cells is the intersected length
+	return max(0.,min(t1,tB)-max(t0,tA));
+}
+
 Real AnisoPorosityAnalyzer::computeOneRay(const Vector3r& A, const Vector3r& B, bool vis){
 	Real tot=0; // cummulative intersected length
 	Real lenAB=(B-A).norm();
 	Vector3r rayDir=(B-A)/lenAB;
-	int i=-1;
-	for(const SpherePack::Sph& s: pack.pack){
-		i++;
-		Real t0,t1;
-		int nIntr=CompUtils::lineSphereIntersection(A,rayDir,s.c,s.r,t0,t1);
-		if(nIntr<2) continue;
-		assert(t1>t0);
-		// segment endpoints have parameters 0 and lenAB, we constrain the intersection to that length only
-		//cerr<<"#"<<s.shadowOf>=0?s.shadowOf:i<<(s.shadowOf>=0?"s":"")<<": ";	cerr<<"t="<<t0<<","<<t1<<" | ";
-		t0=max(0.,t0); t1=min(lenAB,t1);
-		//cerr<<"t="<<t0<<","<<t1<<endl;
-		// same as: t0=max(0.,min(lenAB,t0)); t1=max(0.,min(lenAB,t1)); if(t1==t0) continue;
-		if(t1<=t0) continue; // no intersection on the segment: t0>lenAB or t1<0
-		tot+=t1-t0;
-		if(vis){ rayIds.push_back(s.shadowOf>=0?s.shadowOf:i); rayPts.push_back(A+t0*rayDir); rayPts.push_back(A+t1*rayDir);	}
+	// segment outside of the grid (or no grid): test all spheres
+	const Vector3r& csz(pack.cellSize);
+	Real eps=1e-6*csz.maxCoeff();
+	bool inGrid=(gridN.minCoeff()>0);
+	for(int ax:{0,1,2}) if(min(A[ax],B[ax])<-eps || max(A[ax],B[ax])>csz[ax]+eps) inGrid=false;
+	if(!inGrid){
+		for(int i=0; i<(int)pack.pack.size(); i++) tot+=sphereSegment(i,A,rayDir,lenAB,0,lenAB,vis);
+		return tot;
+	}
+	// traverse grid cells along the segment (3D-DDA, Amanatides & Woo, 1987)
+	Vector3i ijk, step;
+	Vector3r tMax, tDelta;
+	for(int ax:{0,1,2}){
+		ijk[ax]=max(0,min(gridN[ax]-1,(int)floor(A[ax]/gridH[ax])));
+		if(rayDir[ax]>0){ step[ax]=1; tMax[ax]=((ijk[ax]+1)*gridH[ax]-A[ax])/rayDir[ax]; tDelta[ax]=gridH[ax]/rayDir[ax]; }
+		else if(rayDir[ax]<0){ step[ax]=-1; tMax[ax]=(ijk[ax]*gridH[ax]-A[ax])/rayDir[ax]; tDelta[ax]=-gridH[ax]/rayDir[ax]; }
+		else { step[ax]=0; tMax[ax]=tDelta[ax]=Inf; }
+	}
+	Real tEnter=0;
+	while(true){
+		int ax; tMax.minCoeff(&ax);
+		Real tExit=min(tMax[ax],lenAB);
+		size_t cell=ijk[0]+(size_t)gridN[0]*(ijk[1]+(size_t)gridN[1]*ijk[2]);
+		// the last cell extends to the end of the segment
+		for(size_t j=gridStart[cell]; j<gridStart[cell+1]; j++) tot+=sphereSegment(gridIx[j],A,rayDir,lenAB,tEnter,(tExit>=lenAB?Inf:tExit),vis);
+		if(tExit>=lenAB) break;
+		ijk[ax]+=step[ax];
+		// left the grid due to roundoff at the very end of the segment
+		if(ijk[ax]<0 || ijk[ax]>=gridN[ax]) break;
+		tEnter=tExit;
+		tMax[ax]+=tDelta[ax];
 	}
 	return tot;
 }
 
+void AnisoPorosityAnalyzer::buildGrid(){
+	gridN=Vector3i::Zero();
+	gridStart.clear(); gridIx.clear();
+	gridBuiltRelSize=gridRelSize;
+	if(gridRelSize<=0 || pack.pack.empty()) return;
+	const Vector3r& csz(pack.cellSize);
+	Real rMean=0;
+	for(const auto& s: pack.pack) rMean+=s.r;
+	rMean/=pack.pack.size();
+	// about one sphere per cell, but not more cells than spheres
+	Real h=max(gridRelSize*2*rMean,cbrt(csz.prod()/pack.pack.size()));
+	for(int ax:{0,1,2}){ gridN[ax]=max(1,(int)(csz[ax]/h)); gridH[ax]=csz[ax]/gridN[ax]; }
+	const size_t nCells=(size_t)gridN.prod();
+	auto cellRange=[&](const SpherePack::Sph& s, Vector3i& lo, Vector3i& hi){
+		for(int ax:{0,1,2}){
+			lo[ax]=max(0,(int)floor((s.c[ax]-s.r)/gridH[ax]));
+			hi[ax]=min(gridN[ax]-1,(int)floor((s.c[ax]+s.r)/gridH[ax]));
+		}
+	};
+	// count, then fill (compressed row storage)
+	gridStart.assign(nCells+1,0);
+	Vector3i lo, hi, ijk;
+	for(const auto& s: pack.pack){
+		cellRange(s,lo,hi);
+		for(ijk[2]=lo[2]; ijk[2]<=hi[2]; ijk[2]++) for(ijk[1]=lo[1]; ijk[1]<=hi[1]; ijk[1]++) for(ijk[0]=lo[0]; ijk[0]<=hi[0]; ijk[0]++) gridStart[ijk[0]+gridN[0]*(ijk[1]+(size_t)gridN[1]*ijk[2])+1]++;
+	}
+	for(size_t c=0; c<nCells; c++) gridStart[c+1]+=gridStart[c];
+	gridIx.resize(gridStart[nCells]);
+	vector<size_t> fill(gridStart.begin(),gridStart.end()-1);
+	for(int i=0; i<(int)pack.pack.size(); i++){
+		cellRange(pack.pack[i],lo,hi);
+		for(ijk[2]=lo[2]; ijk[2]<=hi[2]; ijk[2]++) for(ijk[1]=lo[1]; ijk[1]<=hi[1]; ijk[1]++) for(ijk[0]=lo[0]; ijk[0]<=hi[0]; ijk[0]++) gridIx[fill[ijk[0]+gridN[0]*(ijk[1]+(size_t)gridN[1]*ijk[2])]++]=i;
+	}
+	LOG_DEBUG("Grid {}x{}x{}, {} sphere references for {} spheres.",gridN[0],gridN[1],gridN[2],gridIx.size(),pack.pack.size());
+}
+
 void AnisoPorosityAnalyzer::initialize(){
 	if(!scene->isPeriodic) throw std::runtime_error("AnisoPorosityAnalyzer can only be used with periodic BC");
 	if(scene->cell->hasShear()) throw std::runtime_error("AnisoPorosityAnalyzer only works so far with PBC without skew.");
 	dem=dynamic_cast<DemField*>(field.get());
-	if(scene->step==initStep && dem->particles->size()==initNum) return;
+	if(scene->step==initStep && dem->particles->size()==initNum){
+		// pack is up-to-date, but gridRelSize may have changed
+		if(gridRelSize!=gridBuiltRelSize) buildGrid();
+		return;
+	}
 	pack=SpherePack();
 	pack.cellSize=scene->cell->getSize();
 	for(const shared_ptr<Particle>& p: *dem->particles){
@@ -140,12 +215,39 @@ void AnisoPorosityAnalyzer::initialize(){
 	}
 	__attribute__((unused)) int sh=pack.addShadows();
 	LOG_DEBUG("Added {} shadow spheres",sh);
+	buildGrid();
 	initStep=scene->step;
 	initNum=dem->particles->size();
 }
 
 void AnisoPorosityAnalyzer::run(){
-	throw std::runtime_error("AnisoPorosityAnalyzer::run not yet implemented.");
+	if(div<=0) throw std::runtime_error("AnisoPorosityAnalyzer.div must be positive.");
+	initialize();
+	const long nRays=div*div;
+	const Vector3r& csz(scene->cell->getSize());
+	Matrix3r ret(Matrix3r::Zero());
+	#ifdef WOO_OPENMP
+		#pragma omp parallel
+	#endif
+	{
+		Matrix3r r(Matrix3r::Zero());
+		#ifdef WOO_OPENMP
+			#pragma omp for schedule(guided)
+		#endif
+		for(long i=0; i<nRays; i++){
+			Real u=((i%div)+.5)/div, v=((i/div)+.5)/div;
+			Real theta=2*M_PI*u, phi=asin(v);
+			// R3 low-discrepancy sequence for starting points
+			Vector3r pt0N=(Vector3r(.8191725134,.6710436067,.5497004779)*(i+1)).array().unaryExpr([](Real x){ return x-floor(x); }).matrix();
+			Vector3r n(cos(phi)*cos(theta),cos(phi)*sin(theta),sin(phi));
+			r+=relSolid_noInit(theta,phi,pt0N.cwiseProduct(csz),/*vis*/false)*n*n.transpose();
+		}
+		#ifdef WOO_OPENMP
+			#pragma omp critical
+		#endif
+		ret+=r;
+	}
+	poro=ret/nRays;
 }
 
 #ifdef WOO_OPENGL
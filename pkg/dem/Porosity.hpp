@@ -5,25 +5,37 @@
 
 #include<woo/lib/sphere-pack/SpherePack.hpp>
 
-struct AnisoPorosityAnalyzer: public Engine {
+struct AnisoPorosityAnalyzer: public PeriodicEngine {
 	bool acceptsField(Field* f) override { return dynamic_cast<DemField*>(f); }
 	DemField* dem;
 	SpherePack pack;
+	// uniform grid over the periodic cell; spheres (including shadows) overlapping grid cell i are pack.pack[gridIx[j]] for j in gridStart[i]…gridStart[i+1]-1
+	Vector3i gridN=Vector3i::Zero();
+	Vector3r gridH;
+	Real gridBuiltRelSize=NaN; // gridRelSize the grid was built with
+	vector<size_t> gridStart;
+	vector<int> gridIx;
+	void buildGrid();
 	virtual void run() override;
 	static vector<Vector3r> splitRay(Real theta, Real phi, Vector3r pt0=Vector3r::Zero(), const Matrix3r& T=Matrix3r::Identity());
 	Real relSolid(Real theta, Real phi, Vector3r pt0=Vector3r::Zero(), bool vis=false);
+	// without calling initialize(); can be called in parallel if vis is false
+	Real relSolid_noInit(Real theta, Real phi, const Vector3r& pt0, bool vis);
 	// _check variants to be called from python (safe scene setup etc)
 	Real computeOneRay_check(const Vector3r& A, const Vector3r& B, bool vis=true);
 	Real computeOneRay_angles_check(Real theta, Real phi, bool vis=true);
 	void clearVis(){ rayIds.clear(); rayPts.clear(); }
 
 	Real computeOneRay(const Vector3r& A, const Vector3r& B, bool vis=false);
+	// length of segment A+t*dir, t∈〈max(0,t0),min(lenAB,t1)〉 inside sphere pack.pack[i]; intersection is added to vis data only if it starts in that interval
+	Real sphereSegment(int i, const Vector3r& A, const Vector3r& dir, Real lenAB, Real t0, Real t1, bool vis);
 	void initialize();
 	WOO_DECL_LOGGER;
 	#define woo_dem_AnisoPorosityAnalyzer__CLASS_BASE_DOC_ATTRS_PY \
-		AnisoPorosityAnalyzer,Engine,"Engine which analyzes current scene and computes directionaly porosity value by intersecting spheres with lines. The algorithm only works on periodic simulations.", \
-		((Matrix3r,poro,Matrix3r::Zero(),AttrTrait<Attr::readonly>(),"Store analysis result here")) \
-		((int,div,10,,"Fineness of division of interval (0…1) for $u$,$v$ ∈〈0…1〉, which are used for uniform distribution over the positive octant as $\\theta=\frac{\\pi}{2}u$, $\\phi=\\arccos v$ (see http://mathworld.wolfram.com/SpherePointPicking.html)")) \
+		AnisoPorosityAnalyzer,PeriodicEngine,"Engine which analyzes current scene and computes directionaly porosity value by intersecting spheres with lines. The algorithm only works on periodic simulations. Spheres are put in a uniform grid (see :obj:`gridRelSize`), and rays only test spheres in grid cells they traverse; rays of one analysis are traced in parallel.", \
+		((Matrix3r,poro,Matrix3r::Zero(),AttrTrait<Attr::readonly>(),"Analysis result: $\\frac{1}{N}\\sum_i s_i \\vec{n}_i\\otimes\\vec{n}_i$, where $s_i$ is the solid fraction along the ray with direction $\\vec{n}_i$ (see :obj:`relSolid`); its trace is the mean solid fraction over all directions, and it is $\\frac{s}{3}\\mathbf{I}$ for an isotropic packing with solid fraction $s$.")) \
+		((int,div,10,,"Fineness of division of interval (0…1) for $u$,$v$ ∈〈0…1〉, which are used for uniform distribution of $\\mathrm{div}^2$ rays over the upper hemisphere (the opposite direction gives the same line) as $\\theta=2\\pi u$, $\\phi=\\arcsin v$ (see http://mathworld.wolfram.com/SpherePointPicking.html); starting points of rays are spread over the cell with a low-discrepancy sequence.")) \
+		((Real,gridRelSize,1.,,"Size of grid cells relative to mean sphere diameter; if non-positive, the grid is not used and every ray is tested against all spheres.")) \
 		/* check that data are up-to-date */ \
 		((long,initStep,-1,AttrTrait<Attr::hidden>(),"Step in which internal data were last updated")) \
 		((size_t,initNum,-1,AttrTrait<Attr::hidden>(),"Number of particles at last update")) \
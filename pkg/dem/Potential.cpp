@@ -1,9 +1,5 @@
 #include<woo/pkg/dem/Potential.hpp>
 
-#if 0
-#include<woo/lib/pcl/bfgs.hpp>
-#include<unsupported/Eigen/NumericalDiff>
-
 WOO_PLUGIN(dem,(PotentialFunctor)(PotentialDispatcher)(Pot1_Sphere)(Pot1_Wall)(Cg2_Shape_Shape_L6Geom__Potential));
 
 WOO_IMPL__CLASS_BASE_DOC_PY(woo_dem_PotentialFunctor__CLASS_BASE_DOC_PY);
@@ -12,42 +8,25 @@ WOO_IMPL__CLASS_BASE_DOC(woo_dem_Pot1_Wall__CLASS_BASE_DOC);
 WOO_IMPL__CLASS_BASE_DOC_ATTRS(woo_dem_Cg2_Shape_Shape_L6Geom__Potential__CLASS_BASE_DOC_ATTRS);
 
 
-PotentialFunctor::PotFuncType PotentialFunctor::funcPotentialValue(const shared_ptr<Shape>& s){
-	throw std::runtime_error(pyStr()+".funcPotentialValue: not overridden (called with shape "+s->pyStr()+").");
+Real PotKernel_Functor::operator()(const Vector3r& x, Vector3r& grad, Matrix3r& hess) const {
+	return f->potGrad(*s,x-shift,grad,hess);
 }
-PotentialFunctor::GradFuncType PotentialFunctor::funcPotentialGradient(const shared_ptr<Shape>&){
-	// return empty function by default
-	return GradFuncType();
+
+Real PotentialFunctor::potGrad(const shared_ptr<Shape>& s, const Vector3r& pt, Vector3r& grad, Matrix3r& hess){
+	throw std::runtime_error(pyStr()+".potGrad: not overridden (called with shape "+s->pyStr()+").");
 }
 Real PotentialFunctor::go(const shared_ptr<Shape>& s, const Vector3r& pt){
-	return funcPotentialValue(s)(pt);
+	Vector3r grad; Matrix3r hess;
+	return potGrad(s,pt,grad,hess);
 }
 
 
 Real Pot1_Sphere::boundingSphereRadius(const shared_ptr<Shape>& s){ return s->cast<Sphere>().radius; }
 
-Real Pot1_Sphere::pot(const shared_ptr<Shape>& s, const Vector3r& pt){
-	Real ret=(pt-s->nodes[0]->pos).norm()-s->cast<Sphere>().radius;
-	cerr<<"Pot1_Sphere::pot("<<pt.transpose()<<")="<<ret<<endl;
-	return ret;
-}
-PotentialFunctor::PotFuncType Pot1_Sphere::funcPotentialValue(const shared_ptr<Shape>& s){
-	// return PotFuncType([&](const Vector3r& pt)->Real{ return (pt-s->nodes[0]->pos).norm()-s->cast<Sphere>().radius; });
-	return PotFuncType([&](const Vector3r& pt)->Real{ return this->pot(s,pt); });
-}
-
-Real Pot1_Wall::pot(const shared_ptr<Shape>& s, const Vector3r& pt){
-	const auto& w(s->cast<Wall>());
-	Real ret=w.sense*(pt[w.axis]-w.nodes[0]->pos[w.axis]);
-	cerr<<"Pot1_Wall::pot  ("<<pt.transpose()<<")="<<ret<<endl;
-	return ret;
-}
-	// return PotFuncType([&](const Vector3r& pt)->Real{ return w.sense*(pt[w.axis]-w.nodes[0]->pos[w.axis]); });
-PotentialFunctor::PotFuncType Pot1_Wall::funcPotentialValue(const shared_ptr<Shape>& s){
+PotKernel_Wall Pot1_Wall::kernel(const shared_ptr<Shape>& s, const Vector3r& shift){
 	const auto& w(s->cast<Wall>());
 	if(w.sense!=-1 && w.sense!=1) throw std::runtime_error("Pot1_Wall: Wall.sense must be +1 or -1, not "+to_string(w.sense)+".");
-	// return PotFuncType([&](const Vector3r& pt)->Real{ return w.sense*(pt[w.axis]-w.nodes[0]->pos[w.axis]); });
-	return PotFuncType([&](const Vector3r& pt)->Real{ return this->pot(s,pt); });
+	return PotKernel_Wall{w.axis,Real(w.sense),w.nodes[0]->pos[w.axis]+shift[w.axis]};
 }
 
 void Cg2_Shape_Shape_L6Geom__Potential::setMinDist00Sq(const shared_ptr<Shape>& s1, const shared_ptr<Shape>& s2, const shared_ptr<Contact>& C) {
@@ -62,120 +41,112 @@ void Cg2_Shape_Shape_L6Geom__Potential::setMinDist00Sq(const shared_ptr<Shape>&
 	C->minDist00Sq=pow2(sum);
 }
 
-void Cg2_Shape_Shape_L6Geom__Potential::pyHandleCustomCtorArgs(py::tuple& t, py::dict& d){
+void Cg2_Shape_Shape_L6Geom__Potential::pyHandleCustomCtorArgs(py::args_& t, py::kwargs& d){
 	if(py::len(t)==0) return; // nothing to do
-	if(py::len(t)!=1) throw invalid_argument(("Collider optionally takes exactly one list of BoundFunctor's as non-keyword argument for constructor ("+to_string(py::len(t))+" non-keyword ards given instead)").c_str());
+	if(py::len(t)!=1) throw std::invalid_argument(("Cg2_Shape_Shape_L6Geom__Potential optionally takes exactly one list of PotentialFunctor's as non-keyword argument for constructor ("+to_string(py::len(t))+" non-keyword args given instead)").c_str());
 	if(!potentialDispatcher) potentialDispatcher=make_shared<PotentialDispatcher>();
 	vector<shared_ptr<PotentialFunctor>> vf=py::extract<vector<shared_ptr<PotentialFunctor>>>((t[0]))();
 	for(const auto& f: vf) potentialDispatcher->add(f);
 	t=py::tuple(); // empty the args
 }
 
-
-template<typename _Scalar, int NX>
-struct ParticleBFGSFunctor
-{
-	typedef _Scalar Scalar;
-	typedef Eigen::Matrix<Scalar,1,1> Matrix11;
-	enum { InputsAtCompileTime = NX, ValuesAtCompileTime=1 };
-	typedef Eigen::Matrix<Scalar,InputsAtCompileTime,1> VectorType;
-	typedef PotentialFunctor::PotFuncType PotFuncType;
-	typedef PotentialFunctor::GradFuncType GradFuncType;
-	// for NumericalDiff
-	typedef VectorType InputType; 
-	typedef Eigen::Matrix<Scalar,1,InputsAtCompileTime> JacobianType;
-	typedef Matrix11 ValueType;
-
-
-	std::function<Real(const Vector3r&)> potFunc;
-	std::function<Vector3r(const Vector3r&)> gradFunc; // unset by default
-	const int m_inputs;
-
-	ParticleBFGSFunctor(PotFuncType _potFunc, GradFuncType _gradFunc=GradFuncType(), int _inputs=0): potFunc(_potFunc), gradFunc(_gradFunc), m_inputs(_inputs!=0?_inputs:InputsAtCompileTime) { }
-
-	int inputs() const { return m_inputs; }
-	int values() const { return 1; }
-
-	int operator() (const InputType& x, ValueType &v) const { v(0,0)=potFunc(x); return 1; }
-	int df(const VectorType &x, JacobianType &df) const { if(!gradFunc) throw std::logic_error("ParticleBFGSFunctor.df: gradFunc is undefined and numerical differentiation is not enabled."); df=gradFunc(x).transpose(); return 0; }
-	// int fdf(const VectorType &x, ValueType &_f, JacobianType &_df) const { int ret=1; (*this)(x,_f); ret+=df(x,_df); return ret; }
-};
-
-typedef ParticleBFGSFunctor<Real,3> ParticleBFGSFunctor_R3;
-typedef Eigen::NumericalDiff<ParticleBFGSFunctor_R3,/*mode=*/ /* Eigen::Central */ Eigen::Forward> ParticleBFGSFunctor_R3_numDiff;
-
-string BFGS_status2str(int status){
-	#define CASE_STATUS(st) case BFGSSpace::st: return string(#st);
-	switch(status){
-		CASE_STATUS(NegativeGradientEpsilon);
-		CASE_STATUS(NotStarted);
-		CASE_STATUS(Running);
-		CASE_STATUS(Success);
-		CASE_STATUS(NoProgress);
+/*
+Newton iteration on F=f1+f2+k(f1-f2)², k=1/refLen; the penalty term selects the point where both potentials are equal
+(the sum alone is flat along the segment between two spheres). Steps which are not descent directions
+(indefinite hessian far from the solution) are replaced by gradient steps, and all steps are backtracked (Armijo).
+*/
+template<class K1, class K2>
+bool Cg2_Shape_Shape_L6Geom__Potential::solve(const K1& k1, const K2& k2, Vector3r& pt, Real refLen, Real& p1, Real& p2, Vector3r& normal) const {
+	const Real k=1./refLen;
+	Vector3r g1, g2; Matrix3r H1, H2;
+	auto funcF=[&](const Vector3r& x)->Real{ Vector3r a, b; Matrix3r A, B; Real q1=k1(x,a,A), q2=k2(x,b,B); return q1+q2+k*pow2(q1-q2); };
+	Real step=NaN;
+	for(int iter=0; iter<maxIter; iter++){
+		p1=k1(pt,g1,H1); p2=k2(pt,g2,H2);
+		// converged in the previous step; potentials and gradients are evaluated at pt now
+		if(step<relTol*refLen){ normal=(g1-g2).normalized(); return true; }
+		const Real d=p1-p2; const Vector3r gd=g1-g2;
+		const Real F=p1+p2+k*pow2(d);
+		const Vector3r G=g1+g2+2*k*d*gd;
+		const Matrix3r H=H1+H2+2*k*(gd*gd.transpose()+d*(H1-H2));
+		Eigen::LDLT<Matrix3r> ldlt(H);
+		Vector3r dx=-ldlt.solve(G);
+		if(ldlt.info()!=Eigen::Success || !ldlt.isPositive() || !(dx.dot(G)<0)) dx=-.1*refLen*G;
+		Real t=1.;
+		for(int ls=0; ls<30; ls++){
+			if(funcF(pt+t*dx)<=F+1e-4*t*G.dot(dx)) break;
+			t*=.5;
+		}
+		pt+=t*dx;
+		step=t*dx.norm();
+		LOG_TRACE("iter {}: F={}, |G|={}, step={}, pt={}",iter,F,G.norm(),step,pt.transpose());
 	}
-	#undef CASE_STATUS
-	throw std::logic_error(("BFGS_status2str: unknown status number "+to_string(status)));
+	return false;
 }
 
+template<class K1, class K2>
+bool Cg2_Shape_Shape_L6Geom__Potential::goKernels(const K1& k1, const K2& k2, const shared_ptr<Shape>& s1, const shared_ptr<Shape>& s2, const Vector3r& shift2, const bool& force, const shared_ptr<Contact>& C){
+	const auto& f1=potentialDispatcher->getFunctor1D(s1);
+	const auto& f2=potentialDispatcher->getFunctor1D(s2);
+	const Vector3r pos1(s1->nodes[0]->pos), pos2(s2->nodes[0]->pos+shift2);
+	Real b1=f1->boundingSphereRadius(s1), b2=f2->boundingSphereRadius(s2);
+	Vector3r pt;
+	Real refLen;
+	if(b1>0 && b2>0){
+		refLen=max(b1+b2,(pos2-pos1).norm());
+		// bounding spheres don't touch, no contact possible
+		if(!C->isReal() && !force && (pos2-pos1).squaredNorm()>pow2(b1+b2)) return false;
+		pt=pos1+(pos2-pos1)*b1/(b1+b2);
+	} else if(b1>0 || b2>0){
+		// start from the surface of the bounded particle, in the direction of the unbounded one
+		refLen=(b1>0?b1:b2);
+		const Vector3r& c(b1>0?pos1:pos2);
+		Vector3r g; Matrix3r H;
+		if(b1>0) k2(c,g,H); else k1(c,g,H);
+		pt=c-refLen*g.normalized();
+	} else {
+		refLen=(pos2-pos1).norm();
+		if(!(refLen>0)) throw std::runtime_error("Cg2_Shape_Shape_L6Geom__Potential: unable to determine reference length for "+s1->pyStr()+" + "+s2->pyStr()+" (neither particle has bounding sphere, and their nodes coincide).");
+		pt=.5*(pos1+pos2);
+	}
+	// existing contacts are warm-started from the previous contact point, which typically converges in 1-2 iterations
+	if(C->geom) pt=C->geom->node->pos;
+
+	Real p1, p2; Vector3r normal;
+	if(!solve(k1,k2,pt,refLen,p1,p2,normal)) throw std::runtime_error("Cg2_Shape_Shape_L6Geom__Potential: contact point of "+s1->pyStr()+" + "+s2->pyStr()+" not converged in "+to_string(maxIter)+" iterations.");
+	LOG_TRACE("Solution {}; potentials are {} {}, normal {}",pt.transpose(),p1,p2,normal.transpose());
+	Real uN=p1+p2;
+	if(uN>0 && !C->isReal() && !force) return false;
+
+	Real r1=s1->equivRadius(), r2=s2->equivRadius();
+	if(!(r1>0) && !(r2>0)) throw std::runtime_error("Shape.equivRadius: at least one should be positive ("+to_string(r1)+" for "+s1->pyStr()+", "+to_string(r2)+" for "+s2->pyStr()+")");
+	if(!(r1>0)) r1=-r2;
+	if(!(r2>0)) r2=-r1;
+	const auto& dyn1=s1->nodes[0]->getData<DemData>();
+	const auto& dyn2=s2->nodes[0]->getData<DemData>();
+	handleSpheresLikeContact(C,pos1,dyn1.vel,dyn1.angVel,pos2,dyn2.vel,dyn2.angVel,normal,pt,uN,r1,r2);
+	return true;
+}
 
+template<class K1>
+bool Cg2_Shape_Shape_L6Geom__Potential::goKernel2(const K1& k1, const shared_ptr<Shape>& s1, const shared_ptr<Shape>& s2, const Vector3r& shift2, const bool& force, const shared_ptr<Contact>& C){
+	const auto& f2=potentialDispatcher->getFunctor1D(s2);
+	switch(f2->kernelType()){
+		case PotentialFunctor::KERNEL_SPHERE: return goKernels(k1,Pot1_Sphere::kernel(s2,shift2),s1,s2,shift2,force,C);
+		case PotentialFunctor::KERNEL_WALL: return goKernels(k1,Pot1_Wall::kernel(s2,shift2),s1,s2,shift2,force,C);
+		default: return goKernels(k1,PotKernel_Functor{f2.get(),&s2,shift2},s1,s2,shift2,force,C);
+	}
+}
 
 WOO_IMPL_LOGGER(Cg2_Shape_Shape_L6Geom__Potential);
 bool Cg2_Shape_Shape_L6Geom__Potential::go(const shared_ptr<Shape>& s1, const shared_ptr<Shape>& s2, const Vector3r& shift2, const bool& force, const shared_ptr<Contact>& C){
 	const auto& f1=potentialDispatcher->getFunctor1D(s1);
 	const auto& f2=potentialDispatcher->getFunctor1D(s2);
 	if(!f1 || !f2) return false; // unable to handle this contact
-	auto l1=f1->funcPotentialValue(s1); auto l2=f2->funcPotentialValue(s2);
-	Real refLen=(s1->nodes[0]->pos-s2->nodes[0]->pos).norm();
-	//auto functor=Eigen::NumericalDiff<ParticleBFGSFunctor_R3>(PotentialFunctor::PotFuncType([&](const Vector3r& pt)->Real{ return l1(pt)+l2(pt); }),refLen*1e-6);
-	auto functor=ParticleBFGSFunctor_R3_numDiff(ParticleBFGSFunctor_R3(PotentialFunctor::PotFuncType([&](const Vector3r& pt)->Real{ return l1(pt)+l2(pt); })),refLen*1e-6);
-	// scaling factor for numerics
-	BFGS<ParticleBFGSFunctor_R3_numDiff> solver(functor);
-	// initial solution?
-	Vector3r solution;
-	if(!C->isReal()){
-		solution=.5*(s1->nodes[0]->pos+s2->nodes[0]->pos);
-	} else {
-		solution=C->geom->node->pos;
+	// dispatch on kernel types once per contact, so that the solver is instantiated for concrete kernels
+	switch(f1->kernelType()){
+		case PotentialFunctor::KERNEL_SPHERE: return goKernel2(Pot1_Sphere::kernel(s1,Vector3r::Zero()),s1,s2,shift2,force,C);
+		case PotentialFunctor::KERNEL_WALL: return goKernel2(Pot1_Wall::kernel(s1,Vector3r::Zero()),s1,s2,shift2,force,C);
+		default: return goKernel2(PotKernel_Functor{f1.get(),&s1,Vector3r::Zero()},s1,s2,shift2,force,C);
 	}
-
-	LOG_TRACE("BFGS: initial {}",solution.transpose());
-	ParticleBFGSFunctor_R3::JacobianType jac; functor.df(solution,jac);
-	LOG_TRACE("BFGS: gradient {}",jac);
-	#if 1
-		int status=solver.minimizeInit(solution);
-		LOG_TRACE("BFGS: initialized, status={} {}",status,BFGS_status2str(status));
-		do{
-			LOG_TRACE("BFGS: gradient={}, pnorm={}, g0norm={}, fp0={}",solver.gradient.transpose(),solver.pnorm,solver.g0norm,solver.fp0);
-			status=solver.minimizeOneStep(solution);
-			LOG_TRACE("BFGS: solution step, solution={}, status={} {}",solution.transpose(),status,BFGS_status2str(status));
-		} while(status==BFGSSpace::Running);
-	#else
-		int status=solver.minimize(solution);
-	#endif
-	LOG_TRACE("BFGS: final solution {}, status={} {}",solution.transpose(),status,BFGS_status2str(status));
-	// solution found
-	if(status==BFGSSpace::Success){
-		Real p1=l1(solution), p2=l2(solution);
-		cerr<<"Solution "<<solution.transpose()<<" found after "<<solver.iter<<" iterations; potentials are "<<p1<<" "<<p2<<endl;
-		if(p1*p2<0) throw std::runtime_error("Potential have differing signs at the solution point.");
-		// compute the gradient
-		ParticleBFGSFunctor_R3_numDiff f2(PotentialFunctor::PotFuncType([&](const Vector3r& pt)->Real{ return l1(pt)-l2(pt); }));
-		ParticleBFGSFunctor_R3::JacobianType jac;
-		f2.df(solution,jac);
-		Vector3r grad(jac.transpose());
-		cerr<<"Gradient (contact normal) at the solution point: "<<grad.transpose()<<endl;
-		Real r1=s1->equivRadius(), r2=s2->equivRadius();
-		if(!(r1>0) && !(r2>0)) throw std::runtime_error("Shape.equivRadius: at least one should be positive ("+to_string(r1)+" for "+s1->pyStr()+", "+to_string(r2)+" for "+s2->pyStr()+")");
-		if(!(r1>0)) r1=-r2;
-		if(!(r2>0)) r2=-r1;
-		Real uN=-p1-p2;
-		const auto& dyn1=s1->nodes[0]->getData<DemData>();
-		const auto& dyn2=s2->nodes[0]->getData<DemData>();
-		handleSpheresLikeContact(C,s1->nodes[0]->pos,dyn1.vel,dyn1.angVel,s2->nodes[0]->pos,dyn2.vel,dyn2.angVel,grad,solution,uN,r1,r2);
-	} else {
-		// no solution found?
-		throw std::runtime_error("BFGS: no solution, status "+BFGS_status2str(status));
-	}
-	return true;
 }
-#endif
@@ -1,62 +1,97 @@
 #pragma once
 
-#if 0
 #include<woo/pkg/dem/Particle.hpp>
+#include<woo/pkg/dem/L6Geom.hpp>
 #include<woo/core/Dispatcher.hpp>
 
+/*
+Potential kernels: plain structs returning potential value at a point, and filling its (analytic) gradient and hessian.
+They are bound to one shape (and periodic shift) and passed by value to Cg2_Shape_Shape_L6Geom__Potential::solve, which is
+instantiated for every pair of kernels, so that the inner loop does no virtual calls (and no numerical differentiation).
+*/
+struct PotentialFunctor;
+struct PotKernel_Functor{
+	// generic fallback for functors without a static kernel: one virtual call per evaluation
+	PotentialFunctor* f; const shared_ptr<Shape>* s; Vector3r shift;
+	Real operator()(const Vector3r& x, Vector3r& grad, Matrix3r& hess) const;
+};
+struct PotKernel_Sphere{
+	Vector3r c; Real r;
+	Real operator()(const Vector3r& x, Vector3r& grad, Matrix3r& hess) const {
+		Vector3r d=x-c; Real l=d.norm();
+		if(!(l>0)){ grad=Vector3r::Zero(); hess=Matrix3r::Identity()/r; return -r; } // gradient undefined at the very center
+		grad=d/l; hess=(Matrix3r::Identity()-grad*grad.transpose())/l;
+		return l-r;
+	}
+};
+struct PotKernel_Wall{
+	int axis; Real sense; Real pos;
+	Real operator()(const Vector3r& x, Vector3r& grad, Matrix3r& hess) const {
+		grad=Vector3r::Zero(); grad[axis]=sense; hess=Matrix3r::Zero();
+		return sense*(x[axis]-pos);
+	}
+};
 
 struct PotentialFunctor: public Functor1D</*dispatch types*/ Shape,/*return type*/ Real, /*argument types*/ TYPELIST_2(const shared_ptr<Shape>&, const Vector3r&)>{
-	// function returning potential at the coordinate given
-	typedef std::function<Real(const Vector3r&)> PotFuncType;
-	typedef std::function<Vector3r(const Vector3r&)> GradFuncType;
-	virtual PotFuncType funcPotentialValue(const shared_ptr<Shape>&);
-	virtual GradFuncType funcPotentialGradient(const shared_ptr<Shape>&);
+	// kernel types with static implementation, see Cg2_Shape_Shape_L6Geom__Potential::go
+	enum { KERNEL_GENERIC=0, KERNEL_SPHERE, KERNEL_WALL };
+	virtual int kernelType() const { return KERNEL_GENERIC; }
+	// return potential at pt, filling its gradient and hessian; functors with static kernel forward to the kernel
+	virtual Real potGrad(const shared_ptr<Shape>& s, const Vector3r& pt, Vector3r& grad, Matrix3r& hess);
 	Real go(const shared_ptr<Shape>&, const Vector3r& pos) override;
 	// return bounding sphere radius, for uninodal particles only
 	virtual Real boundingSphereRadius(const shared_ptr<Shape>&){ return NaN; }
-	#define woo_dem_PotentialFunctor__CLASS_BASE_DOC_PY PotentialFunctor,Functor,"Functor for creating/updating :obj:`woo.dem.Potential`.", /*py*/ ; woo::converters_cxxVector_pyList_2way<shared_ptr<PotentialFunctor>>();
+	Vector3r pyGrad(const shared_ptr<Shape>& s, const Vector3r& pt){ Vector3r g; Matrix3r h; potGrad(s,pt,g,h); return g; }
+	#define woo_dem_PotentialFunctor__CLASS_BASE_DOC_PY PotentialFunctor,Functor,"Functor for computing potential functions of particles, used by :obj:`Cg2_Shape_Shape_L6Geom__Potential`.", /*py*/ .def("pot",&PotentialFunctor::go,WOO_PY_ARGS(py::arg("shape"),py::arg("pt")),"Return potential value of *shape* at point *pt*.").def("grad",&PotentialFunctor::pyGrad,WOO_PY_ARGS(py::arg("shape"),py::arg("pt")),"Return gradient of the potential of *shape* at point *pt*."); woo::converters_cxxVector_pyList_2way<shared_ptr<PotentialFunctor>>(mod);
 	WOO_DECL__CLASS_BASE_DOC_PY(woo_dem_PotentialFunctor__CLASS_BASE_DOC_PY);
 };
 WOO_REGISTER_OBJECT(PotentialFunctor);
 
 struct PotentialDispatcher: public Dispatcher1D</* functor type*/PotentialFunctor>{
-	void run(){}
+	void run() override {}
 	WOO_DISPATCHER1D_FUNCTOR_DOC_ATTRS_CTOR_PY(PotentialDispatcher,PotentialFunctor,/*optional doc*/,/*additional attrs*/,/*ctor*/,/*py*/);
 };
 WOO_REGISTER_OBJECT(PotentialDispatcher);
 
 #include<woo/pkg/dem/Sphere.hpp>
 struct Pot1_Sphere: public PotentialFunctor{
+	static PotKernel_Sphere kernel(const shared_ptr<Shape>& s, const Vector3r& shift){ return PotKernel_Sphere{s->nodes[0]->pos+shift,s->cast<Sphere>().radius}; }
+	int kernelType() const override { return KERNEL_SPHERE; }
 	Real boundingSphereRadius(const shared_ptr<Shape>&) override;
-	Real pot(const shared_ptr<Shape>& s, const Vector3r& x);
-	PotFuncType funcPotentialValue(const shared_ptr<Shape>&) override;
+	Real potGrad(const shared_ptr<Shape>& s, const Vector3r& pt, Vector3r& grad, Matrix3r& hess) override { return kernel(s,Vector3r::Zero())(pt,grad,hess); }
 	FUNCTOR1D(Sphere);
-	#define woo_dem_Pot1_Sphere__CLASS_BASE_DOC Pot1_Sphere,PotentialFunctor,"Fuctor computing potential for spheres."
+	#define woo_dem_Pot1_Sphere__CLASS_BASE_DOC Pot1_Sphere,PotentialFunctor,"Functor computing potential for spheres (distance from the surface)."
 	WOO_DECL__CLASS_BASE_DOC(woo_dem_Pot1_Sphere__CLASS_BASE_DOC);
 };
 WOO_REGISTER_OBJECT(Pot1_Sphere);
 
 #include<woo/pkg/dem/Wall.hpp>
 struct Pot1_Wall: public PotentialFunctor{
-	Real pot(const shared_ptr<Shape>& s, const Vector3r& x);
-	PotFuncType funcPotentialValue(const shared_ptr<Shape>&) override;
+	static PotKernel_Wall kernel(const shared_ptr<Shape>& s, const Vector3r& shift);
+	int kernelType() const override { return KERNEL_WALL; }
+	Real potGrad(const shared_ptr<Shape>& s, const Vector3r& pt, Vector3r& grad, Matrix3r& hess) override { return kernel(s,Vector3r::Zero())(pt,grad,hess); }
 	FUNCTOR1D(Wall);
-	#define woo_dem_Pot1_Wall__CLASS_BASE_DOC Pot1_Wall,PotentialFunctor,"Fuctor computing potential for spheres."
+	#define woo_dem_Pot1_Wall__CLASS_BASE_DOC Pot1_Wall,PotentialFunctor,"Functor computing potential for walls (signed distance from the wall plane, positive on the :obj:`Wall.sense` side)."
 	WOO_DECL__CLASS_BASE_DOC(woo_dem_Pot1_Wall__CLASS_BASE_DOC);
 };
 WOO_REGISTER_OBJECT(Pot1_Wall);
 
 struct Cg2_Shape_Shape_L6Geom__Potential: public Cg2_Any_Any_L6Geom__Base{
-	virtual bool go(const shared_ptr<Shape>& s1, const shared_ptr<Shape>& s2, const Vector3r& shift2, const bool& force, const shared_ptr<Contact>& C);
+	bool go(const shared_ptr<Shape>& s1, const shared_ptr<Shape>& s2, const Vector3r& shift2, const bool& force, const shared_ptr<Contact>& C) override;
 	void setMinDist00Sq(const shared_ptr<Shape>& s1, const shared_ptr<Shape>& s2, const shared_ptr<Contact>& C) override;
-	void pyHandleCustomCtorArgs(py::tuple& t, py::dict& d);
+	void pyHandleCustomCtorArgs(py::args_& t, py::kwargs& d) override;
+	// find contact point for given kernels, starting from (and returning) pt; return false if not converged in maxIter
+	template<class K1, class K2> bool solve(const K1& k1, const K2& k2, Vector3r& pt, Real refLen, Real& p1, Real& p2, Vector3r& normal) const;
+	template<class K1> bool goKernel2(const K1& k1, const shared_ptr<Shape>& s1, const shared_ptr<Shape>& s2, const Vector3r& shift2, const bool& force, const shared_ptr<Contact>& C);
+	template<class K1, class K2> bool goKernels(const K1& k1, const K2& k2, const shared_ptr<Shape>& s1, const shared_ptr<Shape>& s2, const Vector3r& shift2, const bool& force, const shared_ptr<Contact>& C);
 	#define woo_dem_Cg2_Shape_Shape_L6Geom__Potential__CLASS_BASE_DOC_ATTRS \
-		Cg2_Shape_Shape_L6Geom__Potential,Cg2_Any_Any_L6Geom__Base,"Compute contact configuration from potential functions for respective colliding particles.", \
-		((shared_ptr<PotentialDispatcher>,potentialDispatcher,make_shared<PotentialDispatcher>(),,"Dispatcher for potential functions."))
+		Cg2_Shape_Shape_L6Geom__Potential,Cg2_Any_Any_L6Geom__Base,"Compute contact configuration from potential functions for respective colliding particles.\n\nThe contact point minimizes :math:`f_1+f_2+(f_1-f_2)^2/l` (:math:`l` being the reference length of the contact), i.e. the sum of both potentials on the locus where they are equal; the minimization is done by Newton iteration with analytic gradients and hessians, starting from the contact point of the previous step for existing contacts. Normal overlap is :math:`f_1+f_2` and the contact normal is the gradient of :math:`f_1-f_2`.", \
+		((shared_ptr<PotentialDispatcher>,potentialDispatcher,make_shared<PotentialDispatcher>(),,"Dispatcher for potential functions.")) \
+		((Real,relTol,1e-10,,"Convergence tolerance for the contact point, relative to the reference length of the contact.")) \
+		((int,maxIter,50,,"Maximum number of Newton iterations; an exception is raised when the contact point does not converge."))
 	WOO_DECL__CLASS_BASE_DOC_ATTRS(woo_dem_Cg2_Shape_Shape_L6Geom__Potential__CLASS_BASE_DOC_ATTRS);
 	DEFINE_FUNCTOR_ORDER_2D(Shape,Shape);
 	FUNCTOR2D(Shape,Shape);
 	WOO_DECL_LOGGER;
 };
 WOO_REGISTER_OBJECT(Cg2_Shape_Shape_L6Geom__Potential);
-#endif
@@ -43,7 +43,9 @@ void PsdSphereGenerator::sanitizePsd(vector<Vector2r>& psdPts, const string& src
 	}
 }
 
-void PsdSphereGenerator::postLoad(PsdSphereGenerator&,void*){
+void PsdSphereGenerator::postLoad(PsdSphereGenerator&,void* attr){
+	// assigning ParticleGenerator.spill must not reset the bookkeeping
+	if(attr!=NULL && attr!=&psdPts) return;
 	if(psdPts.empty()) return;
 	sanitizePsd(psdPts,"PsdSphereGenerator.psdPts");
 	weightPerBin.resize(psdPts.size());
@@ -138,7 +140,7 @@ void PsdSphereGenerator::saveBinMassRadiusTime(int bin, Real m, Real r, Real tim
 	weightTotal+=(mass?m:1.);
 	lastM=(mass?m:1.);
 	lastBin=bin;
-	if(save) genDiamMassTime.push_back(Vector3r(2*r,m,time));
+	saveDiamMassTime(2*r,m,time);
 }
 
 void PsdSphereGenerator::revokeLast(){
@@ -165,8 +167,8 @@ PsdSphereGenerator::operator()(const shared_ptr<Material>&mat, const Real& time)
 py::tuple PsdSphereGenerator::pyInputPsd(bool normalize, bool cumulative, int num) const {
 	Real factor=1.; // no scaling at all
 	if(!normalize){
-		if(mass) for(const auto& vv: genDiamMassTime) factor+=vv[1]; // scale by total mass of all generated particles
-		else factor=genDiamMassTime.size(); //  scale by number of particles
+		if(mass) SpillLog::forEachDmt(spill,genDiamMassTime,[&factor](const Vector3r& vv, size_t){ factor+=vv[1]; }); // scale by total mass of all generated particles
+		else factor=(spill?spill->nRows():genDiamMassTime.size()); //  scale by number of particles
 	}
 	py::list dia, frac; // diameter and fraction axes
 	if(cumulative){
@@ -9,7 +9,7 @@ struct PsdSphereGenerator: public ParticleGenerator{
 
 	static void sanitizePsd(vector<Vector2r>& psdPts, const string& src);
 
-	void postLoad(PsdSphereGenerator&,void*);
+	void postLoad(PsdSphereGenerator&,void* attr);
 	// return radius and bin for the next particle (also used by derived classes)
 	std::tuple<Real,int> computeNextRadiusBin();
 	// save bookkeeping information once the particle is generated (also used by derived classes)
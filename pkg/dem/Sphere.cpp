@@ -143,7 +143,7 @@ void In2_Sphere_ElastMat::go(const shared_ptr<Shape>& sh, const shared_ptr<Mater
 				cerr<<"\t#"<<(isPA?pA->id:pB->id)<<" @ "<<xc.transpose()<<", F="<<F.transpose()<<", T="<<(xc.cross(F)+T).transpose()<<endl;
 		}
 		#endif
-		sh->nodes[0]->getData<DemData>().addForceTorque(F,xc.cross(F)+T);
+		addNodalForceTorque(sh->nodes[0]->getData<DemData>(),F,xc.cross(F)+T);
 	}
 }
 
@@ -192,13 +192,13 @@ void Gl1_Sphere::renderScaledSphere(const shared_ptr<Shape>& shape, const Vector
 	} else if (wire || wire2 ){
 		glLineWidth(1.);
 		if(!smooth) glDisable(GL_LINE_SMOOTH);
-		glutWireSphere(r,quality*glutSlices,quality*glutStacks);
+		GLUtils::Sphere(r,quality*glutSlices,quality*glutStacks,/*wire*/true);
 		if(!smooth) glEnable(GL_LINE_SMOOTH); // re-enable
 	}
 	else {
 		glEnable(GL_LIGHTING);
 		glShadeModel(GL_SMOOTH);
-		glutSolidSphere(r,quality*glutSlices,quality*glutStacks);
+		GLUtils::Sphere(r,quality*glutSlices,quality*glutStacks);
 	#if 0
 		//Check if quality has been modified or if previous lists are invalidated (e.g. by creating a new qt view), then regenerate lists
 		bool somethingChanged = (abs(quality-prevQuality)>0.001 || glIsList(glStripedSphereList)!=GL_TRUE);
@@ -304,7 +304,7 @@ void Gl1_Sphere::initGlutGlList(){
 	glNewList(glGlutSphereList,GL_COMPILE);
 		glEnable(GL_LIGHTING);
 		glShadeModel(GL_SMOOTH);
-		glutSolidSphere(1.0,max(quality*glutSlices,2.),max(quality*glutStacks,3.));
+		GLUtils::Sphere(1.0,max(quality*glutSlices,2.),max(quality*glutStacks,3.));
 	glEndList();
 }
 
@@ -97,7 +97,7 @@ class Gl1_Sphere: public GlShapeFunctor{
 			renderScaledSphere(sh,shift,wire2,glInfo,sh->cast<Sphere>().radius);
 		}
 	#define woo_dem_Gl1_Sphere__CLASS_BASE_DOC_ATTRS \
-		Gl1_Sphere,GlShapeFunctor,"Renders :obj:`Sphere` object", \
+		Gl1_Sphere,GlShapeFunctor,"Renders :obj:`Sphere` object. With :obj:`Gl1_DemField.sphereImpostors`, spheres are batched by :obj:`Gl1_DemField` and rendered as ray-cast impostors, in which case only :obj:`scale` and :obj:`wire` are used.", \
 		((Real,quality,1.0,AttrTrait<>().range(Vector2r(0,8)),"Change discretization level of spheres. quality>1 for better image quality, at the price of more cpu/gpu usage, 0<quality<1 for faster rendering. If mono-color sphres are displayed (:obj:`stripes` = `False`), quality mutiplies :obj:`glutSlices` and :obj:`glutStacks`. If striped spheres are displayed (:obj:`stripes = `True`), only integer increments are meaningful: quality=1 and quality=1.9 will give the same result, quality=2 will give a finer result.")) \
 		((bool,wire,false,,"Only show wireframe (controlled by :obj:`glutSlices` and :obj:`glutStacks`.")) \
 		((bool,smooth,false,,"Render lines smooth (it makes them thicker and less clear if there are many spheres.)")) \
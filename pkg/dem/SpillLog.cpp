@@ -0,0 +1,234 @@
+#include<woo/pkg/dem/SpillLog.hpp>
+#include<boost/iostreams/filtering_stream.hpp>
+#include<boost/iostreams/filter/zlib.hpp>
+#include<boost/iostreams/device/back_inserter.hpp>
+#include<boost/iostreams/device/array.hpp>
+#include<boost/algorithm/string/join.hpp>
+#include<cstring>
+#include<mutex>
+
+WOO_PLUGIN(dem,(SpillLog));
+WOO_IMPL__CLASS_BASE_DOC_ATTRS_PY(woo_dem_SpillLog__CLASS_BASE_DOC_ATTRS_PY);
+WOO_IMPL_LOGGER(SpillLog);
+
+namespace{
+	const char spillMagic[8]={'W','o','o','S','p','i','l','l'};
+	const long spillHeaderSize=sizeof(spillMagic)+sizeof(int32_t);
+	// files used by logs alive in this process
+	std::mutex liveMutex;
+	std::map<string,std::set<const SpillLog*>> liveLogs;
+}
+
+SpillLog::~SpillLog(){
+	std::scoped_lock l(liveMutex);
+	if(!liveFile.empty()) liveLogs[liveFile].erase(this);
+}
+
+void SpillLog::postLoad(SpillLog&, void* attr){
+	std::scoped_lock l(liveMutex);
+	if(!liveFile.empty()){ liveLogs[liveFile].erase(this); liveFile.clear(); }
+	if(file.empty()) return;
+	// loaded or deep-copied while the original log is alive: continue in a copy of the file
+	if(attr==NULL && !liveLogs[file].empty()){
+		string f2;
+		for(int i=1; ; i++){ f2=file+".copy"+to_string(i); if(liveLogs[f2].empty() && !filesystem::exists(f2)) break; }
+		if(nSpilled>0){
+			if(!filesystem::exists(file) || (long)filesystem::file_size(file)<offset) throw std::runtime_error("SpillLog: "+file+" does not exist or is shorter than "+to_string(offset)+" bytes, unable to copy it to "+f2+".");
+			filesystem::copy_file(file,f2);
+			// without data written by the original after the copy was saved
+			filesystem::resize_file(f2,offset);
+		}
+		LOG_INFO("{} is used by another log, continuing in {}.",file,f2);
+		file=f2;
+	}
+	liveLogs[file].insert(this);
+	liveFile=file;
+}
+
+void SpillLog::setCols(const vector<string>& names){
+	if(cols.empty()){
+		if(!tail.empty() || nSpilled>0) throw std::runtime_error("SpillLog: contains data but no column names (corrupted?).");
+		// fail when the log is attached, rather than at the first spill in the middle of the simulation
+		if(maxTail>0 && file.empty()) throw std::runtime_error("SpillLog.file must be set (or maxTail set to 0 to keep all rows in memory).");
+		cols=names;
+		return;
+	}
+	if(cols!=names) throw std::runtime_error("SpillLog: columns ["+boost::algorithm::join(cols,",")+"] do not match ["+boost::algorithm::join(names,",")+"] (was the log used with some other object before?).");
+}
+
+void SpillLog::append(const vector<Real>& row){
+	if(row.size()!=cols.size()) throw std::logic_error("SpillLog::append: row has "+to_string(row.size())+" values, but there are "+to_string(cols.size())+" columns.");
+	if(maxTail>0 && (long)nTail()>=maxTail) spill();
+	tail.insert(tail.end(),row.begin(),row.end());
+}
+
+void SpillLog::popLast(){
+	if(nRows()==0){ LOG_WARN("{}: no rows to remove.",file); return; }
+	if(nTail()==0) unspillLast();
+	tail.resize(tail.size()-cols.size());
+}
+
+void SpillLog::unspillLast(){
+	std::ifstream in; openRead(in);
+	long pos=in.tellg(), lastPos=pos;
+	size_t i=0, n=0;
+	while(pos<offset){ lastPos=pos; n=readBlock(in,nullptr); i+=n; pos=in.tellg(); }
+	if(i!=(size_t)nSpilled) throw std::runtime_error("SpillLog: "+file+": only "+to_string(i)+" rows found, "+to_string(nSpilled)+" expected.");
+	in.seekg(lastPos);
+	vector<Real> buf;
+	readBlock(in,&buf);
+	in.close();
+	filesystem::resize_file(file,lastPos);
+	tail.insert(tail.begin(),buf.begin(),buf.end());
+	nSpilled-=n;
+	offset=lastPos;
+}
+
+void SpillLog::clear(){
+	tail.clear();
+	nSpilled=0;
+	offset=0;
+}
+
+void SpillLog::spill(){
+	const size_t n=nTail();
+	if(n==0) return;
+	if(file.empty()) throw std::runtime_error("SpillLog.file must be set before rows are spilled.");
+	if(nSpilled==0){
+		// new (or cleared) log: create the file with header
+		std::ofstream out(file,std::ios::binary|std::ios::trunc);
+		if(!out.good()) throw std::runtime_error("SpillLog: unable to open "+file+" for writing.");
+		int32_t nc=cols.size();
+		out.write(spillMagic,sizeof(spillMagic));
+		out.write((const char*)&nc,sizeof(nc));
+		offset=spillHeaderSize;
+	} else {
+		if(!filesystem::exists(file)) throw std::runtime_error("SpillLog: "+file+" does not exist (should contain "+to_string(nSpilled)+" rows).");
+		auto size=filesystem::file_size(file);
+		if((long)size<offset) throw std::runtime_error("SpillLog: "+file+" is shorter ("+to_string(size)+" bytes) than expected ("+to_string(offset)+" bytes).");
+		// discard data written after we were saved
+		if((long)size>offset){
+			LOG_WARN("{}: discarding {} bytes written after {} rows (the simulation was probably reloaded).",file,size-offset,nSpilled);
+			filesystem::resize_file(file,offset);
+		}
+	}
+	vector<char> z;
+	{
+		boost::iostreams::filtering_ostream zs;
+		zs.push(boost::iostreams::zlib_compressor(boost::iostreams::zlib_params(level)));
+		zs.push(boost::iostreams::back_inserter(z));
+		zs.write((const char*)tail.data(),tail.size()*sizeof(Real));
+	} // flushed when destroyed
+	std::ofstream out(file,std::ios::binary|std::ios::app);
+	uint64_t hdr[2]={n,z.size()};
+	out.write((const char*)hdr,sizeof(hdr));
+	out.write(z.data(),z.size());
+	if(!out.good()) throw std::runtime_error("SpillLog: error writing to "+file+".");
+	offset+=sizeof(hdr)+z.size();
+	nSpilled+=n;
+	tail.clear();
+	LOG_DEBUG("{}: spilled {} rows, {} bytes compressed ({} rows total).",file,n,z.size(),nSpilled);
+}
+
+void SpillLog::openRead(std::ifstream& in) const {
+	in.open(file,std::ios::binary);
+	if(!in.good()) throw std::runtime_error("SpillLog: unable to open "+file+" for reading.");
+	char magic[sizeof(spillMagic)]; int32_t nc;
+	in.read(magic,sizeof(magic));
+	in.read((char*)&nc,sizeof(nc));
+	if(!in.good() || memcmp(magic,spillMagic,sizeof(magic))!=0) throw std::runtime_error("SpillLog: "+file+" is not a spill file.");
+	if(nc!=(int32_t)cols.size()) throw std::runtime_error("SpillLog: "+file+" has "+to_string(nc)+" columns, "+to_string(cols.size())+" expected.");
+}
+
+size_t SpillLog::readBlock(std::istream& in, vector<Real>* buf) const {
+	uint64_t hdr[2];
+	in.read((char*)hdr,sizeof(hdr));
+	if(!in.good()) throw std::runtime_error("SpillLog: "+file+": error reading block header.");
+	const size_t n=hdr[0], nz=hdr[1];
+	if(!buf){ in.seekg(nz,std::ios::cur); return n; }
+	vector<char> z(nz);
+	in.read(z.data(),nz);
+	if(!in.good()) throw std::runtime_error("SpillLog: "+file+": error reading block data.");
+	buf->resize(n*cols.size());
+	boost::iostreams::filtering_istream zs;
+	zs.push(boost::iostreams::zlib_decompressor());
+	zs.push(boost::iostreams::array_source(z.data(),z.size()));
+	zs.read((char*)buf->data(),buf->size()*sizeof(Real));
+	if((size_t)zs.gcount()!=buf->size()*sizeof(Real)) throw std::runtime_error("SpillLog: "+file+": corrupted block data.");
+	return n;
+}
+
+void SpillLog::syncPsd(PsdHistogram& h, int dCol, int mCol) const {
+	const size_t n=nRows();
+	const size_t nc=cols.size();
+	// the last row might have been revoked and replaced; it can be checked only if it is in memory
+	const Vector3r last=(nTail()>0?Vector3r(tail[tail.size()-nc+dCol],tail[tail.size()-nc+mCol],0.):Vector3r(NaN,NaN,NaN));
+	auto same=[](Real a, Real b){ return a==b || (isnan(a) && isnan(b)); };
+	if(h.n>n || (h.n==n && nTail()>0 && !(same(h.last[0],last[0]) && same(h.last[1],last[1])))) h.clear();
+	if(h.n==n) return;
+	forEach([&h,dCol,mCol](const Real* r, size_t){ h.add(r[dCol],r[mCol]); },h.n);
+	h.n=n;
+	h.last=last;
+}
+
+vector<Vector2r> SpillLog::dmtPsd(const shared_ptr<SpillLog>& spill, const vector<Vector3r>& vec, PsdHistogram& hist, bool mass, bool cumulative, bool normalize, int num, const Vector2r& dRange, const Vector2r& tRange, bool emptyOk){
+	if(isnan(tRange.minCoeff())){
+		if(spill) spill->syncPsd(hist);
+		else hist.sync(vec);
+		return hist.psd(mass,cumulative,normalize,num,dRange,emptyOk);
+	}
+	auto tOk=[&tRange](const Real& t){ return tRange[0]<=t && t<tRange[1]; };
+	auto dGet=[&tOk](const Vector3r& dmt, const size_t& i)->Real{ return tOk(dmt[2])?dmt[0]:NaN; };
+	auto wGet=[&mass](const Vector3r& dmt, const size_t& i)->Real{ return mass?dmt[1]:1.; };
+	if(!spill) return DemFuncs::psdParallel(vec,cumulative,normalize,num,dRange,dGet,wGet,emptyOk);
+	return DemFuncs::psdForEach([&](auto f){ forEachDmt(spill,vec,f); },cumulative,normalize,num,dRange,dGet,wGet,emptyOk);
+}
+
+py::object SpillLog::dmtToPy(const shared_ptr<SpillLog>& spill, const vector<Vector3r>& vec, bool head2, bool zipped){
+	auto toPy=[&](const vector<Vector3r>& v)->py::object{
+		if(head2) return DemFuncs::seqVectorToPy(v,/*itemGetter*/[](const Vector3r& i)->Vector2r{ return i.head<2>(); },/*zip*/zipped);
+		return DemFuncs::seqVectorToPy(v,/*itemGetter*/[](const Vector3r& i)->Vector3r{ return i; },/*zip*/zipped);
+	};
+	if(!spill) return toPy(vec);
+	vector<Vector3r> all; all.reserve(spill->nRows());
+	forEachDmt(spill,vec,[&all](const Vector3r& i, size_t){ all.push_back(i); });
+	return toPy(all);
+}
+
+int SpillLog::colIndex(const py::object& col) const {
+	py::extract<int> ix(col);
+	if(ix.check()){
+		int i=ix();
+		if(i<0 || i>=(int)cols.size()) woo::IndexError("SpillLog: column index "+to_string(i)+" out of range 0.."+to_string(cols.size()-1)+".");
+		return i;
+	}
+	py::extract<string> name(col);
+	if(!name.check()) woo::TypeError("SpillLog: column must be given as int or str.");
+	auto I=std::find(cols.begin(),cols.end(),name());
+	if(I==cols.end()) woo::KeyError("SpillLog: no column named '"+name()+"' (columns are: "+boost::algorithm::join(cols,", ")+").");
+	return I-cols.begin();
+}
+
+vector<Real> SpillLog::pyColumn(const py::object& col) const {
+	const int c=colIndex(col);
+	vector<Real> ret; ret.reserve(nRows());
+	forEach([&ret,c](const Real* r, size_t){ ret.push_back(r[c]); });
+	return ret;
+}
+
+py::tuple SpillLog::pyColStats(const py::object& col, const Vector2r& tRange, const py::object& tCol) const {
+	const int c=colIndex(col);
+	const bool allT=isnan(tRange.minCoeff());
+	const int t=(allT?-1:colIndex(tCol));
+	long num=0; Real sum=0., min=Inf, max=-Inf;
+	forEach([&](const Real* r, size_t){
+		if(!allT && !(tRange[0]<=r[t] && r[t]<tRange[1])) return;
+		const Real& v=r[c];
+		if(isnan(v)) return;
+		num++; sum+=v;
+		if(v<min) min=v;
+		if(v>max) max=v;
+	});
+	if(num==0) min=max=NaN;
+	return py::make_tuple(num,sum,min,max);
+}
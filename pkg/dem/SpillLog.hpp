@@ -0,0 +1,95 @@
+#pragma once
+#include<woo/lib/object/Object.hpp>
+#include<woo/pkg/dem/Funcs.hpp>
+#include<fstream>
+
+/*
+Append-only log of fixed-width rows of numbers, with bounded memory: rows are kept in memory (tail) until there is maxTail of them, then the tail is compressed and appended to file as one block.
+
+File format (native byte order): 8-byte magic "WooSpill", int32 number of columns, then blocks of uint64 number of rows, uint64 compressed size and zlib-compressed rows (doubles). The object only stores name of the file, number of rows and the file size at the moment it was saved; when loaded, data written to the file later (e.g. by the simulation which continued after saving) are discarded on the next spill.
+*/
+struct SpillLog: public Object{
+	WOO_DECL_LOGGER;
+	~SpillLog();
+	// register file as used by this log; give a copy its own file, so that two logs don't write into the same one
+	void postLoad(SpillLog&, void* attr);
+	// set column names, or check that they match
+	void setCols(const vector<string>& names);
+	size_t nRows() const { return nSpilled+nTail(); }
+	size_t nTail() const { return cols.empty()?0:tail.size()/cols.size(); }
+	// add one row; spill the tail first if it is full (so that the last row is always in memory and can be revoked)
+	void append(const vector<Real>& row);
+	// remove the last row (which is in memory right after append, unless spill was called explicitly)
+	void popLast();
+	// write the tail to the file
+	void spill();
+	void clear();
+	// traverse rows with index >= from, calling f(const Real* row, size_t index); spilled rows are read block by block
+	template<class F> void forEach(F f, size_t from=0) const;
+	// add rows not yet in the histogram, with diameter and mass in given columns; rebuild it if rows were removed or changed
+	void syncPsd(PsdHistogram& h, int dCol=0, int mCol=1) const;
+
+	// traverse (diameter, mass, time) items stored either in the first 3 columns of spill (if given), or in vec
+	template<class F> static void forEachDmt(const shared_ptr<SpillLog>& spill, const vector<Vector3r>& vec, F f){
+		if(spill) spill->forEach([&f](const Real* r, size_t i){ f(Vector3r(r[0],r[1],r[2]),i); });
+		else for(size_t i=0; i<vec.size(); i++) f(vec[i],i);
+	}
+
+	// PSD of (diameter, mass, time) items in spill or vec (as forEachDmt), optionally restricted to tRange; without tRange, hist is updated and used
+	static vector<Vector2r> dmtPsd(const shared_ptr<SpillLog>& spill, const vector<Vector3r>& vec, PsdHistogram& hist, bool mass, bool cumulative, bool normalize, int num, const Vector2r& dRange, const Vector2r& tRange, bool emptyOk=false);
+	// return all (diameter, mass, time) items as python sequence(s), like DemFuncs::seqVectorToPy; with head2, only diameter and mass
+	static py::object dmtToPy(const shared_ptr<SpillLog>& spill, const vector<Vector3r>& vec, bool head2, bool zipped);
+
+	// python
+	int colIndex(const py::object& col) const;
+	vector<Real> pyColumn(const py::object& col) const;
+	py::tuple pyColStats(const py::object& col, const Vector2r& tRange, const py::object& tCol) const;
+	private:
+		// read block header; fill buf with decompressed rows, or skip over data if buf is nullptr; return number of rows
+		size_t readBlock(std::istream& in, vector<Real>* buf) const;
+		void openRead(std::ifstream& in) const;
+		// move rows of the last block from file back to memory, truncating the file
+		void unspillLast();
+		// file under which this log is registered as live
+		string liveFile;
+	public:
+	#define woo_dem_SpillLog__CLASS_BASE_DOC_ATTRS_PY \
+		SpillLog,Object,"Append-only log of data rows (such as diameter, mass and time of particles leaving an :obj:`Outlet`), with bounded memory: up to :obj:`maxTail` rows are kept in memory, then they are compressed and appended to :obj:`file`. Only the file name, number of rows and file size are saved with the simulation (plus the rows in memory), so that saved simulations stay small; the file must be kept along with it. When a saved simulation is loaded and continues running, data written to the file after it was saved are discarded.\n\nQueries (:obj:`column`, :obj:`colStats` and those of the owner, such as :obj:`Outlet.psd`) read the file block by block.", \
+		((string,file,"",AttrTrait<Attr::filename|Attr::triggerPostLoad>(),"File where rows are spilled; must be set (unless :obj:`maxTail` is 0) before the log is used by its owner, and must not be changed afterwards. When the log is copied (e.g. with :obj:`woo.core.Object.deepcopy`), or loaded while the log it was saved from still exists in this process, the copy continues in a copy of the file, named ``file.copy1`` (or the next free number), so that the two logs don't overwrite each other's data.")) \
+		((vector<string>,cols,,AttrTrait<Attr::readonly>(),"Column names, set by the owner.")) \
+		((long,maxTail,100000,,"Number of rows kept in memory before they are written to :obj:`file`; 0 keeps all rows in memory (only spilled with :obj:`spill`).")) \
+		((int,level,1,AttrTrait<>().range(Vector2i(0,9)),"zlib compression level (0 = none, 9 = best).")) \
+		((long,nSpilled,0,AttrTrait<Attr::readonly>(),"Number of rows in :obj:`file`.")) \
+		((long,offset,0,AttrTrait<Attr::readonly>().noGui(),"Size of :obj:`file` in bytes, after the last spill.")) \
+		((vector<Real>,tail,,AttrTrait<Attr::readonly>().noGui(),"Rows in memory, concatenated; saved with the simulation, as they are not in :obj:`file`.")) \
+		,/*py*/ \
+			.add_property_readonly("nRows",&SpillLog::nRows,"Total number of rows, in :obj:`file` and in memory.") \
+			.def("column",&SpillLog::pyColumn,WOO_PY_ARGS(py::arg("col")),"Return all values of column *col* (given as index or name) as list.") \
+			.def("colStats",&SpillLog::pyColStats,WOO_PY_ARGS(py::arg("col"),py::arg("tRange")=Vector2r(NaN,NaN),py::arg("tCol")="time"),"Return (count, sum, min, max) of non-NaN values of column *col* in rows where column *tCol* is inside *tRange* (half-open interval; all rows if NaN).") \
+			.def("spill",&SpillLog::spill,"Write rows in memory to :obj:`file` now.") \
+			.def("clear",&SpillLog::clear,"Remove all rows; the file is truncated on the next spill.")
+	WOO_DECL__CLASS_BASE_DOC_ATTRS_PY(woo_dem_SpillLog__CLASS_BASE_DOC_ATTRS_PY);
+};
+WOO_REGISTER_OBJECT(SpillLog);
+
+template<class F> void SpillLog::forEach(F f, size_t from) const {
+	size_t i=0;
+	if(nSpilled>0 && from<(size_t)nSpilled){
+		std::ifstream in; openRead(in);
+		vector<Real> buf;
+		const size_t nc=cols.size();
+		while(i<(size_t)nSpilled && in.tellg()<offset){
+			// peek at the number of rows, skip the whole block if not needed
+			auto pos=in.tellg();
+			uint64_t n; in.read((char*)&n,sizeof(n));
+			in.seekg(pos);
+			if(i+n<=from){ readBlock(in,nullptr); i+=n; continue; }
+			readBlock(in,&buf);
+			for(size_t j=0; j<n; j++,i++){ if(i>=from) f(&buf[j*nc],i); }
+		}
+		if(i!=(size_t)nSpilled) throw std::runtime_error("SpillLog: "+file+": only "+to_string(i)+" rows found, "+to_string(nSpilled)+" expected.");
+	}
+	i=nSpilled;
+	const size_t nc=cols.size(), nt=nTail();
+	for(size_t j=0; j<nt; j++,i++){ if(i>=from) f(&tail[j*nc],i); }
+}
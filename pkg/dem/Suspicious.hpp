@@ -10,7 +10,7 @@ struct Suspicious: public PeriodicEngine {
 		std::mutex errMutex; // guard errPar and errCon while the engine is active
 	#endif
 	#define woo_dem_Suspicious__CLASS_BASE_DOC_ATTRS \
-		Suspicious,PeriodicEngine,"Watch the simulation and signal suspicious evolutions, such as sudden increase in contact force beyond usual measure or unsual velocity.", \
+		Suspicious,PeriodicEngine,"Watch the simulation and signal suspicious evolutions, such as sudden increase in contact force beyond usual measure or unsual velocity. For monitoring nodal quantities without stopping the simulation, see :obj:`NodeStats` with the ``relMax`` :obj:`~NodeStat.trigger`.", \
 			((Real,avgVel,NaN,AttrTrait<Attr::readonly>(),"Average velocity norm.")) \
 			((Real,avgForce,NaN,AttrTrait<Attr::readonly>(),"Average particle force norm.")) \
 			((Real,avgFn,NaN,AttrTrait<Attr::readonly>(),"Average normal force norm.")) \
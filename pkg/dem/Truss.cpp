@@ -91,8 +91,8 @@ void In2_Truss_ElastMat::go(const shared_ptr<Shape>& shape, const shared_ptr<Mat
 	// cerr<<"AB="<<AB<<", len="<<len<<", natStrain="<<natStrain<<", l0="<<t.l0<<", E="<<mat->cast<ElastMat>().young<<", Fn="<<Fn<<endl;
 
 	// apply nodal forces
-	t.nodes[0]->getData<DemData>().addForceTorque(Fa);
-	t.nodes[1]->getData<DemData>().addForceTorque(Fb);
+	addNodalForceTorque(t.nodes[0]->getData<DemData>(),Fa);
+	addNodalForceTorque(t.nodes[1]->getData<DemData>(),Fb);
 };
 
 void In2_Truss_ElastMat::addIntraStiffnesses(const shared_ptr<Particle>& p, const shared_ptr<Node>&, Vector3r& ktrans, Vector3r& krot) const {
@@ -188,8 +188,8 @@ void Gl1_Rod::go(const shared_ptr<Shape>& shape, const Vector3r& shift, bool wir
 			glTranslatev(glVertices[end]);
 			// do not use stack value here, that is for cylinder length subdivision
 			// TODO: only render half of the sphere
-			if(wire||wire2) glutWireSphere(t.radius,slices,slices/3);
-			else glutSolidSphere(t.radius,slices,slices/3);
+			if(wire||wire2) GLUtils::Sphere(t.radius,slices,slices/3,/*wire*/true);
+			else GLUtils::Sphere(t.radius,slices,slices/3);
 		glPopMatrix();
 	}
 }
@@ -38,7 +38,7 @@ void In2_Wall_ElastMat::go(const shared_ptr<Shape>& sh, const shared_ptr<Materia
 		const shared_ptr<Contact>& C(pC.second); if(!C->isReal()) continue;
 		Vector3r F,T,xc;
 		std::tie(F,T,xc)=C->getForceTorqueBranch(particle,/*nodeI*/0,scene);
-		sh->nodes[0]->getData<DemData>().addForceTorque(F,/*discard any torque on wall*/Vector3r::Zero());
+		addNodalForceTorque(sh->nodes[0]->getData<DemData>(),F,/*discard any torque on wall*/Vector3r::Zero());
 	}
 }
 
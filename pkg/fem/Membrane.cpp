@@ -6,15 +6,14 @@ WOO_IMPL__CLASS_BASE_DOC_ATTRS_CTOR_PY(woo_dem_Membrane__CLASS_BASE_DOC_ATTRS_CT
 WOO_IMPL__CLASS_BASE_DOC_ATTRS(woo_dem_In2_Membrane_ElastMat__CLASS_BASE_DOC_ATTRS);
 WOO_IMPL__CLASS_BASE_DOC(woo_dem_In2_Membrane_FrictMat__CLASS_BASE_DOC);
 
-
-// this should go to some shared header
-typedef Eigen::Matrix<Real,9,1> Vector9r;
-
 WOO_IMPL_LOGGER(Membrane);
 
-#define MEMBRANE_CONDENSE_DKT
-
-
+void Membrane::postLoad(Membrane&,void* attr){
+	if(attr!=NULL) return;
+	// matrices of unexpected shape (such as uncondensed KKdkt saved by a build without MEMBRANE_CONDENSE_DKT) are assembled again
+	if(KKcst.size()>0 && !hasCst()){ LOG_INFO("{}: KKcst has shape {}×{}, will be re-assembled.",pyStr(),KKcst.rows(),KKcst.cols()); KKcst.resize(0,0); }
+	if(KKdkt.size()>0 && !hasBending()){ LOG_INFO("{}: KKdkt has shape {}×{}, will be re-assembled.",pyStr(),KKdkt.rows(),KKdkt.cols()); KKdkt.resize(0,0); DBdkt.resize(0,0); }
+}
 
 
 void Membrane::stepUpdate(Real dt, bool rotIncr){
@@ -72,13 +71,7 @@ void Membrane::setRefConf(){
 void Membrane::ensureStiffnessMatrices(const Real& young, const Real& nu, const Real& thickness,bool bending, const Real& bendThickness){
 	assert(hasRefConf());
 	// do nothing if both matrices exist already
-	if(KKcst.size()==36 && (!bending ||
-		#ifdef MEMBRANE_CONDENSE_DKT		
-			KKdkt.size()==54
-		#else 
-			KKdkt.size()==81
-		#endif
-	)) return; 
+	if(hasCst() && (!bending || hasBending())) return;
 	// check thickness
 	Real t=(isnan(thickness)?2*this->halfThick:thickness);
 	if(/*also covers NaN*/!(t>0)) throw std::runtime_error("Membrane::ensureStiffnessMatrices: Facet thickness is not positive!");
@@ -89,7 +82,8 @@ void Membrane::ensureStiffnessMatrices(const Real& young, const Real& nu, const
 	E*=young/(1-pow2(nu));
 
 	// strain-displacement matrix (CCT element)
-	Real area=this->getArea();
+	// area of the reference configuration, which the matrices are assembled from (the current one may be deformed already)
+	Real area=.5*abs((refPos[2]-refPos[0])*(refPos[5]-refPos[1])-(refPos[4]-refPos[0])*(refPos[3]-refPos[1]));
 	const Real& x1(refPos[0]); const Real& y1(refPos[1]); const Real& x2(refPos[2]); const Real& y2(refPos[3]); const Real& x3(refPos[4]); const Real& y3(refPos[5]);
 
 	// Felippa: Introduction to FEM eq. (15.17), pg. 259
@@ -239,7 +233,7 @@ void Membrane::ensureStiffnessMatrices(const Real& young, const Real& nu, const
 			DBdkt.setZero(3,6);
 			for(int i:{0,1,2}){
 				DBdkt.col(2*i)  =DBdkt0.col(3*i+1);
-				DBdkt.col(2*1+1)=DBdkt0.col(3*i+2);
+				DBdkt.col(2*i+1)=DBdkt0.col(3*i+2);
 			}
 		}
 	#endif
@@ -277,8 +271,8 @@ void Membrane::addIntraStiffnesses(const shared_ptr<Node>& n,Vector3r& ktrans, V
 	int i=-1;
 	for(int j=0; j<3; j++){ if(nodes[j].get()==n.get()){ i=j; break; }}
 	if(i<0) throw std::logic_error("Membrane::addIntraStiffness:: node "+n->pyStr()+" not found within nodes of "+this->pyStr()+".");
-	if(KKcst.size()==0) return;
-	bool dkt=(KKdkt.size()>0);
+	if(!hasCst()) return;
+	bool dkt=hasBending();
 	// local translational stiffness diagonal
 	Vector3r ktl(KKcst(2*i,2*i),KKcst(2*i+1,2*i+1),dkt?abs(KKdkt(3*i)):0);
 	ktrans+=node->ori*ktl;
@@ -385,21 +379,18 @@ void In2_Membrane_ElastMat::go(const shared_ptr<Shape>& sh, const shared_ptr<Mat
 	ff.stepUpdate(scene->dt,rotIncr);
 	// assemble local stiffness matrix, in case it does not exist yet
 	ff.ensureStiffnessMatrices(particle->material->cast<ElastMat>().young,nu,thickness,/*bending*/bending,bendThickness);
-	// compute nodal forces response here
+	// compute nodal forces response here; products are fixed-size, so they are unrolled and vectorized
 	// ?? CST forces are applied with the - sign, DKT with the + sign; are uXy/phiXy introduced differently?
-	Vector6r Fcst=-(ff.KKcst*ff.uXy).transpose();
-
+	const Vector6r Fcst=-ff.KKcstFixed()*ff.uXy;
 
 	Vector9r Fdkt;
 	if(bending){
 		#ifdef MEMBRANE_CONDENSE_DKT
-			assert(ff.KKdkt.size()==54);
-			Fdkt=(ff.KKdkt*ff.phiXy).transpose();
+			Fdkt.noalias()=ff.KKdktFixed()*ff.phiXy;
 		#else
-			assert(ff.KKdkt.size()==81);
 			Vector9r uDkt_;
 			uDkt_<<0,ff.phiXy.segment<2>(0),0,ff.phiXy.segment<2>(2),0,ff.phiXy.segment<2>(4);
-			Fdkt=(ff.KKdkt*uDkt_).transpose();
+			Fdkt.noalias()=ff.KKdktFixed()*uDkt_;
 			#ifdef MEMBRANE_DEBUG_ROT
 				ff.uDkt=uDkt_; // debugging copy, acessible from python
 			#endif
@@ -412,13 +403,14 @@ void In2_Membrane_ElastMat::go(const shared_ptr<Shape>& sh, const shared_ptr<Mat
 	// surface load, if any
 	Real surfLoadForce=0.;
 	if(!isnan(ff.surfLoad) && ff.surfLoad!=0.){ surfLoadForce=(1/3.)*ff.getArea()*ff.surfLoad; }
-	// apply nodal forces
+	// apply nodal forces; rotate all of them with one matrix
+	const Matrix3r R=ff.node->ori.toRotationMatrix();
 	for(int i:{0,1,2}){
 		Vector3r Fl=Vector3r(Fcst[2*i],Fcst[2*i+1],Fdkt[3*i]+surfLoadForce);
 		Vector3r Tl=Vector3r(Fdkt[3*i+1],Fdkt[3*i+2],0);
-		ff.nodes[i]->getData<DemData>().addForceTorque(ff.node->ori*Fl,ff.node->ori*Tl);
-		LOG_TRACE("  {} F: {} \t| {}",i,Fl.transpose(),ff.node->ori*Fl);
-		LOG_TRACE("  {} T: {} \t| {}",i,Tl.transpose(),ff.node->ori*Tl);
+		addNodalForceTorque(ff.nodes[i]->getData<DemData>(),R*Fl,R*Tl);
+		LOG_TRACE("  {} F: {} \t| {}",i,Fl.transpose(),R*Fl);
+		LOG_TRACE("  {} T: {} \t| {}",i,Tl.transpose(),R*Tl);
 	}
 }
 
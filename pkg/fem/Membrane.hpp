@@ -3,9 +3,24 @@
 #include<woo/pkg/dem/FrictMat.hpp>
 
 // #define MEMBRANE_DEBUG_ROT
+// condense z-displacements away from the DKT stiffness matrix (9×6 rather than 9×9)
+#define MEMBRANE_CONDENSE_DKT
+
+typedef Eigen::Matrix<Real,9,1> Vector9r;
+#ifdef MEMBRANE_CONDENSE_DKT
+	typedef Eigen::Matrix<Real,9,6> MatrixKKdkt;
+#else
+	typedef Eigen::Matrix<Real,9,9> MatrixKKdkt;
+#endif
+
 struct Membrane: public Facet{
 	bool hasRefConf() const { return node && refRot.size()==3; }
-	bool hasBending(){ return KKdkt.size()>0; }
+	bool hasCst() const { return KKcst.rows()==6 && KKcst.cols()==6; }
+	bool hasBending() const { return KKdkt.rows()==MatrixKKdkt::RowsAtCompileTime && KKdkt.cols()==MatrixKKdkt::ColsAtCompileTime; }
+	// fixed-size views of stiffness matrices (stored with dynamic size), so that products are unrolled
+	Eigen::Map<const Matrix6r> KKcstFixed() const { assert(hasCst()); return Eigen::Map<const Matrix6r>(KKcst.data()); }
+	Eigen::Map<const MatrixKKdkt> KKdktFixed() const { assert(hasBending()); return Eigen::Map<const MatrixKKdkt>(KKdkt.data()); }
+	void postLoad(Membrane&,void*);
 	void pyReset(){ refRot.clear(); }
 	void setRefConf(); // use the current configuration as the referential one
 	void ensureStiffnessMatrices(const Real& young, const Real& nu, const Real& thickness, bool bending, const Real& bendThickness);
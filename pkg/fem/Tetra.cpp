@@ -130,6 +130,8 @@ void Tet4::setRefConf(){
 	}
 	// set displacements to zero
 	uXyz=VectorXr::Zero(12);
+	// stiffness depends on the reference configuration
+	KK.resize(0,0); EB.resize(0,0);
 }
 
 
@@ -178,9 +180,11 @@ void Tet4::computeCorotatedFrame(){
 
 
 void Tet4::ensureStiffnessMatrix(Real young, Real nu){
-	if(KK.rows()==12 && KK.cols()==12) return;
+	if(!hasRefConf()) setRefConf();
+	if(hasStiffness()) return;
 	// Felippa:: The Linear Tetrahedron
-	const Vector3r& p1(nodes[0]->pos); const Vector3r& p2(nodes[1]->pos); const Vector3r& p3(nodes[2]->pos); const Vector3r& p4(nodes[3]->pos);
+	// use the reference configuration (local coordinates differ from global ones only by translation), not the current one which may be deformed already
+	const Vector3r p1(refPos.col(0)), p2(refPos.col(1)), p3(refPos.col(2)), p4(refPos.col(3));
 	#define _x(i,j) (p##i.x()-p##j.x())
 	#define _y(i,j) (p##i.y()-p##j.y())
 	#define _z(i,j) (p##i.z()-p##j.z())
@@ -211,7 +215,7 @@ void Tet4::ensureStiffnessMatrix(Real young, Real nu){
 	Eigen::Matrix<Real,6,12> B; B<<
 		bHi(0),bHi(1),bHi(2),bHi(3),
 		bLo(0),bLo(1),bLo(2),bLo(3);
-	Real V=getVolume();
+	Real V=(1/6.)*(p2-p1).cross(p3-p1).dot(p4-p1);
 	B*=1./(6*V);
 	// (9.38)
 	Real e=young/((1+nu)*(1-2*nu));
@@ -228,7 +232,12 @@ void Tet4::ensureStiffnessMatrix(Real young, Real nu){
 
 Matrix3r Tet4::getStressTensor() const {
 	if(EB.size()!=72) return Matrix3r::Zero();
-	Matrix3r sigL((EB*uXyz).block<3,3>(0,0));
+	// stress in Voigt notation, ordered as rows of B: xx, yy, zz, xy, yz, zx
+	const Vector6r s=Eigen::Map<const Eigen::Matrix<Real,6,12>>(EB.data())*uXyzFixed();
+	Matrix3r sigL; sigL<<
+		s[0],s[3],s[5],
+		s[3],s[1],s[4],
+		s[5],s[4],s[2];
 	Matrix3r r=node->ori.toRotationMatrix();
 	return r*sigL*r.transpose();
 }
@@ -239,7 +248,7 @@ void Tet4::addIntraStiffnesses(const shared_ptr<Node>& n,Vector3r& ktrans, Vecto
 	int i=-1;
 	for(int j:{0,1,2,3}){ if(nodes[j].get()==n.get()){ i=j; break; }}
 	if(i<0) throw std::logic_error("Tet4::addIntraStiffness:: node "+n->pyStr()+" not found within nodes of "+this->pyStr()+".");
-	if(KK.size()==0) return;
+	if(!hasStiffness()) return;
 	// add translational DoFs corresponding to this node
 	ktrans+=node->ori*(KK.diagonal().segment<3>(3*i));
 	// krot untouched
@@ -260,11 +269,12 @@ void In2_Tet4_ElastMat::go(const shared_ptr<Shape>& sh, const shared_ptr<Materia
 	}
 	t.stepUpdate();
 	t.ensureStiffnessMatrix(particle->material->cast<ElastMat>().young,nu);
-	typedef Eigen::Matrix<Real,12,1> Vector12r;
-	Vector12r F=t.KK*t.uXyz;
+	// fixed-size product, unrolled and vectorized
+	Vector12r F; F.noalias()=t.KKFixed()*t.uXyzFixed();
+	const Matrix3r R=t.node->ori.toRotationMatrix();
 	for(int i:{0,1,2,3}){
 		Vector3r f=-F.segment<3>(3*i); // negative: displacements opposite convention?!
-		t.nodes[i]->getData<DemData>().addForceTorque(t.node->ori*f,Vector3r::Zero());
+		addNodalForceTorque(t.nodes[i]->getData<DemData>(),R*f);
 	}
 }
 
@@ -48,8 +48,15 @@ struct Tetra: public Shape {
 };
 WOO_REGISTER_OBJECT(Tetra);
 
+typedef Eigen::Matrix<Real,12,1> Vector12r;
+typedef Eigen::Matrix<Real,12,12> Matrix12r;
+
 struct Tet4: public Tetra{
 	bool hasRefConf() const { return node && refPos.cols()==4 && refPos.rows()==3; }
+	bool hasStiffness() const { return KK.rows()==12 && KK.cols()==12; }
+	// fixed-size views of the stiffness matrix and displacements (stored with dynamic size), so that products are unrolled
+	Eigen::Map<const Matrix12r> KKFixed() const { assert(hasStiffness()); return Eigen::Map<const Matrix12r>(KK.data()); }
+	Eigen::Map<const Vector12r> uXyzFixed() const { assert(uXyz.size()==12); return Eigen::Map<const Vector12r>(uXyz.data()); }
 	void pyReset(){ node.reset(); refPos=MatrixXr(); }
 	void setRefConf();
 	void stepUpdate();
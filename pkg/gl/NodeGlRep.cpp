@@ -48,7 +48,7 @@ void ScalarGlRep::render(const shared_ptr<Node>& node, const GLViewInfo* viewInf
 			glColor3v(color);
 			glPushMatrix();
 				glTranslatev(pos);
-				glutSolidSphere(relSz*viewInfo->sceneRadius,6,12);
+				GLUtils::Sphere(relSz*viewInfo->sceneRadius,6,12);
 			glPopMatrix();
 		}
 	};
@@ -0,0 +1,241 @@
+#if defined(WOO_OPENGL) && defined(WOO_EGL)
+#include<woo/pkg/gl/OffscreenSnapshot.hpp>
+#include<woo/pkg/gl/Renderer.hpp>
+#include<woo/lib/opengl/OpenGLWrapper.hpp>
+#include<woo/core/Scene.hpp>
+#include<woo/core/Field.hpp>
+#include<woo/core/Master.hpp>
+
+#include<GL/glu.h>
+#include<EGL/egl.h>
+#include<EGL/eglext.h>
+
+#include<boost/iostreams/filtering_stream.hpp>
+#include<boost/iostreams/filter/zlib.hpp>
+#include<boost/iostreams/device/back_inserter.hpp>
+#include<boost/crc.hpp>
+
+#include<thread>
+#include<deque>
+#include<map>
+#include<fstream>
+#include<cstring>
+
+WOO_PLUGIN(gl,(OffscreenSnapshot));
+WOO_IMPL__CLASS_BASE_DOC_ATTRS_PY(woo_gl_OffscreenSnapshot__CLASS_BASE_DOC_ATTRS_PY);
+WOO_IMPL_LOGGER(OffscreenSnapshot);
+
+namespace{
+	// write 8-bit RGBA pixels (rows bottom-up, as returned by glReadPixels) as PNG; zlib and crc32 come from boost
+	void writePng(const string& out, int w, int h, const vector<unsigned char>& rgba, int level){
+		// scanlines top-down, each prefixed by filter type (0=none)
+		vector<char> raw; raw.reserve(h*(4*w+1));
+		for(int y=h-1; y>=0; y--){ raw.push_back(0); raw.insert(raw.end(),rgba.begin()+4*w*y,rgba.begin()+4*w*(y+1)); }
+		vector<char> z;
+		{
+			boost::iostreams::filtering_ostream zs;
+			zs.push(boost::iostreams::zlib_compressor(boost::iostreams::zlib_params(level)));
+			zs.push(boost::iostreams::back_inserter(z));
+			zs.write(raw.data(),raw.size());
+		} // flushed when destroyed
+		std::ofstream f(out,std::ios::binary);
+		if(!f.good()) throw std::runtime_error("Unable to open "+out+" for writing.");
+		auto be32=[](uint32_t i, char* b){ b[0]=(char)(i>>24); b[1]=(char)(i>>16); b[2]=(char)(i>>8); b[3]=(char)i; };
+		auto chunk=[&](const char* type, const char* data, size_t len){
+			char b[4];
+			be32(len,b); f.write(b,4);
+			f.write(type,4); f.write(data,len);
+			boost::crc_32_type crc; crc.process_bytes(type,4); crc.process_bytes(data,len);
+			be32(crc.checksum(),b); f.write(b,4);
+		};
+		f.write("\x89PNG\r\n\x1a\n",8);
+		char ihdr[13];
+		be32(w,ihdr); be32(h,ihdr+4);
+		ihdr[8]=8; /* bit depth */ ihdr[9]=6; /* RGBA */ ihdr[10]=ihdr[11]=ihdr[12]=0; /* compression, filter, interlace */
+		chunk("IHDR",ihdr,13);
+		chunk("IDAT",z.data(),z.size());
+		chunk("IEND","",0);
+		if(!f.good()) throw std::runtime_error("Error writing "+out+".");
+	}
+}
+
+struct OffscreenSnapshot::Impl{
+	struct Frame{ string file; int w, h, level; vector<unsigned char> px; };
+	EGLDisplay dpy=EGL_NO_DISPLAY;
+	EGLConfig cfg;
+	EGLContext ctx=EGL_NO_CONTEXT;
+	EGLSurface surf=EGL_NO_SURFACE;
+	Vector2i surfSize=Vector2i::Zero();
+	// writer thread, same scheme as PyHookQueue
+	std::mutex mutex;
+	std::condition_variable cvItems, cvIdle;
+	std::deque<Frame> frames;
+	bool busy=false, stop=false;
+	string error;
+	std::thread writer;
+
+	static std::mutex dpyRefsMutex;
+	static std::map<EGLDisplay,int> dpyRefs;
+
+	Impl(){ writer=std::thread(&Impl::loop,this); }
+	~Impl(){
+		{ std::scoped_lock<std::mutex> l(mutex); stop=true; }
+		cvItems.notify_all();
+		writer.join(); // pending frames are written before the thread exits
+		if(dpy==EGL_NO_DISPLAY) return;
+		if(surf!=EGL_NO_SURFACE) eglDestroySurface(dpy,surf);
+		if(ctx!=EGL_NO_CONTEXT) eglDestroyContext(dpy,ctx);
+		// displays are per-process and eglInitialize is not reference-counted: terminate when the last user is gone
+		std::scoped_lock<std::mutex> l(dpyRefsMutex);
+		if(--dpyRefs[dpy]==0){ dpyRefs.erase(dpy); eglTerminate(dpy); }
+	}
+	void initDisplay(){
+		const char* ext=eglQueryString(EGL_NO_DISPLAY,EGL_EXTENSIONS);
+		#ifdef EGL_PLATFORM_SURFACELESS_MESA
+			// Mesa's default display needs X or wayland; the surfaceless platform needs nothing (llvmpipe without GPU)
+			if(ext && strstr(ext,"EGL_MESA_platform_surfaceless")){
+				auto getPlatformDisplay=(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+				if(getPlatformDisplay) dpy=getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,EGL_DEFAULT_DISPLAY,NULL);
+			}
+		#endif
+		if(dpy==EGL_NO_DISPLAY) dpy=eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		EGLint major, minor;
+		if(dpy==EGL_NO_DISPLAY || !eglInitialize(dpy,&major,&minor)){ dpy=EGL_NO_DISPLAY; throw std::runtime_error(fmt::format("OffscreenSnapshot: unable to initialize EGL display (error {:#x}).",eglGetError())); }
+		{ std::scoped_lock<std::mutex> l(dpyRefsMutex); dpyRefs[dpy]++; }
+		const EGLint cfgAttr[]={EGL_SURFACE_TYPE,EGL_PBUFFER_BIT,EGL_RED_SIZE,8,EGL_GREEN_SIZE,8,EGL_BLUE_SIZE,8,EGL_ALPHA_SIZE,8,EGL_DEPTH_SIZE,24,EGL_RENDERABLE_TYPE,EGL_OPENGL_BIT,EGL_NONE};
+		EGLint nCfg=0;
+		if(!eglChooseConfig(dpy,cfgAttr,&cfg,1,&nCfg) || nCfg<1) throw std::runtime_error("OffscreenSnapshot: no EGL config with RGBA8 pbuffer and 24-bit depth for desktop OpenGL (EGL "+to_string(major)+"."+to_string(minor)+", "+eglQueryString(dpy,EGL_VENDOR)+").");
+		// compatibility profile, since the renderer uses the fixed pipeline
+		if(!eglBindAPI(EGL_OPENGL_API)) throw std::runtime_error("OffscreenSnapshot: desktop OpenGL not supported by EGL.");
+		ctx=eglCreateContext(dpy,cfg,EGL_NO_CONTEXT,NULL);
+		if(ctx==EGL_NO_CONTEXT) throw std::runtime_error(fmt::format("OffscreenSnapshot: unable to create EGL context (error {:#x}).",eglGetError()));
+		LOG_INFO("EGL {}.{} ({}) initialized.",major,minor,eglQueryString(dpy,EGL_VENDOR));
+	}
+	void makeCurrent(const Vector2i& size){
+		if(dpy==EGL_NO_DISPLAY) initDisplay();
+		eglBindAPI(EGL_OPENGL_API); // the current API is per-thread
+		if(surf==EGL_NO_SURFACE || surfSize!=size){
+			if(surf!=EGL_NO_SURFACE){ eglMakeCurrent(dpy,EGL_NO_SURFACE,EGL_NO_SURFACE,EGL_NO_CONTEXT); eglDestroySurface(dpy,surf); }
+			const EGLint surfAttr[]={EGL_WIDTH,size[0],EGL_HEIGHT,size[1],EGL_NONE};
+			surf=eglCreatePbufferSurface(dpy,cfg,surfAttr);
+			if(surf==EGL_NO_SURFACE) throw std::runtime_error(fmt::format("OffscreenSnapshot: unable to create {}×{} pbuffer (error {:#x}).",size[0],size[1],eglGetError()));
+			surfSize=size;
+		}
+		if(!eglMakeCurrent(dpy,surf,surf,ctx)) throw std::runtime_error(fmt::format("OffscreenSnapshot: eglMakeCurrent failed (error {:#x}).",eglGetError()));
+	}
+	void doneCurrent(){ eglMakeCurrent(dpy,EGL_NO_SURFACE,EGL_NO_SURFACE,EGL_NO_CONTEXT); }
+	void rethrowError(std::unique_lock<std::mutex>&){
+		if(error.empty()) return;
+		string err; err.swap(error);
+		throw std::runtime_error("OffscreenSnapshot: "+err);
+	}
+	void push(Frame&& f, int maxQueue){
+		std::unique_lock<std::mutex> l(mutex);
+		rethrowError(l);
+		cvIdle.wait(l,[&]{ return (int)frames.size()<max(1,maxQueue); });
+		frames.push_back(std::move(f));
+		l.unlock();
+		cvItems.notify_one();
+	}
+	void wait(){
+		std::unique_lock<std::mutex> l(mutex);
+		cvIdle.wait(l,[this]{ return frames.empty() && !busy; });
+		rethrowError(l);
+	}
+	void loop(){
+		while(true){
+			Frame f;
+			{
+				std::unique_lock<std::mutex> l(mutex);
+				cvItems.wait(l,[this]{ return !frames.empty() || stop; });
+				if(frames.empty()) return; // stopping, and everything was written
+				f=std::move(frames.front()); frames.pop_front();
+				busy=true;
+			}
+			cvIdle.notify_all(); // room in the queue
+			try{
+				writePng(f.file,f.w,f.h,f.px,f.level);
+			} catch(std::exception& e){
+				LOG_ERROR("{}",e.what());
+				std::scoped_lock<std::mutex> l(mutex);
+				if(error.empty()) error=e.what();
+			}
+			{
+				std::scoped_lock<std::mutex> l(mutex);
+				busy=false;
+			}
+			cvIdle.notify_all();
+		}
+	}
+};
+
+std::mutex OffscreenSnapshot::Impl::dpyRefsMutex;
+std::map<EGLDisplay,int> OffscreenSnapshot::Impl::dpyRefs;
+
+void OffscreenSnapshot::flush(){ if(impl) impl->wait(); }
+
+void OffscreenSnapshot::run(){
+	if(size.minCoeff()<=0) throw std::runtime_error("OffscreenSnapshot.size: must be positive (not "+to_string(size[0])+"×"+to_string(size[1])+").");
+	if(!impl) impl=make_shared<Impl>();
+	const shared_ptr<Renderer> renderer=scene->ensureAndGetRenderer();
+	if(fileBase.empty()) fileBase=Master::instance().tmpFilename()+"/";
+	std::ostringstream fss; fss<<fileBase<<std::setw(5)<<std::setfill('0')<<counter++<<".png";
+	filesystem::path p(fss.str());
+	if(p.has_parent_path()) filesystem::create_directories(p.parent_path());
+
+	// camera, as GLViewer::centerScene does it
+	Vector3r c(center); Real r(radius);
+	if(isnan(c.maxCoeff()) || isnan(r)){
+		AlignedBox3r box;
+		if(!scene->boxHint.isEmpty()) box=scene->boxHint;
+		else {
+			for(const auto& f: scene->fields) box.extend(f->renderingBbox());
+			if(scene->isPeriodic){ for(int i: {0,1}) for(int j: {0,1}) for(int k: {0,1}) box.extend(scene->cell->hSize*Vector3r(i,j,k)); }
+			if(box.isEmpty()) box=AlignedBox3r(-Vector3r::Ones(),Vector3r::Ones());
+		}
+		if(isnan(c.maxCoeff())) c=box.center();
+		if(isnan(r)){ r=.5*box.sizes().maxCoeff(); if(!(r>0)) r=1; r*=1.5; }
+	}
+	Vector3r dir=(isnan(viewDir.maxCoeff())?renderer->iniViewDir:viewDir).normalized();
+	Vector3r upVec=(isnan(up.maxCoeff())?renderer->iniUp:up);
+	if(upVec.cross(dir).squaredNorm()<1e-12*upVec.squaredNorm()) upVec=dir.unitOrthogonal(); // up parallel with view direction
+	const Real aspect=size[0]*1./size[1];
+	// distance at which the sphere fits the smaller dimension; clipping planes as in QGLViewer
+	const Real dist=r/sin(.5*fov);
+	const Real zNear=max(dist-renderer->zClipCoeff*r,(ortho?-Inf:.005*renderer->zClipCoeff*r)), zFar=dist+renderer->zClipCoeff*r;
+	const Vector3r eye=c-dist*dir;
+
+	Impl::Frame frame{fss.str(),size[0],size[1],compression,vector<unsigned char>(4*size[0]*size[1])};
+	{
+		// the renderer is shared with 3d views, which render from the GUI thread
+		std::scoped_lock<std::mutex> lock(Master::instance().renderMutex);
+		impl->makeCurrent(size);
+		try{
+			glViewport(0,0,size[0],size[1]);
+			glMatrixMode(GL_PROJECTION); glLoadIdentity();
+			if(ortho){ Real hy=(aspect>=1?r:r/aspect), hx=hy*aspect; glOrtho(-hx,hx,-hy,hy,zNear,zFar); }
+			else gluPerspective((aspect>=1?fov:2*atan(tan(.5*fov)/aspect))*180./M_PI,aspect,zNear,zFar);
+			glMatrixMode(GL_MODELVIEW); glLoadIdentity();
+			gluLookAt(eye[0],eye[1],eye[2],c[0],c[1],c[2],upVec[0],upVec[1],upVec[2]);
+			glClearColor(renderer->bgColor[0],renderer->bgColor[1],renderer->bgColor[2],1.);
+			glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
+			glEnable(GL_DEPTH_TEST);
+
+			renderer->viewDirection=dir;
+			renderer->viewInfo.sceneCenter=c;
+			renderer->viewInfo.sceneRadius=r;
+			for(auto& rr: scene->autoRanges){ if(rr) rr->setUsed(false); }
+			renderer->render(static_pointer_cast<Scene>(scene->shared_from_this()),/*withNames*/false,/*fastDraw*/false);
+
+			glPixelStorei(GL_PACK_ALIGNMENT,1);
+			glReadPixels(0,0,size[0],size[1],GL_RGBA,GL_UNSIGNED_BYTE,frame.px.data());
+		} catch(...){ impl->doneCurrent(); throw; }
+		impl->doneCurrent();
+	}
+	LOG_DEBUG("Offscreen frame → {}",fss.str());
+	impl->push(std::move(frame),maxQueue);
+	snapshots.push_back(fss.str());
+	if(maxSnapshots>0 && (int)snapshots.size()>maxSnapshots) snapshots.erase(snapshots.begin(),snapshots.end()-maxSnapshots);
+}
+
+#endif /* WOO_OPENGL && WOO_EGL */
@@ -0,0 +1,40 @@
+#pragma once
+#if defined(WOO_OPENGL) && defined(WOO_EGL)
+
+#include<woo/core/Engine.hpp>
+
+/*
+Rendering without window and without X server: the EGL context renders into a pbuffer (Mesa's surfaceless platform
+with llvmpipe on display-less nodes, or the default EGL display elsewhere), pixels are read back in the simulation thread
+and handed over to a writer thread which encodes and writes PNG files, so that compression and I/O overlap the simulation.
+*/
+struct OffscreenSnapshot: public PeriodicEngine{
+	void run() override;
+	bool needsField() override { return false; }
+	// block until all queued frames are written; rethrow writer error, if any
+	void flush();
+	// EGL objects and the writer thread, created at the first run; not copied or saved
+	struct Impl;
+	shared_ptr<Impl> impl;
+	#define woo_gl_OffscreenSnapshot__CLASS_BASE_DOC_ATTRS_PY \
+		OffscreenSnapshot,PeriodicEngine,"Periodically render the scene (as set up by :obj:`Renderer`) into an offscreen buffer and save it as PNG; no 3d view (and no X server) is needed, which makes it suitable for batch runs on headless nodes with software rendering. Files are named :obj:`fileBase` + :obj:`counter` + ``.png`` (counter is left-padded by 0s, i.e. snap00004.png).\n\nThe camera looks at :obj:`center` from the :obj:`viewDir` direction; its distance is chosen so that the sphere with :obj:`radius` fits the image. Frames are rendered synchronously, but PNG encoding and writing is done in a separate thread; the simulation only waits when more than :obj:`maxQueue` frames are pending. Text (ids, numbers) is only rendered when a display is available, since GLUT requires it.", \
+		((string,fileBase,"",,"Basename for snapshots; if empty, temporary directory is used.")) \
+		((Vector2i,size,Vector2i(800,600),,"Image size in pixels (width, height).")) \
+		((Vector3r,center,Vector3r(NaN,NaN,NaN),AttrTrait<>().lenUnit().startGroup("Camera"),"Point the camera looks at; if NaN, center of :obj:`woo.core.Scene.boxHint` or of bounding box of all fields is used, re-computed at every snapshot.")) \
+		((Real,radius,NaN,AttrTrait<>().lenUnit(),"Radius of the scene sphere which should fit the image; if NaN, 1.5× half of the largest bounding box dimension is used (as when the 3d view is centered).")) \
+		((Vector3r,viewDir,Vector3r(NaN,NaN,NaN),,"View direction; if NaN, :obj:`Renderer.iniViewDir` is used.")) \
+		((Vector3r,up,Vector3r(NaN,NaN,NaN),,"Up vector; if NaN, :obj:`Renderer.iniUp` is used.")) \
+		((Real,fov,M_PI/4.,AttrTrait<>().angleUnit(),"Field of view (in the smaller image dimension) of perspective projection.")) \
+		((bool,ortho,false,,"Use orthographic projection instead of perspective.")) \
+		((int,counter,0,AttrTrait<Attr::readonly>().startGroup("Saved files"),"Number that will be appended to fileBase when the next snapshot is saved (incremented at every save).")) \
+		((vector<string>,snapshots,,AttrTrait<>().readonly().noGui(),"Files that have been created so far (some of them may be still waiting to be written, see :obj:`flush`); only the last :obj:`maxSnapshots` are kept.")) \
+		((int,maxSnapshots,1000,,"Maximum number of entries in :obj:`snapshots`; older entries are removed from the list (not from the disk). Non-positive value keeps all of them.")) \
+		((int,maxQueue,4,,"Maximum number of frames waiting to be written; when reached, the simulation is blocked until the writer thread catches up.")) \
+		((int,compression,1,AttrTrait<>().range(Vector2i(0,9)),"zlib compression level for PNG files (0 = none, 9 = best); low levels are much faster at the cost of slightly larger files.")) \
+		, /*py*/ .def("flush",&OffscreenSnapshot::flush,"Wait until all pending frames are written to disk.")
+	WOO_DECL__CLASS_BASE_DOC_ATTRS_PY(woo_gl_OffscreenSnapshot__CLASS_BASE_DOC_ATTRS_PY);
+	WOO_DECL_LOGGER;
+};
+WOO_REGISTER_OBJECT(OffscreenSnapshot);
+
+#endif
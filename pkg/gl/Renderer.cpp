@@ -72,12 +72,19 @@ void Renderer::init(const shared_ptr<Scene>& scene){
 
 	static bool glutInitDone=false;
 	if(!glutInitDone){
+		glutInitDone=true;
+		// freeglut terminates the process when it cannot connect to the display; offscreen (EGL) rendering on headless nodes
+		// therefore goes without GLUT, and only text is not rendered (geometry is drawn with GLU, see GLUtils)
+		#ifndef _WIN32
+			const char* disp=getenv("DISPLAY");
+			if(!disp || !disp[0]){ LOG_INFO("No DISPLAY, GLUT not initialized (text will not be rendered)."); return; }
+		#endif
 		char* argv[]={NULL};
 		int argc=0;
 		glutInit(&argc,argv);
 		//glutInitDisplayMode(GLUT_DOUBLE);
 		/* transparent spheres (still not working): glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH | GLUT_MULTISAMPLE | GLUT_ALPHA); glEnable(GL_BLEND); glBlendFunc(GL_SRC_ALPHA, GL_ONE); */
-		glutInitDone=true;
+		GLUtils::glutReady=true;
 	}
 }
 
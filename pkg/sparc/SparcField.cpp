@@ -4,6 +4,8 @@
 #include<woo/pkg/sparc/SparcField.hpp>
 
 #include<boost/preprocessor.hpp>
+#include<atomic>
+#include<exception>
 
 namespace bfs=filesystem;
 
@@ -13,27 +15,17 @@ WOO_PLUGIN(sparc,(SparcField)(SparcData)(ExplicitNodeIntegrator)(StaticEquilibri
 WOO_IMPL_LOGGER(SparcField);
 WOO_IMPL_LOGGER(ExplicitNodeIntegrator);
 
-void SparcField::constructLocator(){
-	locator=vtkPointLocator::New(); points=vtkPoints::New(); grid=vtkUnstructuredGrid::New(); grid->SetPoints(points); locator->SetDataSet(grid);
-}
-
 template<bool useNext>
 void SparcField::updateLocator(){
-	// FIXME: just for debugging, leaks memory by discarding old objects
-	// however, it fixes errors when called with point positions being only updated
-	constructLocator();
-	assert(locator && points && grid);
-	/* adjust points size */
-	if(points->GetNumberOfPoints()!=(int)nodes.size()) points->SetNumberOfPoints(nodes.size());
 	size_t sz=nodes.size();
+	vector<Vector3r> pts(sz);
 	for(size_t i=0; i<sz; i++){
 		const shared_ptr<Node>& n(nodes[i]);
 		assert(n->hasData<SparcData>());
-		if(!useNext) points->SetPoint(i,n->pos[0],n->pos[1],n->pos[2]);
-		else{ Vector3r pos=n->pos+n->getData<SparcData>().v*scene->dt; points->SetPoint(i,pos[0],pos[1],pos[2]); }
+		if(!useNext) pts[i]=n->pos;
+		else pts[i]=n->pos+n->getData<SparcData>().v*scene->dt;
 	}
-	// points->ComputeBounds(); points->GetBounds(bb)
-	locator->BuildLocator();
+	tree.build(std::move(pts));
 	locDirty=false;
 };
 
@@ -43,14 +35,14 @@ template<> bool eig_isnan<Vector3r>(const Vector3r& v){for(int i=0; i<v.size();
 template<> bool eig_isnan(const Real& r){ return isnan(r); }
 
 vector<shared_ptr<Node>> SparcField::nodesAround(const Vector3r& pt, int count, Real radius, const shared_ptr<Node>& self, Real* relLocPtDens, const Vector2i& mnMxPts){
-	if(!locator) throw runtime_error("SparcField::locator not initialized!");	
+	if(tree.size()!=nodes.size()) throw runtime_error("SparcField: locator not updated (SparcField.updateLocator) after nodes changed!");
 	if((radius<=0 && count<=0) || (radius>0 && count>0)) throw std::invalid_argument("SparcField.nodesAround: exactly one of radius or count must be positive!");
-	vtkIdList* _ids=vtkIdList::New(); vtkIdList& ids(*_ids);;
+	vector<int> ids;
 	// get given number of closest points
-	if(count>0){ locator->FindClosestNPoints(count,(const double*)(&pt),&ids); }
+	if(count>0){ tree.knnSearch(pt,count,ids); }
 	// search within given radius
 	else {
-		if(!relLocPtDens) locator->FindPointsWithinRadius(radius,(const double*)(&pt),&ids);
+		if(!relLocPtDens) tree.radiusSearch(pt,radius,ids);
 		else{
 			// 10 attempts to adjust relLocPtDens, if given
 			Real fallback=-1; bool forceNextDone=false;
@@ -61,8 +53,8 @@ vector<shared_ptr<Node>> SparcField::nodesAround(const Vector3r& pt, int count,
 					// don't experiment in the last step and use whatever worked already, if available
 					if(fallback>0) (*relLocPtDens)=fallback;
 				}
-				locator->FindPointsWithinRadius(radius*(*relLocPtDens),(const double*)(&pt),&ids);
-				int n=ids.GetNumberOfIds();
+				tree.radiusSearch(pt,radius*(*relLocPtDens),ids);
+				int n=ids.size();
 				LOG_DEBUG("Found {} neighbors with relLocPtDens={}",n,(*relLocPtDens));
 				// we don't want to look any furher: either return what is OK or throw an exception
 				if(forceNextDone){
@@ -89,19 +81,18 @@ vector<shared_ptr<Node>> SparcField::nodesAround(const Vector3r& pt, int count,
 			}
 		}
 	}
-	int numIds=ids.GetNumberOfIds();
+	int numIds=ids.size();
 	vector<shared_ptr<Node>> ret; ret.reserve(numIds);
 	bool selfSeen=false;
 	LOG_DEBUG("{} nodes around {} (radius={}, count={})",numIds,pt.transpose(),radius,count);
 	if(self) LOG_DEBUG("   self is nid {} at {}",self->getData<SparcData>().nid,self->pos.transpose());
-	for(int i=0; i<numIds; i++){
-		if(nodes[ids.GetId(i)]){ LOG_TRACE("Nid {}, at {}",ids.GetId(i),nodes[ids.GetId(i)]->pos.transpose());}
-		else{ LOG_TRACE("Nid {} is None?!",ids.GetId(i));}
-		ret.push_back(nodes[ids.GetId(i)]);
-		if(self && nodes[ids.GetId(i)].get()==self.get()) selfSeen=true;
+	for(int id: ids){
+		if(nodes[id]){ LOG_TRACE("Nid {}, at {}",id,nodes[id]->pos.transpose());}
+		else{ LOG_TRACE("Nid {} is None?!",id);}
+		ret.push_back(nodes[id]);
+		if(self && nodes[id].get()==self.get()) selfSeen=true;
 	};
 	if(self && !selfSeen) throw std::runtime_error("SparcFields::nodesAround: central node at "+to_string(self->pos.transpose())+" given but not found within neighbors around "+to_string(pt.transpose())+".");
-	_ids->Delete();
 	return ret;
 };
 
@@ -121,6 +112,49 @@ void ExplicitNodeIntegrator::findNeighbors(const shared_ptr<Node>&n) const {
 	}
 };
 
+void ExplicitNodeIntegrator::updateStencils(){
+	const auto& nodes(field->nodes);
+	const long N=nodes.size();
+	// stencils are recomputed for points which moved, and for points any neighbor of which moved,
+	// both measured from positions stored when that particular stencil was computed
+	vector<char> rebuild(N,1);
+	if(stencilTol>0){
+		const Real tolSq=pow2(stencilTol*rSearch);
+		// true for NaN reference position
+		auto moved=[&](const Vector3r& pos, const Vector3r& ref){ return !((pos-ref).squaredNorm()<tolSq); };
+		for(long i=0; i<N; i++){
+			const SparcData& dta(nodes[i]->getData<SparcData>());
+			if(dta.neighbors.empty() || dta.stencilNeighPos.size()!=dta.neighbors.size() || moved(nodes[i]->pos,dta.stencilPos)) continue;
+			rebuild[i]=0;
+			for(size_t j=0; j<dta.neighbors.size(); j++){ if(moved(dta.neighbors[j]->pos,dta.stencilNeighPos[j])){ rebuild[i]=1; break; } }
+		}
+	}
+	// nodesAround does not modify the locator, and each node only writes its own data
+	std::exception_ptr err; std::atomic<bool> failed(false);
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(guided)
+	#endif
+	for(long i=0; i<N; i++){
+		if(!rebuild[i] || failed) continue;
+		const shared_ptr<Node>& n(nodes[i]);
+		try{
+			findNeighbors</*useNext*/false>(n);
+			updateLocalInterp</*useNext*/false>(n);
+			SparcData& dta(n->getData<SparcData>());
+			dta.stencilPos=n->pos;
+			dta.stencilNeighPos.resize(dta.neighbors.size());
+			for(size_t j=0; j<dta.neighbors.size(); j++) dta.stencilNeighPos[j]=dta.neighbors[j]->pos;
+		} catch(...){
+			#ifdef WOO_OPENMP
+				#pragma omp critical(ExplicitNodeIntegrator_updateStencils)
+			#endif
+			{ if(!err) err=std::current_exception(); failed=true; }
+		}
+	}
+	// exceptions must not propagate out of parallel sections
+	if(err) std::rethrow_exception(err);
+}
+
 Real ExplicitNodeIntegrator::pointWeight(Real distSq, Real relLocPtDensity) const {
 	assert(relLocPtDensity>0);
 	switch(weightFunc){
@@ -472,10 +506,10 @@ void ExplicitNodeIntegrator::run(){
 
 	if(mff->locDirty || neighborUpdate<2 || (scene->step%neighborUpdate)==0) mff->updateLocator</*useNext*/false>(); // if(mff->locDirty) throw std::runtime_error("SparcField locator was not updated to new positions.");
 
+	updateStencils();
+
 	for(const shared_ptr<Node>& n: field->nodes){
 		nid++; SparcData& dta(n->getData<SparcData>());
-		findNeighbors</*useNext*/false>(n);
-		updateLocalInterp</*useNext*/false>(n);
 		dta.gradV=computeGradV(n);
 		Matrix3r D=dta.getD(), W=dta.getW(); // symm/antisymm decomposition of dta.gradV
 		Matrix3r Tcirc=computeStressRate(dta.T,D,dta.e);
@@ -610,6 +644,57 @@ void StaticEquilibriumSolver::assignDofs() {
 	nDofs=dof;
 }
 
+void StaticEquilibriumSolver::computeJacobianPattern(vector<vector<int>>& colGroups, vector<vector<int>>& colRows) const {
+	if(!neighborsOnce) throw std::runtime_error("StaticEquilibriumSolver: sparse Jacobian (solverNewtonSparse, solverJfnk) requires neighborsOnce=True, since the pattern must not change during the step.");
+	const auto& nodes(field->nodes);
+	const size_t N=nodes.size();
+	// nodes whose velocities enter gradV (and thus nextT) of n: n and its neighbors
+	auto ring=[&](size_t n){
+		vector<int> ret({(int)n});
+		for(const auto& nn: nodes[n]->getData<SparcData>().neighbors) ret.push_back(nn->getData<SparcData>().nid);
+		return ret;
+	};
+	// unique dofs of node n (dofs may be shared with symm01d)
+	auto nodeDofs=[&](size_t n){
+		vector<int> ret;
+		for(int d: nodes[n]->getData<SparcData>().dofs){ if(d>=0 && std::find(ret.begin(),ret.end(),d)==ret.end()) ret.push_back(d); }
+		return ret;
+	};
+	// deps[r]: nodes whose velocities enter residuals of r (divT uses nextT of neighbors); affects is the transpose
+	vector<vector<int>> deps(N), affects(N);
+	for(size_t r=0; r<N; r++){
+		vector<int>& d(deps[r]);
+		for(int a: ring(r)){ for(int m: ring(a)) d.push_back(m); }
+		std::sort(d.begin(),d.end()); d.erase(std::unique(d.begin(),d.end()),d.end());
+		for(int m: d) affects[m].push_back(r);
+	}
+	// greedy coloring: nodes entering residuals of a common node must have different colors
+	vector<int> color(N,-1), mark;
+	int nColors=0;
+	for(size_t m=0; m<N; m++){
+		for(int r: affects[m]){ for(int m2: deps[r]){ if(color[m2]>=0) mark[color[m2]]=m; } }
+		int c=0;
+		while(c<nColors && mark[c]==(int)m) c++;
+		if(c==nColors){ nColors++; mark.push_back(-1); }
+		color[m]=c;
+	}
+	// dofs of one node are perturbed separately, hence up to 3 groups per color
+	colGroups.assign(3*nColors,vector<int>());
+	colRows.assign(nDofs,vector<int>());
+	for(size_t m=0; m<N; m++){
+		vector<int> dd(nodeDofs(m));
+		if(dd.empty()) continue;
+		vector<int> rows;
+		for(int r: affects[m]){ for(int i: nodeDofs(r)) rows.push_back(i); }
+		for(size_t k=0; k<dd.size(); k++){
+			colGroups[3*color[m]+k].push_back(dd[k]);
+			colRows[dd[k]]=rows;
+		}
+	}
+	colGroups.erase(std::remove_if(colGroups.begin(),colGroups.end(),[](const vector<int>& g){ return g.empty(); }),colGroups.end());
+	LOG_DEBUG("Sparse Jacobian pattern: {} dofs in {} groups ({} colors).",nDofs,colGroups.size(),nColors);
+}
+
 VectorXr StaticEquilibriumSolver::computeInitialDofVelocities(bool useZero) const {
 	VectorXr ret; ret.setZero(nDofs);
 	for(const shared_ptr<Node>& n: field->nodes){
@@ -632,10 +717,7 @@ VectorXr StaticEquilibriumSolver::computeInitialDofVelocities(bool useZero) cons
 
 void StaticEquilibriumSolver::prologuePhase(VectorXr& initVel){
 	mff->updateLocator</*useNext*/false>();
-	for(const shared_ptr<Node>& n: field->nodes){
-		findNeighbors</*useNext*/false>(n); 
-		updateLocalInterp</*useNext*/false>(n);
-	}
+	updateStencils();
 	#ifdef SPARC_TRACE
 		SPARC_TRACE_OUT("Neighbor numbers: "); for(const shared_ptr<Node>& n: field->nodes) SPARC_TRACE_OUT(n->getData<SparcData>().neighbors.size()<<" "); SPARC_TRACE_OUT("\n");
 	#endif
@@ -839,6 +921,11 @@ template<> string solverStatus2str<StaticEquilibriumSolver::SolverNewton>(int st
 	throw std::logic_error(("solverStatus2str<NewtonSolver> called with unknown status number "+to_string(status)).c_str());
 }
 
+template<> string solverStatus2str<StaticEquilibriumSolver::SolverSparseNewton>(int status){
+	// same status codes as the dense Newton solver
+	return solverStatus2str<StaticEquilibriumSolver::SolverNewton>(status);
+}
+
 
 void StaticEquilibriumSolver::solverInit(VectorXr& currV){
 	prologuePhase(currV);
@@ -855,10 +942,10 @@ void StaticEquilibriumSolver::solverInit(VectorXr& currV){
 	switch(solver){
 		case SOLVER_NONE:
 			if(nDofs>0) throw std::runtime_error("StaticEquilibriumSolver.solver==solverNone is not admissible with nonzero number of dofs.");
-			solverPowell.reset(); solverLM.reset(); solverNewton.reset();
+			solverPowell.reset(); solverLM.reset(); solverNewton.reset(); solverSparse.reset();
 			return;
 		case SOLVER_POWELL:
-			solverLM.reset(); solverNewton.reset();
+			solverLM.reset(); solverNewton.reset(); solverSparse.reset();
 			solverPowell=make_shared<SolverPowell>(*functor);
 			solverPowell->parameters.factor=solverFactor;
 			solverPowell->parameters.epsfcn=epsfcn;
@@ -878,7 +965,7 @@ void StaticEquilibriumSolver::solverInit(VectorXr& currV){
 			nFactorLowered=0;
 			break;
 		case SOLVER_LM:
-			solverPowell.reset(); solverNewton.reset();
+			solverPowell.reset(); solverNewton.reset(); solverSparse.reset();
 			solverLM=make_shared<SolverLM>(*functor);
 			solverLM->parameters.factor=solverFactor;
 			solverLM->parameters.maxfev=relMaxfev*currV.size(); // this is perhaps bogus, what is exactly maxfev?
@@ -895,7 +982,7 @@ void StaticEquilibriumSolver::solverInit(VectorXr& currV){
 			if(status==Eigen::LevenbergMarquardtSpace::ImproperInputParameters) throw std::runtime_error("StaticEquilibriumSolver:: improper input parameters for the Levenberg-Marquardt solver.");
 			break;
 		case SOLVER_NEWTON:
-			solverLM.reset(); solverPowell.reset();
+			solverLM.reset(); solverPowell.reset(); solverSparse.reset();
 			solverNewton=make_shared<SolverNewton>(*functor);
 			if(solverXtol>0) solverNewton->xtol=solverXtol;
 			solverNewton->maxfev=relMaxfev*currV.size();
@@ -909,6 +996,27 @@ void StaticEquilibriumSolver::solverInit(VectorXr& currV){
 			#endif
 			if(status==NewtonSolverSpace::JacobianNotInvertible) throw std::runtime_error("StaticEquilibriumSolver (Newton): Jacobian matrix not invertible.");
 			break;
+		case SOLVER_NEWTON_SPARSE:
+		case SOLVER_JFNK:
+			solverLM.reset(); solverPowell.reset(); solverNewton.reset();
+			solverSparse=make_shared<SolverSparseNewton>(*functor);
+			if(solverXtol>0) solverSparse->xtol=solverXtol;
+			solverSparse->maxfev=relMaxfev*currV.size();
+			solverSparse->jacEvery=jacEvery;
+			solverSparse->jfnk=(solver==SOLVER_JFNK);
+			solverSparse->krylovDim=krylovDim;
+			solverSparse->krylovRestarts=krylovRestarts;
+			solverSparse->krylovTol=krylovTol;
+			computeJacobianPattern(solverSparse->colGroups,solverSparse->colRows);
+			jacColors=solverSparse->colGroups.size();
+			status=solverSparse->solveInit(currV);
+			LOG_TRACE("Sparse Newton solver: initial solution has residuum {}, Jacobian from {} residual evaluations (instead of {}).",solverSparse->fnorm0,jacColors,nDofs);
+			#ifdef SPARC_INSPECT
+				// dense copy of the jacobian would defeat the purpose
+				residuals=solverSparse->fvec; residuum=solverSparse->fnorm; jac.resize(0,0); jacInv.resize(0,0);
+			#endif
+			if(status==NewtonSolverSpace::JacobianNotInvertible) throw std::runtime_error("StaticEquilibriumSolver (sparse Newton): Jacobian matrix not invertible.");
+			break;
 		default:
 			throw std::logic_error("Unknown value of StaticEquilibriumSolver.solver=="+to_string(solver));
 	}
@@ -956,6 +1064,15 @@ int StaticEquilibriumSolver::solverStep(VectorXr& currV){
 				residuals=solverNewton->fvec; residuum=solverNewton->fnorm; jac=solverNewton->jac; jacInv=solverNewton->jacInv;
 			#endif
 			break;
+		case SOLVER_NEWTON_SPARSE:
+		case SOLVER_JFNK:
+			assert(solverSparse);
+			status=solverSparse->solveOneStep(currV);
+			LOG_TRACE("Sparse Newton inner iteration {}, residuum {} (functor {}×, jacobian {}×, Krylov {}×)",nIter,solverSparse->fnorm,solverSparse->nfev,solverSparse->njev,solverSparse->krylovIter);
+			#ifdef SPARC_INSPECT
+				residuals=solverSparse->fvec; residuum=solverSparse->fnorm;
+			#endif
+			break;
 		default:
 			throw std::logic_error("Unknown value of StaticEquilibriumSolver.solver=="+to_string(solver));
 	}
@@ -972,7 +1089,8 @@ void StaticEquilibriumSolver::run(){
 		if(!out.is_open()) out.open(dbgOut.empty()?"/dev/null":dbgOut.c_str(),ios::out|ios::app);
 		if(scene->step==0) out<<"# vim: guifont=Monospace\\ 7:nowrap:syntax=c:foldenable:foldmethod=syntax:foldopen=percent:foldclose=all:\n";
 	#endif
-	if(!substep || (solver==SOLVER_POWELL && !solverPowell) || (solver==SOLVER_LM && !solverLM) || (solver==SOLVER_NEWTON && !solverNewton)){ /* start anew */ progress=PROGRESS_DONE; }
+	const bool sparseNewton=(solver==SOLVER_NEWTON_SPARSE || solver==SOLVER_JFNK);
+	if(!substep || (solver==SOLVER_POWELL && !solverPowell) || (solver==SOLVER_LM && !solverLM) || (solver==SOLVER_NEWTON && !solverNewton) || (sparseNewton && !solverSparse)){ /* start anew */ progress=PROGRESS_DONE; }
 	int status;
 	SPARC_TRACE_OUT("\n\n ==== Scene step "<<scene->step<<", solution iteration "<<((progress==PROGRESS_DONE || progress==PROGRESS_ERROR?0:nIter))<<endl);
 	// when dt>0, it means we reset scene->dt to our value; restore it now
@@ -998,12 +1116,12 @@ void StaticEquilibriumSolver::run(){
 		if(
 			(solver==SOLVER_POWELL && status==Eigen::HybridNonLinearSolverSpace::Running)
 			|| (solver==SOLVER_LM && status==Eigen::LevenbergMarquardtSpace::Running)
-			|| (solver==SOLVER_NEWTON && status==NewtonSolverSpace::Running)){
+			|| ((solver==SOLVER_NEWTON || sparseNewton) && status==NewtonSolverSpace::Running)){
 			if(substep) goto substepDone; else continue;
 		}
 		// solution found
 		if((solver==SOLVER_POWELL && status==Eigen::HybridNonLinearSolverSpace::RelativeErrorTooSmall)
-			|| (solver==SOLVER_NEWTON && (status==NewtonSolverSpace::RelativeErrorTooSmall || status==NewtonSolverSpace::AbsoluteErrorTooSmall))
+			|| ((solver==SOLVER_NEWTON || sparseNewton) && (status==NewtonSolverSpace::RelativeErrorTooSmall || status==NewtonSolverSpace::AbsoluteErrorTooSmall))
 			|| (solver==SOLVER_LM && (status==Eigen::LevenbergMarquardtSpace::RelativeErrorTooSmall || status==Eigen::LevenbergMarquardtSpace::RelativeErrorAndReductionTooSmall || status==Eigen::LevenbergMarquardtSpace::RelativeReductionTooSmall || status==Eigen::LevenbergMarquardtSpace::CosinusTooSmall))){
 			goto solutionFound;
 		}
@@ -1021,6 +1139,8 @@ void StaticEquilibriumSolver::run(){
 			case SOLVER_POWELL: msg=solverStatus2str<SolverPowell>(status); break;
 			case SOLVER_LM: msg=solverStatus2str<SolverLM>(status); break;
 			case SOLVER_NEWTON: msg=solverStatus2str<SolverNewton>(status); break;
+			case SOLVER_NEWTON_SPARSE:
+			case SOLVER_JFNK: msg=solverStatus2str<SolverSparseNewton>(status); break;
 		}
 		progress=PROGRESS_ERROR;
 		throw std::runtime_error(fmt::format("Solver did not find an acceptable solution, returned {} ({}).",msg,status));
@@ -1041,6 +1161,8 @@ void StaticEquilibriumSolver::run(){
 			case SOLVER_POWELL: nIter=solverPowell->iter; break; 
 			case SOLVER_LM: nIter=solverLM->iter; break;
 			case SOLVER_NEWTON: nIter=solverNewton->iter; break;
+			case SOLVER_NEWTON_SPARSE:
+			case SOLVER_JFNK: nIter=solverSparse->iter; break;
 			default: abort();
 		}
 		// residuum=solver->fnorm;
@@ -9,11 +9,7 @@
 #include<woo/core/Field.hpp>
 #include<woo/core/Scene.hpp>
 #include<woo/core/Field-templates.hpp>
-
-#include<vtkPointLocator.h>
-#include<vtkIdList.h>
-#include<vtkUnstructuredGrid.h>
-#include<vtkPoints.h>
+#include<woo/lib/base/KdTree.hpp>
 
 #ifdef WOO_DEBUG
 	// uncomment to trace most calculations in files, slows down!
@@ -22,6 +18,9 @@
 
 #include<unsupported/Eigen/NonLinearOptimization>
 #include<unsupported/Eigen/MatrixFunctions>
+#include<Eigen/SparseCore>
+#include<Eigen/SparseLU>
+#include<Eigen/IterativeLinearSolvers>
 
 // trace many intermediate numbers in a file given by StaticEquilibriumSolver::dbgOut
 #ifdef WOO_DEBUG
@@ -40,33 +39,27 @@
 #define SPARC_LM
 
 
-class vtkPointLocator;
-class vtkPoints;
-class vtkUnstructuredGrid;
-
 struct SparcField: public Field{
-	vtkPointLocator* locator;
-	vtkPoints* points;
-	vtkUnstructuredGrid* grid;
+	// point locator, rebuilt by updateLocator; indices are positions in nodes
+	KdTree tree;
 	// return nodes around x not further than radius
 	// if count is given, only count closest nodes are returned; radius is the initial radius, which will be however expanded, if insufficient number of points is found.
 	// count does not include self in this case; not finding self in the result throws an exception
+	// does not modify the locator, can be called from several threads at once
 	std::vector<shared_ptr<Node> > nodesAround(const Vector3r& x, int count=-1, Real radius=-1, const shared_ptr<Node>& self=shared_ptr<Node>(), Real* relLocPtDensity=NULL, const Vector2i& mnMxPts=Vector2i::Zero());
-	void constructLocator();
 
 	template<bool useNext=false>
 	void updateLocator();
 
 	WOO_DECL_LOGGER;
 
-	WO0_CLASS_BASE_DOC_ATTRS_CTOR_DTOR_PY(SparcField,Field,"Field for SPARC meshfree method",
+	WO0_CLASS_BASE_DOC_ATTRS_CTOR_PY(SparcField,Field,"Field for SPARC meshfree method",
 		// ((Real,maxRadius,-1,,"Maximum radius for neighbour search (required for periodic simulations)"))
 		((bool,locDirty,true,AttrTrait<Attr::readonly>(),"Flag whether the locator is updated."))
 		((Vector2r,neighAdjFact,Vector2r(.5,2.),,"Factors for adjusting neighbor search range."))
 		((int,neighAdjSteps,10,,"Maximum range for adjusting neighbor search range"))
 		((int,neighRelMax,3,,"Try to keep number of neighbors below *neighRelMax* × basis dimension (which is hard minimum of neighbors)."))
-		,/*ctor*/  createIndex(); constructLocator(); 
-		,/*dtor*/ locator->Delete(); points->Delete(); grid->Delete();
+		,/*ctor*/  createIndex();
 		,/*py*/
 			.def("nodesAround",&SparcField::nodesAround,WOO_PY_ARGS(py::arg("pt"),py::arg("radius")=-1,py::arg("count")=-1,py::arg("ptNode")=shared_ptr<Node>()),"Return array of nodes close to given point *pt*")
 			.def("updateLocator",&SparcField::updateLocator</*useNext*/false>,"Update the locator, should be done manually before the first step perhaps.")
@@ -98,6 +91,8 @@ struct SparcData: public NodeData{
 		// informational
 		((Real,color,Mathr::UnitRandom(),AttrTrait<>().noGui(),"Set node color, so that rendering is more readable"))
 		((int,nid,-1,,"Node id (to locate coordinates in solution matrix)"))
+		((Vector3r,stencilPos,Vector3r(NaN,NaN,NaN),AttrTrait<Attr::noSave|Attr::readonly>().noGui(),"Position where :obj:`neighbors` and the stencil were last computed (see :obj:`ExplicitNodeIntegrator.stencilTol`)."))
+		((vector<Vector3r>,stencilNeighPos,,AttrTrait<Attr::noSave|Attr::readonly>().noGui(),"Positions of :obj:`neighbors` when the stencil was last computed (see :obj:`ExplicitNodeIntegrator.stencilTol`)."))
 		((Real,relLocPtDensity,1.,,"Local density of points, by which :obj:`ExplicitNodeIntegrator.rSearch` is multiplied; automatically adjusted so that enough neighbor points are found, and that they are not too many."))
 
 		// state variables
@@ -171,6 +166,8 @@ struct ExplicitNodeIntegrator: public Engine {
 	void updateLocalInterp(const shared_ptr<Node>& n) const;
 	template<bool useNext>
 	Vector3r computeDivT(const shared_ptr<Node>& n) const;
+	// find neighbors and update interpolation in current positions for all nodes (in parallel), reusing those which did not move much (stencilTol)
+	void updateStencils();
 
 	Matrix3r computeGradV(const shared_ptr<Node>& n) const;
 	Matrix3r computeStressRate(const Matrix3r& T, const Matrix3r& D, Real e=-1) const;
@@ -206,6 +203,7 @@ struct ExplicitNodeIntegrator: public Engine {
 		((Real,gaussAlpha,.6,,"Decay coefficient used with Gauss weight function."))
 		((bool,spinRot,false,,"Rotate particles according to spin in their location; Dofs which prescribe velocity will never be rotated (i.e. only rotation parallel with them will be allowed)."))
 		((int,neighborUpdate,1,,"Number of steps to periodically update neighbour information"))
+		((Real,stencilTol,0,,"Keep neighbors and stencil (interpolation operator) of a point if neither the point nor any of its neighbors moved more than *stencilTol* × :obj:`rSearch` since they were computed. Points entering the neighborhood in the meantime are not considered. Zero recomputes all stencils at every step."))
 		((int,matModel,0,AttrTrait<Attr::triggerPostLoad>(),"Material model to be used (0=linear elasticity, 1=barodesy (Jesse)"))
 		((int,watch,-1,,"Nid to be watched (debugging)."))
 		((Real,damping,0,,"Numerical damping, applied by-component on acceleration"))
@@ -330,6 +328,161 @@ struct NewtonSolver{
 };
 
 
+/*
+Newton solver with sparse Jacobian, assembled by finite differences where structurally orthogonal columns
+(colGroups, with non-zero rows given by colRows) are perturbed together, so that the number of residual
+evaluations depends on the number of groups and not on the number of unknowns.
+
+Without jfnk, each Newton step is solved directly with sparse LU of the Jacobian; with jfnk, the Jacobian
+is only used as incomplete-LU preconditioner for restarted GMRES which evaluates Jacobian-vector products
+by finite differences of the residual (Jacobian-free Newton-Krylov).
+*/
+template<typename FunctorType, typename Scalar=double>
+struct SparseNewtonSolver{
+	typedef typename FunctorType::InputType FVectorType;
+	typedef Eigen::SparseMatrix<Scalar> SparseJacobianType;
+	typedef typename FVectorType::Index Index;
+
+	SparseNewtonSolver(FunctorType &_functor): functor(_functor) {
+		nfev=njev=iter=0;
+		fnorm0=fnorm=0.;
+		xtol=1e-6;
+		abstol=1e-6;
+		jacEvery=0;
+		maxfev=0;
+		jfnk=false;
+		krylovDim=30;
+		krylovRestarts=5;
+		krylovTol=1e-4;
+		krylovIter=0;
+	};
+	int iter, nfev, njev, maxfev;
+	int jacEvery;
+	bool jfnk;
+	int krylovDim, krylovRestarts, krylovIter;
+	vector<vector<int>> colGroups, colRows;
+	SparseJacobianType jac;
+	Eigen::SparseLU<SparseJacobianType> lu;
+	Eigen::IncompleteLUT<Scalar> ilu;
+	FVectorType fvec; // residuals
+	Scalar fnorm0, fnorm, xtol, abstol, krylovTol;
+	FunctorType functor;
+
+	NewtonSolverSpace::Status recomputeJacobian(const FVectorType& x){
+		const Index n=x.size();
+		fvec.resize(n);
+		if(functor(x,fvec)<0) return NewtonSolverSpace::UserAsked;
+		nfev++;
+		vector<Eigen::Triplet<Scalar>> trip;
+		const Scalar sqrtEps=sqrt(Eigen::NumTraits<Scalar>::epsilon());
+		FVectorType x2(x), fvec2(n), dx(n);
+		for(const vector<int>& group: colGroups){
+			for(int j: group){ dx[j]=sqrtEps*std::abs(x[j]); if(dx[j]==0) dx[j]=sqrtEps; x2[j]+=dx[j]; }
+			if(functor(x2,fvec2)<0) return NewtonSolverSpace::UserAsked;
+			nfev++;
+			for(int j: group){
+				for(int i: colRows[j]) trip.push_back(Eigen::Triplet<Scalar>(i,j,(fvec2[i]-fvec[i])/dx[j]));
+				x2[j]=x[j];
+			}
+		}
+		jac.resize(n,n);
+		jac.setFromTriplets(trip.begin(),trip.end());
+		njev++;
+		if(!jfnk){
+			lu.compute(jac);
+			if(lu.info()!=Eigen::Success) return NewtonSolverSpace::JacobianNotInvertible;
+		} else {
+			ilu.compute(jac);
+			if(ilu.info()!=Eigen::Success) return NewtonSolverSpace::JacobianNotInvertible;
+		}
+		return NewtonSolverSpace::Running;
+	}
+
+	// solve jac*d=f0 at x with right-preconditioned restarted GMRES, using finite differences for jac*v
+	bool krylovSolve(const FVectorType& x, const FVectorType& f0, FVectorType& d){
+		const Index n=x.size();
+		const int m=(int)std::min<Index>(krylovDim,n);
+		d.setZero(n);
+		const Scalar bnorm=f0.norm();
+		if(bnorm==0) return true;
+		const Scalar sqrtEps=sqrt(Eigen::NumTraits<Scalar>::epsilon()), xnorm=x.norm();
+		FVectorType f2(n);
+		auto jacVec=[&](const FVectorType& v)->FVectorType{
+			Scalar vnorm=v.norm();
+			if(vnorm==0) return FVectorType::Zero(n);
+			Scalar eps=sqrtEps*(1+xnorm)/vnorm;
+			functor(x+eps*v,f2); nfev++;
+			return (f2-f0)/eps;
+		};
+		MatrixXr V(n,m+1), Z(n,m), H(m+1,m);
+		VectorXr g(m+1), cs(m), sn(m);
+		for(int restart=0; restart<krylovRestarts; restart++){
+			FVectorType r=(restart==0?f0:FVectorType(f0-jacVec(d)));
+			Scalar beta=r.norm();
+			if(beta<=krylovTol*bnorm) return true;
+			H.setZero(); g.setZero(); g[0]=beta;
+			V.col(0)=r/beta;
+			int k=0; bool done=false;
+			for(; k<m && !done; k++){
+				Z.col(k)=ilu.solve(V.col(k));
+				FVectorType w=jacVec(Z.col(k));
+				krylovIter++;
+				// modified Gram-Schmidt
+				for(int i=0; i<=k; i++){ H(i,k)=w.dot(V.col(i)); w-=H(i,k)*V.col(i); }
+				Scalar hNext=w.norm();
+				H(k+1,k)=hNext;
+				if(hNext>0) V.col(k+1)=w/hNext;
+				// apply previous Givens rotations to the new column, then compute the new one
+				for(int i=0; i<k; i++){ Scalar t=cs[i]*H(i,k)+sn[i]*H(i+1,k); H(i+1,k)=-sn[i]*H(i,k)+cs[i]*H(i+1,k); H(i,k)=t; }
+				Scalar den=std::hypot(H(k,k),H(k+1,k));
+				if(den==0){ done=true; break; } // singular
+				cs[k]=H(k,k)/den; sn[k]=H(k+1,k)/den;
+				H(k,k)=den; H(k+1,k)=0;
+				g[k+1]=-sn[k]*g[k]; g[k]*=cs[k];
+				if(std::abs(g[k+1])<=krylovTol*bnorm || hNext==0) done=true;
+			}
+			if(k==0) return false;
+			VectorXr y=H.topLeftCorner(k,k).template triangularView<Eigen::Upper>().solve(g.head(k));
+			d+=Z.leftCols(k)*y;
+			if(std::abs(g[k])<=krylovTol*bnorm) return true;
+		}
+		return false;
+	}
+
+	NewtonSolverSpace::Status solveInit(FVectorType& x){
+		nfev=njev=iter=krylovIter=0;
+		NewtonSolverSpace::Status status=recomputeJacobian(x);
+		fnorm0=fnorm=fvec.stableNorm();
+		return status;
+	}
+
+	NewtonSolverSpace::Status solveOneStep(FVectorType& x){
+		if(jacEvery>0 && iter>0 && (iter%jacEvery)==0){
+			NewtonSolverSpace::Status status=recomputeJacobian(x);
+			if(status!=NewtonSolverSpace::Running) return status;
+		} else {
+			fvec.resize(x.size());
+			if(functor(x,fvec)<0) return NewtonSolverSpace::UserAsked;
+			nfev++;
+		}
+		if(maxfev>0 && nfev>maxfev) return NewtonSolverSpace::TooManyFunctionEvaluation;
+		fnorm=fvec.stableNorm();
+		if(fnorm<xtol*fnorm0) return NewtonSolverSpace::RelativeErrorTooSmall;
+		if(fnorm<abstol) return NewtonSolverSpace::AbsoluteErrorTooSmall;
+		FVectorType d;
+		if(!jfnk){
+			d=lu.solve(fvec);
+			if(lu.info()!=Eigen::Success) return NewtonSolverSpace::JacobianNotInvertible;
+		} else {
+			// inexact Newton: use the Krylov solution even if it did not converge to krylovTol
+			krylovSolve(x,fvec,d);
+		}
+		x-=d;
+		iter++;
+		return NewtonSolverSpace::Running;
+	}
+};
+
 
 struct StaticEquilibriumSolver: public ExplicitNodeIntegrator{
 	struct ResidualsFunctorBase {
@@ -353,11 +506,13 @@ struct StaticEquilibriumSolver: public ExplicitNodeIntegrator{
 	typedef Eigen::HybridNonLinearSolver<ResidualsFunctor,Real> SolverPowell;
 	typedef Eigen::LevenbergMarquardt<ResidualsFunctor,Real> SolverLM;
 	typedef NewtonSolver<ResidualsFunctor> SolverNewton;
+	typedef SparseNewtonSolver<ResidualsFunctor> SolverSparseNewton;
 
 	shared_ptr<ResidualsFunctor> functor;
 	shared_ptr<SolverPowell> solverPowell;
 	shared_ptr<SolverLM> solverLM;
 	shared_ptr<SolverNewton> solverNewton;
+	shared_ptr<SolverSparseNewton> solverSparse;
 
 	void solverInit(VectorXr& x);
 	int solverStep(VectorXr& x);
@@ -376,6 +531,8 @@ struct StaticEquilibriumSolver: public ExplicitNodeIntegrator{
 
 	void prologuePhase(VectorXr& initVel);
 		void assignDofs();
+		// groups of dofs which may be perturbed together when computing the Jacobian, and rows influenced by each dof
+		void computeJacobianPattern(vector<vector<int>>& colGroups, vector<vector<int>>& colRows) const;
 		VectorXr computeInitialDofVelocities(bool useZero=true) const;
 
 	void solutionPhase(const VectorXr& trialVel, VectorXr& errors);
@@ -394,11 +551,11 @@ struct StaticEquilibriumSolver: public ExplicitNodeIntegrator{
 	//VectorXr epiloguePhase(const VectorXr& x} VectorXr ret(x.size()); epiloguePhase(x,ret); return ret; }
 
 	enum {DBG_JAC=1,DBG_DOFERR=2,DBG_NIDERR=4};
-	enum {SOLVER_NONE=0,SOLVER_POWELL,SOLVER_LM,SOLVER_NEWTON};
+	enum {SOLVER_NONE=0,SOLVER_POWELL,SOLVER_LM,SOLVER_NEWTON,SOLVER_NEWTON_SPARSE,SOLVER_JFNK};
 	enum {PROGRESS_DONE=0,PROGRESS_RUNNING,PROGRESS_ERROR};
 
 	WO0_CLASS_BASE_DOC_ATTRS_INIT_CTOR_PY(StaticEquilibriumSolver,ExplicitNodeIntegrator,"Find global static equilibrium of a Sparc system.",
-		((int,solver,SOLVER_POWELL,,"Solver type: 2: Newton-Raphson (finds zero), 0: Powell (minimization) 1: Levenberg-Marquardt."))
+		((int,solver,SOLVER_POWELL,,"Solver type: 0: none, 1: Powell (minimization), 2: Levenberg-Marquardt, 3: Newton-Raphson (finds zero), 4: Newton-Raphson with sparse Jacobian and sparse LU, 5: Jacobian-free Newton-Krylov (GMRES preconditioned with incomplete LU of the sparse Jacobian). The sparse Jacobian is computed from point neighborhoods (which must not change during the step, see :obj:`neighborsOnce`), perturbing many unknowns at once."))
 		((bool,substep,false,,"Whether the solver tries to find solution within one step, or does just one iteration towards the solution"))
 		((Real,dt,NaN,AttrTrait<Attr::readonly>(),"Save Scene.dt here, so that it can be se to 0 during substeps. Other engines should test if S.dt!=0 before running."))
 		((int,nIter,0,AttrTrait<Attr::readonly>(),"Number of iterations of the solver (in the last step, or in-progress iteration if substepping)"))
@@ -416,6 +573,10 @@ struct StaticEquilibriumSolver: public ExplicitNodeIntegrator{
 		((int,jacEvery,10,,"Recompute the Jacobian every *jacEvery* steps, when using the Newton solver"))
 		((bool,jacEigen,true,,"Use Eigen::NumericalDiff routines with the Newton solver; if false, use our own routine."))
 		((bool,epsScale,true,,"When using our own numerical differentiation, enable/disable scaling of distortion based on the current value."))
+		((int,krylovDim,30,,"Dimension of the Krylov subspace (GMRES restart length) for the Jacobian-free Newton-Krylov solver."))
+		((int,krylovRestarts,5,,"Maximum number of GMRES restarts in one Newton iteration of the Jacobian-free Newton-Krylov solver."))
+		((Real,krylovTol,1e-4,,"Relative tolerance of the inner (GMRES) linear solution in the Jacobian-free Newton-Krylov solver."))
+		((int,jacColors,0,AttrTrait<Attr::readonly>(),"Number of groups of unknowns perturbed together to compute the sparse Jacobian (with solverNewtonSparse and solverJfnk), i.e. number of residual evaluations per Jacobian."))
 		((Real,epsfcn,0.,,"Epsfcn parameter of the solver (0 = use machine precision), pg. 26 of MINPACK manual"))
 		((int,nDofs,-1,,"Number of degrees of freedom, set by renumberDoFs"))
 		((Real,charLen,1,,"Characteristic length, for making divT/T errors comensurable"))
@@ -444,6 +605,8 @@ struct StaticEquilibriumSolver: public ExplicitNodeIntegrator{
 		_classObj.attr("solverPowell")=(int)SOLVER_POWELL;
 		_classObj.attr("solverLM")=(int)SOLVER_LM;
 		_classObj.attr("solverNewton")=(int)SOLVER_NEWTON;
+		_classObj.attr("solverNewtonSparse")=(int)SOLVER_NEWTON_SPARSE;
+		_classObj.attr("solverJfnk")=(int)SOLVER_JFNK;
 		_classObj.attr("progressDone")=(int)PROGRESS_DONE;
 		_classObj.attr("progressRunning")=(int)PROGRESS_RUNNING;
 		_classObj.attr("progressError")=(int)PROGRESS_ERROR;
@@ -9,6 +9,8 @@
 #include<woo/pkg/dem/Ellipsoid.hpp>
 #include<woo/pkg/dem/VtkExport.hpp>
 
+#include<pybind11/numpy.h>
+
 #include<boost/graph/adjacency_list.hpp>
 #include<boost/graph/connected_components.hpp>
 #include<boost/graph/subgraph.hpp>
@@ -417,22 +419,31 @@ static int spheroidsToSTL(const string& out, const shared_ptr<DemField>& dem, Re
 
 
 
-static py::list porosity(shared_ptr<DemField>& dem, const AlignedBox3r& box){
-	vector<Real> poro=DemFuncs::boxPorosity(dem,box);
-	py::list ret;
+static py::tuple porosity(shared_ptr<DemField>& dem, const AlignedBox3r& box, int slabs){
+	vector<Real> poro=DemFuncs::boxPorosity(dem,box,slabs);
+	size_t n=0;
+	for(const Real& p: poro) if(!isnan(p)) n++;
+	py::array_t<Particle::id_t> ids(n);
+	py::array_t<Real> pos({n,(size_t)3}), por(n);
+	auto ids_=ids.mutable_unchecked<1>(); auto pos_=pos.mutable_unchecked<2>(); auto por_=por.mutable_unchecked<1>();
+	size_t i=0;
 	for(size_t id=0; id<poro.size(); id++){
 		if(isnan(poro[id])) continue;
-		const auto& sh((*dem->particles)[id]->shape);
-		ret.append(py::make_tuple(id,sh->nodes[0]->pos,poro[id]));
+		const Vector3r& x((*dem->particles)[id]->shape->nodes[0]->pos);
+		ids_(i)=id; for(int ax:{0,1,2}) pos_(i,ax)=x[ax]; por_(i)=poro[id];
+		i++;
 	}
-	return ret;
+	return py::make_tuple(ids,pos,por);
 }
 
-static py::dict surfParticleIdNormals(shared_ptr<DemField>& dem, const AlignedBox3r& box, Real r){
-	std::map<Particle::id_t,std::vector<Vector3r>> surf=DemFuncs::surfParticleIdNormals(dem,box,r);
-	py::dict ret;
-	for(const auto& sn: surf) ret[py::cast(sn.first)]=sn.second;
-	return ret;
+static py::tuple surfParticleIdNormals(shared_ptr<DemField>& dem, const AlignedBox3r& box, Real r, int slabs){
+	vector<Particle::id_t> ids; vector<Vector3r> normals;
+	std::tie(ids,normals)=DemFuncs::surfParticleIdNormals(dem,box,r,slabs);
+	py::array_t<Particle::id_t> ii(ids.size());
+	py::array_t<Real> nn({normals.size(),(size_t)3});
+	auto ii_=ii.mutable_unchecked<1>(); auto nn_=nn.mutable_unchecked<2>();
+	for(size_t i=0; i<ids.size(); i++){ ii_(i)=ids[i]; for(int ax:{0,1,2}) nn_(i,ax)=normals[i][ax]; }
+	return py::make_tuple(ii,nn);
 }
 
 };
@@ -448,9 +459,9 @@ PYBIND11_MODULE(_triangulated,mod){
 
 	mod.def("facetsToSTL",&Triangulated::facetsToSTL,WOO_PY_ARGS(py::arg("stl"),py::arg("dem"),py::arg("solid"),py::arg("mask")=0,py::arg("append")=false),"Export :obj:`facets <woo.dem.Facet>` to STL file. Periodic boundaries are not handled in any special way.");
 
-	mod.def("porosity",&Triangulated::porosity,WOO_PY_ARGS(py::arg("dem"),py::arg("box")),"Return list of `(id,position,porosity)`, where porosity is computed as 1-Vs/Vv, where Vs is particle volume (sphere, capsule, ellipsoid only) and Vv is cell volume using radical Voronoi tesselation around particles. Highly experimental and subject to further changes.");
+	mod.def("porosity",&Triangulated::porosity,WOO_PY_ARGS(py::arg("dem"),py::arg("box"),py::arg("slabs")=0),"Return tuple of NumPy arrays `(ids,positions,porosity)` (with shapes `(N,)`, `(N,3)`, `(N,)`), where porosity is computed as 1-Vs/Vv, where Vs is particle volume (sphere, capsule, ellipsoid only) and Vv is cell volume using radical Voronoi tesselation around particles. The tesselation is computed in parallel, in overlapping sub-boxes; their number is limited by *slabs* (if positive), otherwise it is the number of threads. Highly experimental and subject to further changes.");
 
-	mod.def("surfParticleIdNormals",&Triangulated::surfParticleIdNormals,WOO_PY_ARGS(py::arg("dem"),py::arg("box"),py::arg("r")),"Return map of ID->[normal,normal,...] of normals of cell faces belonging to particle #ID which have no neighbors. [EXPERIMENTAL].");
+	mod.def("surfParticleIdNormals",&Triangulated::surfParticleIdNormals,WOO_PY_ARGS(py::arg("dem"),py::arg("box"),py::arg("r"),py::arg("slabs")=0),"Return tuple of NumPy arrays `(ids,normals)` (with shapes `(N,)`, `(N,3)`) of normals of cell faces which have no neighbors, and IDs of particles they belong to (repeated if a particle has several such faces). *slabs* has the same meaning as for :obj:`porosity`. [EXPERIMENTAL].");
 
 #undef _PY_MOD
 
@@ -112,19 +112,18 @@ annotateKw=dict(horizontalalignment='left',verticalalignment='baseline',fontsize
 lineKw=dict(linewidth=1.5,alpha=.8)
 "Parameters for the normal line plot"
 
-componentSeparator='_'
-componentSuffixes={Vector2:{-1:'norm',0:'x',1:'y'},Vector3:{-1:'norm',0:'x',1:'y',2:'z'},Vector2i:{0:'x',1:'y'},Vector3i:{0:'x',1:'y',2:'z'},Vector6:{-1:'norm',0:'xx',1:'yy',2:'zz',3:'yz',4:'zx',5:'xy'},Matrix3:{(0,0):'xx',(1,1):'yy',(2,2):'zz',(0,1):'xy',(1,0):'yx',(0,2):'xz',(2,0):'zx',(1,2):'yz',(2,1):'zy'}}
-# if a type with entry in componentSuffixes is given in addData, columns for individual components are synthesized using indices and suffixes given for each type; negative index means the norm, which is computed using the 'norm()' method (must be defined by the type)
+# if Vector2, Vector3, Vector6, Matrix3, Vector2i or Vector3i is given in addData, columns for individual components are synthesized (see woo.core.PlotData.addRow)
 #    e.g. foo=Vector3r(1,2,3) will result in columns foo_x=1,foo_y=2,foo_z=3,foo_norm=3.741657...
 
 def Scene_plot_reset(P):
     "Reset all plot-related variables (data, plots, labels)"
-    P.data,P.plots,P.imgData={},{},{}
+    P.data.clear()
+    P.plots,P.imgData={},{}
     pylab.close('all')
 
 def Scene_plot_resetData(P):
     "Reset all plot data; keep plots and labels intact."
-    P.data={}
+    P.data.clear()
 
 def Scene_plot_splitData(P):
     "Make all plots discontinuous at this point (adds nan's to all data fields)"
@@ -135,14 +134,11 @@ def Scene_plot_reverseData(P):
     
     Useful for tension-compression test, where the initial (zero) state is loaded and, to make data continuous, last part must *end* in the zero state.
     """
-    for k in P.data: P.data[k].reverse()
+    P.data.reverse()
 
 def addDataColumns(data,dd):
     '''Add new columns with NaN data, without adding anything to other columns. Does nothing for columns that already exist'''
-    numSamples=len(data[list(data.keys())[0]]) if len(data)>0 else 0
-    for d in dd:
-        if d in list(data.keys()): continue
-        data[d]=[nan for i in range(numSamples)]
+    data.addColumns(list(dd))
 
 def Scene_plot_autoData(P,**kw):
     """Add data by evaluating contents of :obj:`woo.core.Plot.plots`. Expressions rasing exceptions will be handled gracefully, but warning is printed for each.
@@ -152,8 +148,8 @@ def Scene_plot_autoData(P,**kw):
     >>> S=Scene(fields=[DemField(gravity=(0,0,-10))])
     >>> S.plot.plots={'S.step':('S.time',None,'numParticles=len(S.dem.par)')}
     >>> S.plot.autoData()
-    >>> pprint(S.plot.data)
-    {'S.step': [0], 'S.time': [0.0], 'numParticles': [0]}
+    >>> pprint(S.plot.data.asDict())
+    {'S.step': [0.0], 'S.time': [0.0], 'numParticles': [0.0]}
 
     Note that each item in :obj:`woo.core.Plot.plots` can be
 
@@ -175,9 +171,9 @@ def Scene_plot_autoData(P,**kw):
     ... ]
     >>> S.trackEnergy=True
     >>> S.run(3,True)
-    >>> pprint(S.plot.data)   #doctest: +ELLIPSIS
+    >>> pprint(S.plot.data.asDict())   #doctest: +ELLIPSIS
     {'grav': [0.0, 0.0, -20.357...],
-     'i': [0, 1, 2],
+     'i': [0.0, 1.0, 2.0],
      'kinetic': [0.0, 1.526..., 13.741...],
      'nonviscDamp': [nan, nan, 8.143...],
      'rel. error': [0.0, 1.0, 0.0361...],
@@ -253,14 +249,16 @@ def Scene_plot_addData(P,*d_in,**kw):
     >>> S.plot.addData(a=1)
     >>> S.plot.addData(b=2)
     >>> S.plot.addData(a=3,b=4)
-    >>> pprint(S.plot.data)
-    {'a': [1, nan, 3], 'b': [nan, 2, 4]}
+    >>> pprint(S.plot.data.asDict())
+    {'a': [1.0, nan, 3.0], 'b': [nan, 2.0, 4.0]}
+
+    Data are stored as floats in :obj:`woo.core.PlotData`; columns are returned as numpy arrays.
 
     Some sequence types can be given to addData; they will be saved in synthesized columns for individual components.
 
     >>> S.plot.resetData()
     >>> S.plot.addData(c=Vector3(5,6,7),d=Matrix3(8,9,10, 11,12,13, 14,15,16))
-    >>> pprint(S.plot.data)    #doctest: +ELLIPSIS
+    >>> pprint(S.plot.data.asDict())    #doctest: +ELLIPSIS
     {'c_norm': [10.488...],
      'c_x': [5.0],
      'c_y': [6.0],
@@ -277,51 +275,28 @@ def Scene_plot_addData(P,*d_in,**kw):
 
     """
     data,imgData=P.data,P.imgData
-    import numpy
-    if len(data)>0: numSamples=len(data[list(data.keys())[0]])
-    else: numSamples=0
     # align with imgData, if there is more of them than data
-    if len(imgData)>0 and numSamples==0: numSamples=max(numSamples,len(imgData[list(imgData.keys())[0]]))
+    if len(imgData)>0 and data.nRows==0:
+        nImgData=len(imgData[list(imgData.keys())[0]])
+        if nImgData>0: data.resize(nImgData)
     d=(d_in[0] if len(d_in)>0 else {})
     d.update(**kw)
-    # handle types composed of multiple values (vectors, matrices)
-    dNames=list(d.keys())[:] # make copy, since dict cannot change size if iterated over directly
-    for name in dNames:
-        if type(d[name]) in componentSuffixes:
-            val=d[name]
-            suffixes=componentSuffixes[type(d[name])]
-            for ix in suffixes:
-                d[name+componentSeparator+suffixes[ix]]=(d[name].norm() if (isinstance(ix,int) and ix<0) else d[name][ix])
-            del d[name]
-        elif hasattr(d[name],'__len__'):
-            raise ValueError('plot.addData given unhandled sequence type (is a '+type(d[name]).__name__+', must be number or '+'/'.join([k.__name__ for k in componentSuffixes])+')')
-    for name in d:
-        if not name in list(data.keys()): data[name]=[] # numpy.array([])
-    for name in data:
-        ## new=numpy.full(numSamples-len(data[name]+1),nan)
-        ## new[-1]=(d[name] if name in d else nan)
-        data[name]+=(numSamples-len(data[name]))*[nan]
-        data[name].append(d[name] if name in d else nan)
-    #print [(k,len(data[k])) for k in data.keys()]
-    #numpy.array([nan for i in range(numSamples)])
-    #numpy.append(data[name],[d[name]],1)
+    data.addRow(d)
 
 def Scene_plot_addImgData(P,**kw):
     data,imgData=P.data,P.imgData
     for k in kw:
         if k not in imgData: imgData[k]=[]
     # align imgData with data
-    if len(list(data.keys()))>0 and len(list(imgData.keys()))>0:
-        nData,nImgData=len(data[list(data.keys())[0]]),len(imgData[list(imgData.keys())[0]])
+    if len(data)>0 and len(list(imgData.keys()))>0:
+        nData,nImgData=data.nRows,len(imgData[list(imgData.keys())[0]])
         #if nImgData>nData-1: raise RuntimeError("imgData is already the same length as data?")
         if nImgData<nData-1: # repeat last value
             for k in list(imgData.keys()):
                 lastValue=imgData[k][-1] if len(imgData[k])>0 else None
                 imgData[k]+=(nData-len(imgData[k])-1)*[lastValue]
         elif nData<nImgData:
-            for k in list(data.keys()):
-                lastValue=data[k][-1] if len(data[k])>0 else nan
-                data[k]+=(nImgData-nData)*[lastValue]   # add one more, because we will append to imgData below
+            data.resize(nImgData,fillLast=True)
     # add values from kw
     newLen=(len(imgData[list(imgData.keys())[0]]) if imgData else 0)+1 # current length plus 1
     for k in kw:
@@ -351,11 +326,16 @@ def xlateLabel(l,labels):
     else: return l
 
 class LineRef(object):
-    """Holds reference to plot line and to original data arrays (which change during the simulation),
-    and updates the actual line using those data upon request."""
-    def __init__(self,line,scatter,annotation,line2,xdata,ydata,imgData=None,dataName=None):
-        self.line,self.scatter,self.annotation,self.line2,self.xdata,self.ydata,self.imgData,self.dataName=line,scatter,annotation,line2,xdata,ydata,imgData,dataName
+    """Holds reference to plot line and to original data (which change during the simulation),
+    and updates the actual line using those data upon request. With *data*, *xdata* and *ydata* are
+    column names in *data* (:obj:`woo.core.PlotData`), which are fetched (without copying) at every update."""
+    def __init__(self,line,scatter,annotation,line2,xdata,ydata,imgData=None,dataName=None,data=None):
+        self.line,self.scatter,self.annotation,self.line2,self.imgData,self.dataName,self.data=line,scatter,annotation,line2,imgData,dataName,data
+        if data is not None: self.xName,self.yName=xdata,ydata
+        else: self.xName,self.yName,self.xdata,self.ydata=None,None,xdata,ydata
     def update(self):
+        # views do not grow with data, get new ones
+        if self.data is not None: self.xdata,self.ydata=self.data[self.xName],self.data[self.yName]
         if isinstance(self.line,matplotlib.image.AxesImage):
             # image name
             try:
@@ -493,10 +473,8 @@ def createPlots(P,subPlots=True,noShow=False,replace=True,scatterSize=60,wider=F
                 import warnings
                 warnings.error('UnicodeDecodeError when processing data set '+repr(d[0]))
         if missing:
-            if len(list(data.keys()))==0 or len(data[list(data.keys())[0]])==0: # no data at all yet, do not add garbage NaNs
-                for m in missing: data[m]=[]
-            else:
-                addDataColumns(data,missing)
+            addDataColumns(data,missing)
+            if data.nRows>0:
                 try:
                     print('Missing columns in Scene.plot.data, added NaNs:',', '.join([m for m in missing]))
                 except UnicodeDecodeError:
@@ -550,7 +528,7 @@ def createPlots(P,subPlots=True,noShow=False,replace=True,scatterSize=60,wider=F
                     annotation=axes.annotate(text,xy=scatterPtPos,color=line.get_color(),**annotateKw)
                     annotation.annotateFmt=annotateFmt
                 else: annotation=None
-                if replace: P.currLineRefs.append(LineRef(line=line,scatter=scatter,annotation=annotation,line2=line2,xdata=data[pStrip],ydata=data[d[0]]))
+                if replace: P.currLineRefs.append(LineRef(line=line,scatter=scatter,annotation=annotation,line2=line2,xdata=pStrip,ydata=d[0],data=data))
             axes=_my_get_axes(line)
             labelLoc=(legendLoc[0 if isY1 else 1] if y2Exists>0 else 'best')
             l=axes.legend(loc=labelLoc)
@@ -606,7 +584,7 @@ def liveUpdate(P,timestamp):
             l.update()
             figs.add(l.line.get_figure())
             axes.add(_my_get_axes(l.line))
-            linesData.add(id(l.ydata))
+            if l.yName: linesData.add(l.yName)
         # find callables in y specifiers, create new lines if necessary
         for ax in axes:
             if not hasattr(ax,'wooYFuncs') or not ax.wooYFuncs: continue # not defined of empty
@@ -621,9 +599,9 @@ def liveUpdate(P,timestamp):
             if not news: continue
             for new in news:
                 ax.wooYNames.add(new)
-                if new in list(data.keys()) and id(data[new]) in linesData: continue # do not add when reloaded and the old lines are already there
+                if new in data and new in linesData: continue # do not add when reloaded and the old lines are already there
                 print('woo.plot: creating new line for',new)
-                if not new in list(data.keys()): data[new]=len(data[ax.wooXName])*[nan] # create data entry if necessary
+                addDataColumns(data,[new]) # create data entry if necessary
                 #print 'data',len(data[ax.wooXName]),len(data[new]),data[ax.wooXName],data[new]
                 line,=ax.plot(data[ax.wooXName],data[new],label=xlateLabel(new,P.labels)) # no line specifier
                 line2,=ax.plot([],[],color=line.get_color(),alpha=afterCurrentAlpha)
@@ -633,7 +611,7 @@ def liveUpdate(P,timestamp):
                     annotation=ax.annotate(P.annotateFmt.format(xy=scatterPt),xy=scatterPt,color=line.get_color(),**annotateKw)
                     annotation.annotateFmt=P.annotateFmt
                 else: annotation=None
-                P.currLineRefs.append(LineRef(line=line,scatter=scatter,annotation=annotation,line2=line2,xdata=data[ax.wooXName],ydata=data[new]))
+                P.currLineRefs.append(LineRef(line=line,scatter=scatter,annotation=annotation,line2=line2,xdata=ax.wooXName,ydata=new,data=data))
                 ax.set_ylabel(ax.get_ylabel()+(', ' if ax.get_ylabel() else '')+xlateLabel(new,P.labels))
             # it is possible that the legend has not yet been created
             l=ax.legend(loc=ax.wooLabelLoc)
@@ -673,7 +651,7 @@ def savePlotSequence(P,fileBase,stride=1,imgRatio=(5,7),title=None,titleFrames=2
         fig.set_size_inches(5,5)
         fig.subplots_adjust(left=0,right=1,bottom=0,top=1)
     #if not data.keys(): raise ValueError("plot.data is empty.")
-    pltLen=max(len(data[list(data.keys())[0]]) if data else 0,len(imgData[list(imgData.keys())[0]]) if imgData else 0)
+    pltLen=max(data.nRows,len(imgData[list(imgData.keys())[0]]) if imgData else 0)
     if pltLen==0: raise ValueError("Both plot.data and plot.imgData are empty.")
     global current
     ret=[]
@@ -800,16 +778,16 @@ def Scene_plot_saveDataTxt(P,fileName,vars=None):
     >>> S=woo.core.Scene()
     >>> S.plot.addData(a=1,b=11,c=21,d=31)  # add some data here
     >>> S.plot.addData(a=2,b=12,c=22,d=32)
-    >>> pprint(S.plot.data)
-    {'a': [1, 2], 'b': [11, 12], 'c': [21, 22], 'd': [31, 32]}
+    >>> pprint(S.plot.data.asDict())
+    {'a': [1.0, 2.0], 'b': [11.0, 12.0], 'c': [21.0, 22.0], 'd': [31.0, 32.0]}
     >>> txt=woo.master.tmpFilename()+'.txt.gz'
     >>> S.plot.saveDataTxt(txt,vars=('a','b','c'))
     >>> import numpy
     >>> d=numpy.genfromtxt(txt,dtype=None,names=True)
     >>> d['a']
-    array([1, 2])
+    array([1., 2.])
     >>> d['b']
-    array([11, 12])
+    array([11., 12.])
 
     :param fileName: file to save data to; if it ends with ``.bz2`` / ``.gz``, the file will be compressed using bzip2 / gzip. 
     :param vars: Sequence (tuple/list/set) of variable names to be saved. If ``None`` (default), all variables in :obj:`woo.core.Plot` are saved.
@@ -823,8 +801,9 @@ def Scene_plot_saveDataTxt(P,fileName,vars=None):
     elif fileName.endswith('.gz'): f=gzip.GzipFile(fileName,'wb')
     else: f=open(fileName,'wb')
     f.write(_bytes("# "+"\t".join(vars)+"\n"))
-    for i in range(len(data[vars[0]])):
-        f.write(_bytes("\t".join([str(data[var][i]) for var in vars])+"\n"))
+    cols=[data[var] for var in vars]
+    for i in range(data.nRows):
+        f.write(_bytes("\t".join([str(c[i]) for c in cols])+"\n"))
     f.close()
 
 
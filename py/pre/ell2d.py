@@ -109,7 +109,7 @@ class EllGroup(woo.core.Preprocessor,woo.pyderived.PyWooObject):
 
 
         S.plot.plots={'i':('total','**S.energy'),' t':('relErr')}
-        S.plot.data={'i':[nan],'total':[nan],'relErr':[nan]} # to make plot displayable from the very start
+        S.plot.resetData(); S.plot.addData(i=nan,total=nan,relErr=nan) # to make plot displayable from the very start
     
         try:
             import woo.gl
@@ -99,7 +99,7 @@ def prepareHorse(pre):
     ]
     S.trackEnergy=True
     S.plot.plots={'i':('total','**S.energy'),' t':('relErr')}
-    S.plot.data={'i':[nan],'total':[nan],'relErr':[nan]} # to make plot displayable from the very start
+    S.plot.resetData(); S.plot.addData(i=nan,total=nan,relErr=nan) # to make plot displayable from the very start
 
     if pre.deformable:
         # set damping just for mesh nodes, if particles have no damping
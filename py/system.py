@@ -52,6 +52,8 @@ def setExitHandlers():
 
     import atexit
     atexit.register(releaseInternalPythonObjects)
+    # finish python commands queued by PyRunner(queued=True) while the interpreter is still alive
+    atexit.register(woo.core.Engine.waitQueuedPy)
 
 
 
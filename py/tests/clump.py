@@ -79,6 +79,21 @@ class TestSimpleClump(unittest.TestCase):
         # angular velocities
         self.assertEqual(b1.dem.angVel,bC.dem.angVel);
         self.assertEqual(b2.dem.angVel,bC.dem.angVel);
+    def testGatherScatter(self):
+        "Clump: forces gathered from members and positions applied to members, also in a copied scene"
+        S=woo.master.scene
+        for S2 in (S,S.deepcopy()):
+            bC,b1,b2=S2.dem.nodes
+            b1.dem.force,b2.dem.force=(1,2,3),(-2,0,1)
+            b1.dem.torque,b2.dem.torque=(0,0,1),(1,0,0)
+            F,T=ClumpData.forceTorqueFromMembers(bC)
+            self.assertEqual(F,b1.dem.force+b2.dem.force)
+            self.assertTrue((T-(b1.dem.torque+b2.dem.torque+(b1.pos-bC.pos).cross(b1.dem.force)+(b2.pos-bC.pos).cross(b2.dem.force))).norm()<1e-12)
+            # move the clump, members follow
+            rel1=b1.pos-bC.pos
+            bC.pos+=Vector3(1,1,1)
+            ClumpData.applyToMembers(bC)
+            self.assertTrue((b1.pos-bC.pos-rel1).norm()<1e-12)
     def testNoCollide(self):
         "Clump: particles inside one clump don't collide with each other"
         # use a new scene, with a different clump in this test
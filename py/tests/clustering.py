@@ -23,5 +23,64 @@ class TestClusterAnalysis(unittest.TestCase):
             labels.append(S.dem.par[grp[0]].matState.labels[0])
         self.assertEqual([0,1,2,3],sorted(labels))
 
-
-
+    def _labels(self,S,level):
+        'Return dict particle id -> label at *level*, for labeled particles only.'
+        ret={}
+        for p in S.dem.par:
+            if p.matState is None or len(p.matState.labels)<=level or p.matState.labels[level]<0: continue
+            ret[p.id]=p.matState.labels[level]
+        return ret
+    def _partition(self,lab,ids=None):
+        'Return set of clusters (frozensets of particle ids) from id -> label dict, optionally restricted to *ids*.'
+        grp={}
+        for i,l in lab.items():
+            if ids is None or i in ids: grp.setdefault(l,set()).add(i)
+        return set(frozenset(g) for g in grp.values())
+    def _checkIncremental(self,maxConn):
+        import random
+        random.seed(maxConn)
+        clustMin=3
+        S=woo.core.Scene(fields=[woo.dem.DemField(par=[woo.dem.Sphere.make(Vector3(random.uniform(0,12),random.uniform(0,12),random.uniform(0,3)),.5) for i in range(200)])],engines=woo.dem.DemField.minimalEngines(),dtSafety=1e-8,dt=1e-8)
+        inc=woo.dem.ClusterAnalysis(clustMin=clustMin,maxConn=maxConn,incremental=True)
+        nChanged=[]
+        for step in range(12):
+            # teleport a few particles around, which breaks up, joins and creates clusters
+            for i in random.sample(range(len(S.dem.par)),(0 if step%4==3 else 6)):
+                S.dem.par[i].pos=Vector3(random.uniform(0,12),random.uniform(0,12),random.uniform(0,3))
+                S.dem.par[i].vel=Vector3.Zero
+            S.one()
+            inc(S)
+            nChanged.append(inc.nChanged)
+            # reference: label from scratch in a copy
+            S2=S.deepcopy()
+            for p in S2.dem.par: p.matState=None
+            woo.dem.ClusterAnalysis(clustMin=clustMin,maxConn=maxConn,incremental=False)(S2)
+            # connectivity 0 against connected components of the contact graph
+            adj=dict((p.id,set()) for p in S.dem.par)
+            for c in S.dem.con:
+                if not c.real: continue
+                adj[c.id1].add(c.id2); adj[c.id2].add(c.id1)
+            comps,seen=set(),set()
+            for i in adj:
+                if i in seen: continue
+                comp,todo=set(),[i]
+                while todo:
+                    j=todo.pop()
+                    if j in comp: continue
+                    comp.add(j); todo+=list(adj[j]-comp)
+                seen|=comp
+                if len(comp)>=clustMin: comps.add(frozenset(comp))
+            self.assertTrue(len(comps)>1)
+            self.assertEqual(self._partition(self._labels(S2,0)),comps)
+            for level in range(maxConn+1):
+                full=self._labels(S2,level)
+                # particles which are not clustered keep their old labels, hence only compare clustered ones
+                self.assertEqual(self._partition(self._labels(S,level),set(full.keys())),self._partition(full))
+        # nothing changed in steps without teleporting, hence nothing relabeled
+        self.assertEqual([nChanged[i] for i in (3,7,11)],[0,0,0])
+    def testIncremental(self):
+        'clustering: incremental labeling gives the same clusters as labeling from scratch'
+        self._checkIncremental(maxConn=0)
+    def testIncrementalMaxConn(self):
+        'clustering: incremental labeling gives the same clusters as labeling from scratch, with maxConn>0'
+        self._checkIncremental(maxConn=2)
@@ -278,6 +278,36 @@ class TestObjectInstantiation(unittest.TestCase):
             # type mismatch
             self.assertRaises(RuntimeError,lambda: woo.core.Node(dem=woo.gl.GlData()))
 
+class TestKdTree(unittest.TestCase):
+    def setUp(self):
+        random.seed(42)
+        # clustered points with some duplicates, so that leaves with identical coordinates are exercised as well
+        self.pts=[Vector3(random.gauss(0,1),random.gauss(0,.3),random.random()) for i in range(500)]
+        self.pts+=self.pts[:20]
+        self.queries=[Vector3(random.uniform(-2,2),random.uniform(-1,1),random.uniform(-.5,1.5)) for i in range(40)]+self.pts[:5]
+    def testRadiusSearch(self):
+        'Core: KdTree radius search matches brute force'
+        for leafSize in (1,4,10,1000):
+            for q in self.queries:
+                for r in (0.,.1,.4,5.):
+                    bf=sorted([i for i,p in enumerate(self.pts) if (p-q).norm()<=r])
+                    self.assertEqual(sorted(woo.core.WooTestClass.kdRadiusSearch(self.pts,q,r,leafSize=leafSize)),bf)
+    def testKnnSearch(self):
+        'Core: KdTree k-nearest search matches brute force'
+        for leafSize in (1,4,10,1000):
+            for q in self.queries:
+                d=sorted([(p-q).norm() for p in self.pts])
+                for k in (1,7,50,len(self.pts)+10):
+                    ret=woo.core.WooTestClass.kdKnnSearch(self.pts,q,k,leafSize=leafSize)
+                    self.assertEqual(len(ret),min(k,len(self.pts)))
+                    self.assertEqual(len(set(ret)),len(ret))
+                    # compare distances, since ties may be resolved differently
+                    for i,ix in enumerate(ret): self.assertAlmostEqual((self.pts[ix]-q).norm(),d[i],delta=1e-12)
+    def testEmpty(self):
+        'Core: KdTree on empty point set'
+        self.assertEqual(woo.core.WooTestClass.kdRadiusSearch([],Vector3(0,0,0),1.),[])
+        self.assertEqual(woo.core.WooTestClass.kdKnnSearch([],Vector3(0,0,0),3),[])
+
 class TestLoop(unittest.TestCase):
     def setUp(self):
         woo.master.reset()
@@ -377,6 +407,47 @@ class TestLoop(unittest.TestCase):
         S=woo.core.Scene(dt=1e-3,engines=[PyRunner(1,'import time; S.stop(); time.sleep(.3); S.lab.aa=True')])
         S.run(wait=True)
         self.assertTrue(hasattr(S.lab,'aa'))
+    def testQueuedPyRunner(self):
+        'Loop: PyRunner.queued runs once per step, with the snapshot from when it was queued'
+        S=woo.core.Scene(dt=1e-3,engines=[PyRunner(1,'S.lab.steps=S.lab.steps+[snapshot["step"]]',queued=True)])
+        S.lab.steps=[]
+        S.lab._setWritable('steps')
+        S.one()
+        S.wait() # not running, but waits for the queued command
+        self.assertEqual(S.lab.steps,[0])
+        S.run(10,wait=True)
+        # all commands finished, each saw values of its own step
+        self.assertEqual(S.lab.steps,list(range(0,11)))
+    def testQueuedPyRunnerLive(self):
+        'Loop: PyRunner.queued with live runs between steps'
+        S=woo.core.Scene(dt=1e-3,engines=[PyRunner(1,'S.lab.steps=S.lab.steps+[S.step]',queued=True,live=True)])
+        S.lab.steps=[]
+        S.lab._setWritable('steps')
+        S.one()
+        S.wait()
+        self.assertEqual(S.lab.steps,[1])
+        S.run(10,wait=True)
+        # the scene was not modified while the command was running
+        self.assertEqual(S.lab.steps,list(range(1,12)))
+    def testQueuedPyRunnerOverlap(self):
+        'Loop: PyRunner.queued runs concurrently with the following steps'
+        S=woo.core.Scene(dt=1e-3,engines=[PyRunner(1,'import time; s0=S.step; time.sleep(.3); S.lab.overlap=S.step-s0; S.stop()',queued=True,nDo=1)])
+        S.run(wait=True)
+        self.assertTrue(S.lab.overlap>0)
+    def testQueuedPyRunnerPaused(self):
+        'Loop: Scene.paused() inside PyRunner.queued does not deadlock'
+        for live in (False,True):
+            S=woo.core.Scene(dt=1e-3,engines=[PyRunner(1,'with S.paused(): S.lab.pausedStep=S.step\nS.stop()',queued=True,live=live,nDo=1)])
+            S.run(wait=True)
+            self.assertTrue(S.lab.pausedStep>0)
+    def testQueuedPyRunnerException(self):
+        'Loop: exception in PyRunner.queued is re-raised by Scene.wait'
+        S=woo.core.Scene(dt=1e-3,engines=[PyRunner(1,'raise ValueError("queued")',queued=True)])
+        S.one()
+        self.assertRaises(RuntimeError,S.wait)
+        # the error is reported only once
+        S.engines=[]
+        S.one(); S.wait()
     def testWaitForScenes(self):
         'Loop: Master.waitForScenes correctly handles reassignment of the master scene'
         S=woo.master.scene=woo.core.Scene(dt=1e-3,engines=[PyRunner(1,'import time; S.stop(); time.sleep(.3); woo.master.scene=woo.core.Scene(dt=1e-4,engines=[woo.core.PyRunner(1,"S.stop()")])')])
@@ -409,6 +480,104 @@ class TestIO(unittest.TestCase):
             print(80*'#'+'\nFailed classes were: '+' '.join(failed))
         self.assertTrue(len(failed)==0,'Failed classes were: '+' '.join(failed)+'\n'+80*'#')
 
+class TestPlotData(unittest.TestCase):
+    def setUp(self):
+        self.d=PlotData(chunk=4)
+        for i in range(100):
+            row={'i':i,'v':Vector3(i,0,0)}
+            if i>=50: row['late']=2*i
+            self.d.addRow(row)
+    def testGrowth(self):
+        'PlotData: rows are appended across reallocations, columns are expanded and padded'
+        import numpy
+        d=self.d
+        self.assertEqual(d.nRows,100)
+        self.assertEqual(sorted(d.keys()),['i','late','v_norm','v_x','v_y','v_z'])
+        numpy.testing.assert_array_equal(d['i'],numpy.arange(100))
+        numpy.testing.assert_array_equal(d['v_x'],d['v_norm'])
+        self.assertTrue(numpy.isnan(d['late'][:50]).all())
+        numpy.testing.assert_array_equal(d['late'][50:],2*numpy.arange(50,100))
+        d.addRow({'x':1.})
+        self.assertEqual(d.nRows,101)
+        self.assertTrue(numpy.isnan(d['i'][-1]) and numpy.isnan(d['x'][:-1]).all())
+    def testViews(self):
+        'PlotData: columns are read-only views which survive reallocation'
+        import numpy
+        d=PlotData(chunk=4)
+        d.addRow({'a':1})
+        a=d['a']
+        self.assertFalse(a.flags.writeable)
+        self.assertRaises(ValueError,lambda: a.__setitem__(0,2.))
+        for i in range(1000): d.addRow({'a':i})
+        # old view keeps its length and values, new view sees all rows
+        self.assertEqual(len(a),1)
+        self.assertEqual(a[0],1.)
+        self.assertEqual(len(d['a']),1001)
+    def testSaveLoad(self):
+        'PlotData: data survive save, load and deepcopy'
+        import numpy
+        out=woo.master.tmpFilename()
+        self.d.save(out)
+        for d2 in Object.load(out),self.d.deepcopy():
+            self.assertEqual(d2.nRows,self.d.nRows)
+            self.assertEqual(sorted(d2.keys()),sorted(self.d.keys()))
+            for k in self.d.keys(): numpy.testing.assert_array_equal(d2[k],self.d[k])
+            # loaded data can grow further
+            d2.addRow({'i':100})
+            self.assertEqual(d2['i'][-1],100)
+
+    def testDumps(self):
+        'PlotData: data survive expr, json and pickle dumps'
+        import numpy, pickle
+        for d2 in [PlotData.loads(self.d.dumps(format=fmt),format=fmt) for fmt in ('expr','json')]+[pickle.loads(pickle.dumps(self.d))]:
+            self.assertEqual(d2.nRows,self.d.nRows)
+            self.assertEqual(sorted(d2.keys()),sorted(self.d.keys()))
+            for k in self.d.keys(): numpy.testing.assert_array_equal(d2[k],self.d[k])
+    def testDictCompat(self):
+        'PlotData: dict of sequences (old Plot.data) is converted'
+        import numpy
+        S=Scene()
+        S.plot.data={'a':[1,2,None],'b':(4.,5,6)}
+        self.assertTrue(isinstance(S.plot.data,PlotData))
+        self.assertEqual(S.plot.data.nRows,3)
+        numpy.testing.assert_array_equal(S.plot.data['a'],[1,2,float('nan')])
+        numpy.testing.assert_array_equal(S.plot.data['b'],[4,5,6])
+        # old dumps of Plot have data as dict
+        p=Plot(data={'x':[1.,2.]})
+        numpy.testing.assert_array_equal(p.data['x'],[1,2])
+        self.assertEqual(PlotData({}).nRows,0)
+        self.assertRaises(ValueError,lambda: PlotData({'a':[1,2],'b':[1]}))
+        self.assertRaises(ValueError,lambda: PlotData({'a':[1,'foo']}))
+    def testNonNumeric(self):
+        'PlotData: numbers and None are stored, other values are rejected'
+        import numpy
+        d=self.d
+        self.assertRaises(ValueError,lambda: d.addRow({'i':1,'s':'abc'}))
+        self.assertEqual(d.nRows,100)
+        self.assertFalse('s' in d)
+        d.addRow({'i':None,'b':True,'f':numpy.float32(2.5)})
+        self.assertTrue(numpy.isnan(d['i'][-1]))
+        self.assertEqual((d['b'][-1],d['f'][-1]),(1.,2.5))
+
+class TestOffscreenSnapshot(unittest.TestCase):
+    def testPng(self):
+        'OffscreenSnapshot: render one frame to PNG, keep only maxSnapshots file names'
+        if not hasattr(woo,'gl') or not hasattr(woo.gl,'OffscreenSnapshot'): self.skipTest('OffscreenSnapshot not compiled in (no EGL).')
+        S=woo.core.Scene(fields=[DemField()],dt=1.)
+        S.dem.par.add(Sphere.make((0,0,0),1))
+        out=woo.master.tmpFilename()+'/'
+        snap=woo.gl.OffscreenSnapshot(fileBase=out,size=(64,48),maxSnapshots=2)
+        S.engines=[snap]
+        try: S.one()
+        except RuntimeError as e:
+            if 'EGL' in str(e): self.skipTest(str(e))
+            raise
+        snap.flush()
+        self.assertEqual(snap.snapshots,[out+'00000.png'])
+        with open(snap.snapshots[0],'rb') as f: self.assertEqual(f.read(8),b'\x89PNG\r\n\x1a\n')
+        S.run(3,True); snap.flush()
+        self.assertEqual(snap.snapshots,[out+'00002.png',out+'00003.png'])
+        for i in range(4): self.assertTrue(os.path.exists(out+'%05d.png'%i))
 
 class TestContact(unittest.TestCase):
     def setUp(self):
@@ -471,6 +640,25 @@ class TestParticles(unittest.TestCase):
             if S.dem.par.exists(id): S.dem.par.remove(id); removed+=1
         for b in S.dem.par: counted+=1
         self.assertTrue(counted==self.count-removed)
+    def testConveyorInsertMany(self):
+        "Particles: ConveyorInlet fills free ids first, then appends, with consistent nodes"
+        S=woo.master.scene
+        S.dt=1.
+        # the last particle is removed as well, which shrinks the storage and makes its id not reusable
+        holes=[3,17,42]
+        S.dem.par.remove(holes+[self.count-1])
+        nNodes=len(S.dem.nodes)
+        before=set(p.id for p in S.dem.par)
+        S.engines=[ConveyorInlet(maxNum=10,material=FrictMat(),cellLen=1.,radii=[.04]*10,centers=[(.1*i+.05,0,0) for i in range(10)],vel=1.,node=Node(pos=(100,0,0)),label='inlet')]
+        S.one()
+        self.assertEqual(S.lab.inlet.num,10)
+        new=set(p.id for p in S.dem.par)-before
+        self.assertEqual(new,set(holes+list(range(self.count-1,self.count+6))))
+        self.assertEqual(len(S.dem.par),self.count+6)
+        for p in S.dem.par: self.assertEqual(S.dem.par[p.id],p)
+        self.assertEqual(len(S.dem.nodes),nNodes+10)
+        for i,n in enumerate(S.dem.nodes): self.assertEqual(n.dem.linIx,i)
+        for i in new: self.assertTrue(S.dem.par[i].shape.nodes[0] in S.dem.nodes)
 
 
 class TestArrayAccu(unittest.TestCase):
@@ -106,3 +106,243 @@ class TestImpose(unittest.TestCase):
         S.run(wait=True)
         self.assertAlmostEqual(S.dem.nodes[0].ori.toAxisAngle()[1],.5*omega1*t1,delta=1e-3)
 
+
+class TestVoronoi(unittest.TestCase):
+    def setUp(self):
+        import random
+        random.seed(2)
+        self.S=S=Scene(fields=[DemField()])
+        # long box, so that it is split into several slabs
+        for i in range(3000): S.dem.par.add(Sphere.make(Vector3(random.uniform(0,4),random.uniform(0,1),random.uniform(0,1)),random.uniform(.04,.06)))
+        self.box=AlignedBox3((.1,.1,.1),(3.9,.9,.9))
+    def testPorositySlabs(self):
+        'Voronoi: porosity is the same when computed in one and in several slabs'
+        import woo.triangulated, numpy
+        ids1,pos1,por1=woo.triangulated.porosity(self.S.dem,self.box,slabs=1)
+        self.assertTrue(len(ids1)>2000)
+        for slabs in (2,5):
+            ids,pos,por=woo.triangulated.porosity(self.S.dem,self.box,slabs=slabs)
+            numpy.testing.assert_array_equal(ids,ids1)
+            numpy.testing.assert_allclose(pos,pos1)
+            numpy.testing.assert_allclose(por,por1,atol=1e-10)
+    def testSurfNormalsSlabs(self):
+        'Voronoi: surface normals are the same when computed in one and in several slabs'
+        import woo.triangulated, numpy
+        def byId(ids,nn):
+            ret={}
+            for i,n in zip(ids,nn): ret.setdefault(int(i),[]).append(tuple(n))
+            return dict((i,sorted(v)) for i,v in ret.items())
+        surf1=byId(*woo.triangulated.surfParticleIdNormals(self.S.dem,self.box,r=.1,slabs=1))
+        self.assertTrue(len(surf1)>0)
+        for slabs in (2,5):
+            surf=byId(*woo.triangulated.surfParticleIdNormals(self.S.dem,self.box,r=.1,slabs=slabs))
+            self.assertEqual(sorted(surf.keys()),sorted(surf1.keys()))
+            for i in surf1: numpy.testing.assert_allclose(surf[i],surf1[i],atol=1e-10)
+
+class TestMeshVolume(unittest.TestCase):
+    def testGts(self):
+        'MeshVolume: volume equals gts_surface_volume for deformed mesh, and is exact far from the origin'
+        if not hasattr(woo.dem,'MeshVolume'): self.skipTest('MeshVolume not compiled in (no GTS).')
+        import woo.triangulated, random
+        random.seed(4)
+        dim=Vector3(1,2,3)
+        for center,rel in (Vector3(.1,.2,.3),1e-12),(Vector3(1e3,-2e3,3e3),1e-4):
+            S=Scene(fields=[DemField(par=woo.triangulated.box(dim,center))])
+            mv=MeshVolume()
+            mv(S)
+            self.assertAlmostEqual(abs(mv.vol),dim.prod(),delta=1e-10*dim.prod())
+            # GTS subtracts large numbers far from the origin
+            self.assertAlmostEqual(mv.vol,mv.gtsVolume(),delta=rel*dim.prod())
+            for n in mv.nodes: n.pos+=Vector3(random.uniform(-.2,.2),random.uniform(-.2,.2),random.uniform(-.2,.2))
+            mv(S)
+            self.assertAlmostEqual(mv.vol,mv.gtsVolume(),delta=rel*dim.prod())
+
+class TestBuoyancy(unittest.TestCase):
+    def testSharedNodes(self):
+        'HalfspaceBuoyancy: forces on nodes shared by many particles equal serial summation'
+        import random, math
+        random.seed(5)
+        S=Scene(fields=[DemField(gravity=(0,0,-10))])
+        hb=HalfspaceBuoyancy(drag=True)
+        nodes=[]
+        # fully submerged, more than half, less than half, partially or not at all, above
+        for z in (-1,-.1,.05,.2,1):
+            n=Sphere.make((random.random(),random.random(),z),.2).shape.nodes[0]
+            n.dem.vel=Vector3(random.random(),random.random(),random.random())
+            n.dem.angVel=Vector3(random.random(),random.random(),random.random())
+            nodes.append(n)
+            for i in range(40):
+                p=Sphere.make(n.pos,random.uniform(.1,.3))
+                p.shape.nodes=[n]
+                S.dem.par.add(p,nodes=False)
+        hb(S)
+        g=S.dem.gravity
+        for n in nodes:
+            F,T=Vector3.Zero,Vector3.Zero
+            for p in S.dem.par:
+                if p.shape.nodes[0] is not n: continue
+                r=p.shape.radius
+                dp=r-n.pos[2]
+                if dp<=0: continue
+                vD=(math.pi*dp**2*(3*r-dp)/3 if dp<2*r else (4/3.)*math.pi*r**3)
+                F+=-hb.liqRho*vD*g-(3/4.)*hb.liqRho*(hb.dragCoef/2*r)*n.dem.vel*n.dem.vel.norm()
+                T+=-hb.dragCoef*(hb.liqRho/2)*n.dem.angVel*n.dem.angVel.norm()*r**5
+            for i in range(3):
+                self.assertAlmostEqual(n.dem.force[i],F[i],delta=1e-10*max(F.norm(),1))
+                self.assertAlmostEqual(n.dem.torque[i],T[i],delta=1e-10*max(T.norm(),1))
+        # the particle above the surface gets nothing, all others do
+        self.assertEqual(nodes[-1].dem.force,Vector3.Zero)
+        self.assertTrue(min(n.dem.force.norm() for n in nodes[:-1])>0)
+
+class TestNodeStats(unittest.TestCase):
+    def setUp(self):
+        import random
+        random.seed(6)
+        self.S=S=Scene(fields=[DemField()])
+        for i in range(1000):
+            v=(0 if i%97==0 else random.lognormvariate(0,1))
+            S.dem.nodesAppend(woo.core.Node(dem=DemData(vel=v*Vector3(random.gauss(0,1),random.gauss(0,1),random.gauss(0,1)).normalized())))
+        # boundary nodes are skipped
+        for i in range(50):
+            n=woo.core.Node(dem=DemData(vel=(1e3,0,0)))
+            n.dem.blocked='xyzXYZ'
+            S.dem.nodesAppend(n)
+    def testNumpy(self):
+        'NodeStats: mean, stdev, extrema and quantiles equal numpy values'
+        import numpy
+        S=self.S
+        st=NodeStat(qty='vel',quantiles=[0,.1,.5,.9,.99,1])
+        ns=NodeStats(stats=[st,NodeStat(qty='force')],relAcc=.01)
+        ns(S)
+        vv=numpy.array([n.dem.vel.norm() for n in S.dem.nodes if n.dem.blocked!='xyzXYZ'])
+        self.assertEqual(ns.nNodes,len(vv))
+        self.assertEqual(st.n,len(vv))
+        self.assertAlmostEqual(st.mean,vv.mean(),delta=1e-12*vv.mean())
+        self.assertAlmostEqual(st.stdev,vv.std(),delta=1e-12*vv.std())
+        self.assertEqual((st.vMin,st.vMax),(vv.min(),vv.max()))
+        # sketch gives the lower value (no interpolation) within relative accuracy
+        ss=numpy.sort(vv)
+        for q,val in zip(st.quantiles,st.qVals):
+            ref=ss[int(q*(len(ss)-1))]
+            self.assertAlmostEqual(val,ref,delta=ns.relAcc*ref*(1+1e-9))
+            self.assertEqual(val,st.quantile(q))
+        # zero forces everywhere
+        self.assertEqual((ns.stats[1].mean,ns.stats[1].vMax,ns.stats[1].qVals[0]),(0,0,0))
+    def testTrigger(self):
+        'NodeStats: trigger fires once per threshold crossing'
+        S=self.S
+        above=NodeStat(qty='vel',trigger='mean',threshold=1.,hook='S.tags["above"]+=S.tags["pass"]')
+        below=NodeStat(qty='vel',trigger='mean',threshold=1.,above=False,hook='S.tags["below"]+=S.tags["pass"]')
+        ns=NodeStats(stats=[above,below])
+        S.tags['above']=S.tags['below']=''
+        vel0=[n.dem.vel for n in S.dem.nodes]
+        mean0=NodeStats(stats=[NodeStat(qty='vel')])
+        mean0(S)
+        for i,m in enumerate((.5,2,3,.5,.4,2,.1)):
+            for n,v in zip(S.dem.nodes,vel0): n.dem.vel=v*(m/mean0.stats[0].mean)
+            S.tags['pass']=str(i)
+            ns(S)
+            self.assertAlmostEqual(above.mean,m,delta=1e-9*m)
+        # the first pass fires if already beyond the threshold
+        self.assertEqual((S.tags['above'],S.tags['below']),('15','036'))
+        self.assertEqual((above.nFired,below.nFired),(2,3))
+
+class TestFlowAnalysis(unittest.TestCase):
+    def _hitRateSum(self,fa):
+        'Sum of "hit rate" and "avg. velocity" (weighted by hit rate) over all points of the exported grid.'
+        import vtk, vtk.util.numpy_support
+        out=fa.vtkExportFractions(woo.master.tmpFilename(),[])
+        r=vtk.vtkXMLImageDataReader(); r.SetFileName(out); r.Update()
+        pd=r.GetOutput().GetPointData()
+        hit=vtk.util.numpy_support.vtk_to_numpy(pd.GetArray('hit rate'))
+        vel=vtk.util.numpy_support.vtk_to_numpy(pd.GetArray('avg. velocity'))
+        return hit.sum(),(hit[:,None]*vel).sum(axis=0)/hit.sum()
+    def testViaLeapfrog(self):
+        'DEM: FlowAnalysis.viaLeapfrog normalizes to the same rate as sampling at every run'
+        if not hasattr(woo.dem,'FlowAnalysis'): self.skipTest('FlowAnalysis not compiled in (no VTK).')
+        try: import vtk
+        except ImportError: self.skipTest('The vtk module is not importable.')
+        dt,nSteps=1e-3,200
+        for period in 1,10:
+            res={}
+            for via in False,True:
+                S=woo.core.Scene(fields=[DemField(par=[Sphere.make((-.5,0,0),.05)])],engines=DemField.minimalEngines(verletDist=0,dynDtPeriod=0)+[FlowAnalysis(box=((-1,-1,-1),(1,1,1)),cellSize=.1,stepPeriod=period,viaLeapfrog=via,label='flow')],dt=dt)
+                S.dem.par[0].vel=(1,0,0)
+                S.run(nSteps,True)
+                hit,vel=self._hitRateSum(S.lab.flow)
+                # every run deposits one particle (of total weight 1), except the first one with viaLeapfrog, which only sets the grid up
+                nDeposits=S.lab.flow.nDone-(1 if via else 0)
+                self.assertAlmostEqual(hit*S.lab.flow.timeSpan,nDeposits,delta=1e-6*nDeposits)
+                self.assertAlmostEqual(vel[0],1.,delta=1e-6)
+                res[via]=hit
+            # the rate does not depend on how data are deposited (up to the very first deposit)
+            self.assertAlmostEqual(res[True]/res[False],(nSteps/period-1)/(nSteps/period),delta=1e-6)
+
+class TestPotential(unittest.TestCase):
+    def contactGeom(self,cg2):
+        'Return normal overlap, normal and contact point of two overlapping spheres, computed by *cg2*.'
+        mat=FrictMat(young=1e6,density=1e3)
+        S=woo.core.Scene(fields=[DemField(par=[Sphere.make((0,0,0),.1,mat=mat,fixed=True),Sphere.make((.15,.05,.02),.08,mat=mat,fixed=True)])],dt=1e-6)
+        S.engines=[Leapfrog(reset=True),InsertionSortCollider([Bo1_Sphere_Aabb()],verletDist=0.),ContactLoop([cg2],[Cp2_FrictMat_FrictPhys()],[Law2_L6Geom_FrictPhys_IdealElPl(noBreak=True)])]
+        S.one()
+        self.assertEqual(len(S.dem.con),1)
+        g=S.dem.con[0].geom
+        return g.uN,g.node.ori*Vector3.UnitX,g.node.pos
+    def testSphereSphere(self):
+        'Potential: sphere-sphere contact matches Cg2_Sphere_Sphere_L6Geom'
+        uN0,n0,pt0=self.contactGeom(Cg2_Sphere_Sphere_L6Geom())
+        uN1,n1,pt1=self.contactGeom(Cg2_Shape_Shape_L6Geom__Potential([Pot1_Sphere()]))
+        self.assertTrue(uN0<0)
+        self.assertAlmostEqual(uN0,uN1,delta=1e-8)
+        self.assertAlmostEqual((n0-n1).norm(),0,delta=1e-8)
+        self.assertAlmostEqual((pt0-pt1).norm(),0,delta=1e-8)
+
+class TestDeactivator(unittest.TestCase):
+    def testSleepWake(self):
+        'DEM: Deactivator puts settled particles to sleep, falling ball wakes up its island only'
+        mat=FrictMat(young=1e6,density=1e3,ktDivKn=.2,tanPhi=.5)
+        r=.05
+        S=woo.core.Scene(fields=[DemField(gravity=(0,0,-10))],trackEnergy=True)
+        S.dem.par.add(Wall.make(0,axis=2,sense=1,mat=mat))
+        # column of 3 spheres (one island) and a lone sphere far away (another island)
+        S.dem.par.add([Sphere.make((0,0,z),r,mat=mat) for z in (r,3*r,5*r)]+[Sphere.make((1,0,r),r,mat=mat)])
+        S.engines=DemField.minimalEngines(damping=.4)+[Deactivator(maxVel=1e-2,restSteps=50,islandPeriod=10,label='deact')]
+        for i in range(50):
+            S.run(500,True)
+            if S.dem.nSleeping==4: break
+        self.assertEqual(S.dem.nSleeping,4)
+        # sleeping nodes don't move
+        pos=[p.pos for p in S.dem.par[1:]]
+        S.run(100,True)
+        self.assertEqual(pos,[p.pos for p in S.dem.par[1:]])
+        # drop a ball on the column
+        nWoken=S.lab.deact.nWoken
+        S.dem.par.add(Sphere.make((0,0,8*r),r,mat=mat,vel=(0,0,-1)))
+        for i in range(50):
+            S.run(10,True)
+            if S.lab.deact.nWoken>nWoken: break
+        self.assertEqual(S.lab.deact.nWoken-nWoken,3)
+        self.assertEqual(S.dem.nSleeping,1)
+
+class TestDynDt(unittest.TestCase):
+    def testViaContactLoop(self):
+        'DEM: DynDt.viaContactLoop gives the same timestep, stiffnesses are only accumulated when DynDt runs'
+        dts={}
+        for via in False,True:
+            mat=FrictMat(young=1e6,density=1e3)
+            S=woo.core.Scene(fields=[DemField(gravity=(0,0,-10))],dt=1e-5)
+            S.dem.par.add([Wall.make(0,axis=2,sense=1,mat=mat)]+[Sphere.make((.09*i,0,.05+.01*i),.05,mat=mat) for i in range(5)])
+            S.engines=DemField.minimalEngines(dynDtPeriod=10)
+            S.lab.dynDt.dryRun=True
+            S.lab.dynDt.viaContactLoop=via
+            S.run(21,True)
+            dts[via]=S.lab.dynDt.dt
+            cl=S.lab.contactLoop
+            self.assertFalse(cl.trackStiffness)
+            if via:
+                # accumulated in the last step when DynDt ran, and not afterwards
+                self.assertEqual(cl.stiffStep,S.lab.dynDt.stepLast)
+                S.one()
+                self.assertEqual(cl.stiffStep,S.lab.dynDt.stepLast)
+                self.assertTrue(cl.stiffStep<S.step-1)
+        self.assertAlmostEqual(dts[False],dts[True],delta=1e-9*dts[False])
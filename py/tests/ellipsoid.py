@@ -55,6 +55,25 @@ class TestEllipsoid(unittest.TestCase):
                 print('displacement',C.geom.uN)
             # e1 should move by -.1×.1 = .01 towards the first one, which should be the overlap distance
             self.assertAlmostEqual(C.geom.uN,-.01,delta=1e-5*0.01)
+    def testNewtonBrent(self):
+        'Ellipsoid: Newton iteration (warm-started) gives the same contact as Brent'
+        uN={}
+        for brent in (True,False):
+            S=woo.core.Scene(fields=[woo.dem.DemField()])
+            S.engines=[Leapfrog(reset=True),InsertionSortCollider([Bo1_Ellipsoid_Aabb()],verletDist=0.),ContactLoop([Cg2_Ellipsoid_Ellipsoid_L6Geom(brent=brent)],[Cp2_FrictMat_FrictPhys()],[Law2_L6Geom_FrictPhys_IdealElPl(noBreak=True)])]
+            gOri=Quaternion((1,.2,.5),.7); gOri.normalize()
+            S.dem.par.add([
+                woo.dem.Ellipsoid.make((0,0,0),semiAxes=(.1,.2,.15),ori=gOri,mat=self.mat,fixed=True),
+                woo.dem.Ellipsoid.make((.18,.03,0),semiAxes=(.2,.1,.1),ori=gOri.conjugate(),mat=self.mat,fixed=True)
+            ],nodes=True)
+            S.dem.par[1].vel=(-.1,0,0)
+            S.dt=.01
+            S.run(5,True)
+            C=S.dem.con[0]
+            self.assertTrue(isinstance(C.geom,EllL6Geom))
+            self.assertTrue(0<C.geom.lam<1)
+            uN[brent]=C.geom.uN
+        self.assertAlmostEqual(uN[True],uN[False],delta=1e-6*abs(uN[True]))
     def testNormalDisplacementWall(self):
         'Ellipsoid: normal displacement on contact with wall'
         pass
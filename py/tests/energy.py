@@ -90,3 +90,30 @@ class TestLeapfrog(unittest.TestCase):
 
 
 
+class TestMultirate(unittest.TestCase):
+    'Test energy conservation with :obj:`woo.dem.Multirate`.'
+    def setUp(self):
+        self.tol=.02 # relative error of kinetic energy after the bounce, passes at level 0
+    def bounce(self,maxLevel):
+        'Let two spheres collide, return maximum number of nodes at *maxLevel* and relative error of kinetic energy after the bounce.'
+        S=Scene(fields=[DemField(gravity=(0,0,0))])
+        r,v,mat=.1,.1,FrictMat(density=16e3,young=1e7,ktDivKn=.2,tanPhi=0)
+        S.dem.par.add([utils.sphere((0,0,0),r,mat=mat,vel=(v,0,0)),utils.sphere((2*r+1e-4,0,0),r,mat=mat,vel=(-v,0,0))])
+        # fixed timestep (tiny maxRelInc), small enough for the nodes to go up to maxLevel
+        S.dt=.1*utils.spherePWaveDt(r,mat.density,mat.young)/4
+        S.engines=utils.defaultEngines(damping=0,dynDtPeriod=0)+[Multirate(stepPeriod=1,maxLevel=maxLevel,maxRelInc=1e-10,label='multirate')]
+        Ek0=sum(p.Ek for p in S.dem.par)
+        maxCount=0
+        # run until the spheres move apart again
+        while S.step<20000:
+            S.one()
+            maxCount=max(maxCount,S.lab.multirate.levelCounts[maxLevel])
+            if S.dem.par[0].vel[0]<0 and S.dem.par[1].vel[0]>0 and S.dem.con.countReal()==0: break
+        self.assertTrue(S.dem.con.countReal()==0)
+        return maxCount,abs(sum(p.Ek for p in S.dem.par)-Ek0)/Ek0
+    def testLevels(self):
+        'Energy: Multirate conserves energy of bouncing spheres at levels 0, 1, 2'
+        for level in (0,1,2):
+            count,err=self.bounce(level)
+            self.assertTrue(count==2) # both spheres were at this level
+            self.assertTrue(err<self.tol,msg='level %d: relative energy error %g'%(level,err))
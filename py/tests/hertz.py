@@ -49,3 +49,51 @@ class TestHertz(unittest.TestCase):
 
 
 
+
+class TestMatPairTable(unittest.TestCase):
+    'Test constants cached per material pair by :obj:`Cp2_HertzMat_HertzPhys` and :obj:`Cp2_LudingMat_LudingPhys`.'
+    def contacts(self,S,mats,cp2,law):
+        'Create one contact for each pair of *mats* (in given order), return contact physics in the same order.'
+        S.engines=[Leapfrog(reset=True),InsertionSortCollider([Bo1_Sphere_Aabb()],verletDist=0.),ContactLoop([Cg2_Sphere_Sphere_L6Geom()],[cp2],[law],label='contactLoop')]
+        pairs=[(m1,m2) for m1 in mats for m2 in mats]
+        for i,(m1,m2) in enumerate(pairs): S.dem.par.add([woo.utils.sphere((i,0,0),.05,mat=m1,fixed=True),woo.utils.sphere((i,.099,0),.05,mat=m2,fixed=True)])
+        S.one()
+        self.assertEqual(len(S.dem.con),len(pairs))
+        return [(m1,m2,S.dem.con[2*i,2*i+1].phys) for i,(m1,m2) in enumerate(pairs)]
+    def testHertz(self):
+        'Hertz: constants cached per material pair match values computed from materials'
+        S=woo.core.Scene(fields=[woo.dem.DemField()],dt=1e-8)
+        mats=[HertzMat(density=1e3,young=1e8,tanPhi=.5,surfEnergy=.1,alpha=.3),HertzMat(density=2e3,young=3e7,tanPhi=.3,surfEnergy=.2,alpha=.5)]
+        nu=.2
+        def check(cc):
+            for m1,m2,ph in cc:
+                self.assertAlmostEqual(ph.K,(4/3.)/((1-nu**2)/m1.young+(1-nu**2)/m2.young),delta=1e-12*ph.K)
+                G=.5*(m1.young+m2.young)/(2*(1+nu))
+                self.assertAlmostEqual(ph.kt0,4*G/(2-nu)*ph.R**.5,delta=1e-12*ph.kt0)
+                self.assertEqual(ph.tanPhi,min(m1.tanPhi,m2.tanPhi))
+                self.assertEqual(ph.gamma,min(m1.surfEnergy,m2.surfEnergy))
+                self.assertAlmostEqual(ph.alpha,.5*(m1.alpha+m2.alpha))
+        cc=self.contacts(S,mats,Cp2_HertzMat_HertzPhys(poisson=nu,en=.7),Law2_L6Geom_HertzPhys_DMT())
+        check(cc)
+        # modified material is picked up
+        mats[1].young=5e8; mats[1].tanPhi=.8
+        S.lab.contactLoop.updatePhys='always'
+        S.one()
+        check(cc)
+    def testLuding(self):
+        'Luding: constants cached per material pair match values computed from materials'
+        S=woo.core.Scene(fields=[woo.dem.DemField()],dt=1e-8)
+        mats=[LudingMat(density=1e3,young=1e8,k1DivKn=.5,krDivKn=.2,viscR=.1,statW=.3,dynDivStat=.7),LudingMat(density=1e3,young=1e8,k1DivKn=.3,krDivKn=.4,viscR=.05,statW=.4,dynDivStat=.6)]
+        def check(cc):
+            for m1,m2,ph in cc:
+                self.assertAlmostEqual(ph.kn1,ph.k2hat*.5*(m1.k1DivKn+m2.k1DivKn),delta=1e-12*ph.kn1)
+                self.assertAlmostEqual(ph.kr,ph.k2hat*.5*(m1.krDivKn+m2.krDivKn)*ph.a12,delta=1e-12*ph.kr)
+                self.assertEqual(ph.viscR,min(m1.viscR,m2.viscR))
+                self.assertEqual(ph.statW,min(m1.statW,m2.statW))
+                self.assertEqual(ph.dynDivStat,min(m1.dynDivStat,m2.dynDivStat))
+        cc=self.contacts(S,mats,Cp2_LudingMat_LudingPhys(),Law2_L6Geom_LudingPhys())
+        check(cc)
+        mats[0].k1DivKn=.9; mats[0].viscR=.01
+        S.lab.contactLoop.updatePhys='always'
+        S.one()
+        check(cc)
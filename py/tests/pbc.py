@@ -117,6 +117,103 @@ class TestPBC(unittest.TestCase):
         S.cell.homoDeform='pos'; S.one()
         self.assertAlmostEqual(.5*S.dem.par[1].mass*self.initVel.squaredNorm(),S.dem.par[1].Ekt)
 
+class TestAnisoPorosity(unittest.TestCase):
+    def setUp(self):
+        random.seed(1)
+        self.S=S=Scene(fields=[DemField()],dt=1.)
+        S.periodic=True
+        S.cell.setBox(3,2.5,2)
+        for i in range(150): S.dem.par.add(Sphere.make(Vector3(*[random.uniform(0,l) for l in (3,2.5,2)]),random.uniform(.1,.3)))
+        S.engines=[AnisoPorosityAnalyzer(div=8,label='poro')]
+    def testGridEqualsBruteForce(self):
+        'AnisoPorosityAnalyzer: results with the grid are the same as when testing all spheres'
+        S=self.S; a=S.lab.poro
+        rays=[(theta,phi,Vector3(random.uniform(0,3),random.uniform(0,2.5),random.uniform(0,2))) for theta,phi in ((0,0),(.3,.2),(1.,.7),(math.pi/2,math.pi/2),(.01,1.5))]
+        res={}
+        for grs in (0,1,.3):
+            a.gridRelSize=grs
+            # grid is rebuilt in the same step when gridRelSize changes
+            res[grs]=[a.relSolid(*r) for r in rays]
+            S.one()
+            res[grs].append(a.poro)
+        for grs in (1,.3):
+            for s0,s1 in zip(res[0][:-1],res[grs][:-1]): self.assertAlmostEqual(s0,s1,delta=1e-9)
+            for i in range(3):
+                for j in range(3): self.assertAlmostEqual(res[0][-1][i,j],res[grs][-1][i,j],delta=1e-9)
+        # something was actually intersected
+        self.assertTrue(res[0][-1].trace()>.05)
+
+class TestStressStiffness(unittest.TestCase):
+    def setUp(self):
+        random.seed(3)
+        woo.master.scene=self.S=S=Scene(fields=[DemField()],dtSafety=1e-8,dt=1e-8)
+        S.periodic=True
+        S.cell.setBox(1,1.2,.8)
+        # dense enough for many contacts, some across periodic boundaries
+        for i in range(400): S.dem.par.add(Sphere.make(Vector3(random.uniform(0,1),random.uniform(0,1.2),random.uniform(0,.8)),random.uniform(.05,.08)))
+        S.engines=DemField.minimalEngines()
+        S.lab.contactLoop.evalStress=True
+        S.lab.contactLoop.evalStiffness=True
+        S.run(3,True)
+    def reference(self):
+        'Stress and stiffness (both Voigt) and unbalanced force, summed serially over contacts and nodes.'
+        S=self.S
+        vm=[[(0,0),(1,1),(2,2),(1,2),(2,0),(0,1)][p]+[(0,0),(1,1),(2,2),(1,2),(2,0),(0,1)][q] for p in range(6) for q in range(6)]
+        stress,K=Matrix3.Zero,[[0. for q in range(6)] for p in range(6)]
+        sumFc,nc=0.,0
+        for c in S.dem.con:
+            if not c.real: continue
+            n=c.geom.node.ori*Vector3.UnitX
+            F=c.geom.node.ori*c.phys.force
+            d0=c.dPos().norm()
+            fN=F.dot(n); fT=F-n*fN
+            stress+=d0*(fN*n.outer(n)+.5*(fT.outer(n)+n.outer(fT)))
+            nn=n.outer(n)
+            for p in range(6):
+                for q in range(6):
+                    i,j,k,l=vm[6*p+q]
+                    nnnn=nn[i,j]*nn[k,l]
+                    K[p][q]+=d0**2*(c.phys.kn*nnnn+c.phys.kt*(.25*(nn[j,k]*(i==l)+nn[j,l]*(i==k)+nn[i,k]*(j==l)+nn[i,l]*(j==k))-nnnn))
+            sumFc+=c.phys.force.norm(); nc+=1
+        V=S.cell.volume
+        stress/=V
+        stressV=Vector6(stress[0,0],stress[1,1],stress[2,2],stress[1,2],stress[2,0],stress[0,1])
+        Kref=Matrix6(*[Vector6(*[K[p][q]/V for q in range(6)]) for p in range(6)])
+        ff=[n.dem.force.norm() for n in S.dem.nodes if n.dem.blocked=='']
+        return stressV,Kref,(sum(ff)/len(ff))/(sumFc/nc),max(ff)/(sumFc/nc),nc
+    def assertMatrixAlmostEqual(self,A,B,rel=1e-9):
+        tol=rel*max(abs(B.maxCoeff()),abs(B.minCoeff()))
+        for i in range(A.rows()):
+            for j in range(A.cols()): self.assertAlmostEqual(A[i,j],B[i,j],delta=tol)
+    def testFuncs(self):
+        'Stress, stiffness and unbalanced force: parallel DemFuncs equal serial summation'
+        stressV,K,unb,unbMax,nc=self.reference()
+        self.assertTrue(nc>200)
+        s,K2,work=woo.utils.stressStiffnessWork()
+        for i in range(6): self.assertAlmostEqual(s[i],stressV[i],delta=1e-9*stressV.maxAbsCoeff())
+        # stressStiffnessWork prunes small (and negative) entries
+        Kpruned=Matrix6(*[Vector6(*[(K[i,j] if K[i,j]>=1e-12*K.maxCoeff() else 0) for j in range(6)]) for i in range(6)])
+        self.assertMatrixAlmostEqual(K2,Kpruned)
+        self.assertAlmostEqual(woo.utils.unbalancedForce(),unb,delta=1e-9*unb)
+        self.assertAlmostEqual(woo.utils.unbalancedForce(useMaxForce=True),unbMax,delta=1e-9*unbMax)
+    def testFuncsRepeatable(self):
+        'Stress and stiffness: repeated DemFuncs evaluation gives bitwise identical results'
+        s0,K0,w0=woo.utils.stressStiffnessWork()
+        for i in range(5):
+            s,K,w=woo.utils.stressStiffnessWork()
+            self.assertEqual(s,s0)
+            self.assertEqual(K,K0)
+    def testContactLoop(self):
+        'Stress and stiffness: ContactLoop.evalStress and evalStiffness equal serial summation'
+        stressV,K,unb,unbMax,nc=self.reference()
+        cl=self.S.lab.contactLoop
+        self.assertEqual(cl.stressStep,self.S.step-1)
+        st=cl.stress
+        # branch is parallel with normal for spheres, hence the symmetric part equals the reference
+        clV=Vector6(st[0,0],st[1,1],st[2,2],.5*(st[1,2]+st[2,1]),.5*(st[2,0]+st[0,2]),.5*(st[0,1]+st[1,0]))
+        for i in range(6): self.assertAlmostEqual(clV[i],stressV[i],delta=1e-9*stressV.maxAbsCoeff())
+        self.assertMatrixAlmostEqual(cl.stiffness,K)
+
 class TestPBCCollisions(unittest.TestCase):
     def setUp(self):
         woo.master.scene=S=Scene(fields=[DemField()])
@@ -2,6 +2,7 @@
 Test particle generator, that the resulting PSD curve matches the one on input.
 '''
 import unittest
+import woo, woo.utils
 from woo.core import *
 from woo.dem import *
 from minieigen import *
@@ -55,6 +56,37 @@ class PsdSphereGeneratorTest(unittest.TestCase):
         psdB=self.gen.psd(normalize=True,num=10,tRange=(.5,2.))
         self.assertTrue(psdA[0][0]<.2 and psdA[0][-1]>.1)
         self.assertTrue(psdB[0][0]<2 and psdB[0][-1]>1.)
+    def testPsdPaths(self):
+        'PSD: incremental histogram, traversal of saved particles and utils.psd agree'
+        self.gen.mass=True; self.gen.discrete=False
+        for i in range(2000): self.gen(self.mat)
+        ddmm=[Vector2(d,m) for d,m in self.gen.diamMass(zipped=True)]
+        for mass in True,False:
+            hist=self.gen.psd(mass=mass,num=50)
+            trav=self.gen.psd(mass=mass,num=50,tRange=(-float('inf'),float('inf')))
+            util=woo.utils.psd(ddmm,mass=mass,normalize=True,num=50)
+            for a,b in zip(trav,util): numpy.testing.assert_allclose(a,b,rtol=1e-12)
+            # the histogram resolves diameters to 0.1%
+            numpy.testing.assert_allclose(hist[0],trav[0],rtol=2e-3)
+            numpy.testing.assert_allclose(hist[1],trav[1],atol=1e-2)
+    def testPsdResync(self):
+        'PSD: incremental histogram follows revokeLast and clear'
+        self.gen.mass=True; self.gen.discrete=False
+        def check(n):
+            dd=self.gen.diamMass()[0]
+            psd=self.gen.psd(mass=False,normalize=False)
+            self.assertAlmostEqual(psd[1][-1],n)
+            self.assertAlmostEqual(psd[0][0],min(dd),delta=1e-12*min(dd))
+            self.assertAlmostEqual(psd[0][-1],max(dd),delta=1e-12*max(dd))
+        for i in range(100): self.gen(self.mat)
+        check(100)
+        self.gen.revokeLast()
+        check(99)
+        self.gen(self.mat)
+        check(100)
+        self.gen.clear()
+        for i in range(10): self.gen(self.mat)
+        check(10)
     def checkOk(self,relDeltaInt=.02,relDeltaD=.04):
         for i in range(10000): self.gen(self.mat)
         iPsd=self.gen.inputPsd(normalize=False)
@@ -99,6 +131,85 @@ class PsdSphereGeneratorTest(unittest.TestCase):
         self.assertAlmostEqual(dMin,oPsd[0][0],delta=relDeltaD*dMin)
         self.assertAlmostEqual(dMax,oPsd[0][-1],delta=relDeltaD*dMax)
 
+class SpillLogTest(unittest.TestCase):
+    def addSpheres(self,S,radii):
+        mat=woo.utils.defaultMaterial()
+        for r in radii: S.dem.par.add(woo.utils.sphere((0,0,0),r,mat=mat))
+    def testSaveLoad(self):
+        'PSD: SpillLog keeps rows in file and in memory across save and load'
+        import random
+        random.seed(0)
+        S=Scene(fields=[DemField(gravity=(0,0,0))],dt=1e-3)
+        S.engines=[BoxOutlet(inside=True,box=((-1,-1,-1),(1,1,1)),save=True,spill=SpillLog(file=woo.master.tmpFilename(),maxTail=10))]
+        r1=[random.uniform(.01,.05) for i in range(25)]
+        self.addSpheres(S,r1)
+        S.one()
+        spill=S.engines[0].spill
+        self.assertEqual(spill.nRows,25)
+        self.assertTrue(spill.nSpilled>0 and len(spill.tail)>0)
+        out=woo.master.tmpFilename()
+        S.save(out)
+        S2=Object.load(out)
+        r2=[random.uniform(.01,.05) for i in range(17)]
+        self.addSpheres(S2,r2)
+        S2.one()
+        outlet=S2.engines[0]
+        self.assertEqual(outlet.spill.nRows,42)
+        self.assertEqual(sorted(outlet.spill.column('diam')),sorted([2*r for r in r1+r2]))
+        self.assertEqual(outlet.spill.column('time'),25*[0.]+17*[1e-3])
+        # incremental histogram and traversal of all rows
+        for psd in outlet.psd(mass=False,normalize=False),outlet.psd(mass=False,normalize=False,tRange=(-float('inf'),float('inf'))):
+            self.assertAlmostEqual(psd[1][-1],42)
+            self.assertAlmostEqual(psd[0][0],2*min(r1+r2),delta=2e-3*psd[0][0])
+            self.assertAlmostEqual(psd[0][-1],2*max(r1+r2),delta=2e-3*psd[0][-1])
+    def testFileRequired(self):
+        'PSD: SpillLog without file fails as soon as it is used'
+        S=Scene(fields=[DemField(gravity=(0,0,0))],dt=1e-3)
+        S.engines=[BoxOutlet(inside=True,box=((-1,-1,-1),(1,1,1)),save=True,spill=SpillLog(maxTail=10))]
+        self.assertRaises(RuntimeError,S.one)
+
+    def testColsOnAssign(self):
+        'PSD: SpillLog columns are set when assigned to a generator'
+        gen=PsdSphereGenerator(psdPts=[(.05,0),(.1,1)])
+        gen.spill=SpillLog(file=woo.master.tmpFilename(),maxTail=3)
+        self.assertEqual(gen.spill.cols,['diam','mass','time'])
+        self.assertRaises(RuntimeError,lambda: setattr(gen,'spill',SpillLog(maxTail=10)))
+    def testRevokeSpilled(self):
+        'PSD: revoking rows after they were spilled reads them back from the file'
+        mat=woo.utils.defaultMaterial()
+        gen=PsdSphereGenerator(psdPts=[(.05,0),(.1,1)],spill=SpillLog(file=woo.master.tmpFilename(),maxTail=3))
+        for i in range(5): gen(mat)
+        diam=gen.spill.column('diam')
+        gen.spill.spill()
+        self.assertEqual((gen.spill.nSpilled,len(gen.spill.tail)),(5,0))
+        gen.revokeLast()
+        self.assertEqual(gen.spill.nRows,4)
+        self.assertEqual(gen.spill.column('diam'),diam[:4])
+        # rows read back are spilled again with the next ones
+        gen(mat); gen.spill.spill()
+        self.assertEqual(gen.spill.nRows,5)
+        self.assertEqual(gen.spill.column('diam')[:4],diam[:4])
+        for i in range(5): gen.revokeLast()
+        self.assertEqual(gen.spill.nRows,0)
+        # nothing left to revoke: warning only
+        gen.revokeLast()
+        self.assertEqual(gen.spill.nRows,0)
+    def testDeepcopy(self):
+        'PSD: deep-copied SpillLog continues in its own file'
+        S=Scene(fields=[DemField(gravity=(0,0,0))],dt=1e-3)
+        S.engines=[BoxOutlet(inside=True,box=((-1,-1,-1),(1,1,1)),save=True,spill=SpillLog(file=woo.master.tmpFilename(),maxTail=4))]
+        self.addSpheres(S,10*[.01])
+        S.one()
+        S2=S.deepcopy()
+        sp1,sp2=S.engines[0].spill,S2.engines[0].spill
+        self.assertNotEqual(sp1.file,sp2.file)
+        self.assertEqual(sp2.column('diam'),10*[.02])
+        self.addSpheres(S,7*[.03])
+        self.addSpheres(S2,5*[.04])
+        S.one(); S2.one()
+        self.assertEqual(sp1.column('diam'),10*[.02]+7*[.06])
+        self.assertEqual(sp2.column('diam'),10*[.02]+5*[.08])
+
 class BiasedPositionTest(unittest.TestCase):
     def testAxialBias(self):
         'Inlet: axial bias'
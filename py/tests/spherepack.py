@@ -0,0 +1,74 @@
+'''
+Test SpherePack generation and manipulation.
+'''
+import unittest
+import woo, woo.pack
+from minieigen import *
+import itertools
+
+class TestSpherePack(unittest.TestCase):
+    def checkNoOverlap(self,sp,cellSize=None):
+        ss=sp.toList()
+        for i,j in itertools.combinations(range(len(ss)),2):
+            (c1,r1),(c2,r2)=ss[i],ss[j]
+            d=c2-c1
+            if cellSize: d=Vector3(*[d[ax]-cellSize[ax]*round(d[ax]/cellSize[ax]) for ax in (0,1,2)])
+            self.assertTrue(d.norm()>=(r1+r2)*(1-1e-12),'spheres %d and %d overlap'%(i,j))
+    def checkInside(self,sp,mn,mx):
+        for c,r in sp.toList():
+            for ax in (0,1,2): self.assertTrue(mn[ax]+r<=c[ax]+1e-12 and c[ax]+r<=mx[ax]+1e-12)
+    def testMakeCloudNum(self):
+        'SpherePack: makeCloud places the requested number of non-overlapping spheres inside the box'
+        mn,mx=Vector3(0,0,0),Vector3(1,2,1.5)
+        for parallel in (False,True):
+            sp=woo.pack.SpherePack()
+            n=sp.makeCloud(mn,mx,rMean=.08,rRelFuzz=.3,num=150,parallel=parallel)
+            self.assertEqual(n,150)
+            self.assertEqual(len(sp),150)
+            self.checkNoOverlap(sp)
+            self.checkInside(sp,mn,mx)
+    def testMakeCloudFill(self):
+        'SpherePack: makeCloud without num fills the box up to loose-packing porosity'
+        mn,mx=Vector3(0,0,0),Vector3(1,1,1)
+        for parallel in (False,True):
+            sp=woo.pack.SpherePack()
+            n=sp.makeCloud(mn,mx,rMean=.06,rRelFuzz=0,parallel=parallel)
+            self.assertEqual(n,len(sp))
+            self.checkNoOverlap(sp)
+            self.checkInside(sp,mn,mx)
+            # random sequential addition saturates at solid fraction of about .38; stopping after a fixed number of failed tries and spheres must fit in the box, which gives less
+            poro=1-sp.sphereVol()/((mx[0]-mn[0])*(mx[1]-mn[1])*(mx[2]-mn[2]))
+            self.assertTrue(.6<poro<.9,'porosity %g'%poro)
+    def testMakeCloudPeriodic(self):
+        'SpherePack: periodic makeCloud has no overlaps across cell boundaries'
+        for parallel in (False,True):
+            sp=woo.pack.SpherePack()
+            sp.makeCloud(Vector3(0,0,0),Vector3(1,1.2,.8),rMean=.07,rRelFuzz=.2,num=100,periodic=True,parallel=parallel)
+            self.assertEqual(len(sp),100)
+            self.assertEqual(sp.cellSize,Vector3(1,1.2,.8))
+            self.checkNoOverlap(sp,cellSize=sp.cellSize)
+    def testMakeCloudReproducible(self):
+        'SpherePack: parallel makeCloud gives the same packing each time'
+        ll=[]
+        for i in range(2):
+            sp=woo.pack.SpherePack()
+            sp.makeCloud((0,0,0),(1,1,1),rMean=.05,rRelFuzz=.2,num=200,parallel=True)
+            ll.append(sp.toList())
+        self.assertEqual(ll[0],ll[1])
+    def testShadows(self):
+        'SpherePack: removeShadows removes exactly what addShadows added'
+        sp=woo.pack.SpherePack()
+        sp.makeCloud((0,0,0),(1,1,1),rMean=.1,rRelFuzz=.2,num=40,periodic=True)
+        sp.canonicalize()
+        orig=sp.toList()
+        n=sp.addShadows()
+        self.assertTrue(n>0)
+        self.assertEqual(len(sp),len(orig)+n)
+        # shadows are appended, originals are kept in place
+        self.assertEqual(sp.toList()[:len(orig)],orig)
+        self.assertRaises(RuntimeError,lambda: sp.addShadows())
+        self.assertEqual(sp.removeShadows(),n)
+        self.assertEqual(sp.toList(),orig)
+        self.assertEqual(sp.removeShadows(),0)
+        # shadows can be added again after removal
+        self.assertEqual(sp.addShadows(),n)
@@ -37,3 +37,160 @@ class TestTet4(unittest.TestCase):
         ])
         self.assertTrue( (K-Kok).norm()<1e-11 )
         self.assertTrue( (K-K.transpose()).norm()<1e-11 )
+
+    def testStressTensor(self):
+        'Tet4: stress tensor from homogeneous strain'
+        E,nu,eps=480.,.3,1e-3
+        for strain in ('uniaxial','shear'):
+            nodes=[woo.core.Node(pos=p) for p in [(0,0,0),(1,0,0),(0,1,0),(0,0,1)]]
+            S=woo.core.Scene(fields=[DemField()],dt=1.,engines=[IntraForce([woo.fem.In2_Tet4_ElastMat(nu=nu)])])
+            t=S.dem.par[S.dem.par.add(woo.fem.Tet4.make(nodes,mat=ElastMat(young=E),fixed=False))]
+            S.one() # reference configuration
+            for n in nodes:
+                x,y,z=n.pos
+                # pure shear is symmetric, so that the co-rotated frame does not rotate
+                n.pos=(Vector3((1+eps)*x,y,z) if strain=='uniaxial' else Vector3(x+.5*eps*y,y+.5*eps*x,z))
+            S.one()
+            sig=t.shape.getStressTensor()
+            lam,G=E*nu/((1+nu)*(1-2*nu)),E/(2*(1+nu))
+            if strain=='uniaxial': sigOk=Matrix3(eps*(lam+2*G),0,0, 0,eps*lam,0, 0,0,eps*lam)
+            else: sigOk=Matrix3(0,G*eps,0, G*eps,0,0, 0,0,0)
+            self.assertTrue((sig-sigOk).norm()<1e-6*sigOk.norm())
+
+def _stepForces(S):
+    'Reset nodal forces and torques, run one step and return them'
+    for n in S.dem.nodes: n.dem.force=n.dem.torque=Vector3.Zero
+    S.one()
+    return [Vector3(n.dem.force) for n in S.dem.nodes],[Vector3(n.dem.torque) for n in S.dem.nodes]
+
+def _nodeIndex(S,n):
+    return [i for i,nn in enumerate(S.dem.nodes) if nn is n][0]
+
+class TestTet4Forces(unittest.TestCase):
+    'Tet4: nodal forces from :obj:`woo.dem.IntraForce`.'
+    def setUp(self):
+        # two tetrahedra sharing a face
+        nn=[woo.core.Node(pos=p) for p in [(0,0,0),(1,0,0),(0,1,0),(0,0,1),(1,1,1)]]
+        mat=ElastMat(young=1e4)
+        self.S=S=woo.core.Scene(fields=[DemField()],dt=1.,engines=[IntraForce([woo.fem.In2_Tet4_ElastMat(nu=.3)])])
+        for ii in [(0,1,2,3),(1,2,3,4)]: S.dem.par.add(woo.fem.Tet4.make([nn[i] for i in ii],mat=mat,fixed=False),nodes=False)
+        S.dem.nodesAppend(nn)
+        # reference configuration
+        self.pos0=[Vector3(n.pos) for n in nn]
+        _stepForces(S)
+        for n,d in zip(nn,[(.01,0,-.02),(0,.03,0),(-.02,.01,.01),(0,0,.02),(.01,-.01,0)]): n.pos+=Vector3(d)
+    def expectedForces(self):
+        'Nodal forces computed from the (dynamic-size) stiffness matrices and displacements'
+        S=self.S
+        F=[Vector3.Zero for n in S.dem.nodes]
+        for p in S.dem.par:
+            t=p.shape
+            R=t.node.ori.toRotationMatrix()
+            f=t.KK*t.uXyz
+            for i in range(4): F[_nodeIndex(S,t.nodes[i])]-=R*Vector3(f[3*i],f[3*i+1],f[3*i+2])
+        return F
+    def testForces(self):
+        'Tet4: nodal forces are -K u rotated to global coordinates'
+        F,T=_stepForces(self.S)
+        self.assertEqual(self.S.engines[0].nColors,2)
+        for f,fe in zip(F,self.expectedForces()): self.assertTrue((f-fe).norm()<1e-9*fe.norm()+1e-12)
+        self.assertTrue(max([f.norm() for f in F])>0)
+    def testColored(self):
+        'Tet4: forces are the same with and without IntraForce.colored, also in a copied scene'
+        S2=self.S.deepcopy()
+        S2.engines[0].colored=False
+        F,T=_stepForces(self.S)
+        F2,T2=_stepForces(S2)
+        self.assertEqual(S2.engines[0].nColors,0)
+        for f,f2 in zip(F,F2): self.assertTrue((f-f2).norm()<1e-9*f.norm()+1e-12)
+
+    def testRecolor(self):
+        'Tet4: IntraForce colors are recomputed when particles are added or removed'
+        S=self.S
+        S.one()
+        self.assertEqual(S.engines[0].nColors,2)
+        # third element sharing nodes with both: needs a third color
+        nn=S.dem.nodes
+        S.dem.par.add(woo.fem.Tet4.make([nn[1],nn[2],nn[3],woo.core.Node(pos=(1,1,-1))],mat=S.dem.par[0].mat,fixed=False),nodes=True)
+        S.one()
+        self.assertEqual(S.engines[0].nColors,3)
+        S.dem.par.remove(2)
+        S.one()
+        self.assertEqual(S.engines[0].nColors,2)
+    def testStiffnessReferenceConf(self):
+        'Tet4: stiffness is assembled from the reference configuration, also when nodes moved before it was needed'
+        S2=self.S.deepcopy()
+        pos=[Vector3(n.pos) for n in S2.dem.nodes]
+        for n,p0 in zip(S2.dem.nodes,self.pos0): n.pos=p0
+        for p in S2.dem.par: p.shape.setRefConf() # clears stiffness
+        for n,p in zip(S2.dem.nodes,pos): n.pos=p
+        S2.one()
+        for p,p2 in zip(self.S.dem.par,S2.dem.par):
+            self.assertTrue((p.shape.KK-p2.shape.KK).norm()<1e-9*p.shape.KK.norm())
+
+class TestMembraneForces(unittest.TestCase):
+    'Membrane: nodal forces from :obj:`woo.dem.IntraForce`.'
+    def setUp(self):
+        # two triangles sharing an edge, in the xy-plane
+        nn=[woo.core.Node(pos=p) for p in [(0,0,0),(1,0,0),(0,1,0),(1,1,0)]]
+        mat=ElastMat(young=1e4)
+        self.S=S=woo.core.Scene(fields=[DemField()],dt=1.,engines=[IntraForce([woo.fem.In2_Membrane_ElastMat(thickness=.01,bending=True)])])
+        for ii in [(0,1,2),(1,3,2)]: S.dem.par.add(woo.fem.Membrane.make([nn[i] for i in ii],mat=mat,fixed=False),nodes=False)
+        S.dem.nodesAppend(nn)
+        self.pos0=[Vector3(n.pos) for n in nn]
+        _stepForces(S)
+        # in-plane displacements, and rotations (bending)
+        for n,d in zip(nn,[(.01,0,0),(0,.02,0),(-.01,.01,0),(.02,-.01,0)]): n.pos+=Vector3(d)
+        nn[1].ori=Quaternion((1,0,0),.02)
+        nn[3].ori=Quaternion((0,1,0),-.01)
+    def testForces(self):
+        'Membrane: nodal forces and torques are given by the CST and DKT stiffness matrices'
+        S=self.S
+        F,T=_stepForces(S)
+        self.assertEqual(S.engines[0].nColors,2)
+        Fe=[Vector3.Zero for n in S.dem.nodes]; Te=[Vector3.Zero for n in S.dem.nodes]
+        for p in S.dem.par:
+            m=p.shape
+            self.assertEqual((m.KKcst.rows(),m.KKcst.cols(),m.KKdkt.rows(),m.KKdkt.cols()),(6,6,9,6))
+            R=m.node.ori.toRotationMatrix()
+            fc=m.KKcst*VectorX(list(m.uXy))
+            fd=m.KKdkt*VectorX(list(m.phiXy))
+            for i in range(3):
+                j=_nodeIndex(S,m.nodes[i])
+                Fe[j]+=R*Vector3(-fc[2*i],-fc[2*i+1],fd[3*i])
+                Te[j]+=R*Vector3(fd[3*i+1],fd[3*i+2],0)
+        for f,fe in zip(F,Fe): self.assertTrue((f-fe).norm()<1e-9*fe.norm()+1e-12)
+        for t,te in zip(T,Te): self.assertTrue((t-te).norm()<1e-9*te.norm()+1e-12)
+        self.assertTrue(max([t.norm() for t in T])>0)
+    def testLoadShape(self):
+        'Membrane: stiffness matrices of unexpected shape are dropped when loaded, and re-assembled'
+        m=self.S.dem.par[0].shape
+        KKdkt=MatrixX(m.KKdkt)
+        m2=m.deepcopy()
+        # matrices of the right shape are kept
+        self.assertEqual((m2.KKdkt-KKdkt).norm(),0.)
+        m.KKdkt=MatrixX.Zero(9,9) # as saved without condensed DKT
+        m2=m.deepcopy()
+        self.assertEqual(m2.KKdkt.rows(),0)
+    def testDBdkt(self):
+        'Membrane: condensed DBdkt has all rotational columns of the full matrix'
+        S=self.S.deepcopy()
+        for p in S.dem.par:
+            p.shape.enableStress=True
+            p.shape.reset()
+        S.one()
+        for p in S.dem.par:
+            DB=p.shape.DBdkt
+            self.assertEqual((DB.rows(),DB.cols()),(3,6))
+            for c in range(6): self.assertTrue(DB.col(c).norm()>0)
+    def testStiffnessReferenceConf(self):
+        'Membrane: stiffness is assembled from the reference configuration, also when nodes moved before it was needed'
+        S2=self.S.deepcopy()
+        pos,ori=[Vector3(n.pos) for n in S2.dem.nodes],[Quaternion(n.ori) for n in S2.dem.nodes]
+        for n,p0 in zip(S2.dem.nodes,self.pos0): n.pos,n.ori=p0,Quaternion.Identity
+        for p in S2.dem.par: p.shape.setRefConf() # clears stiffness
+        for n,p,o in zip(S2.dem.nodes,pos,ori): n.pos,n.ori=p,o
+        S2.one()
+        for p,p2 in zip(self.S.dem.par,S2.dem.par):
+            self.assertTrue((p.shape.KKcst-p2.shape.KKcst).norm()<1e-9*p.shape.KKcst.norm())
+            self.assertTrue((p.shape.KKdkt-p2.shape.KKdkt).norm()<1e-9*p.shape.KKdkt.norm())